@@ -0,0 +1,240 @@
+"""
+puyothon の Python から呼ぶ関数の処理速度を測るベンチマーク.
+
+C のベンチマーク (build/bench/puyo_bench) と同じ盤面 (bench/corpus.txt) を使い,
+同じ形式の結果 (table / json / csv) を出力する.
+
+使い方:
+    python bench/bench.py [--format table|json|csv] [--min-time SEC] [--repeats N] [--filter NAME] [--label TEXT]
+    python bench/bench.py --compare base.json new.json
+"""
+import argparse
+import json
+import os
+import platform
+import sys
+import time
+
+import numpy as np
+
+import puyothon as puyo
+
+CORPUS = os.path.join(os.path.dirname(os.path.abspath(__file__)), "corpus.txt")
+CELLS = {".": puyo.EMPTY, "R": 1, "G": 2, "B": 3, "Y": 4, "O": puyo.OJAMA}
+BATCH = 256
+
+
+def loadCorpus(path:str) -> list[tuple[str, np.ndarray]]:
+    """
+    盤面ファイルを読み込む関数.
+
+    Returns:
+        list[tuple[str, np.ndarray]]: (名前, 盤面) のリスト.
+    """
+    cases = []
+    rows = None
+    with open(path, encoding="utf-8") as f:
+        for line in f:
+            line = line.rstrip("\r\n")
+            if not line or line.startswith("#"):
+                continue
+            if line.startswith("board "):
+                rows = []
+                cases.append((line[6:], rows))
+                continue
+            rows.append(line)
+
+    boards = []
+    for name, rows in cases:
+        board = puyo.makeBoard()
+        for k, row in enumerate(rows):
+            for j, ch in enumerate(row):
+                board[puyo.PUYO, puyo.ROWS_NUM - 1 - k, j + 1] = CELLS[ch]
+        boards.append((name, board))
+    return boards
+
+
+def actionToColRot(action:int) -> tuple[int, int]:
+    """
+    アクション番号 (0..21) を (列, 回転) に変換する関数. C の actionToColRot と同じ.
+    """
+    if action >= 3:
+        action += 1
+    if action >= 21:
+        action += 1
+    return action // 4 + 1, action % 4
+
+
+def timeIt(func, min_time:float, repeats:int) -> tuple[float, float, int]:
+    """
+    func(iters) を min_time 秒以上かかる回数で repeats 回測り, (中央値, 最小値, 回数) を ns/op で返す関数.
+    """
+    iters = 1
+    while True:
+        start = time.perf_counter()
+        func(iters)
+        elapsed = time.perf_counter() - start
+        if elapsed >= min_time:
+            break
+        iters = min(iters * 10, max(iters * 2, int(iters * min_time * 1.2 / max(elapsed, 1e-9))))
+
+    samples = []
+    for _ in range(repeats):
+        start = time.perf_counter_ns()
+        func(iters)
+        samples.append((time.perf_counter_ns() - start) / iters)
+    samples.sort()
+    return samples[len(samples) // 2], samples[0], iters
+
+
+def makeBenches(name:str, board:np.ndarray) -> list[tuple[str, str, object, int]]:
+    """
+    盤面ごとの計測対象を作る関数.
+
+    Returns:
+        list: (関数名, 種類, func(iters), 1回あたりの盤面数) のリスト.
+    """
+    chain = board.copy()
+    chain[puyo.STATE, 1:, 1:-1] = puyo.NEW
+    floating = board.copy()
+    floating[puyo.PUYO, 2:, 1:-1] = board[puyo.PUYO, 1:-1, 1:-1]
+    floating[puyo.PUYO, 1, 1:-1] = puyo.EMPTY
+    _, able_actions = puyo.getAbleBoardsForModel(board, 1, 2)
+    moves = [actionToColRot(int(a)) for a in able_actions]
+
+    out = np.empty((22, 14, 6, 4), np.float32)
+    actions = np.empty(22, np.int32)
+    boards = np.repeat(board[None], BATCH, axis=0)
+    batch_out = np.empty((BATCH, 22, 14, 6, 4), np.float32)
+    batch_mask = np.empty((BATCH, 22), bool)
+    parents = np.ones(BATCH, np.int32)
+    children = np.full(BATCH, 2, np.int32)
+
+    def putPuyo(iters):
+        for k in range(iters):
+            col, rot = moves[k % len(moves)]
+            puyo.putPuyo(board.copy(), 1, 2, col, rot)
+
+    def fallPuyo(engine):
+        def run(iters):
+            for _ in range(iters):
+                puyo.fallPuyo(floating.copy(), engine)
+        return run
+
+    def chainAuto(engine):
+        def run(iters):
+            for _ in range(iters):
+                puyo.chainAuto(chain.copy(), engine)
+        return run
+
+    def cvtBoardForModel(layout, dtype):
+        def run(iters):
+            for _ in range(iters):
+                puyo.cvtBoardForModel(board, layout, dtype)
+        return run
+
+    def getAbleBoardsForModel(iters):
+        for _ in range(iters):
+            puyo.getAbleBoardsForModel(board, 1, 2)
+
+    def getAbleBoardsForModelInto(iters):
+        for _ in range(iters):
+            puyo.getAbleBoardsForModelInto(board, 1, 2, out, actions)
+
+    def stepBatch(iters):
+        cols = np.array([moves[k % len(moves)][0] for k in range(BATCH)], np.int32) if moves else np.ones(BATCH, np.int32)
+        rots = np.array([moves[k % len(moves)][1] for k in range(BATCH)], np.int32) if moves else np.zeros(BATCH, np.int32)
+        for _ in range(iters):
+            puyo.stepBatch(boards.copy(), parents, children, cols, rots)
+
+    def getAbleBoardsForModelBatch(iters):
+        for _ in range(iters):
+            puyo.getAbleBoardsForModelBatch(boards, parents, children, batch_out, batch_mask)
+
+    benches = [
+        ("copy", "ndarray", lambda iters: [board.copy() for _ in range(iters)], 1),
+        ("fallPuyo", "array", fallPuyo(puyo.ENGINE_ARRAY), 1),
+        ("fallPuyo", "bitboard", fallPuyo(puyo.ENGINE_BITBOARD), 1),
+        ("chainAuto", "array", chainAuto(puyo.ENGINE_ARRAY), 1),
+        ("chainAuto", "bitboard", chainAuto(puyo.ENGINE_BITBOARD), 1),
+        ("cvtBoardForModel", "float32", cvtBoardForModel(puyo.LAYOUT_NHWC, puyo.DTYPE_FLOAT32), 1),
+        ("cvtBoardForModel", "nhwc_bits", cvtBoardForModel(puyo.LAYOUT_NHWC, puyo.DTYPE_BITS), 1),
+        ("cvtBoardForModel", "nchw_f16", cvtBoardForModel(puyo.LAYOUT_NCHW, puyo.DTYPE_FLOAT16), 1),
+        ("getAbleBoardsForModel", "float32", getAbleBoardsForModel, 1),
+        ("getAbleBoardsForModelInto", "float32", getAbleBoardsForModelInto, 1),
+        ("getAbleBoardsForModelBatch", f"n{BATCH}", getAbleBoardsForModelBatch, BATCH),
+        ("stepBatch", f"n{BATCH}", stepBatch, BATCH),
+    ]
+    if moves:
+        benches.insert(1, ("putPuyo", "array", putPuyo, 1))
+    return benches
+
+
+def printResults(results:list[dict], meta:dict, fmt:str) -> None:
+    if fmt == "json":
+        json.dump({"meta": meta, "results": results}, sys.stdout, indent=2)
+        print()
+    elif fmt == "csv":
+        print("suite,label,name,variant,board,ns_per_op,min_ns_per_op,ops_per_sec,iters")
+        for r in results:
+            print(f"python,{meta['label']},{r['name']},{r['variant']},{r['board']},"
+                  f"{r['ns_per_op']:.3f},{r['min_ns_per_op']:.3f},{r['ops_per_sec']:.1f},{r['iters']}")
+    else:
+        print(f"python: {meta['python']}  numpy: {meta['numpy']}" + (f"  label: {meta['label']}" if meta["label"] else ""))
+        print(f"{'name':<28} {'variant':<10} {'board':<10} {'ns/board':>12} {'boards/s':>14}")
+        for r in results:
+            print(f"{r['name']:<28} {r['variant']:<10} {r['board']:<10} {r['ns_per_op']:>12.1f} {r['ops_per_sec']:>14.0f}")
+
+
+def compare(base_path:str, new_path:str) -> None:
+    """
+    2つの json の結果を比べ, 同じ (関数名, 種類, 盤面) ごとの速度比を表示する関数.
+    """
+    with open(base_path) as f:
+        base = json.load(f)
+    with open(new_path) as f:
+        new = json.load(f)
+    base_map = {(r["name"], r["variant"], r["board"]): r for r in base["results"]}
+    print(f"base: {base['meta'].get('label', '')}  new: {new['meta'].get('label', '')}")
+    print(f"{'name':<28} {'variant':<10} {'board':<10} {'base ns':>10} {'new ns':>10} {'speedup':>8}")
+    for r in new["results"]:
+        b = base_map.get((r["name"], r["variant"], r["board"]))
+        if b is None:
+            continue
+        print(f"{r['name']:<28} {r['variant']:<10} {r['board']:<10} "
+              f"{b['ns_per_op']:>10.1f} {r['ns_per_op']:>10.1f} {b['ns_per_op'] / r['ns_per_op']:>7.2f}x")
+
+
+def main() -> None:
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--corpus", default=CORPUS)
+    parser.add_argument("--format", choices=["table", "json", "csv"], default="table")
+    parser.add_argument("--min-time", type=float, default=0.1)
+    parser.add_argument("--repeats", type=int, default=5)
+    parser.add_argument("--filter", default=None)
+    parser.add_argument("--label", default="")
+    parser.add_argument("--compare", nargs=2, metavar=("BASE", "NEW"))
+    args = parser.parse_args()
+
+    if args.compare:
+        compare(*args.compare)
+        return
+
+    results = []
+    for name, board in loadCorpus(args.corpus):
+        for bench_name, variant, func, per_op in makeBenches(name, board):
+            if args.filter and args.filter not in bench_name:
+                continue
+            ns, min_ns, iters = timeIt(func, args.min_time, max(args.repeats, 1))
+            results.append({
+                "name": bench_name, "variant": variant, "board": name,
+                "ns_per_op": ns / per_op, "min_ns_per_op": min_ns / per_op,
+                "ops_per_sec": 1e9 * per_op / ns, "iters": iters,
+            })
+
+    meta = {"suite": "python", "label": args.label, "python": platform.python_version(), "numpy": np.__version__}
+    printResults(results, meta, args.format)
+
+
+if __name__ == "__main__":
+    main()
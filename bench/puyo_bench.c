@@ -0,0 +1,470 @@
+// C本体の処理速度を測るベンチマーク
+// python setup.py build_bench でbuild/bench/puyo_benchが作られる
+//
+// 使い方: puyo_bench [--corpus PATH] [--format table|json|csv] [--min-time SEC] [--repeats N] [--filter NAME] [--label TEXT] [--simd LEVEL]
+// --simdでSIMDの命令セット（scalar, sse2, avx2, avx512）の上限を指定できる
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "puyo_func.h"
+#include "puyo_bitboard.h"
+#include "puyo_env.h"
+#include "puyo_encode.h"
+#include "puyo_hash.h"
+#include "puyo_legal.h"
+#include "puyo_simd.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#define MAX_CASES 64
+#define MAX_RESULTS 1024
+#define NAME_LEN 64
+
+typedef struct {
+    char name[NAME_LEN];
+    int board[ARRS_NUM][ROWS_NUM][COLS_NUM];   //盤面そのもの
+    int chain[ARRS_NUM][ROWS_NUM][COLS_NUM];   //STATE面を全てNEWにした盤面
+    int floating[ARRS_NUM][ROWS_NUM][COLS_NUM];//1段目を空にして全体が1段落ちる盤面
+    int able_actions[ACTIONS_NUM];
+    int able_num;
+} BenchCase;
+
+typedef struct {
+    const char *name;
+    const char *variant;
+    const char *board;
+    double ns_per_op;     //繰り返しの中央値
+    double min_ns_per_op; //繰り返しの最小値
+    long long iters;
+} BenchResult;
+
+typedef long long (*BenchFunc)(BenchCase *c, long long iters);
+
+static volatile long long sink;
+static BenchResult results[MAX_RESULTS];
+static int results_num = 0;
+
+static double nowSec(void){
+#ifdef _WIN32
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+//盤面ファイルの読み込み--------------------------------------------------------------------------------------
+
+static int cellFromChar(char ch){
+    switch(ch){
+        case '.': return EMPTY;
+        case 'R': return 1;
+        case 'G': return 2;
+        case 'B': return 3;
+        case 'Y': return 4;
+        case 'O': return OJAMA;
+    }
+    return BLOCK - 1;
+}
+
+static void prepareCase(BenchCase *c){
+    memcpy(c->chain, c->board, sizeof(c->chain));
+    memcpy(c->floating, c->board, sizeof(c->floating));
+    for(int i = 1; i < ROWS_NUM; i++){
+        for(int j = 1; j < COLS_NUM-1; j++)
+            c->chain[STATE][i][j] = NEW;
+    }
+    //元の盤面を1段持ち上げ，1段目を空ける（14段目のぷよは落ちないので捨てる）
+    for(int i = ROWS_NUM-1; i >= 2; i--){
+        for(int j = 1; j < COLS_NUM-1; j++)
+            c->floating[PUYO][i][j] = c->board[PUYO][i-1][j];
+    }
+    for(int j = 1; j < COLS_NUM-1; j++)
+        c->floating[PUYO][1][j] = EMPTY;
+    c->able_num = listAbleActions(c->board, c->able_actions);
+}
+
+static int loadCorpus(const char *path, BenchCase *cases){
+    FILE *fp = fopen(path, "r");
+    if(fp == NULL){
+        fprintf(stderr, "cannot open corpus: %s\n", path);
+        return -1;
+    }
+    char line[256];
+    int n = 0, row = 0;
+    BenchCase *c = NULL;
+    while(fgets(line, sizeof(line), fp)){
+        line[strcspn(line, "\r\n")] = '\0';
+        if(line[0] == '#' || line[0] == '\0') continue;
+        if(strncmp(line, "board ", 6) == 0){
+            if(n >= MAX_CASES) break;
+            c = &cases[n++];
+            memset(c, 0, sizeof(BenchCase));
+            snprintf(c->name, NAME_LEN, "%s", line + 6);
+            initBoard(c->board);
+            row = ROWS_NUM - 1;
+            continue;
+        }
+        if(c == NULL || row < 1 || strlen(line) != COLS_NUM - 2){
+            fprintf(stderr, "invalid corpus line: %s\n", line);
+            fclose(fp);
+            return -1;
+        }
+        for(int j = 1; j < COLS_NUM-1; j++){
+            int p = cellFromChar(line[j-1]);
+            if(p < BLOCK){
+                fprintf(stderr, "invalid corpus cell: %s\n", line);
+                fclose(fp);
+                return -1;
+            }
+            c->board[PUYO][row][j] = p;
+        }
+        if(--row == 0) prepareCase(c);
+    }
+    fclose(fp);
+    return n;
+}
+
+//各処理の計測対象--------------------------------------------------------------------------------------------
+
+static long long benchCopy(BenchCase *c, long long iters){
+    int tmp[ARRS_NUM][ROWS_NUM][COLS_NUM];
+    long long acc = 0;
+    for(long long k = 0; k < iters; k++){
+        memcpy(tmp, c->board, sizeof(tmp));
+        acc += tmp[PUYO][1][(k & 3) + 1];
+    }
+    return acc;
+}
+
+static long long benchCanPut(BenchCase *c, long long iters){
+    long long acc = 0;
+    for(long long k = 0; k < iters; k++){
+        int col, rot;
+        actionToColRot((int)(k % ACTIONS_NUM), &col, &rot);
+        acc += canPut(c->board, col, rot);
+    }
+    return acc;
+}
+
+//22手分の判定をまとめて行う（canPutの22回分に当たる）
+static long long benchLegalMask(BenchCase *c, long long iters){
+    int (*volatile board)[ROWS_NUM][COLS_NUM] = c->board; //ループの外に出されないようにする
+    long long acc = 0;
+    for(long long k = 0; k < iters; k++)
+        acc += legalActionMask(board);
+    return acc;
+}
+
+static long long benchPutPuyo(BenchCase *c, long long iters){
+    int tmp[ARRS_NUM][ROWS_NUM][COLS_NUM];
+    long long acc = 0;
+    for(long long k = 0; k < iters; k++){
+        int col, rot;
+        actionToColRot(c->able_actions[k % c->able_num], &col, &rot);
+        memcpy(tmp, c->board, sizeof(tmp));
+        acc += putPuyo(tmp, col, rot, 1, 2);
+    }
+    return acc;
+}
+
+static long long benchFallPuyos(BenchCase *c, long long iters){
+    int tmp[ARRS_NUM][ROWS_NUM][COLS_NUM];
+    long long acc = 0;
+    for(long long k = 0; k < iters; k++){
+        memcpy(tmp, c->floating, sizeof(tmp));
+        acc += fallPuyos(tmp);
+    }
+    return acc;
+}
+
+static long long benchFallPuyosBB(BenchCase *c, long long iters){
+    int tmp[ARRS_NUM][ROWS_NUM][COLS_NUM];
+    long long acc = 0;
+    for(long long k = 0; k < iters; k++){
+        memcpy(tmp, c->floating, sizeof(tmp));
+        acc += fallPuyosBB(tmp);
+    }
+    return acc;
+}
+
+static long long benchOneChain(BenchCase *c, long long iters){
+    int tmp[ARRS_NUM][ROWS_NUM][COLS_NUM];
+    long long acc = 0;
+    for(long long k = 0; k < iters; k++){
+        memcpy(tmp, c->chain, sizeof(tmp));
+        acc += oneChain(tmp, 1);
+    }
+    return acc;
+}
+
+static long long benchOneChainBB(BenchCase *c, long long iters){
+    int tmp[ARRS_NUM][ROWS_NUM][COLS_NUM];
+    long long acc = 0;
+    for(long long k = 0; k < iters; k++){
+        memcpy(tmp, c->chain, sizeof(tmp));
+        acc += oneChainBB(tmp, 1);
+    }
+    return acc;
+}
+
+static long long benchAllChain(BenchCase *c, long long iters){
+    int tmp[ARRS_NUM][ROWS_NUM][COLS_NUM];
+    long long acc = 0;
+    for(long long k = 0; k < iters; k++){
+        int n_chains, score;
+        memcpy(tmp, c->chain, sizeof(tmp));
+        allChain(tmp, &n_chains, &score);
+        acc += n_chains + score;
+    }
+    return acc;
+}
+
+static long long benchAllChainBB(BenchCase *c, long long iters){
+    int tmp[ARRS_NUM][ROWS_NUM][COLS_NUM];
+    long long acc = 0;
+    for(long long k = 0; k < iters; k++){
+        int n_chains, score;
+        memcpy(tmp, c->chain, sizeof(tmp));
+        allChainBB(tmp, &n_chains, &score);
+        acc += n_chains + score;
+    }
+    return acc;
+}
+
+static long long benchToBitBoard(BenchCase *c, long long iters){
+    BitBoard bb;
+    long long acc = 0;
+    for(long long k = 0; k < iters; k++){
+        acc += toBitBoard(c->board, &bb);
+        acc += (long long)bb.color[k % COLOR_NUM].w[0];
+    }
+    return acc;
+}
+
+static long long benchToBoardForModel(BenchCase *c, long long iters){
+    float x[ROWS_NUM-1][COLS_NUM-2][COLOR_NUM];
+    long long acc = 0;
+    for(long long k = 0; k < iters; k++){
+        toBoardForModel(c->board, x);
+        acc += (long long)x[k % (ROWS_NUM-1)][0][0];
+    }
+    return acc;
+}
+
+//encodeBoardの並びと型の組み合わせ
+static int encode_layout, encode_dtype;
+
+static long long benchEncodeBoard(BenchCase *c, long long iters){
+    unsigned char x[ENCODE_ELEMS * 4];
+    long long acc = 0;
+    for(long long k = 0; k < iters; k++){
+        encodeBoard(c->board, encode_layout, encode_dtype, x);
+        acc += x[k % sizeof(x)];
+    }
+    return acc;
+}
+
+static long long benchAbleBoardsForModel(BenchCase *c, long long iters){
+    static float x[ACTIONS_NUM][ROWS_NUM-1][COLS_NUM-2][COLOR_NUM];
+    int able_actions[ACTIONS_NUM];
+    long long acc = 0;
+    for(long long k = 0; k < iters; k++)
+        acc += ableBoardsForModel(c->board, 1, 2, LAYOUT_NHWC, DTYPE_FLOAT32, x, able_actions);
+    return acc;
+}
+
+//計測-----------------------------------------------------------------------------------------------------
+
+static int compareDouble(const void *a, const void *b){
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// min_time秒以上かかる回数を求めてからrepeats回計測する
+static void runBench(const char *name, const char *variant, BenchFunc func, BenchCase *c, double min_time, int repeats){
+    long long iters = 1;
+    while(1){
+        double start = nowSec();
+        sink += func(c, iters);
+        double elapsed = nowSec() - start;
+        if(elapsed >= min_time || iters >= (1LL << 40)) break;
+        long long next = elapsed > 0 ? (long long)(iters * (min_time * 1.2 / elapsed)) : iters * 10;
+        iters = next > iters * 10 ? iters * 10 : (next > iters ? next : iters * 2);
+    }
+
+    double samples[64];
+    if(repeats > 64) repeats = 64;
+    for(int r = 0; r < repeats; r++){
+        double start = nowSec();
+        sink += func(c, iters);
+        samples[r] = (nowSec() - start) * 1e9 / (double)iters;
+    }
+    qsort(samples, repeats, sizeof(double), compareDouble);
+
+    if(results_num >= MAX_RESULTS) return;
+    BenchResult *res = &results[results_num++];
+    res->name = name;
+    res->variant = variant;
+    res->board = c->name;
+    res->ns_per_op = samples[repeats / 2];
+    res->min_ns_per_op = samples[0];
+    res->iters = iters;
+}
+
+//出力-----------------------------------------------------------------------------------------------------
+
+static const char *compilerName(void){
+#if defined(__clang__)
+    return "clang " __clang_version__;
+#elif defined(__GNUC__)
+    return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+    return "msvc";
+#else
+    return "unknown";
+#endif
+}
+
+static void printFeatures(FILE *out, const char *sep){
+    const char *features[] = {
+#ifdef __OPTIMIZE__
+        "optimize",
+#endif
+#ifdef __BMI2__
+        "bmi2",
+#endif
+#ifdef __AVX2__
+        "avx2",
+#endif
+#ifdef __AVX512F__
+        "avx512f",
+#endif
+        NULL
+    };
+    for(int i = 0; features[i] != NULL; i++)
+        fprintf(out, "%s%s%s%s", i ? sep : "", sep[0] == ',' ? "\"" : "", features[i], sep[0] == ',' ? "\"" : "");
+}
+
+static void printJson(FILE *out, const char *label){
+    fprintf(out, "{\n  \"meta\": {\"suite\": \"c\", \"label\": \"%s\", \"compiler\": \"%s\", \"simd\": \"%s\", \"features\": [",
+            label, compilerName(), simdLevelName(simdLevel()));
+    printFeatures(out, ",");
+    fprintf(out, "]},\n  \"results\": [\n");
+    for(int i = 0; i < results_num; i++){
+        BenchResult *r = &results[i];
+        fprintf(out, "    {\"name\": \"%s\", \"variant\": \"%s\", \"board\": \"%s\", \"ns_per_op\": %.3f, \"min_ns_per_op\": %.3f, \"ops_per_sec\": %.1f, \"iters\": %lld}%s\n",
+                r->name, r->variant, r->board, r->ns_per_op, r->min_ns_per_op, 1e9 / r->ns_per_op, r->iters, i + 1 < results_num ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+static void printCsv(FILE *out, const char *label){
+    fprintf(out, "suite,label,name,variant,board,ns_per_op,min_ns_per_op,ops_per_sec,iters\n");
+    for(int i = 0; i < results_num; i++){
+        BenchResult *r = &results[i];
+        fprintf(out, "c,%s,%s,%s,%s,%.3f,%.3f,%.1f,%lld\n",
+                label, r->name, r->variant, r->board, r->ns_per_op, r->min_ns_per_op, 1e9 / r->ns_per_op, r->iters);
+    }
+}
+
+static void printTable(FILE *out, const char *label){
+    fprintf(out, "compiler: %s  simd: %s  features: ", compilerName(), simdLevelName(simdLevel()));
+    printFeatures(out, " ");
+    fprintf(out, "%s%s\n", label[0] ? "  label: " : "", label);
+    fprintf(out, "%-22s %-10s %-10s %12s %14s\n", "name", "variant", "board", "ns/op", "ops/s");
+    for(int i = 0; i < results_num; i++){
+        BenchResult *r = &results[i];
+        fprintf(out, "%-22s %-10s %-10s %12.1f %14.0f\n", r->name, r->variant, r->board, r->ns_per_op, 1e9 / r->ns_per_op);
+    }
+}
+
+int main(int argc, char **argv){
+    const char *corpus = "bench/corpus.txt";
+    const char *format = "table";
+    const char *filter = NULL;
+    const char *label = "";
+    const char *simd = NULL;
+    double min_time = 0.1;
+    int repeats = 5;
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i], "--corpus") == 0 && i + 1 < argc) corpus = argv[++i];
+        else if(strcmp(argv[i], "--format") == 0 && i + 1 < argc) format = argv[++i];
+        else if(strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) min_time = atof(argv[++i]);
+        else if(strcmp(argv[i], "--repeats") == 0 && i + 1 < argc) repeats = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--filter") == 0 && i + 1 < argc) filter = argv[++i];
+        else if(strcmp(argv[i], "--label") == 0 && i + 1 < argc) label = argv[++i];
+        else if(strcmp(argv[i], "--simd") == 0 && i + 1 < argc) simd = argv[++i];
+        else{
+            fprintf(stderr, "usage: %s [--corpus PATH] [--format table|json|csv] [--min-time SEC] [--repeats N] [--filter NAME] [--label TEXT] [--simd LEVEL]\n", argv[0]);
+            return 2;
+        }
+    }
+    if(repeats < 1) repeats = 1;
+
+    initSimd();
+    if(simd != NULL){
+        int level = simdLevelFromName(simd);
+        if(level < 0){
+            fprintf(stderr, "unknown SIMD level: %s\n", simd);
+            return 2;
+        }
+        setSimdLevel(level);
+    }
+
+    static BenchCase cases[MAX_CASES];
+    int cases_num = loadCorpus(corpus, cases);
+    if(cases_num < 0) return 1;
+
+    static const struct {
+        const char *name;
+        const char *variant;
+        BenchFunc func;
+        int needs_action; //置ける手がない盤面では測らない
+        int layout, dtype;
+    } benches[] = {
+        {"copy",                  "memcpy",   benchCopy,               0, 0, 0},
+        {"canPut",                "array",    benchCanPut,             0, 0, 0},
+        {"legalActionMask",       "table",    benchLegalMask,          0, 0, 0},
+        {"putPuyo",               "array",    benchPutPuyo,            1, 0, 0},
+        {"fallPuyos",             "array",    benchFallPuyos,          0, 0, 0},
+        {"fallPuyos",             "bitboard", benchFallPuyosBB,        0, 0, 0},
+        {"oneChain",              "array",    benchOneChain,           0, 0, 0},
+        {"oneChain",              "bitboard", benchOneChainBB,         0, 0, 0},
+        {"allChain",              "array",    benchAllChain,           0, 0, 0},
+        {"allChain",              "bitboard", benchAllChainBB,         0, 0, 0},
+        {"toBitBoard",            "scan",     benchToBitBoard,         0, 0, 0},
+        {"toBoardForModel",       "float32",  benchToBoardForModel,    0, 0, 0},
+        {"encodeBoard",           "nhwc_f16", benchEncodeBoard,        0, LAYOUT_NHWC, DTYPE_FLOAT16},
+        {"encodeBoard",           "nhwc_u8",  benchEncodeBoard,        0, LAYOUT_NHWC, DTYPE_UINT8},
+        {"encodeBoard",           "nhwc_bits", benchEncodeBoard,       0, LAYOUT_NHWC, DTYPE_BITS},
+        {"encodeBoard",           "nchw_f32", benchEncodeBoard,        0, LAYOUT_NCHW, DTYPE_FLOAT32},
+        {"ableBoardsForModel",    "float32",  benchAbleBoardsForModel, 0, 0, 0},
+    };
+    int benches_num = (int)(sizeof(benches) / sizeof(benches[0]));
+
+    initZobrist();
+    initLegalTable();
+    for(int b = 0; b < benches_num; b++){
+        if(filter != NULL && strstr(benches[b].name, filter) == NULL) continue;
+        for(int i = 0; i < cases_num; i++){
+            if(benches[b].needs_action && cases[i].able_num == 0) continue;
+            encode_layout = benches[b].layout;
+            encode_dtype = benches[b].dtype;
+            runBench(benches[b].name, benches[b].variant, benches[b].func, &cases[i], min_time, repeats);
+        }
+    }
+
+    if(strcmp(format, "json") == 0) printJson(stdout, label);
+    else if(strcmp(format, "csv") == 0) printCsv(stdout, label);
+    else printTable(stdout, label);
+    return 0;
+}
\ No newline at end of file
@@ -1,12 +1,97 @@
-from setuptools import setup, Extension, find_packages
+from setuptools import setup, Extension, find_packages, Command
 import numpy
+import os
+import shlex
+import sys
+
+# スレッドを使うためのオプション（Windows では不要）
+thread_args = [] if os.name == "nt" else ["-pthread"]
+
+# 共有メモリ（shm_open）のためのライブラリ（古い glibc では librt が必要）
+shm_libraries = ["rt"] if sys.platform.startswith("linux") else []
+
+# 計測カウンタ（PUYO_STATS=1 でカウンタ，PUYO_STATS=2 でサイクル数も計測．未指定なら計測コードは入らない）
+stats_level = os.environ.get("PUYO_STATS", "")
+stats_macros = []
+if stats_level not in ("", "0"):
+    stats_macros.append(("PUYO_STATS", "1"))
+    if stats_level == "2":
+        stats_macros.append(("PUYO_STATS_TIMERS", "1"))
 
 ext = Extension(
     "puyothon.puyothon", # パッケージ名.モジュール名
-    sources=["src/puyothon/puyo_module.c", "src/puyothon/puyo_func.c"],
+    sources=[
+        "src/puyothon/puyo_module.c",
+        "src/puyothon/puyo_func.c",
+        "src/puyothon/puyo_bitboard.c",
+        "src/puyothon/puyo_env.c",
+        "src/puyothon/puyo_legal.c",
+        "src/puyothon/puyo_encode.c",
+        "src/puyothon/puyo_pack.c",
+        "src/puyothon/puyo_log.c",
+        "src/puyothon/puyo_replay.c",
+        "src/puyothon/puyo_shm.c",
+        "src/puyothon/puyo_search.c",
+        "src/puyothon/puyo_hash.c",
+        "src/puyothon/puyo_cache.c",
+        "src/puyothon/puyo_rollout.c",
+        "src/puyothon/puyo_versus.c",
+        "src/puyothon/puyo_thread.c",
+        "src/puyothon/puyo_stats.c",
+        "src/puyothon/puyo_simd.c",
+        "src/puyothon/puyo_augment.c",
+        "src/puyothon/puyo_tsumo.c",
+        "src/puyothon/puyo_feature.c",
+        "src/puyothon/puyo_variant.c",
+    ],
+    define_macros=stats_macros,
     include_dirs=[numpy.get_include()],
+    extra_compile_args=thread_args,
+    extra_link_args=thread_args,
+    libraries=shm_libraries,
 )
 
+# ベンチマークに使う C 本体のソース（Python に依存しないもの）
+bench_sources = [
+    "bench/puyo_bench.c",
+    "src/puyothon/puyo_func.c",
+    "src/puyothon/puyo_bitboard.c",
+    "src/puyothon/puyo_env.c",
+    "src/puyothon/puyo_legal.c",
+    "src/puyothon/puyo_encode.c",
+    "src/puyothon/puyo_hash.c",
+    "src/puyothon/puyo_thread.c",
+    "src/puyothon/puyo_stats.c",
+    "src/puyothon/puyo_simd.c",
+]
+
+class BuildBench(Command):
+    """C のベンチマーク実行ファイルを作るコマンド (python setup.py build_bench)"""
+
+    description = "build the standalone C benchmark executable"
+    user_options = [
+        ("cflags=", None, "extra compiler flags, e.g. \"-O3 -march=native\""),
+        ("build-dir=", None, "output directory (default: build/bench)"),
+    ]
+
+    def initialize_options(self):
+        self.cflags = ""
+        self.build_dir = os.path.join("build", "bench")
+
+    def finalize_options(self):
+        pass
+
+    def run(self):
+        from distutils.ccompiler import new_compiler
+        from distutils.sysconfig import customize_compiler
+
+        compiler = new_compiler()
+        customize_compiler(compiler)
+        compile_args = thread_args + shlex.split(self.cflags)
+        objects = compiler.compile(bench_sources, output_dir=self.build_dir,
+                                   include_dirs=["src/puyothon"], extra_postargs=compile_args)
+        compiler.link_executable(objects, "puyo_bench", output_dir=self.build_dir, extra_postargs=thread_args)
+
 setup(
     name="puyothon",
     version="1.0",
@@ -14,5 +99,6 @@ setup(
     package_dir={"": "src"},
     packages=find_packages(where="src"),
     ext_modules=[ext],
+    cmdclass={"build_bench": BuildBench},
     zip_safe=False,
 )
\ No newline at end of file
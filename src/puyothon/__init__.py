@@ -1,3 +1,5 @@
+import os
+
 import numpy as np
 
 # C拡張モジュールをインポート
@@ -5,11 +7,46 @@ from .puyothon import (
     makeBoard as _makeBoard,
     cvtBoardForModel as _cvtBoardForModel,
     getAbleBoardsForModel as _getAbleBoardsForModel,
+    getAbleBoardsForModelInto as _getAbleBoardsForModelInto,
+    getAbleBoardsForModelBatch as _getAbleBoardsForModelBatch,
+    step as _step,
     putPuyo as _putPuyo,
+    makeMove as _makeMove,
+    unmakeMove as _unmakeMove,
     fallPuyo as _fallPuyo,
     erasePuyo as _erasePuyo,
     chainAuto as _chainAuto,
     isDead as _isDead,
+    legalActionMask as _legalActionMask,
+    legalActionMasks as _legalActionMasks,
+    stepBatch as _stepBatch,
+    evaluateActions as _evaluateActions,
+    evaluateActionsBatch as _evaluateActionsBatch,
+    chainFeatures as _chainFeatures,
+    chainFeaturesBatch as _chainFeaturesBatch,
+    getRuleVariants as _getRuleVariants,
+    searchActions as _searchActions,
+    beamSearch as _beamSearch,
+    rollout as _rollout,
+    versusStep as _versusStep,
+    playVersus as _playVersus,
+    generateTsumo as _generateTsumo,
+    hashBoard as _hashBoard,
+    chainAutoCached as _chainAutoCached,
+    probeCache as _probeCache,
+    setCacheSize as _setCacheSize,
+    clearCache as _clearCache,
+    getCacheStats as _getCacheStats,
+    getStats as _getStats,
+    getSimdInfo as _getSimdInfo,
+    setSimdLevel as _setSimdLevel,
+    packBoards as _packBoards,
+    unpackBoards as _unpackBoards,
+    augmentColors as _augmentColors,
+    appendGameLog as _appendGameLog,
+    Board as _Board,
+    ReplayBuffer as _ReplayBuffer,
+    SharedRing as _SharedRing,
     ARRS_NUM as _ARRS_NUM,
     ROWS_NUM as _ROWS_NUM,
     COLS_NUM as _COLS_NUM,
@@ -21,35 +58,90 @@ from .puyothon import (
     EMPTY as _EMPTY,
     IDLE as _IDLE,
     NEW as _NEW,
+    ENGINE_ARRAY as _ENGINE_ARRAY,
+    ENGINE_BITBOARD as _ENGINE_BITBOARD,
+    POLICY_RANDOM as _POLICY_RANDOM,
+    POLICY_GREEDY as _POLICY_GREEDY,
+    OJAMA_RATE as _OJAMA_RATE,
+    OJAMA_MAX_DROP as _OJAMA_MAX_DROP,
+    TSUMO_CYCLE as _TSUMO_CYCLE,
+    FEATURES_NUM as _FEATURES_NUM,
+    FEATURE_DROPS as _FEATURE_DROPS,
+    FEATURE_HEIGHT_OFFSET as _FEATURE_HEIGHT_OFFSET,
+    FEATURE_CONNECT_OFFSET as _FEATURE_CONNECT_OFFSET,
+    FEATURE_GROUP_OFFSET as _FEATURE_GROUP_OFFSET,
+    VARIANT_STANDARD as _VARIANT_STANDARD,
+    VARIANT_COLOR3 as _VARIANT_COLOR3,
+    VARIANT_COLOR5 as _VARIANT_COLOR5,
+    VARIANT_WIDE as _VARIANT_WIDE,
+    VARIANTS_NUM as _VARIANTS_NUM,
+    LAYOUT_NHWC as _LAYOUT_NHWC,
+    LAYOUT_NCHW as _LAYOUT_NCHW,
+    DTYPE_FLOAT32 as _DTYPE_FLOAT32,
+    DTYPE_FLOAT16 as _DTYPE_FLOAT16,
+    DTYPE_UINT8 as _DTYPE_UINT8,
+    DTYPE_BITS as _DTYPE_BITS,
+    PACK_BYTES as _PACK_BYTES,
+    LOG_HEADER_BYTES as _LOG_HEADER_BYTES,
+    LOG_RECORD_BYTES as _LOG_RECORD_BYTES,
+    LOG_VERSION as _LOG_VERSION,
 )
 
 
-def makeBoard() -> np.ndarray:
+def makeBoard(variant:int = _VARIANT_STANDARD) -> np.ndarray:
     """
     新しく空の盤面を作成する関数.
 
+    Args:
+        variant (int): ルールの種類 (VARIANT_STANDARD など). 盤面の大きさが決まる.
+
     Returns:
         np.ndarray: iint32 ndarray, shape = (ARRS_NUM, ROWS_NUM, COLS_NUM) = (2, 15, 8).
                     puyo面とstate面を含む. 内部はそれぞれ EMPTY, IDLE で初期化.
                     puyo面は実際の盤面, state面は連鎖の処理に使われる.
                     puyo面の外側は BLOCKになっているため, ぷよぷよの盤面本体は 14 x 6 配列.
+                    VARIANT_STANDARD 以外では shape = (2, rows, cols) (getRuleVariants を参照).
+    """
+    return _makeBoard(variant)
+
+def getRuleVariants() -> list[dict]:
     """
-    return _makeBoard()
+    ルールの種類の一覧を返す関数. i 番目が variant = i のルール.
+    種類ごとに色数と盤面の大きさを定数にした関数をコンパイル時に作ってあり,
+    putPuyo, fallPuyo, erasePuyo, chainAuto, isDead, makeBoard, cvtBoardForModel の variant で選ぶ.
 
-def cvtBoardForModel(board:np.ndarray) -> np.ndarray:
+    Returns:
+        list[dict]: name (名前), colors (色数), rows, cols (壁を含む盤面の大きさ), actions (行動の数).
+    """
+    keys = ("name", "colors", "rows", "cols", "actions")
+    return [dict(zip(keys, v)) for v in _getRuleVariants()]
+
+def cvtBoardForModel(board:np.ndarray, layout:int = _LAYOUT_NHWC, dtype:int = _DTYPE_FLOAT32, out=None,
+                     variant:int = _VARIANT_STANDARD) -> np.ndarray:
     """
     モデルに入力するために盤面を変換する関数.
 
     Args:
         board (np.ndarray): int32 ndarray, shape = (ARRS_NUM, ROWS_NUM, COLS_NUM) = (2, 15, 8).
+        layout (int): 並び. LAYOUT_NHWC または LAYOUT_NCHW.
+        dtype (int): 要素の型. DTYPE_FLOAT32, DTYPE_FLOAT16, DTYPE_UINT8, DTYPE_BITS のいずれか.
+        out: 書き込み先. bufferプロトコルに対応した書き込み可能で C 連続なオブジェクト
+             (ndarray, bytearray, memoryview など). 要素の型は dtype に合わせる.
+             None なら新しい ndarray を作成する.
+        variant (int): ルールの種類. board の shape は (2, rows, cols).
 
     Returns:
-        np.ndarray: float32 ndarray, shape = (1, ROWS_NUM-1, COLS_NUM-2, COLOR_NUM) = (1, 14, 6, 4).
+        np.ndarray: shape = (1, ROWS_NUM-1, COLS_NUM-2, COLOR_NUM) = (1, 14, 6, 4) (LAYOUT_NHWC)
+                    または (1, COLOR_NUM, ROWS_NUM-1, COLS_NUM-2) = (1, 4, 14, 6) (LAYOUT_NCHW).
+                    DTYPE_BITS のときは uint8 ndarray, shape = (1, 42).
                     one-hot(色数=4)でpuyo面をエンコード.
+                    VARIANT_STANDARD 以外では ROWS_NUM, COLS_NUM, COLOR_NUM をそのルールの rows, cols, colors に読み替える.
+                    out を指定した場合は out をそのまま返す.
     """
-    return _cvtBoardForModel(board)
+    return _cvtBoardForModel(board, layout, dtype, out, variant)
 
-def getAbleBoardsForModel(board:np.ndarray, parent_puyo:int, child_puyo:int) -> tuple[np.ndarray, np.ndarray]:
+def getAbleBoardsForModel(board:np.ndarray, parent_puyo:int, child_puyo:int,
+                          layout:int = _LAYOUT_NHWC, dtype:int = _DTYPE_FLOAT32) -> tuple[np.ndarray, np.ndarray]:
     """
     ぷよを設置できるすべての有効手を列挙し, 
     各手でぷよを設置した後の盤面をモデル入力に変換する関数.
@@ -58,17 +150,117 @@ def getAbleBoardsForModel(board:np.ndarray, parent_puyo:int, child_puyo:int) ->
         board (np.ndarray): 現在のboard.int32 ndarray, shape = (ARRS_NUM, ROWS_NUM, COLS_NUM) = (2, 15, 8).
         parent_puyo (int): 親ぷよの色ID (1..COLOR_NUM).
         child_puyo (int): 子ぷよの色ID (1..COLOR_NUM).
+        layout (int): 並び. LAYOUT_NHWC または LAYOUT_NCHW.
+        dtype (int): 要素の型. DTYPE_FLOAT32, DTYPE_FLOAT16, DTYPE_UINT8, DTYPE_BITS のいずれか.
 
     Returns:
         tuple[np.ndarray, np.ndarray]:
-            - result: float32 ndarray, shape = (K, ROWS_NUM-1, COLS_NUM-2, COLOR_NUM) = (K, 14, 6, 4).
-                      各有効手を打った後の盤面を one-hot で表現したテンソル.
+            - result: shape = (K, ROWS_NUM-1, COLS_NUM-2, COLOR_NUM) = (K, 14, 6, 4) (LAYOUT_NHWC の場合).
+                      各有効手を打った後の盤面を one-hot で表現したテンソル. 形と型は cvtBoardForModel と同じ.
             - able_actions: int ndarray, shape (K,).
                       各手のアクション番号 (0..21の22通り).
     """
-    return _getAbleBoardsForModel(board, parent_puyo, child_puyo)
+    return _getAbleBoardsForModel(board, parent_puyo, child_puyo, layout, dtype)
+
+def getAbleBoardsForModelInto(board:np.ndarray, parent_puyo:int, child_puyo:int, out, actions:np.ndarray,
+                              layout:int = _LAYOUT_NHWC, dtype:int = _DTYPE_FLOAT32) -> int:
+    """
+    getAbleBoardsForModel の結果を, 呼び出し側が用意したバッファに書き込む関数.
+    配列の確保を行わないので, 毎ステップ同じバッファを使い回せる.
+
+    Args:
+        board (np.ndarray): 現在のboard.int32 ndarray, shape = (ARRS_NUM, ROWS_NUM, COLS_NUM) = (2, 15, 8).
+        parent_puyo (int): 親ぷよの色ID (1..COLOR_NUM).
+        child_puyo (int): 子ぷよの色ID (1..COLOR_NUM).
+        out: 書き込み先. bufferプロトコルに対応した書き込み可能で C 連続なオブジェクト.
+             22 盤面分以上の大きさが必要. 既定では float32 ndarray, shape = (22, 14, 6, 4).
+             先頭の K 個に各有効手を打った後の盤面が書き込まれる.
+        actions (np.ndarray): 書き込み先. int32 ndarray, shape = (22,).
+                              先頭の K 個に各手のアクション番号 (0..21) が書き込まれる.
+        layout (int): 並び. LAYOUT_NHWC または LAYOUT_NCHW.
+        dtype (int): 要素の型. DTYPE_FLOAT32, DTYPE_FLOAT16, DTYPE_UINT8, DTYPE_BITS のいずれか.
+
+    Returns:
+        int: 有効手の数 K.
+    """
+    return _getAbleBoardsForModelInto(board, parent_puyo, child_puyo, out, actions, layout, dtype)
+
+def getAbleBoardsForModelBatch(boards:np.ndarray, parent_puyos:np.ndarray, child_puyos:np.ndarray, out, mask:np.ndarray,
+                               n_threads:int = 1, layout:int = _LAYOUT_NHWC, dtype:int = _DTYPE_FLOAT32) -> None:
+    """
+    N個の盤面について, 全22手それぞれを打った後の盤面をモデル入力に変換して書き込む関数.
+    処理中は GIL を解放する.
+
+    Args:
+        boards (np.ndarray): int32 ndarray, shape = (N, ARRS_NUM, ROWS_NUM, COLS_NUM) = (N, 2, 15, 8).
+        parent_puyos (np.ndarray): 親ぷよの色ID, shape = (N,).
+        child_puyos (np.ndarray): 子ぷよの色ID, shape = (N,).
+        out: 書き込み先. bufferプロトコルに対応した書き込み可能で C 連続なオブジェクト.
+             N*22 盤面分以上の大きさが必要. 既定では float32 ndarray, shape = (N, 22, 14, 6, 4).
+             out[i, a] にアクション番号 a を打った後の盤面が書き込まれる. 置けない手は 0 で埋められる.
+        mask (np.ndarray): 書き込み先. bool ndarray, shape = (N, 22). 置ける手なら True.
+        n_threads (int): 使用するスレッド数. 0 以下なら CPU 数.
+        layout (int): 並び. LAYOUT_NHWC または LAYOUT_NCHW.
+        dtype (int): 要素の型. DTYPE_FLOAT32, DTYPE_FLOAT16, DTYPE_UINT8, DTYPE_BITS のいずれか.
+    """
+    _getAbleBoardsForModelBatch(boards, parent_puyos, child_puyos, out, mask, n_threads, layout, dtype)
+
+def step(board, parent:int, child:int, action:int, next_parent:int, next_child:int,
+         out=None, mask:np.ndarray|None = None, layout:int = _LAYOUT_NHWC, dtype:int = _DTYPE_FLOAT32) -> tuple[bool, int, int, bool]:
+    """
+    強化学習の 1 ステップ (設置・連鎖・ゲームオーバー判定・次のツモの候補盤面の変換) を 1 回の呼び出しで行う関数.
+    putPuyo, chainAuto, isDead, getAbleBoardsForModel を順に呼ぶのと同じ結果になる. 処理中は GIL を解放する.
+
+    Args:
+        board (np.ndarray | Board): 盤面. その場で書き換えられる. 置けない手なら変更しない.
+        parent (int): 親ぷよの色ID (1..COLOR_NUM).
+        child (int): 子ぷよの色ID (1..COLOR_NUM).
+        action (int): アクション番号 (0..21).
+        next_parent (int): 次のツモの親ぷよの色ID.
+        next_child (int): 次のツモの子ぷよの色ID.
+        out: 書き込み先 (None なら書き込まない). bufferプロトコルに対応した書き込み可能で C 連続なオブジェクト.
+             22 盤面分以上の大きさが必要. 既定では float32 ndarray, shape = (22, 14, 6, 4).
+             out[a] に次のツモをアクション番号 a で置いた後の盤面が書き込まれる. 置けない手は 0 で埋められる.
+        mask (np.ndarray | None): 書き込み先. bool ndarray, shape = (22,). 次のツモで置ける手なら True.
+        layout (int): 並び. LAYOUT_NHWC または LAYOUT_NCHW.
+        dtype (int): 要素の型. DTYPE_FLOAT32, DTYPE_FLOAT16, DTYPE_UINT8, DTYPE_BITS のいずれか.
+
+    Returns:
+        tuple[bool, int, int, bool]: (置けたか, 連鎖数, スコア, ゲームオーバーか).
+    """
+    return _step(board, parent, child, action, next_parent, next_child, out, mask, layout, dtype)
+
+def makeMove(board, parent_puyo:int, child_puyo:int, col:int, rot:int) -> tuple[bool, int, int, bytes]:
+    """
+    ぷよを設置して連鎖を最後まで行い, 書き換えたマスの元の値を記録する関数.
+    記録を unmakeMove に渡すと, 盤面をコピーせずに元に戻せる (探索で同じ盤面を使い回せる).
+
+    Args:
+        board (np.ndarray | Board): 盤面. その場で書き換えられる. 置けない場合は変更しない.
+        parent_puyo (int): 親ぷよの色ID (1..COLOR_NUM).
+        child_puyo (int): 子ぷよの色ID (1..COLOR_NUM).
+        col (int): 軸ぷよの列 (1..6).
+        rot (int): 回転数.
+
+    Returns:
+        tuple[bool, int, int, bytes]: (置けたか, 連鎖数, スコア, 変更記録).
+            変更記録は 1 マスあたり 2 バイト (マスの番号, 元の値).
+    """
+    return _makeMove(board, parent_puyo, child_puyo, col, rot)
 
-def putPuyo(board:np.ndarray, parent_puyo:int, child_puyo:int, col:int, rot:int) -> bool:
+def unmakeMove(board, undo:bytes) -> None:
+    """
+    makeMove の変更記録を使って盤面を元に戻す関数.
+    複数手を進めた場合は, 進めたのと逆の順に戻すこと.
+
+    Args:
+        board (np.ndarray | Board): makeMove で進めた盤面.
+        undo (bytes): makeMove が返した変更記録.
+    """
+    _unmakeMove(board, undo)
+
+def putPuyo(board:np.ndarray, parent_puyo:int, child_puyo:int, col:int, rot:int,
+            variant:int = _VARIANT_STANDARD) -> bool:
     """
     指定した場所にぷよを設置する関数
     
@@ -78,62 +270,583 @@ def putPuyo(board:np.ndarray, parent_puyo:int, child_puyo:int, col:int, rot:int)
         child_puyo (int): 子ぷよの色ID.
         col (int): 列 (1-origin, 左右の壁を除く実列).
         rot (int): 回転 (0, 1, 2, 3).
+        variant (int): ルールの種類. board の shape は (2, rows, cols).
+                       ぷよは (cols-1)//2 列目から降ってきて, rows-3 段目が 12 段目にあたる.
 
     Returns:
         bool: 置けたら True. 置けない配置なら False.
               ぷよが置けるかどうかは「まわし」も考慮され, 「ぷよぷよ通」基準で判断される. 
     
     """
-    return _putPuyo(board, parent_puyo, child_puyo, col, rot)
+    return _putPuyo(board, parent_puyo, child_puyo, col, rot, variant)
 
-def fallPuyo(board:np.ndarray) -> int:
+def fallPuyo(board:np.ndarray, engine:int = _ENGINE_ARRAY, variant:int = _VARIANT_STANDARD) -> int:
     """
     ぷよを下に落とす関数.
 
     Args:
         board (np.ndarray): int32 ndarray, shape = (ARRS_NUM, ROWS_NUM, COLS_NUM) = (2, 15, 8).
+        engine (int): 使用するエンジン (ENGINE_ARRAY または ENGINE_BITBOARD).
+        variant (int): ルールの種類. ENGINE_BITBOARD は VARIANT_STANDARD でのみ使える.
 
     Returns:
         int: 最も落下したぷよの落下段数.
     """
-    return _fallPuyo(board)
+    return _fallPuyo(board, engine, variant)
 
-def erasePuyo(board:np.ndarray, chain_count:int) -> int:
+def erasePuyo(board:np.ndarray, chain_count:int, engine:int = _ENGINE_ARRAY, variant:int = _VARIANT_STANDARD) -> int:
     """
     4つ以上つながったぷよを消す関数.
 
     Args:
         board (np.ndarray): int32 ndarray, shape = (ARRS_NUM, ROWS_NUM, COLS_NUM) = (2, 15, 8).
         chain_count (int): この消去を行う前の連鎖数 (得点計算に使用).
+        engine (int): 使用するエンジン (ENGINE_ARRAY または ENGINE_BITBOARD).
+        variant (int): ルールの種類. ENGINE_BITBOARD は VARIANT_STANDARD でのみ使える.
 
     Returns:
         int: このステップで得られたスコア.
     """
-    return _erasePuyo(board, chain_count)
+    return _erasePuyo(board, chain_count, engine, variant)
 
-def chainAuto(board:np.ndarray) -> tuple[int, int]:
+def chainAuto(board:np.ndarray, engine:int = _ENGINE_ARRAY, variant:int = _VARIANT_STANDARD) -> tuple[int, int]:
     """
     連鎖を最後まで実行する関数.
 
     Args:
         board (np.ndarray): int32 ndarray, shape = (ARRS_NUM, ROWS_NUM, COLS_NUM) = (2, 15, 8).
+        engine (int): 使用するエンジン (ENGINE_ARRAY または ENGINE_BITBOARD).
+                      どちらのエンジンでも連鎖数・スコア・処理後の盤面は同じになる.
+        variant (int): ルールの種類. ENGINE_BITBOARD は VARIANT_STANDARD でのみ使える.
 
     Returns:
         tuple[int, int]: (連鎖数, スコア)
     """
-    return _chainAuto(board)
+    return _chainAuto(board, engine, variant)
 
-def isDead(board:np.ndarray) -> bool:
+def isDead(board:np.ndarray, variant:int = _VARIANT_STANDARD) -> bool:
     """
     ゲームオーバーになっているかを判定する関数.
 
     Args:
         board (np.ndarray): int32 ndarray, shape = (ARRS_NUM, ROWS_NUM, COLS_NUM) = (2, 15, 8).
+        variant (int): ルールの種類. board の shape は (2, rows, cols).
 
     Returns:
         bool: ゲームオーバーならTrue, そうでないならFalse.
     """
-    return _isDead(board)
+    return _isDead(board, variant)
+
+def legalActionMask(board) -> int:
+    """
+    置けるアクションを 22bit のマスクで返す関数. bit a が 1 ならアクション番号 a は置ける.
+    各列の 11~14 段目の埋まり方から表を引くだけなので, 22 手それぞれを判定するより速い.
+
+    Args:
+        board (np.ndarray | Board): int32 ndarray, shape = (ARRS_NUM, ROWS_NUM, COLS_NUM) = (2, 15, 8), または Board.
+
+    Returns:
+        int: 置けるアクションのマスク (ゲームオーバーなら 0).
+    """
+    return _legalActionMask(board)
+
+def legalActionMasks(boards:np.ndarray) -> np.ndarray:
+    """
+    N個の盤面について, 置けるアクションのマスクをまとめて求める関数.
+
+    Args:
+        boards (np.ndarray): int32 ndarray, shape = (N, ARRS_NUM, ROWS_NUM, COLS_NUM) = (N, 2, 15, 8).
+
+    Returns:
+        np.ndarray: uint32 ndarray, shape = (N,). 各盤面の 22bit のマスク.
+    """
+    return _legalActionMasks(boards)
+
+def stepBatch(boards:np.ndarray, parent_puyos:np.ndarray, child_puyos:np.ndarray, cols:np.ndarray, rots:np.ndarray,
+              n_threads:int = 1) -> tuple[np.ndarray, np.ndarray, np.ndarray, np.ndarray]:
+    """
+    N個の盤面に対して, ぷよの設置・連鎖・ゲームオーバー判定をまとめて行う関数.
+    処理中は GIL を解放する.
+
+    Args:
+        boards (np.ndarray): int32 ndarray, shape = (N, ARRS_NUM, ROWS_NUM, COLS_NUM) = (N, 2, 15, 8).
+                             その場で更新される.
+        parent_puyos (np.ndarray): 親ぷよの色ID, shape = (N,).
+        child_puyos (np.ndarray): 子ぷよの色ID, shape = (N,).
+        cols (np.ndarray): 列 (1-origin), shape = (N,).
+        rots (np.ndarray): 回転 (0, 1, 2, 3), shape = (N,).
+        n_threads (int): 使用するスレッド数. 0 以下なら CPU 数.
+
+    Returns:
+        tuple[np.ndarray, np.ndarray, np.ndarray, np.ndarray]:
+            - legal: bool ndarray, shape (N,). 置けたら True. 置けなかった盤面は変更されない.
+            - n_chains: int32 ndarray, shape (N,). 連鎖数.
+            - scores: int32 ndarray, shape (N,). スコア.
+            - dead: bool ndarray, shape (N,). 処理後にゲームオーバーなら True.
+    """
+    return _stepBatch(boards, parent_puyos, child_puyos, cols, rots, n_threads)
+
+def evaluateActions(board, parent_puyo:int, child_puyo:int) -> tuple[np.ndarray, np.ndarray, np.ndarray, np.ndarray, np.ndarray]:
+    """
+    全 22 手それぞれについて, 盤面のコピーにぷよを置いて連鎖を最後まで行った結果を返す関数. 盤面は変更しない.
+    Python 側で盤面を 22 回コピーして putPuyo と chainAuto を呼ぶ代わりに使える.
+
+    Args:
+        board (np.ndarray | Board): int32 ndarray, shape = (ARRS_NUM, ROWS_NUM, COLS_NUM) = (2, 15, 8), または Board.
+        parent_puyo (int): 親ぷよの色ID (1..COLOR_NUM).
+        child_puyo (int): 子ぷよの色ID (1..COLOR_NUM).
+
+    Returns:
+        tuple[np.ndarray, np.ndarray, np.ndarray, np.ndarray, np.ndarray]:
+            legal (bool, shape = (22,)): 置ける手なら True.
+            n_chains (int32, shape = (22,)): 連鎖数.
+            scores (int32, shape = (22,)): スコア.
+            heights (int32, shape = (22, 6)): 連鎖後の各列の高さ (最も上にあるぷよの段. 空なら 0).
+            dead (bool, shape = (22,)): 連鎖後にゲームオーバーか.
+            置けない手はすべて 0 (False).
+    """
+    return _evaluateActions(board, parent_puyo, child_puyo)
+
+def evaluateActionsBatch(boards:np.ndarray, parent_puyos:np.ndarray, child_puyos:np.ndarray,
+                         n_threads:int = 1) -> tuple[np.ndarray, np.ndarray, np.ndarray, np.ndarray, np.ndarray]:
+    """
+    N個の盤面について evaluateActions をまとめて行う関数. 処理中は GIL を解放する.
+
+    Args:
+        boards (np.ndarray): int32 ndarray, shape = (N, ARRS_NUM, ROWS_NUM, COLS_NUM) = (N, 2, 15, 8).
+        parent_puyos (np.ndarray): 親ぷよの色ID, shape = (N,).
+        child_puyos (np.ndarray): 子ぷよの色ID, shape = (N,).
+        n_threads (int): 使用するスレッド数. 0 以下なら CPU 数.
+
+    Returns:
+        tuple[np.ndarray, np.ndarray, np.ndarray, np.ndarray, np.ndarray]:
+            evaluateActions の結果に先頭の次元 N が付いたもの.
+            (legal (N, 22), n_chains (N, 22), scores (N, 22), heights (N, 22, 6), dead (N, 22)).
+    """
+    return _evaluateActionsBatch(boards, parent_puyos, child_puyos, n_threads)
+
+def chainFeatures(board, out=None) -> np.ndarray:
+    """
+    盤面の連鎖の種の特徴量 (FEATURES_NUM = 114 個) を返す関数. 盤面は変更しない. 処理中は GIL を解放する.
+    各列に各色のぷよを 1 個・2 個落としたときの連鎖を, Python 側で盤面をコピーして putPuyo と chainAuto を
+    48 回呼ぶ代わりに使える. 落としたぷよが 4 個以上つながらない場合は連鎖を実行せずに 0 とする.
+
+    特徴量の並び (値はすべて数えたままで, 正規化しない):
+        [0, FEATURE_HEIGHT_OFFSET): 列 j (0..5)・色 c (0..3)・落とす数 k (0: 1 個, 1: 2 個) ごとの (連鎖数, スコア).
+            番号は ((j * COLOR_NUM + c) * FEATURE_DROPS + k) * 2. 落としたぷよが 12 段目に収まらない場合は 0.
+        [FEATURE_HEIGHT_OFFSET, FEATURE_CONNECT_OFFSET): 各列の高さ (最も上にあるぷよの段. 空なら 0).
+        [FEATURE_CONNECT_OFFSET, FEATURE_GROUP_OFFSET): 色ごとの, 上下左右に隣り合う同色ぷよの組の数 (12 段目まで).
+        [FEATURE_GROUP_OFFSET, FEATURES_NUM): 色ごとの (2 個のグループの数, 3 個のグループの数) (12 段目まで).
+
+    Args:
+        board (np.ndarray | Board): int32 ndarray, shape = (ARRS_NUM, ROWS_NUM, COLS_NUM) = (2, 15, 8), または Board.
+        out (np.ndarray | None): 書き込み先. float32, shape (FEATURES_NUM,), C 連続.
+
+    Returns:
+        np.ndarray: float32, shape (FEATURES_NUM,).
+    """
+    return _chainFeatures(board, out)
+
+def chainFeaturesBatch(boards:np.ndarray, out=None, n_threads:int = 1) -> np.ndarray:
+    """
+    N個の盤面について chainFeatures をまとめて行う関数. 処理中は GIL を解放する.
+
+    Args:
+        boards (np.ndarray): int32 ndarray, shape = (N, ARRS_NUM, ROWS_NUM, COLS_NUM) = (N, 2, 15, 8).
+        out (np.ndarray | None): 書き込み先. float32, shape (N, FEATURES_NUM), C 連続.
+        n_threads (int): 使用するスレッド数. 0 以下なら CPU 数.
+
+    Returns:
+        np.ndarray: float32, shape (N, FEATURES_NUM).
+    """
+    return _chainFeaturesBatch(boards, out, n_threads)
+
+def searchActions(board:np.ndarray, pairs:np.ndarray, depth:int = -1, n_threads:int = 1) -> tuple[np.ndarray, np.ndarray, np.ndarray]:
+    """
+    最初の一手 (アクション番号 0..21) ごとに, 続くツモを depth 手先まで置いたときの
+    最大スコア・最大連鎖数・最善の次の手を求める関数. board は変更しない.
+    最初の一手ごとにスレッドに分担し, 処理中は GIL を解放する.
+
+    Args:
+        board (np.ndarray): int32 ndarray, shape = (ARRS_NUM, ROWS_NUM, COLS_NUM) = (2, 15, 8).
+        pairs (np.ndarray): ツモ列. int ndarray, shape = (D, 2). pairs[k] = (親ぷよ, 子ぷよ) が k 手目のツモ.
+                            色は 1..COLOR_NUM.
+        depth (int): 探索する手数 (1..D, 最大 4). 負なら D.
+                     全ての手順 (22^depth 通り) を調べるので, 1 手深くするごとに約 22 倍の時間がかかる.
+                     より深く読むときは beamSearch を使う.
+        n_threads (int): 使用するスレッド数. 0 以下なら CPU 数.
+
+    Returns:
+        tuple[np.ndarray, np.ndarray, np.ndarray]: いずれも int32 ndarray, shape (22,). 置けない手は -1.
+            - scores: 経路上のスコアの合計の最大値.
+            - chains: 経路上で起きた連鎖数の最大値.
+            - next_actions: 最大スコアとなる 2 手目のアクション番号. depth = 1 や 2 手目が置けない場合は -1.
+    """
+    return _searchActions(board, pairs, depth, n_threads)
+
+_BEAM_WEIGHTS = {"score": 1.0, "chain": 0.0, "connect": 0.0, "bumpiness": 0.0, "death": 0.0}
+
+def beamSearch(board, pairs, depth:int = -1, width:int = 64, weights:dict|None = None, seed:int = 0,
+               n_threads:int = 1) -> tuple[int, np.ndarray, int, float, int, int]:
+    """
+    ビームサーチで最初の一手を選ぶ関数. board は変更しない.
+    各深さで, ビームの全ノードの置ける手を全て試し, 窒息していない子から評価値の高い順に width 個を残す.
+    pairs より先のツモは seed から一様ランダムに決める. ノードの展開はスレッドに分担し, 処理中は GIL を解放する.
+    同じ引数なら結果はスレッド数によらない.
+
+    評価値は次の特徴量に weights の重みを掛けた和.
+        - score: 経路上で得たスコアの合計.
+        - chain: ぷよを 1 個置いたときに起こせる最大連鎖数 (重みが 0 なら計算しない).
+        - connect: 上下左右に隣り合う同色ぷよの組の数.
+        - bumpiness: 隣り合う列の高さの差の合計.
+        - death: 置けない手の数.
+
+    Args:
+        board (np.ndarray | Board): 盤面. shape = (ARRS_NUM, ROWS_NUM, COLS_NUM) = (2, 15, 8).
+        pairs (np.ndarray): 既知のツモ列. int ndarray, shape = (K, 2). K = 0 でもよい.
+        depth (int): 探索する手数 (1..32). 負なら K.
+        width (int): ビーム幅 (1..1024).
+        weights (dict | None): 重み. 指定しないキーは score = 1, それ以外 = 0.
+        seed (int): K 手目より先のツモを決める乱数のシード.
+        n_threads (int): 使用するスレッド数. 0 以下なら CPU 数.
+
+    Returns:
+        tuple[int, np.ndarray, int, float, int, int]:
+            - action: 選んだ最初の手. 置ける手がなければ -1.
+            - pv: 最善ノードまでの手順. int32 ndarray. 途中で全て窒息した場合は depth より短い.
+            - nodes: 生成した子ノードの数.
+            - value: 最善ノードの評価値.
+            - score: 最善ノードまでのスコアの合計.
+            - max_chain: 最善ノードまでの最大連鎖数.
+    """
+    w = dict(_BEAM_WEIGHTS)
+    if weights is not None:
+        for key in weights:
+            if key not in w:
+                raise KeyError(f"unknown weight: {key}")
+        w.update(weights)
+    weight_tuple = (w["score"], w["chain"], w["connect"], w["bumpiness"], w["death"])
+    return _beamSearch(board, pairs, depth, width, weight_tuple, seed, n_threads)
+
+def rollout(board:np.ndarray, seed:int, n_rollouts:int, horizon:int, policy:int = _POLICY_RANDOM,
+            n_threads:int = 1) -> dict[str, float]:
+    """
+    盤面からランダムなツモでロールアウトを行い, スコアと最大連鎖数の統計を返す関数. board は変更しない.
+    ツモは generateTsumo と同じ 128 組周期のツモ列の先頭から使う. ゲームオーバーになるか horizon 手置くまで続ける.
+    i 回目のロールアウトは seed と i から決まる乱数系列を使うので, 結果はスレッド数によらず再現できる.
+    ロールアウトはスレッドに分担し, 処理中は GIL を解放する.
+
+    Args:
+        board (np.ndarray): int32 ndarray, shape = (ARRS_NUM, ROWS_NUM, COLS_NUM) = (2, 15, 8).
+        seed (int): 乱数のシード (0..2**64-1).
+        n_rollouts (int): ロールアウトの回数.
+        horizon (int): 1 回のロールアウトで置く最大の手数.
+        policy (int): 方策. POLICY_RANDOM (置ける手から一様ランダム) または
+                      POLICY_GREEDY (その手で得られるスコアが最大の手. 同点はランダム).
+        n_threads (int): 使用するスレッド数. 0 以下なら CPU 数.
+
+    Returns:
+        dict[str, float]:
+            - n_rollouts: ロールアウトの回数.
+            - score_mean, score_std, score_max: 合計スコアの平均, 標準偏差, 最大値.
+            - score_p10, score_p25, score_p50, score_p75, score_p90: 合計スコアのパーセンタイル.
+            - chain_mean, chain_max, chain_p10, ..., chain_p90: 最大連鎖数の統計.
+            - dead_rate: ゲームオーバーで終わった割合.
+            - turns_mean: 置いた手数の平均.
+    """
+    return _rollout(board, seed, n_rollouts, horizon, policy, n_threads)
+
+def versusStep(boards:np.ndarray, pending:np.ndarray, carry:np.ndarray, parent_puyos:np.ndarray, child_puyos:np.ndarray,
+               actions:np.ndarray, seed:int, max_drop:int = _OJAMA_MAX_DROP) -> tuple[tuple[bool, bool], tuple[int, int], tuple[int, int], tuple[int, int], tuple[int, int], tuple[bool, bool]]:
+    """
+    2人対戦を1手進める関数.
+    各プレイヤーがぷよを置いて連鎖し, スコアをおじゃまぷよ (OJAMA_RATE 点で 1 個, 余りは繰り越し) に変換する.
+    発生したおじゃまぷよは自分に降る予定のおじゃまぷよと相殺し, 残りを相手に送る.
+    その手で連鎖しなかったプレイヤーには, 降る予定のおじゃまぷよが最大 max_drop 個降る
+    (6 個ごとに 1 段, 余りはランダムな別々の列).
+
+    Args:
+        boards (np.ndarray): int32 ndarray, shape = (2, ARRS_NUM, ROWS_NUM, COLS_NUM) = (2, 2, 15, 8). その場で更新される.
+        pending (np.ndarray): int32 ndarray, shape = (2,). 各プレイヤーに降る予定のおじゃまぷよの数. その場で更新される.
+        carry (np.ndarray): int32 ndarray, shape = (2,). 各プレイヤーの繰り越しスコア. その場で更新される.
+        parent_puyos (np.ndarray): 親ぷよの色ID (1..COLOR_NUM), shape = (2,).
+        child_puyos (np.ndarray): 子ぷよの色ID (1..COLOR_NUM), shape = (2,).
+        actions (np.ndarray): アクション番号 (0..21), shape = (2,). 置けない手ならぷよを置かない.
+        seed (int): おじゃまぷよを降らせる列を決める乱数のシード.
+        max_drop (int): 1 手で降るおじゃまぷよの最大数 (0 以上).
+
+    Returns:
+        tuple: 各要素がプレイヤー 0, 1 の値のタプル.
+            - legal: 置けたら True.
+            - n_chains: 連鎖数.
+            - scores: スコア.
+            - sent: 相殺後に相手に送ったおじゃまぷよの数.
+            - dropped: 自分に降ったおじゃまぷよの数.
+            - dead: ゲームオーバーなら True.
+    """
+    return _versusStep(boards, pending, carry, parent_puyos, child_puyos, actions, seed, max_drop)
+
+def playVersus(seed:int, n_games:int, max_turns:int, policy0:int = _POLICY_GREEDY, policy1:int = _POLICY_GREEDY,
+               n_threads:int = 1) -> tuple[np.ndarray, np.ndarray, np.ndarray, np.ndarray]:
+    """
+    組み込みの方策どうしの対戦を最後までまとめて行う関数.
+    両プレイヤーには同じ 128 組周期のツモ列 (generateTsumo と同じ作り方) が配られ, versusStep と同じ規則で進む.
+    対戦はスレッドに分担し, 処理中は GIL を解放する. 結果は seed で決まり, スレッド数によらない.
+
+    Args:
+        seed (int): 乱数のシード.
+        n_games (int): 対戦の回数.
+        max_turns (int): 1 回の対戦の最大手数. 超えたら引き分け.
+        policy0 (int): プレイヤー 0 の方策 (POLICY_RANDOM または POLICY_GREEDY).
+        policy1 (int): プレイヤー 1 の方策.
+        n_threads (int): 使用するスレッド数. 0 以下なら CPU 数.
+
+    Returns:
+        tuple[np.ndarray, np.ndarray, np.ndarray, np.ndarray]:
+            - winners: int32 ndarray, shape (n_games,). 勝ったプレイヤー (0, 1). 引き分けは -1.
+            - turns: int32 ndarray, shape (n_games,). 手数.
+            - scores: int32 ndarray, shape (n_games, 2). 各プレイヤーの合計スコア.
+            - max_chains: int32 ndarray, shape (n_games, 2). 各プレイヤーの最大連鎖数.
+    """
+    return _playVersus(seed, n_games, max_turns, policy0, policy1, n_threads)
+
+def generateTsumo(seed:int, n:int, length:int, start:int = 0, stream:int = 0, out=None,
+                  n_threads:int = 1) -> np.ndarray:
+    """
+    N 個の環境のツモ列をまとめて作る関数.
+    ツモ列は各色を同じ数ずつ並べた 256 個のぷよをシャッフルしたもので, TSUMO_CYCLE (128) 組ごとに同じ並びを繰り返す.
+    最初の 2 組は高々 3 色になる.
+    i 番目のツモ列は seed と stream + i から決まるので, 環境を別のプロセスに分けても stream をずらせば同じツモ列になる.
+    処理中は GIL を解放する.
+
+    Args:
+        seed (int): 乱数のシード (0..2**64-1).
+        n (int): ツモ列の数.
+        length (int): 各ツモ列から取り出す組数.
+        start (int): 取り出す最初の組の番号 (0 始まり). 続きのツモが欲しいときに使う.
+        stream (int): 最初のツモ列の系列番号.
+        out (np.ndarray | None): 書き込み先. int32, shape (n, length, 2), C 連続.
+        n_threads (int): 使用するスレッド数. 0 以下なら CPU 数.
+
+    Returns:
+        np.ndarray: int32, shape (n, length, 2). [i, t] は i 番目のツモ列の start + t 組目の (親ぷよ, 子ぷよ) の色 (1..COLOR_NUM).
+    """
+    return _generateTsumo(seed, n, length, start, stream, out, n_threads)
+
+def hashBoard(board:np.ndarray) -> int:
+    """
+    puyo面の 64bit Zobrist ハッシュを求める関数.
+    キーは固定シードで生成されるため, どのプロセスでも同じ盤面は同じ値になる.
+
+    Args:
+        board (np.ndarray): int32 ndarray, shape = (ARRS_NUM, ROWS_NUM, COLS_NUM) = (2, 15, 8).
+
+    Returns:
+        int: ハッシュ値 (0..2**64-1). 空の盤面は 0.
+    """
+    return _hashBoard(board)
+
+def chainAutoCached(board:np.ndarray) -> tuple[int, int]:
+    """
+    置換表を使って連鎖を最後まで実行する関数.
+    同じ盤面の連鎖結果が置換表にあれば, 連鎖を実行せずに結果の盤面を書き込む.
+    置換表が無効 (サイズ 0) のときは chainAuto と同じ.
+
+    Args:
+        board (np.ndarray): int32 ndarray, shape = (ARRS_NUM, ROWS_NUM, COLS_NUM) = (2, 15, 8).
+
+    Returns:
+        tuple[int, int]: (連鎖数, スコア)
+    """
+    return _chainAutoCached(board)
+
+def probeCache(board:np.ndarray) -> tuple[int, int] | None:
+    """
+    盤面の連鎖結果が置換表にあれば返す関数. board は変更しない.
+
+    Args:
+        board (np.ndarray): int32 ndarray, shape = (ARRS_NUM, ROWS_NUM, COLS_NUM) = (2, 15, 8).
+
+    Returns:
+        tuple[int, int] | None: (連鎖数, スコア). 置換表になければ None.
+    """
+    return _probeCache(board)
+
+def setCacheSize(n_entries:int) -> None:
+    """
+    置換表の大きさを設定する関数. 置換表の中身と統計は消える.
+    置換表は searchActions や chainAutoCached などのすべてのスレッドで共有される.
+
+    Args:
+        n_entries (int): エントリ数. 2 の累乗に切り下げられる (最小 64). 0 なら置換表を無効にする (初期状態).
+                         1 エントリあたり約 220 バイト.
+    """
+    _setCacheSize(n_entries)
+
+def clearCache() -> None:
+    """
+    置換表の中身とヒット数などの統計を消す関数.
+    """
+    _clearCache()
+
+def getCacheStats() -> dict[str, int]:
+    """
+    置換表の統計を返す関数.
+
+    Returns:
+        dict[str, int]: size (エントリ数), hits (ヒット数), misses (ミス数), stores (登録数).
+    """
+    return _getCacheStats()
+
+def getStats(reset:bool=False) -> dict:
+    """
+    C 本体 (puyo_func.c) のホットパスの計測値を全スレッド分合計して返す関数.
+    環境変数 PUYO_STATS=1 (サイクル数も測るなら 2) を付けてビルドしたときだけ値が入る.
+    それ以外のビルドでは計測コードが入らず, 値はすべて 0 になる.
+
+    Args:
+        reset (bool): True なら読み取った後に計測値を 0 に戻す. 計測中のスレッドがないときに呼ぶこと.
+
+    Returns:
+        dict: enabled, timers (計測の有無), clock (サイクル数の単位. "rdtsc" か "ns". タイマーが無効なら None),
+              canput_calls, canput_rejects, seed_calls, seed_fails (isLinkingSeed の呼び出し・失敗回数),
+              erase_visited (eraseLinkingPuyos が訪れたマス数), fall_calls, fall_moved (落下したぷよの数),
+              one_chain_calls, all_chain_calls,
+              chain_hist (ビットボード版を含む連鎖処理の連鎖数の分布. 最後のビンは 19 連鎖以上), fall_hist (ぷよ 1 個の落下段数の分布),
+              cycles (canPut, fallPuyos, oneChain, allChain の累計. 入れ子の呼び出し分を含む).
+    """
+    return _getStats(reset)
+
+def getSimdInfo() -> dict:
+    """
+    盤面の one-hot 変換 (toBoardForModel, NCHW の float32) とビットボードへの変換に使っている SIMD 命令セットを返す関数.
+    import 時に CPUID で実行中の CPU を調べ, 使える中で最も新しいものが選ばれる.
+    環境変数 PUYO_SIMD (scalar, sse2, avx2, avx512) を付けて import すると, それより新しいものは使わない.
+
+    Returns:
+        dict: level (使っている命令セット), supported (この CPU で使える命令セットのリスト).
+    """
+    return _getSimdInfo()
+
+def setSimdLevel(level:str) -> str:
+    """
+    使う SIMD 命令セットを level 以下で使える最も新しいものに切り替える関数. 結果はどれを使っても同じ.
+    他のスレッドが盤面を処理している間に呼んでもよい (処理中の呼び出しは切り替える前の命令セットで終わる).
+
+    Args:
+        level (str): "scalar", "sse2", "avx2", "avx512" のいずれか.
+
+    Returns:
+        str: 実際に選ばれた命令セット.
+    """
+    return _setSimdLevel(level)
+
+def augmentColors(x:np.ndarray, perms=None, actions=None, pairs=None, out=None, layout:int = _LAYOUT_NHWC,
+                  n_threads:int = 1) -> tuple[np.ndarray, np.ndarray|None, np.ndarray|None]:
+    """
+    盤面の束またはモデル入力の束を, 色を並べ替えた全ての組み合わせに増やす関数. 処理中は GIL を解放する.
+    並べ替え perms[p] では色 c (1..4) が perms[p][c-1] + 1 になる. EMPTY, OJAMA, 壁はそのまま.
+    行動番号は色によらないのでそのまま写し, ツモなどの色は同じ並べ替えで書き換える.
+
+    Args:
+        x (np.ndarray): int32 の盤面 (N, 2, 15, 8), または encodeBoard の出力を N 個並べたもの
+            (float32 / float16 / uint8 の (N, 14, 6, 4) か (N, 4, 14, 6), ビット詰めなら uint8 の (N, 42)).
+        perms (np.ndarray | None): int ndarray, shape = (P, 4). 各行は 0..3 の並べ替え.
+            None なら 24 通り全て (itertools.permutations(range(4)) と同じ順. 先頭は恒等置換).
+        actions (np.ndarray | None): 行動番号. shape = (N,).
+        pairs (np.ndarray | None): ツモなどの色. shape = (N, ...). 例えば (N, 2) や (N, K, 2).
+        out (np.ndarray | None): 書き込み先. x と同じ dtype で shape = (N, P, ...). None なら新しく作る.
+        layout (int): x がモデル入力のときの並び (LAYOUT_NHWC か LAYOUT_NCHW).
+        n_threads (int): 使用するスレッド数. 0 以下なら CPU 数.
+
+    Returns:
+        tuple[np.ndarray, np.ndarray | None, np.ndarray | None]:
+            - out: shape = (N, P, ...). out[k, p] が x[k] を perms[p] で並べ替えたもの.
+            - actions: int32 ndarray, shape = (N, P). actions を指定しなければ None.
+            - pairs: int32 ndarray, shape = (N, P, ...). pairs を指定しなければ None.
+    """
+    return _augmentColors(x, perms, actions, pairs, out, layout, n_threads)
+
+def packBoards(boards:np.ndarray) -> np.ndarray:
+    """
+    N個の盤面の puyo面を 1 盤面 32 バイトに詰める関数. STATE面は保存しない.
+    1 マスを 3bit (EMPTY=0, 色=1..4, OJAMA=5, BLOCK=6) で表し, 21 マスずつ 64bit 語に詰めてリトルエンディアンで並べる.
+
+    Args:
+        boards (np.ndarray): int32 ndarray, shape = (N, 2, 15, 8).
+
+    Returns:
+        np.ndarray: uint8 ndarray, shape = (N, PACK_BYTES) = (N, 32).
+    """
+    return _packBoards(boards)
+
+def unpackBoards(packed:np.ndarray) -> np.ndarray:
+    """
+    packBoards で詰めた盤面を元に戻す関数. STATE面は IDLE になる.
+
+    Args:
+        packed (np.ndarray): uint8 ndarray, shape = (N, 32). openGameLog で開いたログの "board" 列も渡せる.
+
+    Returns:
+        np.ndarray: int32 ndarray, shape = (N, 2, 15, 8).
+    """
+    return _unpackBoards(packed)
+
+GAME_LOG_DTYPE = np.dtype([
+    ("board", np.uint8, (_PACK_BYTES,)),
+    ("parent", np.uint8),
+    ("child", np.uint8),
+    ("action", np.uint8),
+    ("n_chains", np.uint8),
+    ("score", "<i4"),
+])
+"""対局ログの 1 レコード (40 バイト) を表す numpy の構造化 dtype. """
+
+def appendGameLog(path:str, boards:np.ndarray, parent_puyos:np.ndarray, child_puyos:np.ndarray, actions:np.ndarray,
+                  scores:np.ndarray, chains:np.ndarray | None = None) -> int:
+    """
+    対局ログのファイルに N 個のレコード (盤面, ツモ, 行動, 連鎖数, スコア) を追記する関数.
+    ファイルがなければ作成する. 処理中は GIL を解放する.
+    追記の間はファイルをロックするので, 複数のプロセスやスレッドから同じファイルに追記してよい.
+
+    Args:
+        path (str): ログファイルのパス.
+        boards (np.ndarray): ツモを置く前の盤面. int32 ndarray, shape = (N, 2, 15, 8).
+        parent_puyos (np.ndarray): 親ぷよの色ID (1..COLOR_NUM), shape = (N,).
+        child_puyos (np.ndarray): 子ぷよの色ID (1..COLOR_NUM), shape = (N,).
+        actions (np.ndarray): アクション番号 (0..21), shape = (N,).
+        scores (np.ndarray): スコア, shape = (N,).
+        chains (np.ndarray | None): 連鎖数 (0..255), shape = (N,). None なら 0.
+            範囲外の値があれば ValueError になり, 何も書き込まない.
+
+    Returns:
+        int: 追記後のレコード数.
+    """
+    return _appendGameLog(path, boards, parent_puyos, child_puyos, actions, scores, chains)
+
+def openGameLog(path:str, mode:str = "r") -> np.ndarray:
+    """
+    対局ログのファイルをメモリマップで開く関数. ファイル全体を読み込まずに参照できる.
+    盤面は unpackBoards(log["board"][i:j]) で元に戻せる.
+
+    Args:
+        path (str): ログファイルのパス.
+        mode (str): np.memmap のモード ("r" または "r+").
+
+    Returns:
+        np.ndarray: GAME_LOG_DTYPE の np.memmap, shape = (レコード数,).
+                    末尾に途中までしか書かれていないレコードがあれば含めない.
+    """
+    header = np.fromfile(path, dtype="<u4", count=_LOG_HEADER_BYTES // 4)
+    if (len(header) < 8 or header[:2].tobytes() != b"PUYOLOG\0" or header[2] != _LOG_VERSION
+            or header[3] != _LOG_RECORD_BYTES or header[4] != _LOG_HEADER_BYTES
+            or tuple(header[5:8]) != (_ROWS_NUM, _COLS_NUM, _COLOR_NUM)):
+        raise ValueError(f"{path} is not a compatible game log")
+    size = os.path.getsize(path)
+    n = (size - _LOG_HEADER_BYTES) // _LOG_RECORD_BYTES
+    if n == 0:
+        return np.zeros(0, dtype=GAME_LOG_DTYPE)
+    return np.memmap(path, dtype=GAME_LOG_DTYPE, mode=mode, offset=_LOG_HEADER_BYTES, shape=(n,))
 
 # ---- 定数 (説明付きラッパー)  ----
 class _Const(int):
@@ -144,6 +857,209 @@ class _Const(int):
         return obj
 
 
+class Board(_Board):
+    """
+    盤面を内部に直接持つオブジェクト. ndarray の確認を毎回行わないので, 1 手ずつ進める処理が速い.
+    呼び出しを軽くするため, メソッドは C のものをそのまま使う (位置引数のみ).
+
+    Args:
+        board (np.ndarray | Board | None): コピー元の盤面. None なら空の盤面を作る.
+
+    Methods:
+        put(parent, child, col, rot) -> bool: ぷよを設置する. 置けなければ False を返し, 盤面は変わらない.
+        fall(engine=ENGINE_ARRAY) -> int: 落下処理を行い, 落下した最大段数を返す.
+        erase(chain_count, engine=ENGINE_ARRAY) -> int: chain_count 連鎖目として 4 つ以上繋がったぷよを消し, スコアを返す.
+        chain(engine=ENGINE_ARRAY) -> tuple[int, int]: 連鎖が終わるまで処理し, (連鎖数, スコア) を返す.
+        is_dead() -> bool: ゲームオーバー状態かを返す.
+        make(parent, child, col, rot) -> tuple[bool, int, int, bytes]: makeMove と同じ. 設置と連鎖を行い変更記録を返す.
+        unmake(undo) -> None: unmakeMove と同じ. 変更記録で盤面を元に戻す.
+        copy() -> Board: 盤面をコピーする.
+        encode(layout=LAYOUT_NHWC, dtype=DTYPE_FLOAT32, out=None) -> np.ndarray: cvtBoardForModel と同じ変換を行う.
+
+    Attributes:
+        array (np.ndarray): int32 ndarray, shape = (2, 15, 8). 盤面をそのまま指す (書き込むと盤面も変わる).
+                            np.asarray(board) でも同じ配列が得られるので, 既存の関数にもそのまま渡せる.
+    """
+
+
+class ReplayBuffer(_ReplayBuffer):
+    """
+    優先度付き経験再生のバッファ.
+    遷移 (board, action, reward, next_board, done) を保存し, 優先度^alpha に比例してサンプリングする.
+    盤面は 1 マス 3bit (1盤面 32 バイト) に詰めて保存するので, (2, 15, 8) の int32 のままより約 30 倍小さい.
+    STATE面は保存しない.
+
+    Args:
+        capacity (int): 保存できる遷移の数. 満杯になると古い遷移から上書きする.
+        alpha (float): 優先度の指数. 0 なら一様サンプリング.
+        seed (int): サンプリングに使う乱数のシード.
+    """
+
+    def __init__(self, capacity:int, alpha:float = 0.6, seed:int = 0):
+        super().__init__(capacity, alpha, seed)
+
+    def add(self, board:np.ndarray, action:int, reward:float, next_board:np.ndarray, done:bool,
+            priority:float | None = None) -> int:
+        """
+        遷移を1つ追加する関数.
+
+        Args:
+            board (np.ndarray): int32 ndarray, shape = (2, 15, 8).
+            action (int): アクション番号.
+            reward (float): 報酬.
+            next_board (np.ndarray): 次の盤面. int32 ndarray, shape = (2, 15, 8).
+            done (bool): エピソードが終了したか.
+            priority (float | None): 優先度 (alpha 乗する前の値). None なら今までの最大の優先度.
+
+        Returns:
+            int: 書き込んだ位置.
+        """
+        return super().add(board, action, reward, next_board, done, -1.0 if priority is None else priority)
+
+    def addBatch(self, boards:np.ndarray, actions:np.ndarray, rewards:np.ndarray, next_boards:np.ndarray, dones:np.ndarray,
+                 priorities:np.ndarray | None = None) -> None:
+        """
+        N個の遷移をまとめて追加する関数.
+
+        Args:
+            boards (np.ndarray): int32 ndarray, shape = (N, 2, 15, 8).
+            actions (np.ndarray): shape = (N,).
+            rewards (np.ndarray): shape = (N,).
+            next_boards (np.ndarray): int32 ndarray, shape = (N, 2, 15, 8).
+            dones (np.ndarray): shape = (N,).
+            priorities (np.ndarray | None): shape = (N,). None なら今までの最大の優先度.
+        """
+        super().addBatch(boards, actions, rewards, next_boards, dones, priorities)
+
+    def sample(self, batch_size:int, beta:float = 0.4, layout:int = _LAYOUT_NHWC, dtype:int = _DTYPE_FLOAT32) -> tuple:
+        """
+        優先度に比例して遷移を取り出す関数 (層化サンプリング).
+        盤面は cvtBoardForModel と同じ形式に変換して1つの配列にまとめて返す.
+
+        Args:
+            batch_size (int): 取り出す数 B.
+            beta (float): 重要度重みの指数.
+            layout (int): 盤面の並び. LAYOUT_NHWC または LAYOUT_NCHW.
+            dtype (int): 盤面の型. DTYPE_FLOAT32, DTYPE_FLOAT16, DTYPE_UINT8, DTYPE_BITS のいずれか.
+
+        Returns:
+            tuple:
+                - x: shape = (B, 14, 6, 4) (LAYOUT_NHWC の場合). board を変換したもの.
+                - actions: int32 ndarray, shape = (B,).
+                - rewards: float32 ndarray, shape = (B,).
+                - next_x: next_board を変換したもの. 形は x と同じ.
+                - dones: bool ndarray, shape = (B,).
+                - indices: int32 ndarray, shape = (B,). updatePriorities に渡す位置.
+                - weights: float32 ndarray, shape = (B,). 重要度重み (B 個の中の最大値が 1).
+        """
+        return super().sample(batch_size, beta, layout, dtype)
+
+    def updatePriorities(self, indices:np.ndarray, priorities:np.ndarray) -> None:
+        """
+        遷移の優先度を更新する関数.
+
+        Args:
+            indices (np.ndarray): sample で得た位置, shape = (B,).
+            priorities (np.ndarray): 新しい優先度 (alpha 乗する前の値, 0 以上), shape = (B,).
+        """
+        super().updatePriorities(indices, priorities)
+
+    def getBoards(self, indices:np.ndarray) -> tuple[np.ndarray, np.ndarray]:
+        """
+        保存した盤面を取り出す関数.
+
+        Args:
+            indices (np.ndarray): 位置, shape = (N,).
+
+        Returns:
+            tuple[np.ndarray, np.ndarray]: board と next_board. int32 ndarray, shape = (N, 2, 15, 8).
+                                           STATE面は IDLE になる.
+        """
+        return super().getBoards(indices)
+
+class SharedRing(_SharedRing):
+    """
+    POSIX 共有メモリ上に置く, 盤面と行動・報酬・連鎖数・スコア・終了フラグのリングバッファ.
+    複数のプロセス (書き込み側) から 1 つのプロセス (読み出し側) へ, 直列化せずに受け渡せる.
+    書き込みはスロットごとの通し番号でロックなしに公開される (複数書き込み・単一読み出し).
+    読み出し (acquire・release・pop) は作成した (capacity > 0 で作った) オブジェクトだけが行える.
+
+    Args:
+        name (str): 共有メモリの名前 ("/puyo_ring" など).
+        capacity (int): 0 より大きければその数 (2 のべきに切り上げ) のスロットで新しく作成する.
+                        0 なら既存のリングバッファにつなぐ.
+
+    Attributes:
+        boards (np.ndarray): int32 ndarray, shape = (capacity, 2, 15, 8). 共有メモリをそのまま指す.
+        actions, rewards, chains, scores, dones (np.ndarray): shape = (capacity,). 共有メモリをそのまま指す.
+    """
+
+    def __init__(self, name:str, capacity:int = 0):
+        super().__init__(name, capacity)
+
+    def push(self, board:np.ndarray, action:int, reward:float, n_chains:int = 0, score:int = 0, done:bool = False) -> bool:
+        """
+        1件書き込む関数.
+
+        Args:
+            board (np.ndarray): int32 ndarray, shape = (2, 15, 8).
+            action (int): アクション番号.
+            reward (float): 報酬.
+            n_chains (int): 連鎖数.
+            score (int): スコア.
+            done (bool): エピソードが終了したか.
+
+        Returns:
+            bool: 書き込めたら True. 満杯なら False.
+        """
+        return super().push(board, action, reward, n_chains, score, done)
+
+    def pushBatch(self, boards:np.ndarray, actions:np.ndarray, rewards:np.ndarray, chains:np.ndarray,
+                  scores:np.ndarray, dones:np.ndarray) -> int:
+        """
+        N件を先頭から順に書き込む関数. 満杯になったらそこで止める. 処理中は GIL を解放する.
+
+        Args:
+            boards (np.ndarray): int32 ndarray, shape = (N, 2, 15, 8).
+            actions, rewards, chains, scores, dones (np.ndarray): shape = (N,).
+
+        Returns:
+            int: 書き込めた件数.
+        """
+        return super().pushBatch(boards, actions, rewards, chains, scores, dones)
+
+    def acquire(self, max_n:int) -> tuple[int, int]:
+        """
+        公開済みのスロットを最大 max_n 件, 連続した範囲で確保する関数 (読み出し側専用).
+        boards[first:first+n] などをコピーせずに読み, 読み終えたら release(n) を呼ぶ.
+        配列の末尾で折り返す前に止まるので, n が max_n より小さくても続きがあることがある.
+
+        Returns:
+            tuple[int, int]: (先頭のスロット番号 first, 件数 n).
+        """
+        return super().acquire(max_n)
+
+    def release(self, n:int) -> None:
+        """
+        acquire で確保したスロットの先頭 n 件を書き込み側に返す関数.
+        """
+        super().release(n)
+
+    def pop(self, max_n:int) -> tuple:
+        """
+        最大 max_n 件を読み出してコピーを返し, スロットを返却する関数 (読み出し側専用).
+
+        Returns:
+            tuple: (boards, actions, rewards, chains, scores, dones). それぞれ先頭の次元が読み出した件数.
+        """
+        return super().pop(max_n)
+
+    def unlink(self) -> None:
+        """
+        共有メモリの名前を削除する関数. つないでいるプロセスは引き続き使える.
+        """
+        super().unlink()
+
 ARRS_NUM: int = _ARRS_NUM
 """配列の層数. 値は 2 (ぷよ面と状態面)."""
 
@@ -166,9 +1082,48 @@ STATE: int = _STATE
 
 OJAMA: int = _OJAMA
 """おじゃまぷよを表す定数. 値は -2. 
-現在はおじゃまぷよの処理は実装されていない. 
+隣接するぷよが消えると消える (12段目まで). 
 """
 
+OJAMA_RATE: int = _OJAMA_RATE
+"""おじゃまぷよ 1 個あたりのスコア. 値は 70. """
+
+OJAMA_MAX_DROP: int = _OJAMA_MAX_DROP
+"""1 手で降るおじゃまぷよの最大数. 値は 30 (5 段). """
+
+TSUMO_CYCLE: int = _TSUMO_CYCLE
+"""ツモ列の周期 (組数). 値は 128. """
+
+FEATURES_NUM: int = _FEATURES_NUM
+"""chainFeatures の特徴量の数. 値は 114. """
+
+FEATURE_DROPS: int = _FEATURE_DROPS
+"""chainFeatures で各列に落とすぷよの数の種類 (1 個, 2 個). 値は 2. """
+
+FEATURE_HEIGHT_OFFSET: int = _FEATURE_HEIGHT_OFFSET
+"""chainFeatures の列の高さの開始位置. 値は 96. """
+
+FEATURE_CONNECT_OFFSET: int = _FEATURE_CONNECT_OFFSET
+"""chainFeatures の色ごとの隣り合う同色ぷよの組の数の開始位置. 値は 102. """
+
+FEATURE_GROUP_OFFSET: int = _FEATURE_GROUP_OFFSET
+"""chainFeatures の色ごとの 2 個・3 個のグループの数の開始位置. 値は 106. """
+
+VARIANT_STANDARD: int = _VARIANT_STANDARD
+"""ルールの種類. 4 色, 6 列 (盤面 (2, 15, 8)). 他の関数と同じ処理を使う. 値は 0. """
+
+VARIANT_COLOR3: int = _VARIANT_COLOR3
+"""ルールの種類. 3 色, 6 列 (盤面 (2, 15, 8)). 値は 1. """
+
+VARIANT_COLOR5: int = _VARIANT_COLOR5
+"""ルールの種類. 5 色, 6 列 (盤面 (2, 15, 8)). 値は 2. """
+
+VARIANT_WIDE: int = _VARIANT_WIDE
+"""ルールの種類. 4 色, 8 列 (盤面 (2, 15, 10)). ぷよは 4 列目から降ってくる. 値は 3. """
+
+VARIANTS_NUM: int = _VARIANTS_NUM
+"""ルールの種類の数. 値は 4. """
+
 BLOCK: int = _BLOCK
 """ブロック (壁) を表す定数. 値は -1. """
 
@@ -181,15 +1136,90 @@ IDLE: int = _IDLE
 NEW: int = _NEW
 """新しく落下したぷよを表す状態定数. 値は 1. """
 
+POLICY_RANDOM: int = _POLICY_RANDOM
+"""rollout の方策. 置ける手から一様ランダムに選ぶ. 値は 0. """
+
+POLICY_GREEDY: int = _POLICY_GREEDY
+"""rollout の方策. その手で得られるスコアが最大の手を選ぶ (同点はランダム). 値は 1. """
+
+ENGINE_ARRAY: int = _ENGINE_ARRAY
+"""配列を1マスずつ走査する連鎖処理エンジン. 値は 0. """
+
+ENGINE_BITBOARD: int = _ENGINE_BITBOARD
+"""色ごとのビットマスクで連鎖処理を行うエンジン. 値は 1. 
+ビットボードで表せない盤面 (盤面内の BLOCK など) は ENGINE_ARRAY で処理される. 
+"""
+
+LAYOUT_NHWC: int = _LAYOUT_NHWC
+"""モデル入力の並び. (ROWS_NUM-1, COLS_NUM-2, COLOR_NUM) = (14, 6, 4). 値は 0. """
+
+LAYOUT_NCHW: int = _LAYOUT_NCHW
+"""モデル入力の並び. (COLOR_NUM, ROWS_NUM-1, COLS_NUM-2) = (4, 14, 6). 値は 1. """
+
+DTYPE_FLOAT32: int = _DTYPE_FLOAT32
+"""モデル入力の型. float32. 値は 0. """
+
+DTYPE_FLOAT16: int = _DTYPE_FLOAT16
+"""モデル入力の型. float16. 値は 1. """
+
+DTYPE_UINT8: int = _DTYPE_UINT8
+"""モデル入力の型. uint8 (0 または 1). 値は 2. """
+
+DTYPE_BITS: int = _DTYPE_BITS
+"""モデル入力の型. 1要素1bitで 1盤面 42 バイトに詰める. 値は 3. 
+並びの順に上位 bit から詰めるので, np.unpackbits で元の one-hot に戻せる. 
+"""
+
+PACK_BYTES: int = _PACK_BYTES
+"""packBoards で詰めた 1 盤面のバイト数. 値は 32. """
+
 __all__ = [
     "cvtBoardForModel",
     "getAbleBoardsForModel",
+    "getAbleBoardsForModelInto",
+    "getAbleBoardsForModelBatch",
+    "step",
     "putPuyo",
+    "makeMove",
+    "unmakeMove",
     "fallPuyo",
     "erasePuyo",
     "chainAuto",
     "makeBoard",
+    "getRuleVariants",
     "isDead",
+    "legalActionMask",
+    "legalActionMasks",
+    "stepBatch",
+    "evaluateActions",
+    "evaluateActionsBatch",
+    "chainFeatures",
+    "chainFeaturesBatch",
+    "searchActions",
+    "beamSearch",
+    "rollout",
+    "versusStep",
+    "playVersus",
+    "generateTsumo",
+    "hashBoard",
+    "chainAutoCached",
+    "probeCache",
+    "setCacheSize",
+    "clearCache",
+    "getCacheStats",
+    "getStats",
+    "getSimdInfo",
+    "setSimdLevel",
+    "augmentColors",
+    "packBoards",
+    "unpackBoards",
+    "appendGameLog",
+    "openGameLog",
+    "GAME_LOG_DTYPE",
+    "PACK_BYTES",
+    "Board",
+    "ReplayBuffer",
+    "SharedRing",
     "ARRS_NUM",
     "ROWS_NUM",
     "COLS_NUM",
@@ -197,10 +1227,33 @@ __all__ = [
     "PUYO",
     "STATE",
     "OJAMA",
+    "OJAMA_RATE",
+    "OJAMA_MAX_DROP",
+    "TSUMO_CYCLE",
+    "FEATURES_NUM",
+    "FEATURE_DROPS",
+    "FEATURE_HEIGHT_OFFSET",
+    "FEATURE_CONNECT_OFFSET",
+    "FEATURE_GROUP_OFFSET",
+    "VARIANT_STANDARD",
+    "VARIANT_COLOR3",
+    "VARIANT_COLOR5",
+    "VARIANT_WIDE",
+    "VARIANTS_NUM",
     "BLOCK",
     "EMPTY",
     "IDLE",
     "NEW",
+    "ENGINE_ARRAY",
+    "ENGINE_BITBOARD",
+    "POLICY_RANDOM",
+    "POLICY_GREEDY",
+    "LAYOUT_NHWC",
+    "LAYOUT_NCHW",
+    "DTYPE_FLOAT32",
+    "DTYPE_FLOAT16",
+    "DTYPE_UINT8",
+    "DTYPE_BITS",
 ]
 
 __version__ = "1.0"
\ No newline at end of file
@@ -0,0 +1,140 @@
+#include <stdlib.h>
+#include <string.h>
+#include "puyo_augment.h"
+#include "puyo_encode.h"
+#include "puyo_thread.h"
+
+//並列処理で1スレッドが一度に受け持つサンプル数
+#define AUGMENT_GRAIN 16
+
+// 色の並べ替えを全て辞書順に書き込み，その数を返す関数（先頭は恒等置換）
+int colorPermutations(int (*perms)[COLOR_NUM]){
+    int perm[COLOR_NUM];
+    for(int c = 0; c < COLOR_NUM; c++) perm[c] = c;
+    int n = 0;
+    while(1){
+        memcpy(perms[n++], perm, sizeof(perm));
+        //次の順列
+        int k = COLOR_NUM - 2;
+        while(k >= 0 && perm[k] > perm[k+1]) k--;
+        if(k < 0) return n;
+        int l = COLOR_NUM - 1;
+        while(perm[l] < perm[k]) l--;
+        int tmp = perm[k]; perm[k] = perm[l]; perm[l] = tmp;
+        for(int a = k + 1, b = COLOR_NUM - 1; a < b; a++, b--){
+            tmp = perm[a]; perm[a] = perm[b]; perm[b] = tmp;
+        }
+    }
+}
+
+int isColorPermutation(const int *perm){
+    int seen = 0;
+    for(int c = 0; c < COLOR_NUM; c++){
+        if(perm[c] < 0 || perm[c] >= COLOR_NUM || (seen >> perm[c]) & 1) return 0;
+        seen |= 1 << perm[c];
+    }
+    return 1;
+}
+
+//色なら並べ替え，それ以外（EMPTY, OJAMA, 壁など）はそのまま
+static inline int permuteColor(int v, const int *perm){
+    return (unsigned)(v - 1) < COLOR_NUM ? perm[v-1] + 1 : v;
+}
+
+typedef struct {
+    int (*boards)[ARRS_NUM][ROWS_NUM][COLS_NUM];
+    const int (*perms)[COLOR_NUM];
+    int n_perms;
+    int (*out)[ARRS_NUM][ROWS_NUM][COLS_NUM];
+} AugmentBoards;
+
+static void augmentBoardsTask(void *ctx, int begin, int end){
+    AugmentBoards *job = (AugmentBoards *)ctx;
+    for(int k = begin; k < end; k++){
+        for(int p = 0; p < job->n_perms; p++){
+            int (*dst)[ROWS_NUM][COLS_NUM] = job->out[(size_t)k * job->n_perms + p];
+            const int *perm = job->perms[p];
+            for(int i = 0; i < ROWS_NUM; i++)
+                for(int j = 0; j < COLS_NUM; j++)
+                    dst[PUYO][i][j] = permuteColor(job->boards[k][PUYO][i][j], perm);
+            memcpy(dst[STATE], job->boards[k][STATE], sizeof(dst[STATE]));
+        }
+    }
+}
+
+// n個の盤面それぞれをn_perms通りに色を並べ替えてoutに書き込む関数
+// out[k*n_perms + p]がboards[k]をperms[p]で並べ替えた盤面．STATE面はそのまま写す
+void augmentBoards(int (*boards)[ARRS_NUM][ROWS_NUM][COLS_NUM], int n, const int (*perms)[COLOR_NUM], int n_perms,
+                   int (*out)[ARRS_NUM][ROWS_NUM][COLS_NUM], int n_threads){
+    AugmentBoards job = {boards, perms, n_perms, out};
+    parallelFor(n, n_threads, AUGMENT_GRAIN, augmentBoardsTask, &job);
+}
+
+typedef struct {
+    const unsigned char *x;
+    int dtype;
+    int n_perms;
+    const unsigned short *src; //並べ替えごとに，出力の各要素の元になる入力の要素番号
+    unsigned char *out;
+} AugmentEncoded;
+
+static void augmentEncodedTask(void *ctx, int begin, int end){
+    AugmentEncoded *job = (AugmentEncoded *)ctx;
+    size_t bytes = (size_t)encodedBytes(job->dtype);
+    for(int k = begin; k < end; k++){
+        const unsigned char *in = job->x + (size_t)k * bytes;
+        for(int p = 0; p < job->n_perms; p++){
+            unsigned char *dst = job->out + ((size_t)k * job->n_perms + p) * bytes;
+            const unsigned short *src = job->src + (size_t)p * ENCODE_ELEMS;
+            switch(job->dtype){
+                case DTYPE_FLOAT32:
+                    for(int e = 0; e < ENCODE_ELEMS; e++) ((uint32_t *)dst)[e] = ((const uint32_t *)in)[src[e]];
+                    break;
+                case DTYPE_FLOAT16:
+                    for(int e = 0; e < ENCODE_ELEMS; e++) ((uint16_t *)dst)[e] = ((const uint16_t *)in)[src[e]];
+                    break;
+                case DTYPE_UINT8:
+                    for(int e = 0; e < ENCODE_ELEMS; e++) dst[e] = in[src[e]];
+                    break;
+                case DTYPE_BITS:
+                    memset(dst, 0, bytes);
+                    for(int e = 0; e < ENCODE_ELEMS; e++)
+                        if((in[src[e] >> 3] << (src[e] & 7)) & 0x80) dst[e >> 3] |= (unsigned char)(0x80 >> (e & 7));
+                    break;
+            }
+        }
+    }
+}
+
+//並びごとのマス(i, j)，色c（いずれも0始まり）の要素番号
+static int encodedIndex(int layout, int i, int j, int c){
+    if(layout == LAYOUT_NHWC) return (i*(COLS_NUM-2) + j)*COLOR_NUM + c;
+    return (c*(ROWS_NUM-1) + i)*(COLS_NUM-2) + j;
+}
+
+// encodeBoardで変換したn個のモデル入力それぞれをn_perms通りに色を並べ替えてoutに書き込む関数
+// 出力の並びはaugmentBoardsと同じ．メモリが足りなければ-1を返す
+int augmentEncoded(const void *x, int n, int layout, int dtype, const int (*perms)[COLOR_NUM], int n_perms,
+                   void *out, int n_threads){
+    unsigned short *src = (unsigned short *)malloc(sizeof(unsigned short) * ENCODE_ELEMS * n_perms);
+    if(src == NULL) return -1;
+    for(int p = 0; p < n_perms; p++)
+        for(int i = 0; i < ROWS_NUM-1; i++)
+            for(int j = 0; j < COLS_NUM-2; j++)
+                for(int c = 0; c < COLOR_NUM; c++)
+                    src[(size_t)p * ENCODE_ELEMS + encodedIndex(layout, i, j, perms[p][c])] = (unsigned short)encodedIndex(layout, i, j, c);
+
+    AugmentEncoded job = {(const unsigned char *)x, dtype, n_perms, src, (unsigned char *)out};
+    parallelFor(n, n_threads, AUGMENT_GRAIN, augmentEncodedTask, &job);
+    free(src);
+    return 0;
+}
+
+// 1サンプルあたりm個の色（ツモなど）をn_perms通りに並べ替える関数
+// out[(k*n_perms + p)*m + t]がvalues[k*m + t]をperms[p]で並べ替えた値．色以外の値はそのまま
+void augmentColorValues(const int *values, int n, int m, const int (*perms)[COLOR_NUM], int n_perms, int *out){
+    for(int k = 0; k < n; k++)
+        for(int p = 0; p < n_perms; p++)
+            for(int t = 0; t < m; t++)
+                out[((size_t)k * n_perms + p) * m + t] = permuteColor(values[(size_t)k * m + t], perms[p]);
+}
\ No newline at end of file
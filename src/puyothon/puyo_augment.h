@@ -0,0 +1,19 @@
+#ifndef _PUYO_AUGMENT_H_
+#define _PUYO_AUGMENT_H_
+
+#include "puyo_func.h"
+
+//色の並べ替えの数（COLOR_NUMの階乗）
+#define AUGMENT_MAX_PERMS 24
+
+//色の並べ替え．色c（1~COLOR_NUM）はperm[c-1]+1になる
+int colorPermutations(int (*perms)[COLOR_NUM]);
+int isColorPermutation(const int *perm);
+
+void augmentBoards(int (*boards)[ARRS_NUM][ROWS_NUM][COLS_NUM], int n, const int (*perms)[COLOR_NUM], int n_perms,
+                   int (*out)[ARRS_NUM][ROWS_NUM][COLS_NUM], int n_threads);
+int augmentEncoded(const void *x, int n, int layout, int dtype, const int (*perms)[COLOR_NUM], int n_perms,
+                   void *out, int n_threads);
+void augmentColorValues(const int *values, int n, int m, const int (*perms)[COLOR_NUM], int n_perms, int *out);
+
+#endif //_PUYO_AUGMENT_H_
\ No newline at end of file
@@ -0,0 +1,311 @@
+#include <string.h>
+#include "puyo_bitboard.h"
+#include "puyo_simd.h"
+#include "puyo_stats.h"
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+//レーン単位のマスク
+#define LANE_MASK    0xFFFFu
+#define LANE_ROWS13  0x3FFEu //1~13段目（落下処理の対象）
+#define LANE_ROW14   0x4000u //14段目
+
+static const BitMask FIELD14 = {{0x7FFE7FFE7FFE7FFEull, 0x000000007FFE7FFEull}};
+static const BitMask FIELD12 = {{0x1FFE1FFE1FFE1FFEull, 0x000000001FFE1FFEull}};
+
+static inline int popcount64(uint64_t x){
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(x);
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ull);
+    x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+    return (int)((x * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+static inline int highestBit32(uint32_t x){
+#if defined(__GNUC__) || defined(__clang__)
+    return 31 - __builtin_clz(x);
+#else
+    int r = 0;
+    while(x >>= 1) r++;
+    return r;
+#endif
+}
+
+static inline BitMask bmAnd(BitMask a, BitMask b){
+    BitMask r = {{a.w[0] & b.w[0], a.w[1] & b.w[1]}};
+    return r;
+}
+
+static inline BitMask bmOr(BitMask a, BitMask b){
+    BitMask r = {{a.w[0] | b.w[0], a.w[1] | b.w[1]}};
+    return r;
+}
+
+static inline BitMask bmAndNot(BitMask a, BitMask b){
+    BitMask r = {{a.w[0] & ~b.w[0], a.w[1] & ~b.w[1]}};
+    return r;
+}
+
+static inline int bmIsEmpty(BitMask a){
+    return (a.w[0] | a.w[1]) == 0;
+}
+
+static inline int bmEqual(BitMask a, BitMask b){
+    return a.w[0] == b.w[0] && a.w[1] == b.w[1];
+}
+
+static inline int bmCount(BitMask a){
+    return popcount64(a.w[0]) + popcount64(a.w[1]);
+}
+
+//一つ上の段のビットを自分の位置に持ってくる
+static inline BitMask bmFromUp(BitMask a){
+    BitMask r = {{a.w[0] >> 1, a.w[1] >> 1}};
+    return r;
+}
+
+//一つ下の段のビットを自分の位置に持ってくる
+static inline BitMask bmFromDown(BitMask a){
+    BitMask r = {{a.w[0] << 1, a.w[1] << 1}};
+    return r;
+}
+
+//右隣の列のビットを自分の位置に持ってくる
+static inline BitMask bmFromRight(BitMask a){
+    BitMask r = {{(a.w[0] >> BB_LANE_BITS) | (a.w[1] << (64 - BB_LANE_BITS)), a.w[1] >> BB_LANE_BITS}};
+    return r;
+}
+
+//左隣の列のビットを自分の位置に持ってくる
+static inline BitMask bmFromLeft(BitMask a){
+    BitMask r = {{a.w[0] << BB_LANE_BITS, (a.w[1] << BB_LANE_BITS) | (a.w[0] >> (64 - BB_LANE_BITS))}};
+    return r;
+}
+
+//上下左右に隣接するマス（盤面外へのはみ出しは呼び出し側でマスクする）
+static inline BitMask bmNeighbors(BitMask a){
+    return bmOr(bmOr(bmFromUp(a), bmFromDown(a)), bmOr(bmFromRight(a), bmFromLeft(a)));
+}
+
+//startからmaskの中でつながっているマスを全て求める
+static inline BitMask bmFlood(BitMask start, BitMask mask){
+    BitMask x = bmAnd(start, mask);
+    while(1){
+        BitMask next = bmAnd(bmOr(x, bmNeighbors(x)), mask);
+        if(bmEqual(next, x)) return x;
+        x = next;
+    }
+}
+
+//最下位のビットだけを取り出す
+static inline BitMask bmLowestBit(BitMask a){
+    BitMask r = {{0, 0}};
+    if(a.w[0]) r.w[0] = a.w[0] & (~a.w[0] + 1);
+    else r.w[1] = a.w[1] & (~a.w[1] + 1);
+    return r;
+}
+
+static inline uint32_t getLane(BitMask a, int lane){
+    return (uint32_t)(a.w[lane >> 2] >> ((lane & 3) * BB_LANE_BITS)) & LANE_MASK;
+}
+
+static inline void setLane(BitMask *a, int lane, uint32_t v){
+    int shift = (lane & 3) * BB_LANE_BITS;
+    a->w[lane >> 2] = (a->w[lane >> 2] & ~((uint64_t)LANE_MASK << shift)) | ((uint64_t)v << shift);
+}
+
+static inline int testCell(const BitMask *a, int row, int col){
+    int lane = col - 1;
+    return (int)((a->w[lane >> 2] >> ((lane & 3) * BB_LANE_BITS + row)) & 1);
+}
+
+// 配列の盤面をビットボードに変換する関数
+// 壁が正の値だったり，盤面内にBLOCKや範囲外の色がある場合は変換できず0を返す
+// 盤面の走査はSIMDのカーネル（puyo_simd.c）で行う
+int toBitBoard(int (*board)[ROWS_NUM][COLS_NUM], BitBoard *bb){
+    return simdKernels()->to_bitboard(board, bb);
+}
+
+// ビットボードを配列の盤面に書き戻す関数
+// STATE面は落下処理で書き換えたマスだけを書き戻す
+void fromBitBoard(const BitBoard *bb, int (*board)[ROWS_NUM][COLS_NUM]){
+    for(int j = 1; j < COLS_NUM-1; j++){
+        for(int i = 1; i < ROWS_NUM; i++){
+            int p = EMPTY;
+            if(testCell(&bb->ojama, i, j)) p = OJAMA;
+            for(int c = 0; c < COLOR_NUM; c++)
+                if(testCell(&bb->color[c], i, j)) p = c + 1;
+            board[PUYO][i][j] = p;
+
+            if(testCell(&bb->touched, i, j))
+                board[STATE][i][j] = testCell(&bb->state, i, j) ? NEW : IDLE;
+        }
+    }
+}
+
+// 1列分のビット列を詰める（pext相当）
+static inline uint32_t compactLane(uint32_t x, uint32_t occ){
+#if defined(__BMI2__)
+    return _pext_u32(x, occ) << 1;
+#else
+    uint32_t r = 0;
+    for(uint32_t dst = 2; occ; occ &= occ - 1, dst <<= 1)
+        if(x & occ & (~occ + 1)) r |= dst;
+    return r;
+#endif
+}
+
+// fallPuyosのビットボード版
+// 1~13段目のぷよを列ごとに下に詰める．14段目のぷよは落とさない
+int bbFallPuyos(BitBoard *bb){
+    int fall_max = 0;
+    for(int lane = 0; lane < BB_LANES; lane++){
+        uint32_t cols[COLOR_NUM + 1];
+        uint32_t occ = getLane(bb->ojama, lane);
+        cols[COLOR_NUM] = occ;
+        for(int c = 0; c < COLOR_NUM; c++){
+            cols[c] = getLane(bb->color[c], lane);
+            occ |= cols[c];
+        }
+        occ &= LANE_ROWS13;
+
+        int n = popcount64(occ);
+        uint32_t packed = ((1u << n) - 1) << 1;
+        if(occ == packed) continue;
+
+        //最初の隙間より上にあるぷよが全て落ちる
+        uint32_t gap = ~occ & LANE_ROWS13;
+        uint32_t below_gap = (gap & (~gap + 1)) - 1;
+        uint32_t src = occ & ~below_gap;
+        uint32_t dst = packed & ~below_gap;
+
+        int fall = highestBit32(occ) - n;
+        if(fall > fall_max) fall_max = fall;
+
+        for(int c = 0; c < COLOR_NUM; c++)
+            setLane(&bb->color[c], lane, compactLane(cols[c] & LANE_ROWS13, occ) | (cols[c] & LANE_ROW14));
+        setLane(&bb->ojama, lane, compactLane(cols[COLOR_NUM] & LANE_ROWS13, occ) | (cols[COLOR_NUM] & LANE_ROW14));
+
+        //移動元はIDLE，移動先はNEWになる
+        setLane(&bb->state, lane, (getLane(bb->state, lane) & ~src) | dst);
+        setLane(&bb->touched, lane, getLane(bb->touched, lane) | src | dst);
+    }
+    return fall_max;
+}
+
+// oneChainのビットボード版
+// isLinkingSeedと同じ条件（12段目までの隣接数）で起点を求め，起点がNEWのグループを14段目まで含めて消す
+// 消えたぷよに隣接する12段目までのおじゃまぷよも消す
+int bbOneChain(BitBoard *bb, int chain_num){
+    int total_erased_count = 0;
+    int linking_bonus = 0;
+    int color_num = 0;
+    BitMask all_erased = {{0, 0}};
+
+    for(int c = 0; c < COLOR_NUM; c++){
+        BitMask m = bmAnd(bb->color[c], FIELD14);
+        BitMask m12 = bmAnd(m, FIELD12);
+        if(bmCount(m12) < 4) continue;
+
+        //上下左右それぞれに同色ぷよがあるマス
+        BitMask up = bmAnd(bmFromUp(m12), m12);
+        BitMask down = bmAnd(bmFromDown(m12), m12);
+        BitMask right = bmAnd(bmFromRight(m12), m12);
+        BitMask left = bmAnd(bmFromLeft(m12), m12);
+
+        //隣接数が2以上，3以上のマスを求める
+        BitMask s1 = {{up.w[0] ^ down.w[0], up.w[1] ^ down.w[1]}};
+        BitMask c1 = bmAnd(up, down);
+        BitMask s2 = {{right.w[0] ^ left.w[0], right.w[1] ^ left.w[1]}};
+        BitMask c2 = bmAnd(right, left);
+        BitMask deg2 = bmOr(bmOr(c1, c2), bmAnd(s1, s2));
+        BitMask deg3 = bmOr(bmAnd(c1, bmOr(c2, s2)), bmAnd(c2, s1));
+
+        //隣接数3以上のマスか，隣接数2以上のマス同士が隣り合っているマスが起点になる
+        BitMask seed = bmOr(deg3, bmAnd(deg2, bmNeighbors(deg2)));
+        BitMask start = bmAnd(seed, bb->state);
+        if(bmIsEmpty(start)) continue;
+
+        BitMask erased = {{0, 0}};
+        while(!bmIsEmpty(start)){
+            BitMask group = bmFlood(bmLowestBit(start), m);
+            int erased_count = bmCount(group);
+            total_erased_count += erased_count;
+
+            //連結ボーナスに加算
+            if(erased_count >= 11) linking_bonus += 10;
+            else if(erased_count >= 5) linking_bonus += erased_count - 3;
+
+            erased = bmOr(erased, group);
+            start = bmAndNot(start, group);
+        }
+        bb->color[c] = bmAndNot(bb->color[c], erased);
+        all_erased = bmOr(all_erased, erased);
+        color_num++;
+    }
+
+    //消えたぷよに隣接するおじゃまぷよを12段目まで消す
+    bb->ojama = bmAndNot(bb->ojama, bmAnd(bmNeighbors(all_erased), FIELD12));
+
+    //ひとつも消えてなければスコアは0
+    if(total_erased_count <= 0) return 0;
+
+    return calcChainScore(total_erased_count, linking_bonus, color_num, chain_num);
+}
+
+// allChainのビットボード版
+// 連鎖数の分布はallChainと同じカウンタに数える
+void bbAllChain(BitBoard *bb, int *n_chains, int *score){
+    STAT_INC(STAT_ALLCHAIN_CALLS);
+    bbFallPuyos(bb);
+
+    *n_chains = 0;
+    *score = 0;
+
+    while(1){
+        int s = bbOneChain(bb, *n_chains+1);
+
+        //スコアが0以下なら連鎖終了
+        if(s <= 0){
+            STAT_CHAIN(*n_chains);
+            return;
+        }
+
+        bbFallPuyos(bb);
+        (*n_chains)++;
+        *score += s;
+    }
+}
+
+//配列の盤面をビットボードエンジンで処理する関数
+//ビットボードに変換できない盤面は配列版で処理する
+int fallPuyosBB(int (*board)[ROWS_NUM][COLS_NUM]){
+    BitBoard bb;
+    if(!toBitBoard(board, &bb)) return fallPuyos(board);
+    int fall_max = bbFallPuyos(&bb);
+    fromBitBoard(&bb, board);
+    return fall_max;
+}
+
+int oneChainBB(int (*board)[ROWS_NUM][COLS_NUM], int chain_num){
+    BitBoard bb;
+    if(!toBitBoard(board, &bb)) return oneChain(board, chain_num);
+    int score = bbOneChain(&bb, chain_num);
+    fromBitBoard(&bb, board);
+    return score;
+}
+
+void allChainBB(int (*board)[ROWS_NUM][COLS_NUM], int *n_chains, int *score){
+    BitBoard bb;
+    if(!toBitBoard(board, &bb)){
+        allChain(board, n_chains, score);
+        return;
+    }
+    bbAllChain(&bb, n_chains, score);
+    fromBitBoard(&bb, board);
+}
\ No newline at end of file
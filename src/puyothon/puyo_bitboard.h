@@ -0,0 +1,36 @@
+#ifndef _PUYO_BITBOARD_H_
+#define _PUYO_BITBOARD_H_
+
+#include <stdint.h>
+#include "puyo_func.h"
+
+//ビットボードの配置
+//列ごとに16bitのレーンを割り当て，レーン内のbit rが行rに対応する．
+//1~4列目はw[0]，5~6列目はw[1]の下位32bitに入る．
+#define BB_LANE_BITS 16
+#define BB_LANES (COLS_NUM-2)
+
+typedef struct {
+    uint64_t w[2];
+} BitMask;
+
+//色ごとのビットマスクで表した盤面
+//stateはSTATE面がNEWのマス，touchedは落下処理でSTATE面を書き換えたマス
+typedef struct {
+    BitMask color[COLOR_NUM];
+    BitMask ojama;
+    BitMask state;
+    BitMask touched;
+} BitBoard;
+
+int toBitBoard(int (*board)[ROWS_NUM][COLS_NUM], BitBoard *bb);
+void fromBitBoard(const BitBoard *bb, int (*board)[ROWS_NUM][COLS_NUM]);
+int bbFallPuyos(BitBoard *bb);
+int bbOneChain(BitBoard *bb, int chain_num);
+void bbAllChain(BitBoard *bb, int *n_chains, int *score);
+
+int fallPuyosBB(int (*board)[ROWS_NUM][COLS_NUM]);
+int oneChainBB(int (*board)[ROWS_NUM][COLS_NUM], int chain_num);
+void allChainBB(int (*board)[ROWS_NUM][COLS_NUM], int *n_chains, int *score);
+
+#endif //_PUYO_BITBOARD_H_
\ No newline at end of file
@@ -0,0 +1,226 @@
+#include <stdlib.h>
+#include <string.h>
+#include "puyo_cache.h"
+#include "puyo_bitboard.h"
+#include "puyo_hash.h"
+#include "puyo_thread.h"
+
+//置換表の分割数（ロックの数）．置換表の大きさはこれ以上の2の累乗になる
+#define CACHE_SHARDS 64
+
+//盤面を表すビットマスクの数（色，おじゃま，STATE面）
+#define CACHE_MASKS (COLOR_NUM + 2)
+
+typedef struct {
+    uint64_t hash;
+    uint64_t out_hash;
+    int valid;
+    int n_chains;
+    int score;
+    BitMask in[CACHE_MASKS];
+    BitMask out[CACHE_MASKS];
+} CacheEntry;
+
+typedef struct {
+    PuyoMutex mutex;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t stores;
+} CacheShard;
+
+static CacheEntry *cache_table = NULL;
+static size_t cache_size = 0;
+static CacheShard cache_shards[CACHE_SHARDS];
+
+//cache_sizeはlockAllの中で書き換える．allChainCachedはロックを取る前に無効かどうかだけを見るので，原子的に読み書きする
+static size_t loadCacheSize(void){
+#ifdef _MSC_VER
+    return *(volatile size_t *)&cache_size;
+#else
+    return __atomic_load_n(&cache_size, __ATOMIC_RELAXED);
+#endif
+}
+
+static void storeCacheSize(size_t size){
+#ifdef _MSC_VER
+    *(volatile size_t *)&cache_size = size;
+#else
+    __atomic_store_n(&cache_size, size, __ATOMIC_RELAXED);
+#endif
+}
+
+// 置換表を初期化する関数．最初は置換表を持たない（無効）
+void initCache(void){
+    for(int k = 0; k < CACHE_SHARDS; k++){
+        mutexInit(&cache_shards[k].mutex);
+        cache_shards[k].hits = 0;
+        cache_shards[k].misses = 0;
+        cache_shards[k].stores = 0;
+    }
+}
+
+static void lockAll(void){
+    for(int k = 0; k < CACHE_SHARDS; k++) mutexLock(&cache_shards[k].mutex);
+}
+
+static void unlockAll(void){
+    for(int k = CACHE_SHARDS - 1; k >= 0; k--) mutexUnlock(&cache_shards[k].mutex);
+}
+
+// 置換表の大きさを設定する関数．中身と統計は消える
+// n_entriesは2の累乗に切り下げる（CACHE_SHARDS未満は切り上げ）．0なら置換表を無効にする
+// メモリを確保できなかった場合は-1を返し，置換表は無効になる
+int setCacheSize(size_t n_entries){
+    size_t size = 0;
+    if(n_entries > 0){
+        size = CACHE_SHARDS;
+        while(size * 2 <= n_entries && size * 2 > size) size *= 2;
+    }
+
+    lockAll();
+    free(cache_table);
+    cache_table = NULL;
+    storeCacheSize(0);
+    int ret = 0;
+    if(size > 0){
+        cache_table = (CacheEntry *)calloc(size, sizeof(CacheEntry));
+        if(cache_table) storeCacheSize(size);
+        else ret = -1;
+    }
+    for(int k = 0; k < CACHE_SHARDS; k++){
+        cache_shards[k].hits = 0;
+        cache_shards[k].misses = 0;
+        cache_shards[k].stores = 0;
+    }
+    unlockAll();
+    return ret;
+}
+
+// 置換表の中身と統計を消す関数
+void clearCache(void){
+    lockAll();
+    if(cache_table) memset(cache_table, 0, sizeof(CacheEntry) * cache_size);
+    for(int k = 0; k < CACHE_SHARDS; k++){
+        cache_shards[k].hits = 0;
+        cache_shards[k].misses = 0;
+        cache_shards[k].stores = 0;
+    }
+    unlockAll();
+}
+
+void getCacheStats(CacheStats *stats){
+    memset(stats, 0, sizeof(CacheStats));
+    lockAll();
+    stats->size = cache_size;
+    for(int k = 0; k < CACHE_SHARDS; k++){
+        stats->hits += cache_shards[k].hits;
+        stats->misses += cache_shards[k].misses;
+        stats->stores += cache_shards[k].stores;
+    }
+    unlockAll();
+}
+
+// 盤面を置換表のキーに変換する関数
+// ビットボードで表せない盤面や，STATE面にIDLE, NEW以外の値がある盤面はキャッシュしない
+static int toCacheKey(int (*board)[ROWS_NUM][COLS_NUM], BitBoard *bb, BitMask *key){
+    if(!toBitBoard(board, bb)) return 0;
+    for(int i = 1; i < ROWS_NUM; i++)
+        for(int j = 1; j < COLS_NUM-1; j++)
+            if(board[STATE][i][j] != IDLE && board[STATE][i][j] != NEW) return 0;
+
+    for(int c = 0; c < COLOR_NUM; c++) key[c] = bb->color[c];
+    key[COLOR_NUM] = bb->ojama;
+    key[COLOR_NUM+1] = bb->state;
+    return 1;
+}
+
+// 置換表の値を盤面に書き戻す関数．STATE面もすべて書き換える
+static void fromCacheKey(const BitMask *key, int (*board)[ROWS_NUM][COLS_NUM]){
+    BitBoard bb;
+    for(int c = 0; c < COLOR_NUM; c++) bb.color[c] = key[c];
+    bb.ojama = key[COLOR_NUM];
+    bb.state = key[COLOR_NUM+1];
+    memset(&bb.touched, 0xFF, sizeof(bb.touched));
+    fromBitBoard(&bb, board);
+}
+
+// 置換表を引き，見つかればentryにコピーして1を返す．ロックは呼び出し側で取る
+static int lookup(uint64_t hash, const BitMask *key, CacheEntry *entry){
+    CacheEntry *e = &cache_table[hash & (cache_size - 1)];
+    if(!e->valid || e->hash != hash) return 0;
+    if(memcmp(e->in, key, sizeof(e->in)) != 0) return 0;
+    *entry = *e;
+    return 1;
+}
+
+// 盤面の連鎖結果が置換表にあれば，盤面を変更せずに連鎖数とスコアを返す関数
+// hashは盤面のpuyo面のZobristハッシュ．見つからなければ0を返す
+int probeCache(int (*board)[ROWS_NUM][COLS_NUM], uint64_t hash, int *n_chains, int *score){
+    BitBoard bb;
+    BitMask key[CACHE_MASKS];
+    if(!toCacheKey(board, &bb, key)) return 0;
+
+    CacheShard *shard = &cache_shards[hash & (CACHE_SHARDS - 1)];
+    CacheEntry entry;
+    int found = 0;
+    mutexLock(&shard->mutex);
+    if(cache_size > 0) found = lookup(hash, key, &entry);
+    mutexUnlock(&shard->mutex);
+
+    if(found){
+        *n_chains = entry.n_chains;
+        *score = entry.score;
+    }
+    return found;
+}
+
+// 置換表を使って最後まで連鎖を実行する関数
+// *hashには連鎖前のpuyo面のZobristハッシュを入れて呼ぶ．連鎖後のハッシュに更新される
+// 置換表が無効なときやキャッシュできない盤面はallChainBBで処理する
+void allChainCached(int (*board)[ROWS_NUM][COLS_NUM], uint64_t *hash, int *n_chains, int *score){
+    BitBoard bb;
+    BitMask key[CACHE_MASKS];
+    if(loadCacheSize() == 0 || !toCacheKey(board, &bb, key)){
+        allChainBB(board, n_chains, score);
+        *hash = zobristHash(board);
+        return;
+    }
+
+    CacheShard *shard = &cache_shards[*hash & (CACHE_SHARDS - 1)];
+    CacheEntry entry;
+    int found = 0;
+    mutexLock(&shard->mutex);
+    if(cache_size > 0) found = lookup(*hash, key, &entry);
+    if(found) shard->hits++;
+    else shard->misses++;
+    mutexUnlock(&shard->mutex);
+
+    if(found){
+        fromCacheKey(entry.out, board);
+        *n_chains = entry.n_chains;
+        *score = entry.score;
+        *hash = entry.out_hash;
+        return;
+    }
+
+    //置換表になければ連鎖を実行して登録する
+    entry.hash = *hash;
+    entry.valid = 1;
+    memcpy(entry.in, key, sizeof(entry.in));
+    bbAllChain(&bb, n_chains, score);
+    fromBitBoard(&bb, board);
+    for(int c = 0; c < COLOR_NUM; c++) entry.out[c] = bb.color[c];
+    entry.out[COLOR_NUM] = bb.ojama;
+    entry.out[COLOR_NUM+1] = bb.state;
+    entry.n_chains = *n_chains;
+    entry.score = *score;
+    entry.out_hash = zobristHash(board);
+    *hash = entry.out_hash;
+
+    mutexLock(&shard->mutex);
+    if(cache_size > 0){
+        cache_table[entry.hash & (cache_size - 1)] = entry;
+        shard->stores++;
+    }
+    mutexUnlock(&shard->mutex);
+}
\ No newline at end of file
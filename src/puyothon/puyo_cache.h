@@ -0,0 +1,23 @@
+#ifndef _PUYO_CACHE_H_
+#define _PUYO_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "puyo_func.h"
+
+//置換表の統計
+typedef struct {
+    size_t size;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t stores;
+} CacheStats;
+
+void initCache(void);
+int setCacheSize(size_t n_entries);
+void clearCache(void);
+void getCacheStats(CacheStats *stats);
+int probeCache(int (*board)[ROWS_NUM][COLS_NUM], uint64_t hash, int *n_chains, int *score);
+void allChainCached(int (*board)[ROWS_NUM][COLS_NUM], uint64_t *hash, int *n_chains, int *score);
+
+#endif //_PUYO_CACHE_H_
\ No newline at end of file
@@ -0,0 +1,80 @@
+#include <stdint.h>
+#include <string.h>
+#include "puyo_encode.h"
+#include "puyo_simd.h"
+
+//半精度浮動小数点数の1.0
+#define FLOAT16_ONE 0x3C00
+
+//各並びでのマス(i, j)，色pの要素番号
+#define INDEX_NHWC(i, j, p) ((((i)-1)*(COLS_NUM-2) + ((j)-1))*COLOR_NUM + ((p)-1))
+#define INDEX_NCHW(i, j, p) ((((p)-1)*(ROWS_NUM-1) + ((i)-1))*(COLS_NUM-2) + ((j)-1))
+
+//型と並びごとに特殊化した変換関数を定義する
+#define DEFINE_ENCODE(name, type, one, index)                                   \
+static void name(int (*board)[ROWS_NUM][COLS_NUM], type *x){                    \
+    memset(x, 0, sizeof(type)*ENCODE_ELEMS);                                    \
+    for(int i = 1; i < ROWS_NUM; i++){                                          \
+        for(int j = 1; j < COLS_NUM-1; j++){                                    \
+            int p = board[PUYO][i][j];                                          \
+            if(1 <= p && p <= COLOR_NUM)                                        \
+                x[index(i, j, p)] = one;                                        \
+        }                                                                       \
+    }                                                                           \
+}
+
+#define DEFINE_ENCODE_BITS(name, index)                                         \
+static void name(int (*board)[ROWS_NUM][COLS_NUM], uint8_t *x){                 \
+    memset(x, 0, (ENCODE_ELEMS + 7) / 8);                                       \
+    for(int i = 1; i < ROWS_NUM; i++){                                          \
+        for(int j = 1; j < COLS_NUM-1; j++){                                    \
+            int p = board[PUYO][i][j];                                          \
+            if(1 <= p && p <= COLOR_NUM){                                       \
+                int k = index(i, j, p);                                         \
+                x[k >> 3] |= (uint8_t)(0x80 >> (k & 7));                        \
+            }                                                                   \
+        }                                                                       \
+    }                                                                           \
+}
+
+DEFINE_ENCODE(encodeNHWCFloat16, uint16_t, FLOAT16_ONE, INDEX_NHWC)
+DEFINE_ENCODE(encodeNHWCUint8, uint8_t, 1, INDEX_NHWC)
+DEFINE_ENCODE(encodeNCHWFloat16, uint16_t, FLOAT16_ONE, INDEX_NCHW)
+DEFINE_ENCODE(encodeNCHWUint8, uint8_t, 1, INDEX_NCHW)
+DEFINE_ENCODE_BITS(encodeNHWCBits, INDEX_NHWC)
+DEFINE_ENCODE_BITS(encodeNCHWBits, INDEX_NCHW)
+
+int isValidEncoding(int layout, int dtype){
+    return (layout == LAYOUT_NHWC || layout == LAYOUT_NCHW) && DTYPE_FLOAT32 <= dtype && dtype <= DTYPE_BITS;
+}
+
+// 1盤面を変換したときのバイト数を返す関数
+int encodedBytes(int dtype){
+    switch(dtype){
+        case DTYPE_FLOAT32: return ENCODE_ELEMS * 4;
+        case DTYPE_FLOAT16: return ENCODE_ELEMS * 2;
+        case DTYPE_UINT8:   return ENCODE_ELEMS;
+        case DTYPE_BITS:    return (ENCODE_ELEMS + 7) / 8;
+    }
+    return 0;
+}
+
+// 盤面を指定した並びと型のone-hot表現に変換する関数
+// NHWCのfloat32はtoBoardForModelと同じ．float32の変換はSIMDのカーネルを使う
+void encodeBoard(int (*board)[ROWS_NUM][COLS_NUM], int layout, int dtype, void *x){
+    if(layout == LAYOUT_NHWC){
+        switch(dtype){
+            case DTYPE_FLOAT32: toBoardForModel(board, (float (*)[COLS_NUM-2][COLOR_NUM])x); return;
+            case DTYPE_FLOAT16: encodeNHWCFloat16(board, (uint16_t *)x); return;
+            case DTYPE_UINT8:   encodeNHWCUint8(board, (uint8_t *)x); return;
+            case DTYPE_BITS:    encodeNHWCBits(board, (uint8_t *)x); return;
+        }
+    }else{
+        switch(dtype){
+            case DTYPE_FLOAT32: simdKernels()->encode_nchw_f32(board, (float *)x); return;
+            case DTYPE_FLOAT16: encodeNCHWFloat16(board, (uint16_t *)x); return;
+            case DTYPE_UINT8:   encodeNCHWUint8(board, (uint8_t *)x); return;
+            case DTYPE_BITS:    encodeNCHWBits(board, (uint8_t *)x); return;
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,23 @@
+#ifndef _PUYO_ENCODE_H_
+#define _PUYO_ENCODE_H_
+
+#include "puyo_func.h"
+
+//モデル入力の並び
+#define LAYOUT_NHWC 0 //(ROWS_NUM-1, COLS_NUM-2, COLOR_NUM)
+#define LAYOUT_NCHW 1 //(COLOR_NUM, ROWS_NUM-1, COLS_NUM-2)
+
+//モデル入力の型
+#define DTYPE_FLOAT32 0
+#define DTYPE_FLOAT16 1
+#define DTYPE_UINT8 2
+#define DTYPE_BITS 3 //1要素1bit．並びの順に上位bitから詰める（numpy.packbitsと同じ）
+
+//1盤面あたりの要素数
+#define ENCODE_ELEMS ((ROWS_NUM-1)*(COLS_NUM-2)*COLOR_NUM)
+
+int isValidEncoding(int layout, int dtype);
+int encodedBytes(int dtype);
+void encodeBoard(int (*board)[ROWS_NUM][COLS_NUM], int layout, int dtype, void *x);
+
+#endif //_PUYO_ENCODE_H_
\ No newline at end of file
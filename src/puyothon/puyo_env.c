@@ -0,0 +1,190 @@
+#include <string.h>
+#include "puyo_env.h"
+#include "puyo_bitboard.h"
+#include "puyo_thread.h"
+#include "puyo_legal.h"
+
+//並列処理で1スレッドが一度に受け持つ盤面数
+#define STEP_GRAIN 16
+
+// 1手進める関数
+// 置けるなら設置して連鎖を最後まで実行する．置けない場合は盤面を変更しない
+void stepBoard(int (*board)[ROWS_NUM][COLS_NUM], int parent_puyo, int child_puyo, int col, int rot, StepResult *result){
+    result->n_chains = 0;
+    result->score = 0;
+    result->legal = canPut(board, col, rot);
+    if(result->legal){
+        putPuyo(board, col, rot, parent_puyo, child_puyo);
+        allChainBB(board, &result->n_chains, &result->score);
+    }
+    result->dead = isDeadBoard(board);
+}
+
+typedef struct {
+    int (*boards)[ARRS_NUM][ROWS_NUM][COLS_NUM];
+    const int *parent_puyos;
+    const int *child_puyos;
+    const int *cols;
+    const int *rots;
+    StepResult *results;
+} StepBatch;
+
+static void stepTask(void *ctx, int begin, int end){
+    StepBatch *batch = (StepBatch *)ctx;
+    for(int i = begin; i < end; i++)
+        stepBoard(batch->boards[i], batch->parent_puyos[i], batch->child_puyos[i], batch->cols[i], batch->rots[i], &batch->results[i]);
+}
+
+// n個の盤面をまとめて1手進める関数
+void stepBoards(int (*boards)[ARRS_NUM][ROWS_NUM][COLS_NUM], int n, const int *parent_puyos, const int *child_puyos, const int *cols, const int *rots, StepResult *results, int n_threads){
+    StepBatch batch = {boards, parent_puyos, child_puyos, cols, rots, results};
+    parallelFor(n, n_threads, STEP_GRAIN, stepTask, &batch);
+}
+
+// 置ける行動を列挙する関数
+// able_actionsにはACTIONS_NUM個分の領域が必要．置ける行動の数を返す
+int listAbleActions(int (*board)[ROWS_NUM][COLS_NUM], int *able_actions){
+    int able_actions_num = 0;
+    uint32_t legal = legalActionMask(board);
+    for(int action = 0; action < ACTIONS_NUM; action++){
+        if((legal >> action) & 1)
+            able_actions[able_actions_num++] = action;
+    }
+    return able_actions_num;
+}
+
+// 盤面のコピーに行動actionでぷよを置き，layoutとdtypeで指定したモデル入力に変換する関数．boardは変更しない
+void putForModel(int (*board)[ROWS_NUM][COLS_NUM], int action, int parent_puyo, int child_puyo, int layout, int dtype, void *x){
+    int col, rot;
+    actionToColRot(action, &col, &rot);
+
+    int tmp_board[ARRS_NUM][ROWS_NUM][COLS_NUM];
+    memcpy(tmp_board, board, sizeof(tmp_board));
+    putPuyo(tmp_board, col, rot, parent_puyo, child_puyo);
+    encodeBoard(tmp_board, layout, dtype, x);
+}
+
+// 置ける全ての行動について置いた後の盤面をモデル入力に変換する関数
+// xとable_actionsの先頭から詰めて書き込み，置ける行動の数を返す．xは1盤面あたりencodedBytes(dtype)バイト
+int ableBoardsForModel(int (*board)[ROWS_NUM][COLS_NUM], int parent_puyo, int child_puyo, int layout, int dtype, void *x, int *able_actions){
+    int stride = encodedBytes(dtype);
+    int able_actions_num = listAbleActions(board, able_actions);
+    for(int i = 0; i < able_actions_num; i++)
+        putForModel(board, able_actions[i], parent_puyo, child_puyo, layout, dtype, (char *)x + (size_t)i * stride);
+    return able_actions_num;
+}
+
+// 全行動について置いた後の盤面をモデル入力に変換する関数
+// x[action]は行動番号の位置に書き込み，置けない行動は0で埋めてmaskを0にする．xがNULLならmaskだけを求める
+static void actionBoardsForModel(int (*board)[ROWS_NUM][COLS_NUM], int parent_puyo, int child_puyo, int layout, int dtype,
+                                 char *x, unsigned char *mask){
+    size_t stride = (size_t)encodedBytes(dtype);
+    uint32_t legal = legalActionMask(board);
+    for(int action = 0; action < ACTIONS_NUM; action++){
+        mask[action] = (unsigned char)((legal >> action) & 1);
+        if(x == NULL) continue;
+        if(mask[action])
+            putForModel(board, action, parent_puyo, child_puyo, layout, dtype, x + action * stride);
+        else
+            memset(x + action * stride, 0, stride);
+    }
+}
+
+// 行動番号actionで1手進め，次のツモで置ける行動のマスクと置いた後のモデル入力を書き込む関数
+// xはACTIONS_NUM盤面分（NULLならマスクだけ）．置けない行動なら盤面は変更せず，その盤面について次の手を求める
+void stepForModel(int (*board)[ROWS_NUM][COLS_NUM], int parent_puyo, int child_puyo, int action, int next_parent_puyo, int next_child_puyo,
+                  int layout, int dtype, void *x, unsigned char *mask, StepResult *result){
+    if(action >= 0 && action < ACTIONS_NUM){
+        int col, rot;
+        actionToColRot(action, &col, &rot);
+        stepBoard(board, parent_puyo, child_puyo, col, rot, result);
+    }else{
+        result->legal = 0;
+        result->n_chains = 0;
+        result->score = 0;
+        result->dead = isDeadBoard(board);
+    }
+    actionBoardsForModel(board, next_parent_puyo, next_child_puyo, layout, dtype, (char *)x, mask);
+}
+
+typedef struct {
+    int (*boards)[ARRS_NUM][ROWS_NUM][COLS_NUM];
+    const int *parent_puyos;
+    const int *child_puyos;
+    int layout;
+    int dtype;
+    char *x;
+    unsigned char (*mask)[ACTIONS_NUM];
+} AbleBoardsBatch;
+
+static void ableBoardsTask(void *ctx, int begin, int end){
+    AbleBoardsBatch *batch = (AbleBoardsBatch *)ctx;
+    size_t stride = (size_t)encodedBytes(batch->dtype);
+    for(int i = begin; i < end; i++)
+        actionBoardsForModel(batch->boards[i], batch->parent_puyos[i], batch->child_puyos[i], batch->layout, batch->dtype,
+                             batch->x + (size_t)i * ACTIONS_NUM * stride, batch->mask[i]);
+}
+
+// n個の盤面について，全行動の置いた後の盤面をモデル入力に変換する関数
+// x[i][action]は行動番号の位置に書き込み，置けない行動は0で埋めてmaskを0にする
+void ableBoardsForModelBatch(int (*boards)[ARRS_NUM][ROWS_NUM][COLS_NUM], int n, const int *parent_puyos, const int *child_puyos,
+                             int layout, int dtype, void *x, unsigned char (*mask)[ACTIONS_NUM], int n_threads){
+    AbleBoardsBatch batch = {boards, parent_puyos, child_puyos, layout, dtype, (char *)x, mask};
+    parallelFor(n, n_threads, 1, ableBoardsTask, &batch);
+}
+
+// 各列の高さ（最も上にあるぷよの段．空なら0）を求める関数．heightsにはCOLS_NUM-2個分の領域が必要
+void columnHeights(int (*board)[ROWS_NUM][COLS_NUM], int *heights){
+    for(int j = 1; j < COLS_NUM-1; j++){
+        int h = 0;
+        for(int i = ROWS_NUM-1; i >= 1; i--){
+            if(board[PUYO][i][j] != EMPTY){
+                h = i;
+                break;
+            }
+        }
+        heights[j-1] = h;
+    }
+}
+
+// 全ての行動について，盤面のコピーに置いて連鎖を最後まで行った結果を求める関数．boardは変更しない
+// evalsにはACTIONS_NUM個分の領域が必要
+void evaluateActions(int (*board)[ROWS_NUM][COLS_NUM], int parent_puyo, int child_puyo, ActionEval *evals){
+    uint32_t legal = legalActionMask(board);
+    for(int action = 0; action < ACTIONS_NUM; action++){
+        ActionEval *e = &evals[action];
+        memset(e, 0, sizeof(*e));
+        if(!((legal >> action) & 1)) continue;
+
+        int col, rot;
+        actionToColRot(action, &col, &rot);
+        int tmp_board[ARRS_NUM][ROWS_NUM][COLS_NUM];
+        memcpy(tmp_board, board, sizeof(tmp_board));
+        putPuyo(tmp_board, col, rot, parent_puyo, child_puyo);
+        allChainBB(tmp_board, &e->n_chains, &e->score);
+
+        e->legal = 1;
+        e->dead = isDeadBoard(tmp_board);
+        columnHeights(tmp_board, e->heights);
+    }
+}
+
+typedef struct {
+    int (*boards)[ARRS_NUM][ROWS_NUM][COLS_NUM];
+    const int *parent_puyos;
+    const int *child_puyos;
+    ActionEval (*evals)[ACTIONS_NUM];
+} EvaluateBatch;
+
+static void evaluateTask(void *ctx, int begin, int end){
+    EvaluateBatch *batch = (EvaluateBatch *)ctx;
+    for(int i = begin; i < end; i++)
+        evaluateActions(batch->boards[i], batch->parent_puyos[i], batch->child_puyos[i], batch->evals[i]);
+}
+
+// n個の盤面についてevaluateActionsを行う関数
+void evaluateActionsBatch(int (*boards)[ARRS_NUM][ROWS_NUM][COLS_NUM], int n, const int *parent_puyos, const int *child_puyos,
+                          ActionEval (*evals)[ACTIONS_NUM], int n_threads){
+    EvaluateBatch batch = {boards, parent_puyos, child_puyos, evals};
+    parallelFor(n, n_threads, 1, evaluateTask, &batch);
+}
\ No newline at end of file
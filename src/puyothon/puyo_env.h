@@ -0,0 +1,39 @@
+#ifndef _PUYO_ENV_H_
+#define _PUYO_ENV_H_
+
+#include "puyo_func.h"
+#include "puyo_encode.h"
+
+//1手分の結果
+typedef struct {
+    int legal;
+    int n_chains;
+    int score;
+    int dead;
+} StepResult;
+
+//1つの行動を試した結果．置けない行動は全て0
+typedef struct {
+    int legal;
+    int n_chains;
+    int score;
+    int dead;
+    int heights[COLS_NUM-2];
+} ActionEval;
+
+void stepBoard(int (*board)[ROWS_NUM][COLS_NUM], int parent_puyo, int child_puyo, int col, int rot, StepResult *result);
+void stepBoards(int (*boards)[ARRS_NUM][ROWS_NUM][COLS_NUM], int n, const int *parent_puyos, const int *child_puyos, const int *cols, const int *rots, StepResult *results, int n_threads);
+
+int listAbleActions(int (*board)[ROWS_NUM][COLS_NUM], int *able_actions);
+void putForModel(int (*board)[ROWS_NUM][COLS_NUM], int action, int parent_puyo, int child_puyo, int layout, int dtype, void *x);
+int ableBoardsForModel(int (*board)[ROWS_NUM][COLS_NUM], int parent_puyo, int child_puyo, int layout, int dtype, void *x, int *able_actions);
+void stepForModel(int (*board)[ROWS_NUM][COLS_NUM], int parent_puyo, int child_puyo, int action, int next_parent_puyo, int next_child_puyo,
+                  int layout, int dtype, void *x, unsigned char *mask, StepResult *result);
+void ableBoardsForModelBatch(int (*boards)[ARRS_NUM][ROWS_NUM][COLS_NUM], int n, const int *parent_puyos, const int *child_puyos,
+                             int layout, int dtype, void *x, unsigned char (*mask)[ACTIONS_NUM], int n_threads);
+void columnHeights(int (*board)[ROWS_NUM][COLS_NUM], int *heights);
+void evaluateActions(int (*board)[ROWS_NUM][COLS_NUM], int parent_puyo, int child_puyo, ActionEval *evals);
+void evaluateActionsBatch(int (*boards)[ARRS_NUM][ROWS_NUM][COLS_NUM], int n, const int *parent_puyos, const int *child_puyos,
+                          ActionEval (*evals)[ACTIONS_NUM], int n_threads);
+
+#endif //_PUYO_ENV_H_
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include <string.h>
+#include "puyo_feature.h"
+#include "puyo_bitboard.h"
+#include "puyo_env.h"
+#include "puyo_thread.h"
+
+//つながりを数える最上段（isLinkingSeedと同じく12段目まで）
+#define FEATURE_TOP_ROW 12
+
+//12段目までの同色ぷよのグループ．label[i][j]はグループ番号（なければ-1）
+typedef struct {
+    int label[ROWS_NUM][COLS_NUM];
+    int size[FEATURE_TOP_ROW * (COLS_NUM-2)];
+    int color[FEATURE_TOP_ROW * (COLS_NUM-2)];
+    int n_groups;
+} GroupMap;
+
+static void findGroups(int (*board)[ROWS_NUM][COLS_NUM], GroupMap *map){
+    int stack[FEATURE_TOP_ROW * (COLS_NUM-2)][2];
+    memset(map->label, 0xFF, sizeof(map->label));
+    map->n_groups = 0;
+    for(int i = 1; i <= FEATURE_TOP_ROW; i++){
+        for(int j = 1; j < COLS_NUM-1; j++){
+            int p = board[PUYO][i][j];
+            if(p < 1 || p > COLOR_NUM || map->label[i][j] >= 0) continue;
+
+            int g = map->n_groups++;
+            int n_stack = 0, size = 0;
+            map->label[i][j] = g;
+            stack[n_stack][0] = i;
+            stack[n_stack][1] = j;
+            n_stack++;
+            while(n_stack > 0){
+                n_stack--;
+                int y = stack[n_stack][0], x = stack[n_stack][1];
+                size++;
+                const int dy[4] = {1, -1, 0, 0}, dx[4] = {0, 0, 1, -1};
+                for(int d = 0; d < 4; d++){
+                    int ny = y + dy[d], nx = x + dx[d];
+                    if(ny < 1 || ny > FEATURE_TOP_ROW) continue;
+                    if(board[PUYO][ny][nx] != p || map->label[ny][nx] >= 0) continue;
+                    map->label[ny][nx] = g;
+                    stack[n_stack][0] = ny;
+                    stack[n_stack][1] = nx;
+                    n_stack++;
+                }
+            }
+            map->size[g] = size;
+            map->color[g] = p;
+        }
+    }
+}
+
+// (i, j)に色colorのぷよを置いたとき，隣のグループの大きさを重複なく足す
+// seenには足したグループ番号を入れていく
+static int addNeighborGroups(const GroupMap *map, int i, int j, int color, int *seen, int *n_seen){
+    const int dy[4] = {1, -1, 0, 0}, dx[4] = {0, 0, 1, -1};
+    int total = 0;
+    for(int d = 0; d < 4; d++){
+        int ny = i + dy[d], nx = j + dx[d];
+        if(ny < 1 || ny > FEATURE_TOP_ROW) continue;
+        int g = map->label[ny][nx];
+        if(g < 0 || map->color[g] != color) continue;
+        int dup = 0;
+        for(int k = 0; k < *n_seen; k++) dup |= seen[k] == g;
+        if(dup) continue;
+        seen[(*n_seen)++] = g;
+        total += map->size[g];
+    }
+    return total;
+}
+
+// 盤面の連鎖の種の特徴量を求める関数．boardは変更しない．featuresにはFEATURES_NUM個分の領域が必要
+// 各列に各色を1個・2個落としたときの連鎖数とスコアは，落としたぷよが4個以上つながる場合だけ盤面のコピーで連鎖を実行して求める
+void chainFeatures(int (*board)[ROWS_NUM][COLS_NUM], float *features){
+    memset(features, 0, sizeof(float) * FEATURES_NUM);
+    GroupMap map;
+    findGroups(board, &map);
+
+    int heights[COLS_NUM-2];
+    columnHeights(board, heights);
+
+    for(int j = 1; j < COLS_NUM-1; j++){
+        int i = 1;
+        while(i <= FEATURE_TOP_ROW && board[PUYO][i][j] != EMPTY) i++;
+        for(int color = 1; color <= COLOR_NUM; color++){
+            int seen[8], n_seen = 0, linked = 0;
+            for(int k = 0; k < FEATURE_DROPS; k++){
+                int row = i + k;
+                if(row > FEATURE_TOP_ROW) break;
+                linked += 1 + addNeighborGroups(&map, row, j, color, seen, &n_seen);
+                if(linked < 4) continue;
+
+                int tmp_board[ARRS_NUM][ROWS_NUM][COLS_NUM];
+                memcpy(tmp_board[PUYO], board[PUYO], sizeof(tmp_board[PUYO]));
+                memset(tmp_board[STATE], 0, sizeof(tmp_board[STATE]));
+                for(int r = i; r <= row; r++){
+                    tmp_board[PUYO][r][j] = color;
+                    tmp_board[STATE][r][j] = NEW;
+                }
+                int n_chains, score;
+                allChainBB(tmp_board, &n_chains, &score);
+                float *f = &features[(((j-1) * COLOR_NUM + color-1) * FEATURE_DROPS + k) * 2];
+                f[0] = (float)n_chains;
+                f[1] = (float)score;
+            }
+        }
+    }
+
+    for(int j = 0; j < COLS_NUM-2; j++) features[FEATURE_HEIGHT_OFFSET + j] = (float)heights[j];
+
+    for(int i = 1; i <= FEATURE_TOP_ROW; i++){
+        for(int j = 1; j < COLS_NUM-1; j++){
+            int p = board[PUYO][i][j];
+            if(p < 1 || p > COLOR_NUM) continue;
+            if(i < FEATURE_TOP_ROW && board[PUYO][i+1][j] == p) features[FEATURE_CONNECT_OFFSET + p-1] += 1.0f;
+            if(board[PUYO][i][j+1] == p) features[FEATURE_CONNECT_OFFSET + p-1] += 1.0f;
+        }
+    }
+
+    for(int g = 0; g < map.n_groups; g++){
+        if(map.size[g] == 2 || map.size[g] == 3)
+            features[FEATURE_GROUP_OFFSET + (map.color[g]-1) * 2 + map.size[g] - 2] += 1.0f;
+    }
+}
+
+typedef struct {
+    int (*boards)[ARRS_NUM][ROWS_NUM][COLS_NUM];
+    float (*features)[FEATURES_NUM];
+} FeatureJob;
+
+static void featureTask(void *ctx, int begin, int end){
+    FeatureJob *job = (FeatureJob *)ctx;
+    for(int i = begin; i < end; i++)
+        chainFeatures(job->boards[i], job->features[i]);
+}
+
+// n個の盤面についてchainFeaturesを行う関数
+void chainFeaturesBatch(int (*boards)[ARRS_NUM][ROWS_NUM][COLS_NUM], int n, float (*features)[FEATURES_NUM], int n_threads){
+    FeatureJob job = {boards, features};
+    parallelFor(n, n_threads, 8, featureTask, &job);
+}
\ No newline at end of file
@@ -0,0 +1,20 @@
+#ifndef _PUYO_FEATURE_H_
+#define _PUYO_FEATURE_H_
+
+#include "puyo_func.h"
+
+//連鎖の種の特徴量の並び（1盤面あたりFEATURES_NUM個のfloat）
+//[0, FEATURE_HEIGHT_OFFSET): 列j・色c・落とす数kごとの(連鎖数, スコア)．番号は((j*COLOR_NUM + c)*FEATURE_DROPS + k)*2
+//[FEATURE_HEIGHT_OFFSET, FEATURE_CONNECT_OFFSET): 各列の高さ
+//[FEATURE_CONNECT_OFFSET, FEATURE_GROUP_OFFSET): 色ごとの上下左右に隣り合う同色ぷよの組の数
+//[FEATURE_GROUP_OFFSET, FEATURES_NUM): 色ごとの2個のグループの数と3個のグループの数
+#define FEATURE_DROPS 2 //落とすぷよの数（1個，2個）
+#define FEATURE_HEIGHT_OFFSET ((COLS_NUM-2) * COLOR_NUM * FEATURE_DROPS * 2)
+#define FEATURE_CONNECT_OFFSET (FEATURE_HEIGHT_OFFSET + (COLS_NUM-2))
+#define FEATURE_GROUP_OFFSET (FEATURE_CONNECT_OFFSET + COLOR_NUM)
+#define FEATURES_NUM (FEATURE_GROUP_OFFSET + COLOR_NUM * 2)
+
+void chainFeatures(int (*board)[ROWS_NUM][COLS_NUM], float *features);
+void chainFeaturesBatch(int (*boards)[ARRS_NUM][ROWS_NUM][COLS_NUM], int n, float (*features)[FEATURES_NUM], int n_threads);
+
+#endif //_PUYO_FEATURE_H_
\ No newline at end of file
@@ -1,6 +1,8 @@
 #ifndef _PUYO_FUNC_H_
 #define _PUYO_FUNC_H_
 
+#include <stdint.h>
+
 //配列の大きさ
 #define ARRS_NUM 2
 #define ROWS_NUM 15
@@ -22,11 +24,45 @@
 #define IDLE 0
 #define NEW 1
 
+//行動の数（列と回転の組み合わせ）
+#define ACTIONS_NUM 22
+
+//連鎖処理のエンジン
+#define ENGINE_ARRAY 0
+#define ENGINE_BITBOARD 1
+
+//1手で書き換えたマスの元の値（マスの番号は (plane*ROWS_NUM + i)*COLS_NUM + j）
+typedef struct {
+    unsigned char index;
+    signed char value;
+} UndoCell;
+
+//makeMoveで1手進めたときの変更記録．unmakeMoveで元の盤面に戻せる
+//各マスは最初に書き換えたときの値だけを記録する
+#define UNDO_MAX_CELLS (ARRS_NUM*ROWS_NUM*COLS_NUM)
+typedef struct {
+    int n_cells;
+    int n_chains;
+    int score;
+    uint64_t seen[(UNDO_MAX_CELLS + 63) / 64];
+    UndoCell cells[UNDO_MAX_CELLS];
+} UndoRecord;
+
+void actionToColRot(int action, int *col, int *rot);
+int isDeadBoard(int (*board)[ROWS_NUM][COLS_NUM]);
+void initBoard(int (*board)[ROWS_NUM][COLS_NUM]);
 int canPut(int (*board)[ROWS_NUM][COLS_NUM], int col, int rot);
+int canPutUncounted(int (*board)[ROWS_NUM][COLS_NUM], int col, int rot);
 int putPuyo(int (*board)[ROWS_NUM][COLS_NUM], int col, int rot, int parent_puyo, int child_puyo);
+int putPuyoHash(int (*board)[ROWS_NUM][COLS_NUM], int col, int rot, int parent_puyo, int child_puyo, uint64_t *hash);
 int eraseLinkingPuyos(int (*board)[ROWS_NUM][COLS_NUM], int i, int j);
 int fallPuyos(int (*board)[ROWS_NUM][COLS_NUM]);
+int fallPuyosHash(int (*board)[ROWS_NUM][COLS_NUM], uint64_t *hash);
+int calcChainScore(int erased_count, int linking_bonus, int color_num, int chain_num);
 int oneChain(int (*board)[ROWS_NUM][COLS_NUM], int chain_num);
 void allChain(int (*board)[ROWS_NUM][COLS_NUM], int *n_chains, int *score);
+int makeMove(int (*board)[ROWS_NUM][COLS_NUM], int col, int rot, int parent_puyo, int child_puyo, UndoRecord *undo);
+void unmakeMove(int (*board)[ROWS_NUM][COLS_NUM], const UndoRecord *undo);
+void toBoardForModel(int (*board)[ROWS_NUM][COLS_NUM], float (*x)[COLS_NUM-2][COLOR_NUM]);
 
 #endif //_PUYO_FUNC_H_
\ No newline at end of file
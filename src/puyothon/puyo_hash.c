@@ -0,0 +1,22 @@
+#include "puyo_hash.h"
+#include "puyo_random.h"
+
+uint64_t zobrist_keys[ROWS_NUM][COLS_NUM][COLOR_NUM+1];
+
+// キー表を初期化する関数．シードは固定なので，どのプロセスでも同じハッシュ値になる
+void initZobrist(void){
+    uint64_t seed = 0x70757930ull;
+    for(int i = 0; i < ROWS_NUM; i++)
+        for(int j = 0; j < COLS_NUM; j++)
+            for(int k = 0; k <= COLOR_NUM; k++)
+                zobrist_keys[i][j][k] = splitmix64Next(&seed);
+}
+
+// puyo面のZobristハッシュを求める関数．空の盤面は0になる
+uint64_t zobristHash(int (*board)[ROWS_NUM][COLS_NUM]){
+    uint64_t hash = 0;
+    for(int i = 1; i < ROWS_NUM; i++)
+        for(int j = 1; j < COLS_NUM-1; j++)
+            hash ^= zobristKey(i, j, board[PUYO][i][j]);
+    return hash;
+}
\ No newline at end of file
@@ -0,0 +1,20 @@
+#ifndef _PUYO_HASH_H_
+#define _PUYO_HASH_H_
+
+#include <stdint.h>
+#include "puyo_func.h"
+
+//Zobristハッシュのキー表．[行][列][0はおじゃま，1~COLOR_NUMは色]
+extern uint64_t zobrist_keys[ROWS_NUM][COLS_NUM][COLOR_NUM+1];
+
+void initZobrist(void);
+uint64_t zobristHash(int (*board)[ROWS_NUM][COLS_NUM]);
+
+// マス(i, j)にあるぷよpのキーを返す．空白やキーのない値は0
+static inline uint64_t zobristKey(int i, int j, int p){
+    if(1 <= p && p <= COLOR_NUM) return zobrist_keys[i][j][p];
+    if(p == OJAMA) return zobrist_keys[i][j][0];
+    return 0;
+}
+
+#endif //_PUYO_HASH_H_
\ No newline at end of file
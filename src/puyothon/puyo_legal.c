@@ -0,0 +1,48 @@
+#include "puyo_legal.h"
+
+uint32_t legal_table[LEGAL_TABLE_SIZE];
+
+//11~14段目の埋まり方 (bit0: 11段目, bit1: 12段目, bit2: 13段目, bit3: 14段目) から分類への対応
+//12段目が空なら14段目は見ない．12段目が埋まっていれば11段目は見ず，13段目も埋まっていれば14段目も見ない
+const unsigned char legal_column_class[16] = {
+    0, 1, 4, 4, 2, 3, 6, 6,
+    0, 1, 5, 5, 2, 3, 6, 6,
+};
+
+//分類ごとの代表の埋まり方
+static const unsigned char class_cells[LEGAL_CLASSES] = {0x0, 0x1, 0x4, 0x5, 0x2, 0xA, 0x6};
+
+// 行動マスクの表を作る関数．各分類の代表の盤面でcanPutを調べて埋める
+// import時に呼ぶので，getStatsの値に入らないよう計測しない版を使う
+void initLegalTable(void){
+    int board[ARRS_NUM][ROWS_NUM][COLS_NUM];
+    initBoard(board);
+    for(int index = 0; index < LEGAL_TABLE_SIZE; index++){
+        int rest = index;
+        for(int j = COLS_NUM-2; j >= 1; j--){
+            int cells = class_cells[rest % LEGAL_CLASSES];
+            rest /= LEGAL_CLASSES;
+            for(int r = 0; r < 4; r++)
+                board[PUYO][11+r][j] = (cells >> r) & 1 ? 1 : EMPTY;
+        }
+
+        //死亡している盤面には置けない
+        if(isDeadBoard(board)){
+            legal_table[index] = 0;
+            continue;
+        }
+        uint32_t mask = 0;
+        for(int action = 0; action < ACTIONS_NUM; action++){
+            int col, rot;
+            actionToColRot(action, &col, &rot);
+            if(canPutUncounted(board, col, rot)) mask |= 1u << action;
+        }
+        legal_table[index] = mask;
+    }
+}
+
+// n個の盤面の行動マスクを求める関数
+void legalActionMasks(int (*boards)[ARRS_NUM][ROWS_NUM][COLS_NUM], int n, uint32_t *masks){
+    for(int i = 0; i < n; i++)
+        masks[i] = legalActionMask(boards[i]);
+}
\ No newline at end of file
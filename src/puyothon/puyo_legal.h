@@ -0,0 +1,29 @@
+#ifndef _PUYO_LEGAL_H_
+#define _PUYO_LEGAL_H_
+
+#include <stdint.h>
+#include "puyo_func.h"
+
+//置ける行動は各列の11~14段目が埋まっているかだけで決まる
+//列ごとの埋まり方をcanPutが区別できる7通りに分類し，6列分の組み合わせごとに行動のマスクを表にする
+#define LEGAL_CLASSES 7
+#define LEGAL_TABLE_SIZE (LEGAL_CLASSES*LEGAL_CLASSES*LEGAL_CLASSES*LEGAL_CLASSES*LEGAL_CLASSES*LEGAL_CLASSES)
+
+extern uint32_t legal_table[LEGAL_TABLE_SIZE];
+extern const unsigned char legal_column_class[16];
+
+void initLegalTable(void);
+void legalActionMasks(int (*boards)[ARRS_NUM][ROWS_NUM][COLS_NUM], int n, uint32_t *masks);
+
+// 置ける行動のマスクを返す関数．bit aが1なら行動番号aは置ける（canPutと同じ判定）
+static inline uint32_t legalActionMask(int (*board)[ROWS_NUM][COLS_NUM]){
+    int index = 0;
+    for(int j = 1; j < COLS_NUM-1; j++){
+        int key = (board[PUYO][11][j] != EMPTY) | (board[PUYO][12][j] != EMPTY) << 1
+                | (board[PUYO][13][j] != EMPTY) << 2 | (board[PUYO][14][j] != EMPTY) << 3;
+        index = index * LEGAL_CLASSES + legal_column_class[key];
+    }
+    return legal_table[index];
+}
+
+#endif //_PUYO_LEGAL_H_
\ No newline at end of file
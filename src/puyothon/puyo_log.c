@@ -0,0 +1,138 @@
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include "puyo_log.h"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#include <windows.h>
+#define logSeek _fseeki64
+#define logTell _ftelli64
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#define logSeek fseeko
+#define logTell ftello
+#endif
+
+static void storeU32(unsigned char *p, uint32_t x){
+    for(int b = 0; b < 4; b++)
+        p[b] = (unsigned char)(x >> (8*b));
+}
+
+static void makeHeader(unsigned char *header){
+    memset(header, 0, LOG_HEADER_BYTES);
+    memcpy(header, LOG_MAGIC, sizeof(LOG_MAGIC));
+    storeU32(header + 8, LOG_VERSION);
+    storeU32(header + 12, LOG_RECORD_BYTES);
+    storeU32(header + 16, LOG_HEADER_BYTES);
+    storeU32(header + 20, ROWS_NUM);
+    storeU32(header + 24, COLS_NUM);
+    storeU32(header + 28, COLOR_NUM);
+}
+
+static void encodeRecord(const LogRecord *record, unsigned char *bytes){
+    packedToBytes(&record->board, bytes);
+    bytes[PACK_BYTES + 0] = (unsigned char)record->parent_puyo;
+    bytes[PACK_BYTES + 1] = (unsigned char)record->child_puyo;
+    bytes[PACK_BYTES + 2] = (unsigned char)record->action;
+    bytes[PACK_BYTES + 3] = (unsigned char)record->n_chains;
+    storeU32(bytes + PACK_BYTES + 4, (uint32_t)record->score);
+}
+
+// ファイルを開き（なければ空のファイルを作り），排他ロックを取る関数
+// 他のプロセスが追記している間は終わるまで待つ．ロックはcloseLockedで外す
+static FILE *openLocked(const char *path){
+#ifdef _WIN32
+    int fd = _open(path, _O_RDWR | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+    if(fd < 0) return NULL;
+    OVERLAPPED overlapped = {0};
+    if(!LockFileEx((HANDLE)_get_osfhandle(fd), LOCKFILE_EXCLUSIVE_LOCK, 0, MAXDWORD, MAXDWORD, &overlapped)){
+        _close(fd);
+        errno = EACCES;
+        return NULL;
+    }
+    FILE *fp = _fdopen(fd, "r+b");
+    if(fp == NULL) _close(fd);
+    return fp;
+#else
+    int fd = open(path, O_RDWR | O_CREAT, 0666);
+    if(fd < 0) return NULL;
+    int ret;
+    do{
+        ret = flock(fd, LOCK_EX);
+    }while(ret != 0 && errno == EINTR);
+    FILE *fp = ret == 0 ? fdopen(fd, "r+b") : NULL;
+    if(fp == NULL){
+        int err = errno;
+        close(fd);
+        errno = err;
+    }
+    return fp;
+#endif
+}
+
+// 書き込みを終えてからロックを外して閉じる関数．flockはcloseで外れる
+static int closeLocked(FILE *fp){
+    int ret = fflush(fp);
+#ifdef _WIN32
+    OVERLAPPED overlapped = {0};
+    UnlockFileEx((HANDLE)_get_osfhandle(_fileno(fp)), 0, MAXDWORD, MAXDWORD, &overlapped);
+#endif
+    if(fclose(fp) != 0) ret = EOF;
+    return ret == 0 ? 0 : -1;
+}
+
+// 対局ログにn個のレコードを追記し，追記後のレコード数を返す関数
+// ファイルがなければヘッダを書いて作る．末尾に途中までしか書かれていないレコードがあれば上書きする
+// 追記の間はファイルに排他ロックを取るので，複数のプロセスから同じファイルに追記してよい
+// 失敗したら-1（errnoを設定），ヘッダが合わなければ-2を返す
+long long appendGameLog(const char *path, const LogRecord *records, int n){
+    unsigned char header[LOG_HEADER_BYTES];
+    makeHeader(header);
+
+    FILE *fp = openLocked(path);
+    if(fp == NULL) return -1;
+    if(logSeek(fp, 0, SEEK_END) != 0){
+        closeLocked(fp);
+        return -1;
+    }
+    if(logTell(fp) == 0){
+        //作ったばかりのファイル
+        if(logSeek(fp, 0, SEEK_SET) != 0 || fwrite(header, 1, LOG_HEADER_BYTES, fp) != LOG_HEADER_BYTES){
+            closeLocked(fp);
+            return -1;
+        }
+    }else{
+        unsigned char existing[LOG_HEADER_BYTES];
+        if(logSeek(fp, 0, SEEK_SET) != 0 || fread(existing, 1, LOG_HEADER_BYTES, fp) != LOG_HEADER_BYTES ||
+           memcmp(existing, header, 32) != 0){
+            closeLocked(fp);
+            return -2;
+        }
+    }
+
+    if(logSeek(fp, 0, SEEK_END) != 0){
+        closeLocked(fp);
+        return -1;
+    }
+    long long count = ((long long)logTell(fp) - LOG_HEADER_BYTES) / LOG_RECORD_BYTES;
+    if(logSeek(fp, LOG_HEADER_BYTES + count * LOG_RECORD_BYTES, SEEK_SET) != 0){
+        closeLocked(fp);
+        return -1;
+    }
+
+    unsigned char bytes[LOG_RECORD_BYTES];
+    for(int i = 0; i < n; i++){
+        encodeRecord(&records[i], bytes);
+        if(fwrite(bytes, 1, LOG_RECORD_BYTES, fp) != LOG_RECORD_BYTES){
+            closeLocked(fp);
+            return -1;
+        }
+    }
+    if(closeLocked(fp) != 0) return -1;
+    return count + n;
+}
\ No newline at end of file
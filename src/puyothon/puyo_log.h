@@ -0,0 +1,26 @@
+#ifndef _PUYO_LOG_H_
+#define _PUYO_LOG_H_
+
+#include "puyo_pack.h"
+
+//対局ログのファイル形式
+//先頭にLOG_HEADER_BYTESバイトのヘッダ，その後にLOG_RECORD_BYTESバイトのレコードが並ぶ追記専用の形式
+//ヘッダ: magic "PUYOLOG\0"，version，レコード長，ヘッダ長，ROWS_NUM，COLS_NUM，COLOR_NUM（全てuint32，リトルエンディアン）
+//レコード: 詰めた盤面(PACK_BYTES)，親ぷよ，子ぷよ，行動，連鎖数（各uint8），スコア（int32，リトルエンディアン）
+#define LOG_MAGIC "PUYOLOG"
+#define LOG_VERSION 1
+#define LOG_HEADER_BYTES 64
+#define LOG_RECORD_BYTES (PACK_BYTES + 8)
+
+typedef struct {
+    PackedBoard board;
+    int parent_puyo;
+    int child_puyo;
+    int action;
+    int n_chains;
+    int score;
+} LogRecord;
+
+long long appendGameLog(const char *path, const LogRecord *records, int n);
+
+#endif //_PUYO_LOG_H_
\ No newline at end of file
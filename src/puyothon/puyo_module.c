@@ -3,10 +3,54 @@
 #define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
 #include <numpy/arrayobject.h>
 #include "puyo_func.h"
+#include "puyo_bitboard.h"
+#include "puyo_env.h"
+#include "puyo_encode.h"
+#include "puyo_search.h"
+#include "puyo_hash.h"
+#include "puyo_cache.h"
+#include "puyo_rollout.h"
+#include "puyo_versus.h"
+#include "puyo_pack.h"
+#include "puyo_replay.h"
+#include "puyo_shm.h"
+#include "puyo_log.h"
+#include "puyo_stats.h"
+#include "puyo_legal.h"
+#include "puyo_simd.h"
+#include "puyo_augment.h"
+#include "puyo_tsumo.h"
+#include "puyo_feature.h"
+#include "puyo_variant.h"
+#include "puyo_thread.h"
 
+//盤面をオブジェクトの中に直接持つ．ndarrayの確認を省けるので1手ごとの呼び出しが軽い
+typedef struct {
+    PyObject_HEAD
+    int board[ARRS_NUM][ROWS_NUM][COLS_NUM];
+} BoardObject;
 
-// PyObjectから配列を取得しboardにポインタを渡す関数（読み取り専用）
-int toBoard_ro(PyObject *obj, int (**board)[ROWS_NUM][COLS_NUM]) {
+//型はモジュールごとにヒープ型として作る．静的型と同じく属性の書き換えは禁止する（3.10以降）
+#ifdef Py_TPFLAGS_IMMUTABLETYPE
+#define PUYO_TPFLAGS_IMMUTABLE Py_TPFLAGS_IMMUTABLETYPE
+#else
+#define PUYO_TPFLAGS_IMMUTABLE 0
+#endif
+
+static PyObject* Board_new(PyTypeObject *type, PyObject *args, PyObject *kwds);
+
+//Boardかその派生クラスのインスタンスか判定する関数
+//Board型はモジュール（インタプリタ）ごとに作るので，型オブジェクトではなくtp_newで見分ける
+static int isBoardObject(PyObject *obj){
+    for (PyTypeObject *type = Py_TYPE(obj); type != NULL; type = type->tp_base) {
+        if (type->tp_new == Board_new) return 1;
+    }
+    return 0;
+}
+
+
+// PyObjectから形 (ARRS_NUM, rows, cols) の配列を取得しboardにポインタを渡す関数（読み取り専用）
+static int toBoardShape_ro(PyObject *obj, int rows, int cols, int **board) {
     if (!PyArray_Check(obj)) {
         PyErr_SetString(PyExc_TypeError, "ndarray is required");
         return -1;
@@ -25,8 +69,8 @@ int toBoard_ro(PyObject *obj, int (**board)[ROWS_NUM][COLS_NUM]) {
     }
     /* 形状チェック */
     npy_intp const *dims = PyArray_DIMS(arr);
-    if (dims[0] != ARRS_NUM || dims[1] != ROWS_NUM || dims[2] != COLS_NUM) {
-        PyErr_Format(PyExc_ValueError, "shape must be (%d,%d,%d), got (%" NPY_INTP_FMT ",%" NPY_INTP_FMT ",%" NPY_INTP_FMT ")", ARRS_NUM, ROWS_NUM, COLS_NUM, dims[0], dims[1], dims[2]);
+    if (dims[0] != ARRS_NUM || dims[1] != rows || dims[2] != cols) {
+        PyErr_Format(PyExc_ValueError, "shape must be (%d,%d,%d), got (%" NPY_INTP_FMT ",%" NPY_INTP_FMT ",%" NPY_INTP_FMT ")", ARRS_NUM, rows, cols, dims[0], dims[1], dims[2]);
         return -1;
     }
     /* 連続 & アライン（※コピー禁止なので必須） */
@@ -40,16 +84,122 @@ int toBoard_ro(PyObject *obj, int (**board)[ROWS_NUM][COLS_NUM]) {
         return -1;
     }
 
-    *board = (int (*)[ROWS_NUM][COLS_NUM])PyArray_DATA(arr);
+    *board = (int *)PyArray_DATA(arr);
+    return 0;
+}
+
+// PyObjectから形 (ARRS_NUM, rows, cols) の配列を取得しboardにポインタを渡す関数（読み書き可）
+static int toBoardShape_rw(PyObject *obj, int rows, int cols, int **board) {
+    if (toBoardShape_ro(obj, rows, cols, board) != 0)
+        return -1;
+
+    /* 書き込み可能か確認（read-only のビューは拒否） */
+    PyArrayObject *arr = (PyArrayObject *)obj;
+    if (!(PyArray_FLAGS(arr) & NPY_ARRAY_WRITEABLE)) {
+        PyErr_SetString(PyExc_ValueError, "array must be writeable");
+        return -1;
+    }
     return 0;
 }
 
+// PyObjectから配列を取得しboardにポインタを渡す関数（読み取り専用）
+int toBoard_ro(PyObject *obj, int (**board)[ROWS_NUM][COLS_NUM]) {
+    return toBoardShape_ro(obj, ROWS_NUM, COLS_NUM, (int **)board);
+}
+
 // PyObjectから配列を取得しboardにポインタを渡す関数（読み書き可）
 int toBoard_rw(PyObject *obj, int (**board)[ROWS_NUM][COLS_NUM]) {
-    if (toBoard_ro(obj, board) != 0)
+    return toBoardShape_rw(obj, ROWS_NUM, COLS_NUM, (int **)board);
+}
+
+//ルールの番号から種類を取得する関数
+static const RuleVariant* toRuleVariant(int variant){
+    const RuleVariant *v = getRuleVariant(variant);
+    if (v == NULL) PyErr_Format(PyExc_ValueError, "invalid variant: %d", variant);
+    return v;
+}
+
+//連鎖のエンジンの番号を確認する関数
+static int checkEngine(int engine){
+    if (engine != ENGINE_ARRAY && engine != ENGINE_BITBOARD) {
+        PyErr_Format(PyExc_ValueError, "invalid engine: %d", engine);
+        return -1;
+    }
+    return 0;
+}
+
+//連鎖のエンジンがルールに対応しているか確認する関数．ビットボードは標準のルール専用
+static int checkVariantEngine(int variant, int engine){
+    if (engine == ENGINE_BITBOARD && variant != VARIANT_STANDARD) {
+        PyErr_SetString(PyExc_ValueError, "ENGINE_BITBOARD supports only VARIANT_STANDARD");
+        return -1;
+    }
+    return 0;
+}
+
+// ndarrayかBoardからboardにポインタを渡す関数（読み取り専用）
+static int toBoardOrObject_ro(PyObject *obj, int (**board)[ROWS_NUM][COLS_NUM]) {
+    if (isBoardObject(obj)) {
+        *board = ((BoardObject *)obj)->board;
+        return 0;
+    }
+    return toBoard_ro(obj, board);
+}
+
+// ndarrayかBoardからboardにポインタを渡す関数（読み書き可）
+static int toBoardOrObject_rw(PyObject *obj, int (**board)[ROWS_NUM][COLS_NUM]) {
+    if (isBoardObject(obj)) {
+        *board = ((BoardObject *)obj)->board;
+        return 0;
+    }
+    return toBoard_rw(obj, board);
+}
+
+// PyObjectから盤面の束 (N, ARRS_NUM, ROWS_NUM, COLS_NUM) を取得しboardsにポインタを渡す関数（読み取り専用）
+int toBoards_ro(PyObject *obj, int (**boards)[ARRS_NUM][ROWS_NUM][COLS_NUM], int *n) {
+    if (!PyArray_Check(obj)) {
+        PyErr_SetString(PyExc_TypeError, "ndarray is required");
+        return -1;
+    }
+    PyArrayObject *arr = (PyArrayObject *)obj;
+
+    if (PyArray_TYPE(arr) != NPY_INT32) {
+        PyErr_SetString(PyExc_TypeError, "dtype must be int32");
+        return -1;
+    }
+    if (PyArray_NDIM(arr) != 4) {
+        PyErr_SetString(PyExc_ValueError, "array must be 4D");
+        return -1;
+    }
+    npy_intp const *dims = PyArray_DIMS(arr);
+    if (dims[1] != ARRS_NUM || dims[2] != ROWS_NUM || dims[3] != COLS_NUM) {
+        PyErr_Format(PyExc_ValueError, "shape must be (N,%d,%d,%d), got (%" NPY_INTP_FMT ",%" NPY_INTP_FMT ",%" NPY_INTP_FMT ",%" NPY_INTP_FMT ")", ARRS_NUM, ROWS_NUM, COLS_NUM, dims[0], dims[1], dims[2], dims[3]);
+        return -1;
+    }
+    if (dims[0] > INT_MAX) {
+        PyErr_SetString(PyExc_ValueError, "too many boards");
+        return -1;
+    }
+    unsigned int flags = PyArray_FLAGS(arr);
+    if (!(flags & NPY_ARRAY_C_CONTIGUOUS)) {
+        PyErr_SetString(PyExc_ValueError, "array must be C-contiguous");
+        return -1;
+    }
+    if (!(flags & NPY_ARRAY_ALIGNED)) {
+        PyErr_SetString(PyExc_ValueError, "array must be aligned");
+        return -1;
+    }
+
+    *boards = (int (*)[ARRS_NUM][ROWS_NUM][COLS_NUM])PyArray_DATA(arr);
+    *n = (int)dims[0];
+    return 0;
+}
+
+// PyObjectから盤面の束を取得しboardsにポインタを渡す関数（読み書き可）
+int toBoards_rw(PyObject *obj, int (**boards)[ARRS_NUM][ROWS_NUM][COLS_NUM], int *n) {
+    if (toBoards_ro(obj, boards, n) != 0)
         return -1;
 
-    /* 書き込み可能か確認（read-only のビューは拒否） */
     PyArrayObject *arr = (PyArrayObject *)obj;
     if (!(PyArray_FLAGS(arr) & NPY_ARRAY_WRITEABLE)) {
         PyErr_SetString(PyExc_ValueError, "array must be writeable");
@@ -58,47 +208,183 @@ int toBoard_rw(PyObject *obj, int (**board)[ROWS_NUM][COLS_NUM]) {
     return 0;
 }
 
-void toBoardForModel(int (*board)[ROWS_NUM][COLS_NUM], float (*x)[COLS_NUM-2][COLOR_NUM]){
-    memset(x, 0, sizeof(float)*(ROWS_NUM-1)*(COLS_NUM-2)*(COLOR_NUM));
-    for (int i = 1; i < ROWS_NUM; i++) {
-        for(int j = 1; j < COLS_NUM-1; j++){
-            int p = board[PUYO][i][j];
-            if(1 <= p && p <= (COLOR_NUM)){
-                x[i-1][j-1][p-1] = 1.0f;
-            }
+// PyObjectを長さnのint32配列に変換する関数（必要ならコピーされる）
+PyArrayObject* toIntArray(PyObject *obj, int n, const char *name) {
+    PyArrayObject *arr = (PyArrayObject *)PyArray_FROMANY(obj, NPY_INT32, 1, 1, NPY_ARRAY_IN_ARRAY | NPY_ARRAY_FORCECAST);
+    if (arr == NULL) return NULL;
+    if (PyArray_DIM(arr, 0) != n) {
+        PyErr_Format(PyExc_ValueError, "%s must have length %d", name, n);
+        Py_DECREF(arr);
+        return NULL;
+    }
+    return arr;
+}
+
+// PyObjectを長さnのfloat64配列に変換する関数（必要ならコピーされる）
+PyArrayObject* toDoubleArray(PyObject *obj, int n, const char *name) {
+    PyArrayObject *arr = (PyArrayObject *)PyArray_FROMANY(obj, NPY_FLOAT64, 1, 1, NPY_ARRAY_IN_ARRAY | NPY_ARRAY_FORCECAST);
+    if (arr == NULL) return NULL;
+    if (PyArray_DIM(arr, 0) != n) {
+        PyErr_Format(PyExc_ValueError, "%s must have length %d", name, n);
+        Py_DECREF(arr);
+        return NULL;
+    }
+    return arr;
+}
+
+// 出力先のNumPy配列を確認し，データへのポインタを返す関数
+// dimsの要素が負の場合，その次元の大きさは問わない
+void* toOutArray(PyObject *obj, int type, int ndim, const npy_intp *dims, const char *name) {
+    if (!PyArray_Check(obj)) {
+        PyErr_Format(PyExc_TypeError, "%s must be ndarray", name);
+        return NULL;
+    }
+    PyArrayObject *arr = (PyArrayObject *)obj;
+
+    if (PyArray_TYPE(arr) != type) {
+        PyArray_Descr *descr = PyArray_DescrFromType(type);
+        PyErr_Format(PyExc_TypeError, "%s: dtype must be %c", name, descr ? descr->type : '?');
+        Py_XDECREF(descr);
+        return NULL;
+    }
+    if (PyArray_NDIM(arr) != ndim) {
+        PyErr_Format(PyExc_ValueError, "%s must be %dD", name, ndim);
+        return NULL;
+    }
+    for (int k = 0; k < ndim; k++) {
+        if (dims[k] >= 0 && PyArray_DIM(arr, k) != dims[k]) {
+            PyErr_Format(PyExc_ValueError, "%s: dimension %d must be %" NPY_INTP_FMT ", got %" NPY_INTP_FMT, name, k, dims[k], PyArray_DIM(arr, k));
+            return NULL;
         }
     }
+    unsigned int flags = PyArray_FLAGS(arr);
+    if (!(flags & NPY_ARRAY_C_CONTIGUOUS) || !(flags & NPY_ARRAY_ALIGNED) || !(flags & NPY_ARRAY_WRITEABLE)) {
+        PyErr_Format(PyExc_ValueError, "%s must be C-contiguous, aligned and writeable", name);
+        return NULL;
+    }
+    return PyArray_DATA(arr);
+}
+
+//モデル入力の形式を確認する関数
+static int checkEncoding(int layout, int dtype){
+    if (!isValidEncoding(layout, dtype)) {
+        PyErr_Format(PyExc_ValueError, "invalid encoding: layout=%d, dtype=%d", layout, dtype);
+        return -1;
+    }
+    return 0;
+}
+
+//dtypeに対応するnumpyの型番号
+static int encodedTypenum(int dtype){
+    switch(dtype){
+        case DTYPE_FLOAT32: return NPY_FLOAT32;
+        case DTYPE_FLOAT16: return NPY_FLOAT16;
+        default:            return NPY_UINT8;
+    }
+}
+
+//ルールvでのn盤面分のモデル入力の形をdimsに設定し，次元数を返す関数
+static int variantEncodedShape(const RuleVariant *v, int layout, int dtype, npy_intp n, npy_intp *dims){
+    dims[0] = n;
+    if (dtype == DTYPE_BITS) {
+        dims[1] = variantEncodedBytes(v, dtype);
+        return 2;
+    }
+    if (layout == LAYOUT_NHWC) {
+        dims[1] = v->rows-1; dims[2] = v->cols-2; dims[3] = v->colors;
+    } else {
+        dims[1] = v->colors; dims[2] = v->rows-1; dims[3] = v->cols-2;
+    }
+    return 4;
+}
+
+//n盤面分のモデル入力の形をdimsに設定し，次元数を返す関数
+static int encodedShape(int layout, int dtype, npy_intp n, npy_intp *dims){
+    return variantEncodedShape(&rule_variants[VARIANT_STANDARD], layout, dtype, n, dims);
+}
+
+//1盤面board_bytesバイトのモデル入力の書き込み先を取得する関数
+//bufferプロトコルに対応した書き込み可能でC連続なオブジェクトを受け付ける．成功したら呼び出し側でPyBuffer_Releaseする
+static int getEncodedBufferBytes(PyObject *obj, int dtype, Py_ssize_t n_boards, Py_ssize_t board_bytes, Py_buffer *view, const char *name){
+    if (PyObject_GetBuffer(obj, view, PyBUF_C_CONTIGUOUS | PyBUF_WRITABLE | PyBUF_FORMAT) != 0) {
+        return -1;
+    }
+    Py_ssize_t itemsize = dtype == DTYPE_FLOAT32 ? 4 : dtype == DTYPE_FLOAT16 ? 2 : 1;
+    char expected = dtype == DTYPE_FLOAT32 ? 'f' : dtype == DTYPE_FLOAT16 ? 'e' : 'B';
+    const char *format = view->format ? view->format : "B";
+    while (*format == '@' || *format == '=' || *format == '<') format++;
+    int ok = view->itemsize == itemsize && format[1] == '\0' &&
+             (format[0] == expected || (itemsize == 1 && (format[0] == 'b' || format[0] == 'c' || format[0] == '?')));
+    if (!ok) {
+        PyErr_Format(PyExc_TypeError, "%s: element format '%s' does not match dtype %d", name, view->format ? view->format : "B", dtype);
+        PyBuffer_Release(view);
+        return -1;
+    }
+    if (((uintptr_t)view->buf % (uintptr_t)itemsize) != 0) {
+        PyErr_Format(PyExc_ValueError, "%s must be aligned", name);
+        PyBuffer_Release(view);
+        return -1;
+    }
+    Py_ssize_t required = n_boards * board_bytes;
+    if (view->len < required) {
+        PyErr_Format(PyExc_ValueError, "%s must hold at least %zd bytes, got %zd", name, required, view->len);
+        PyBuffer_Release(view);
+        return -1;
+    }
+    return 0;
+}
+
+//モデル入力の書き込み先を取得する関数
+static int getEncodedBuffer(PyObject *obj, int dtype, Py_ssize_t n_boards, Py_buffer *view, const char *name){
+    return getEncodedBufferBytes(obj, dtype, n_boards, encodedBytes(dtype), view, name);
 }
 
 static PyObject* cvtBoardForModel(PyObject *self, PyObject *args){
     PyObject *input_array_obj;
+    PyObject *out_obj = Py_None;
+    int layout = LAYOUT_NHWC, dtype = DTYPE_FLOAT32;
+    int variant = VARIANT_STANDARD;
     
-    if (!PyArg_ParseTuple(args, "O!", &PyArray_Type, &input_array_obj)) {
+    if (!PyArg_ParseTuple(args, "O!|iiOi", &PyArray_Type, &input_array_obj, &layout, &dtype, &out_obj, &variant)) {
         PyErr_SetString(PyExc_TypeError, "Failed to parse.");
         return NULL;
     }
+    if (checkEncoding(layout, dtype) != 0) return NULL;
+    const RuleVariant *v = toRuleVariant(variant);
+    if (v == NULL) return NULL;
     
     //配列を取得
-    int (*board)[ROWS_NUM][COLS_NUM];
-    if(toBoard_ro(input_array_obj, &board) != 0){
+    int *board;
+    if(toBoardShape_ro(input_array_obj, v->rows, v->cols, &board) != 0){
         return NULL;
     }
 
+    //書き込み先が指定されていればそこに書き込む
+    if (out_obj != Py_None) {
+        Py_buffer view;
+        if (getEncodedBufferBytes(out_obj, dtype, 1, variantEncodedBytes(v, dtype), &view, "out") != 0) return NULL;
+        Py_BEGIN_ALLOW_THREADS
+        v->encodeBoard(board, layout, dtype, view.buf);
+        Py_END_ALLOW_THREADS
+        PyBuffer_Release(&view);
+        Py_INCREF(out_obj);
+        return out_obj;
+    }
+
     // 配列の次元とサイズを設定
-    npy_intp dims[4] = {1, ROWS_NUM-1, COLS_NUM-2, COLOR_NUM};
+    npy_intp dims[4];
+    int ndim = variantEncodedShape(v, layout, dtype, 1, dims);
     
     // NumPy配列を作成
-    PyArrayObject *x = (PyArrayObject*)PyArray_SimpleNew(4, dims, NPY_FLOAT32);
+    PyArrayObject *x = (PyArrayObject*)PyArray_SimpleNew(ndim, dims, encodedTypenum(dtype));
 
     if (x == NULL) {
         return PyErr_NoMemory();
     }
 
-    PyArray_FILLWBYTE(x, 0);
-
-    float (*x_data)[ROWS_NUM-1][COLS_NUM-2][COLOR_NUM] = (float (*)[ROWS_NUM-1][COLS_NUM-2][COLOR_NUM])PyArray_DATA(x);
-
-    toBoardForModel(board, x_data[0]);
+    Py_BEGIN_ALLOW_THREADS
+    v->encodeBoard(board, layout, dtype, PyArray_DATA(x));
+    Py_END_ALLOW_THREADS
 
     return (PyObject*)x;
 }
@@ -106,10 +392,12 @@ static PyObject* cvtBoardForModel(PyObject *self, PyObject *args){
 static PyObject* getAbleBoardsForModel(PyObject *self, PyObject *args){
     PyObject *board;
     int parent_puyo, child_puyo;
-    if (!PyArg_ParseTuple(args, "O!ii", &PyArray_Type, &board, &parent_puyo, &child_puyo)) {
+    int layout = LAYOUT_NHWC, dtype = DTYPE_FLOAT32;
+    if (!PyArg_ParseTuple(args, "O!ii|ii", &PyArray_Type, &board, &parent_puyo, &child_puyo, &layout, &dtype)) {
         PyErr_SetString(PyExc_TypeError, "Failed to parse.");
         return NULL;
     }
+    if (checkEncoding(layout, dtype) != 0) return NULL;
     
     //配列を取得
     int (*board_data)[ROWS_NUM][COLS_NUM];
@@ -117,45 +405,36 @@ static PyObject* getAbleBoardsForModel(PyObject *self, PyObject *args){
         return NULL;
     }
 
-    int able_actions_num = 0;
-    int able_actions[22];
-    int action_col[22];
-    int action_rot[22];
-    for(int action = 0; action < 22; action++){
-        int a = action;
-        if(a >= 3) a++;
-        if(a >= 21) a++;
-        
-        int col = a / 4 + 1;
-        int rot = a % 4;
-
-        if(canPut(board_data, col, rot)){
-            able_actions[able_actions_num] = action;
-            action_col[able_actions_num] = col;
-            action_rot[able_actions_num] = rot;
-            able_actions_num++;
-        }
-    }
+    int able_actions[ACTIONS_NUM];
+    int able_actions_num;
+    Py_BEGIN_ALLOW_THREADS
+    able_actions_num = listAbleActions(board_data, able_actions);
+    Py_END_ALLOW_THREADS
 
     // 配列の次元とサイズを設定
-    npy_intp result_dims[4] = {able_actions_num, ROWS_NUM-1, COLS_NUM-2, COLOR_NUM};
+    npy_intp result_dims[4];
+    int result_ndim = encodedShape(layout, dtype, able_actions_num, result_dims);
     npy_intp able_actions_obj_dims[1] = {able_actions_num};
     
     // NumPy配列を作成
-    PyArrayObject *result = (PyArrayObject*)PyArray_SimpleNew(4, result_dims, NPY_FLOAT32);
-    PyArrayObject *able_actions_obj = (PyArrayObject*)PyArray_SimpleNew(1, able_actions_obj_dims, NPY_INT);
+    PyArrayObject *result = (PyArrayObject*)PyArray_SimpleNew(result_ndim, result_dims, encodedTypenum(dtype));
     if (result == NULL) {
         return PyErr_NoMemory();
     }
-    float (*result_data)[ROWS_NUM-1][COLS_NUM-2][COLOR_NUM] = (float (*)[ROWS_NUM-1][COLS_NUM-2][COLOR_NUM])PyArray_DATA(result);
+    PyArrayObject *able_actions_obj = (PyArrayObject*)PyArray_SimpleNew(1, able_actions_obj_dims, NPY_INT);
+    if (able_actions_obj == NULL) {
+        Py_DECREF(result);
+        return PyErr_NoMemory();
+    }
+    char *result_data = (char*)PyArray_DATA(result);
     int *able_actions_data = (int*)PyArray_DATA(able_actions_obj);
+    int stride = encodedBytes(dtype);
+    Py_BEGIN_ALLOW_THREADS
     for(int i = 0; i < able_actions_num; i++){
-        int tmp_board_data[ARRS_NUM][ROWS_NUM][COLS_NUM];
-        memcpy(tmp_board_data, board_data, sizeof(int)*ARRS_NUM*ROWS_NUM*COLS_NUM);
-        putPuyo(tmp_board_data, action_col[i], action_rot[i], parent_puyo, child_puyo);
-        toBoardForModel(tmp_board_data, result_data[i]);
+        putForModel(board_data, able_actions[i], parent_puyo, child_puyo, layout, dtype, result_data + (size_t)i * stride);
         able_actions_data[i] = able_actions[i];
     }
+    Py_END_ALLOW_THREADS
 
     // 2つの配列を含むタプルを作成
     PyObject *tuple = PyTuple_New(2);
@@ -181,27 +460,248 @@ static PyObject* getAbleBoardsForModel(PyObject *self, PyObject *args){
     return tuple;
 }
 
+//getAbleBoardsForModelの結果を呼び出し側が用意したバッファに書き込む関数
+static PyObject* getAbleBoardsForModelInto(PyObject *self, PyObject *args){
+    PyObject *board, *out_obj, *actions_obj;
+    int parent_puyo, child_puyo;
+    int layout = LAYOUT_NHWC, dtype = DTYPE_FLOAT32;
+    if (!PyArg_ParseTuple(args, "O!iiOO|ii", &PyArray_Type, &board, &parent_puyo, &child_puyo, &out_obj, &actions_obj, &layout, &dtype)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse.");
+        return NULL;
+    }
+    if (checkEncoding(layout, dtype) != 0) return NULL;
+
+    //配列を取得
+    int (*board_data)[ROWS_NUM][COLS_NUM];
+    if(toBoard_ro(board, &board_data) != 0){
+        return NULL;
+    }
+
+    npy_intp actions_dims[1] = {ACTIONS_NUM};
+    void *actions = toOutArray(actions_obj, NPY_INT32, 1, actions_dims, "actions");
+    if (actions == NULL) return NULL;
+    Py_buffer out;
+    if (getEncodedBuffer(out_obj, dtype, ACTIONS_NUM, &out, "out") != 0) return NULL;
+
+    int able_actions_num;
+    Py_BEGIN_ALLOW_THREADS
+    able_actions_num = ableBoardsForModel(board_data, parent_puyo, child_puyo, layout, dtype, out.buf, (int *)actions);
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&out);
+    return PyLong_FromLong(able_actions_num);
+}
+
+//N個の盤面についてgetAbleBoardsForModelを行い，行動番号の位置に書き込む関数
+static PyObject* getAbleBoardsForModelBatch(PyObject *self, PyObject *args){
+    PyObject *boards_obj, *parent_obj, *child_obj, *out_obj, *mask_obj;
+    int n_threads = 1;
+    int layout = LAYOUT_NHWC, dtype = DTYPE_FLOAT32;
+    if (!PyArg_ParseTuple(args, "O!OOOO|iii", &PyArray_Type, &boards_obj, &parent_obj, &child_obj, &out_obj, &mask_obj, &n_threads, &layout, &dtype)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse.");
+        return NULL;
+    }
+    if (checkEncoding(layout, dtype) != 0) return NULL;
+
+    //配列を取得
+    int (*boards)[ARRS_NUM][ROWS_NUM][COLS_NUM];
+    int n;
+    if(toBoards_ro(boards_obj, &boards, &n) != 0){
+        return NULL;
+    }
+
+    npy_intp mask_dims[2] = {n, ACTIONS_NUM};
+    void *mask = toOutArray(mask_obj, NPY_BOOL, 2, mask_dims, "mask");
+    if (mask == NULL) return NULL;
+
+    PyArrayObject *parents = toIntArray(parent_obj, n, "parent_puyos");
+    if (parents == NULL) return NULL;
+    PyArrayObject *children = toIntArray(child_obj, n, "child_puyos");
+    if (children == NULL) {
+        Py_DECREF(parents);
+        return NULL;
+    }
+    Py_buffer out;
+    if (getEncodedBuffer(out_obj, dtype, (Py_ssize_t)n * ACTIONS_NUM, &out, "out") != 0) {
+        Py_DECREF(parents);
+        Py_DECREF(children);
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    ableBoardsForModelBatch(boards, n, (int *)PyArray_DATA(parents), (int *)PyArray_DATA(children),
+                            layout, dtype, out.buf, (unsigned char (*)[ACTIONS_NUM])mask, n_threads);
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&out);
+    Py_DECREF(parents);
+    Py_DECREF(children);
+    Py_RETURN_NONE;
+}
+
+//行動番号で1手進め，次のツモで置ける行動のマスクと置いた後のモデル入力を書き込む関数
+static PyObject* pyStep(PyObject *self, PyObject *args, PyObject *kwds){
+    static char *kwlist[] = {"board", "parent", "child", "action", "next_parent", "next_child", "out", "mask", "layout", "dtype", NULL};
+    PyObject *board_obj, *out_obj = Py_None, *mask_obj = Py_None;
+    int parent_puyo, child_puyo, action, next_parent_puyo, next_child_puyo;
+    int layout = LAYOUT_NHWC, dtype = DTYPE_FLOAT32;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "Oiiiii|OOii", kwlist, &board_obj, &parent_puyo, &child_puyo, &action,
+                                     &next_parent_puyo, &next_child_puyo, &out_obj, &mask_obj, &layout, &dtype)) {
+        return NULL;
+    }
+    if (checkEncoding(layout, dtype) != 0) return NULL;
+
+    int (*board)[ROWS_NUM][COLS_NUM];
+    if (toBoardOrObject_rw(board_obj, &board) != 0) return NULL;
+
+    unsigned char local_mask[ACTIONS_NUM];
+    unsigned char *mask = local_mask;
+    if (mask_obj != Py_None) {
+        npy_intp mask_dims[1] = {ACTIONS_NUM};
+        mask = (unsigned char *)toOutArray(mask_obj, NPY_BOOL, 1, mask_dims, "mask");
+        if (mask == NULL) return NULL;
+    }
+    Py_buffer out;
+    out.buf = NULL;
+    if (out_obj != Py_None && getEncodedBuffer(out_obj, dtype, ACTIONS_NUM, &out, "out") != 0) return NULL;
+
+    StepResult result;
+    Py_BEGIN_ALLOW_THREADS
+    stepForModel(board, parent_puyo, child_puyo, action, next_parent_puyo, next_child_puyo, layout, dtype, out.buf, mask, &result);
+    Py_END_ALLOW_THREADS
+
+    if (out_obj != Py_None) PyBuffer_Release(&out);
+    return Py_BuildValue("(NiiN)", PyBool_FromLong(result.legal), result.n_chains, result.score, PyBool_FromLong(result.dead));
+}
+
+//置ける行動のマスク（bit aが行動番号a）を返す関数
+static PyObject* pyLegalActionMask(PyObject *self, PyObject *board_obj){
+    int (*board)[ROWS_NUM][COLS_NUM];
+    if (toBoardOrObject_ro(board_obj, &board) != 0) return NULL;
+    return PyLong_FromUnsignedLong(legalActionMask(board));
+}
+
+//N個の盤面の行動マスクをuint32配列で返す関数
+static PyObject* pyLegalActionMasks(PyObject *self, PyObject *args){
+    PyObject *boards_obj;
+    if (!PyArg_ParseTuple(args, "O!", &PyArray_Type, &boards_obj)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse.");
+        return NULL;
+    }
+    int (*boards)[ARRS_NUM][ROWS_NUM][COLS_NUM];
+    int n;
+    if (toBoards_ro(boards_obj, &boards, &n) != 0) return NULL;
+
+    npy_intp dims[1] = {n};
+    PyArrayObject *masks = (PyArrayObject *)PyArray_SimpleNew(1, dims, NPY_UINT32);
+    if (masks == NULL) return NULL;
+
+    Py_BEGIN_ALLOW_THREADS
+    legalActionMasks(boards, n, (uint32_t *)PyArray_DATA(masks));
+    Py_END_ALLOW_THREADS
+    return (PyObject *)masks;
+}
+
+//変更記録をbytes（1マスあたりマスの番号と元の値の2バイト）にする関数
+static PyObject* undoToBytes(const UndoRecord *undo){
+    PyObject *bytes = PyBytes_FromStringAndSize(NULL, (Py_ssize_t)undo->n_cells * 2);
+    if (bytes == NULL) return NULL;
+    char *data = PyBytes_AS_STRING(bytes);
+    for (int k = 0; k < undo->n_cells; k++) {
+        data[2*k] = (char)undo->cells[k].index;
+        data[2*k+1] = (char)undo->cells[k].value;
+    }
+    return bytes;
+}
+
+//bytesの変更記録で盤面を元に戻す関数
+static int applyUndoBytes(int (*board)[ROWS_NUM][COLS_NUM], PyObject *obj){
+    Py_buffer view;
+    if (PyObject_GetBuffer(obj, &view, PyBUF_SIMPLE) != 0) return -1;
+    const unsigned char *data = (const unsigned char *)view.buf;
+    if (view.len % 2 != 0 || view.len > UNDO_MAX_CELLS * 2) {
+        PyErr_SetString(PyExc_ValueError, "invalid undo record");
+        PyBuffer_Release(&view);
+        return -1;
+    }
+    UndoRecord undo;
+    undo.n_cells = (int)(view.len / 2);
+    for (int k = 0; k < undo.n_cells; k++) {
+        if (data[2*k] >= UNDO_MAX_CELLS) {
+            PyErr_SetString(PyExc_ValueError, "invalid undo record");
+            PyBuffer_Release(&view);
+            return -1;
+        }
+        undo.cells[k].index = data[2*k];
+        undo.cells[k].value = (signed char)data[2*k+1];
+    }
+    PyBuffer_Release(&view);
+    unmakeMove(board, &undo);
+    return 0;
+}
+
+static PyObject* makeMoveResult(int legal, const UndoRecord *undo){
+    PyObject *bytes = undoToBytes(undo);
+    if (bytes == NULL) return NULL;
+    return Py_BuildValue("(NiiN)", PyBool_FromLong(legal), undo->n_chains, undo->score, bytes);
+}
+
+//設置と連鎖を行い，(置けたか, 連鎖数, スコア, 変更記録) を返す関数
+static PyObject* pyMakeMove(PyObject *self, PyObject *args){
+    PyObject *board_obj;
+    int parent_puyo, child_puyo, col, rot;
+    if (!PyArg_ParseTuple(args, "Oiiii", &board_obj, &parent_puyo, &child_puyo, &col, &rot)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse.");
+        return NULL;
+    }
+    int (*board)[ROWS_NUM][COLS_NUM];
+    if (toBoardOrObject_rw(board_obj, &board) != 0) return NULL;
+
+    UndoRecord undo;
+    int legal;
+    Py_BEGIN_ALLOW_THREADS
+    legal = makeMove(board, col, rot, parent_puyo, child_puyo, &undo);
+    Py_END_ALLOW_THREADS
+    return makeMoveResult(legal, &undo);
+}
+
+//makeMoveの変更記録で盤面を元に戻す関数
+static PyObject* pyUnmakeMove(PyObject *self, PyObject *args){
+    PyObject *board_obj, *undo_obj;
+    if (!PyArg_ParseTuple(args, "OO", &board_obj, &undo_obj)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse.");
+        return NULL;
+    }
+    int (*board)[ROWS_NUM][COLS_NUM];
+    if (toBoardOrObject_rw(board_obj, &board) != 0) return NULL;
+    if (applyUndoBytes(board, undo_obj) != 0) return NULL;
+    Py_RETURN_NONE;
+}
+
 static PyObject* pyPutPuyo(PyObject *self, PyObject *args) {
     PyObject *input_array_obj;
     int parent_puyo, child_puyo;
     int col, rot;
+    int variant = VARIANT_STANDARD;
     
-    if (!PyArg_ParseTuple(args, "O!iiii", &PyArray_Type, &input_array_obj, &parent_puyo, &child_puyo, &col, &rot)) {
+    if (!PyArg_ParseTuple(args, "O!iiii|i", &PyArray_Type, &input_array_obj, &parent_puyo, &child_puyo, &col, &rot, &variant)) {
         PyErr_SetString(PyExc_TypeError, "Failed to parse.");
         return NULL;
     }
+    const RuleVariant *v = toRuleVariant(variant);
+    if (v == NULL) return NULL;
     
     //配列を取得
-    int (*board)[ROWS_NUM][COLS_NUM];
-    if(toBoard_rw(input_array_obj, &board) != 0){
+    int *board;
+    if(toBoardShape_rw(input_array_obj, v->rows, v->cols, &board) != 0){
         return NULL;
     }
 
     //置けなかった場合はfalseを返す
-    if(!canPut(board, col, rot))
+    if(!v->canPut(board, col, rot))
         Py_RETURN_FALSE;
     
-    putPuyo(board, col, rot, parent_puyo, child_puyo);
+    v->putPuyo(board, col, rot, parent_puyo, child_puyo);
 
     // 置けた場合はtrueを返す
     Py_RETURN_TRUE;
@@ -210,19 +710,29 @@ static PyObject* pyPutPuyo(PyObject *self, PyObject *args) {
 //連鎖処理を1つ進める関数
 static PyObject* fall(PyObject *self, PyObject *args) {
     PyObject *input_array_obj;
-    if (!PyArg_ParseTuple(args, "O!", &PyArray_Type, &input_array_obj)) {
+    int engine = ENGINE_ARRAY;
+    int variant = VARIANT_STANDARD;
+    if (!PyArg_ParseTuple(args, "O!|ii", &PyArray_Type, &input_array_obj, &engine, &variant)) {
         PyErr_SetString(PyExc_TypeError, "Failed to parse.");
         return NULL;
     }
+    const RuleVariant *v = toRuleVariant(variant);
+    if (v == NULL || checkEngine(engine) != 0 || checkVariantEngine(variant, engine) != 0) return NULL;
 
     //配列を取得
-    int (*board)[ROWS_NUM][COLS_NUM];
-    if(toBoard_rw(input_array_obj, &board) != 0){
+    int *board;
+    if(toBoardShape_rw(input_array_obj, v->rows, v->cols, &board) != 0){
         return NULL;
     }
 
     
-    int fall_max = fallPuyos(board);
+    int fall_max;
+    Py_BEGIN_ALLOW_THREADS
+    if(engine == ENGINE_BITBOARD)
+        fall_max = fallPuyosBB((int (*)[ROWS_NUM][COLS_NUM])board);
+    else
+        fall_max = v->fallPuyos(board);
+    Py_END_ALLOW_THREADS
 
     // 連鎖数とスコアをPythonのタプルとして返す
     return Py_BuildValue("i", fall_max);
@@ -232,19 +742,29 @@ static PyObject* fall(PyObject *self, PyObject *args) {
 static PyObject* erasePuyo(PyObject *self, PyObject *args) {
     PyObject *input_array_obj;
     int chain_count;
-    if (!PyArg_ParseTuple(args, "O!i", &PyArray_Type, &input_array_obj, &chain_count)) {
+    int engine = ENGINE_ARRAY;
+    int variant = VARIANT_STANDARD;
+    if (!PyArg_ParseTuple(args, "O!i|ii", &PyArray_Type, &input_array_obj, &chain_count, &engine, &variant)) {
         PyErr_SetString(PyExc_TypeError, "Failed to parse.");
         return NULL;
     }
+    const RuleVariant *v = toRuleVariant(variant);
+    if (v == NULL || checkEngine(engine) != 0 || checkVariantEngine(variant, engine) != 0) return NULL;
 
     //配列を取得
-    int (*board)[ROWS_NUM][COLS_NUM];
-    if(toBoard_rw(input_array_obj, &board) != 0){
+    int *board;
+    if(toBoardShape_rw(input_array_obj, v->rows, v->cols, &board) != 0){
         return NULL;
     }
 
     //4つ以上つながったぷよを消す
-    int score = oneChain(board, chain_count);
+    int score;
+    Py_BEGIN_ALLOW_THREADS
+    if(engine == ENGINE_BITBOARD)
+        score = oneChainBB((int (*)[ROWS_NUM][COLS_NUM])board, chain_count);
+    else
+        score = v->oneChain(board, chain_count);
+    Py_END_ALLOW_THREADS
 
     // スコアを返す
     return Py_BuildValue("i", score);
@@ -253,28 +773,45 @@ static PyObject* erasePuyo(PyObject *self, PyObject *args) {
 //実際に連鎖を行い、連鎖数とスコアを返す関数
 static PyObject* chainAuto(PyObject *self, PyObject *args) {
     PyObject *input_array_obj;
-    if (!PyArg_ParseTuple(args, "O!", &PyArray_Type, &input_array_obj)) {
+    int engine = ENGINE_ARRAY;
+    int variant = VARIANT_STANDARD;
+    if (!PyArg_ParseTuple(args, "O!|ii", &PyArray_Type, &input_array_obj, &engine, &variant)) {
         PyErr_SetString(PyExc_TypeError, "Failed to parse.");
         return NULL;
     }
+    const RuleVariant *v = toRuleVariant(variant);
+    if (v == NULL || checkEngine(engine) != 0 || checkVariantEngine(variant, engine) != 0) return NULL;
 
     //配列を取得
-    int (*board)[ROWS_NUM][COLS_NUM];
-    if(toBoard_rw(input_array_obj, &board) != 0){
+    int *board;
+    if(toBoardShape_rw(input_array_obj, v->rows, v->cols, &board) != 0){
         return NULL;
     }
 
     //最後まで連鎖を実行
     int n_chains, score;
-    allChain(board, &n_chains, &score);
+    Py_BEGIN_ALLOW_THREADS
+    if(engine == ENGINE_BITBOARD)
+        allChainBB((int (*)[ROWS_NUM][COLS_NUM])board, &n_chains, &score);
+    else
+        v->allChain(board, &n_chains, &score);
+    Py_END_ALLOW_THREADS
 
     // 連鎖数とスコアをPythonのタプルとして返す
     return Py_BuildValue("(ii)", n_chains, score);
 }
 
 static PyObject* makeBoard(PyObject *self, PyObject *args){
+    int variant = VARIANT_STANDARD;
+    if (!PyArg_ParseTuple(args, "|i", &variant)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse.");
+        return NULL;
+    }
+    const RuleVariant *v = toRuleVariant(variant);
+    if (v == NULL) return NULL;
+
     // 配列の次元とサイズを設定
-    npy_intp dims[3] = {ARRS_NUM, ROWS_NUM, COLS_NUM};
+    npy_intp dims[3] = {ARRS_NUM, v->rows, v->cols};
     
     // NumPy配列を作成（ここでは整数型）
     PyArrayObject *board = (PyArrayObject*)PyArray_SimpleNew(3, dims, NPY_INT32);
@@ -284,33 +821,28 @@ static PyObject* makeBoard(PyObject *self, PyObject *args){
     }
 
     // 配列のデータを取得し、初期化
-    int *data = (int *)PyArray_DATA(board);
-    for (int i = 0; i < ROWS_NUM * COLS_NUM; i++) {
-        if(i % COLS_NUM == 0 || i % COLS_NUM == COLS_NUM - 1 || i < COLS_NUM)
-            data[i] = BLOCK;
-        else
-            data[i] = EMPTY;
-        
-        data[ROWS_NUM*COLS_NUM + i] = IDLE;
-    }
+    v->initBoard((int *)PyArray_DATA(board));
 
     return (PyObject*)board;
 }
 
 static PyObject* isDead(PyObject *self, PyObject *args) {
     PyObject *input_array_obj;
-    if (!PyArg_ParseTuple(args, "O!", &PyArray_Type, &input_array_obj)) {
+    int variant = VARIANT_STANDARD;
+    if (!PyArg_ParseTuple(args, "O!|i", &PyArray_Type, &input_array_obj, &variant)) {
         PyErr_SetString(PyExc_TypeError, "Failed to parse.");
         return NULL;
     }
+    const RuleVariant *v = toRuleVariant(variant);
+    if (v == NULL) return NULL;
 
     //配列を取得
-    int (*board)[ROWS_NUM][COLS_NUM];
-    if(toBoard_ro(input_array_obj, &board) != 0){
+    int *board;
+    if(toBoardShape_ro(input_array_obj, v->rows, v->cols, &board) != 0){
         return NULL;
     }
 
-    int is_dead = (board[PUYO][12][3] != EMPTY);
+    int is_dead = v->isDead(board);
     
     if(is_dead)
         Py_RETURN_TRUE;
@@ -318,18 +850,2183 @@ static PyObject* isDead(PyObject *self, PyObject *args) {
         Py_RETURN_FALSE;
 }
 
-//モジュールの作成-------------------------------------------------------------------------------------------------
+//ルールの種類の一覧を (名前, 色数, 行数, 列数, 行動の数) のタプルで返す関数
+static PyObject* pyGetRuleVariants(PyObject *self, PyObject *Py_UNUSED(args)){
+    PyObject *variants = PyTuple_New(VARIANTS_NUM);
+    if (variants == NULL) return NULL;
+    for (int k = 0; k < VARIANTS_NUM; k++) {
+        const RuleVariant *v = &rule_variants[k];
+        PyObject *item = Py_BuildValue("(siiii)", v->name, v->colors, v->rows, v->cols, v->actions);
+        if (item == NULL) {
+            Py_DECREF(variants);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(variants, k, item);
+    }
+    return variants;
+}
 
-static int addIntConstants(PyObject *module){
-    if (PyModule_AddIntMacro(module, ARRS_NUM) < 0) return -1;
-    if (PyModule_AddIntMacro(module, ROWS_NUM) < 0) return -1;
-    if (PyModule_AddIntMacro(module, COLS_NUM) < 0) return -1;
+//N個の盤面に対して設置・連鎖・死亡判定をまとめて行う関数
+static PyObject* stepBatch(PyObject *self, PyObject *args) {
+    PyObject *boards_obj, *parent_obj, *child_obj, *col_obj, *rot_obj;
+    int n_threads = 1;
+    if (!PyArg_ParseTuple(args, "O!OOOO|i", &PyArray_Type, &boards_obj, &parent_obj, &child_obj, &col_obj, &rot_obj, &n_threads)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse.");
+        return NULL;
+    }
 
-    if (PyModule_AddIntMacro(module, PUYO) < 0) return -1;
-    if (PyModule_AddIntMacro(module, STATE) < 0) return -1;
+    //配列を取得
+    int (*boards)[ARRS_NUM][ROWS_NUM][COLS_NUM];
+    int n;
+    if(toBoards_rw(boards_obj, &boards, &n) != 0){
+        return NULL;
+    }
 
-    if (PyModule_AddIntMacro(module, OJAMA) < 0) return -1;
-    if (PyModule_AddIntMacro(module, BLOCK) < 0) return -1;
+    PyArrayObject *inputs[4] = {NULL, NULL, NULL, NULL};
+    PyObject *input_objs[4] = {parent_obj, child_obj, col_obj, rot_obj};
+    const char *input_names[4] = {"parent_puyos", "child_puyos", "cols", "rots"};
+    for(int k = 0; k < 4; k++){
+        inputs[k] = toIntArray(input_objs[k], n, input_names[k]);
+        if(inputs[k] == NULL) goto fail;
+    }
+
+    StepResult *results = (StepResult *)PyMem_RawMalloc(sizeof(StepResult) * (n > 0 ? n : 1));
+    if(results == NULL){
+        PyErr_NoMemory();
+        goto fail;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    stepBoards(boards, n, (int *)PyArray_DATA(inputs[0]), (int *)PyArray_DATA(inputs[1]),
+               (int *)PyArray_DATA(inputs[2]), (int *)PyArray_DATA(inputs[3]), results, n_threads);
+    Py_END_ALLOW_THREADS
+
+    for(int k = 0; k < 4; k++) Py_DECREF(inputs[k]);
+
+    //結果をNumPy配列に詰める
+    npy_intp dims[1] = {n};
+    PyArrayObject *legal = (PyArrayObject*)PyArray_SimpleNew(1, dims, NPY_BOOL);
+    PyArrayObject *n_chains = (PyArrayObject*)PyArray_SimpleNew(1, dims, NPY_INT32);
+    PyArrayObject *scores = (PyArrayObject*)PyArray_SimpleNew(1, dims, NPY_INT32);
+    PyArrayObject *dead = (PyArrayObject*)PyArray_SimpleNew(1, dims, NPY_BOOL);
+    if (legal == NULL || n_chains == NULL || scores == NULL || dead == NULL) {
+        PyMem_RawFree(results);
+        Py_XDECREF(legal);
+        Py_XDECREF(n_chains);
+        Py_XDECREF(scores);
+        Py_XDECREF(dead);
+        return NULL;
+    }
+    npy_bool *legal_data = (npy_bool *)PyArray_DATA(legal);
+    int *n_chains_data = (int *)PyArray_DATA(n_chains);
+    int *scores_data = (int *)PyArray_DATA(scores);
+    npy_bool *dead_data = (npy_bool *)PyArray_DATA(dead);
+    for(int i = 0; i < n; i++){
+        legal_data[i] = (npy_bool)results[i].legal;
+        n_chains_data[i] = results[i].n_chains;
+        scores_data[i] = results[i].score;
+        dead_data[i] = (npy_bool)results[i].dead;
+    }
+    PyMem_RawFree(results);
+
+    return Py_BuildValue("(NNNN)", legal, n_chains, scores, dead);
+
+fail:
+    for(int k = 0; k < 4; k++) Py_XDECREF(inputs[k]);
+    return NULL;
+}
+
+//行動ごとの評価結果をNumPy配列 (legal, n_chains, scores, heights, dead) に詰める関数
+//n_boardsが負なら1盤面分として先頭の次元を付けない
+static PyObject* evalsToArrays(const ActionEval *evals, npy_intp n_boards){
+    int batched = n_boards >= 0;
+    npy_intp n = batched ? n_boards : 1;
+    npy_intp dims[3] = {n, ACTIONS_NUM, COLS_NUM-2};
+    npy_intp *d = batched ? dims : dims + 1;
+    int nd = batched ? 2 : 1;
+
+    PyArrayObject *legal = (PyArrayObject*)PyArray_SimpleNew(nd, d, NPY_BOOL);
+    PyArrayObject *n_chains = (PyArrayObject*)PyArray_SimpleNew(nd, d, NPY_INT32);
+    PyArrayObject *scores = (PyArrayObject*)PyArray_SimpleNew(nd, d, NPY_INT32);
+    PyArrayObject *heights = (PyArrayObject*)PyArray_SimpleNew(nd + 1, d, NPY_INT32);
+    PyArrayObject *dead = (PyArrayObject*)PyArray_SimpleNew(nd, d, NPY_BOOL);
+    if (legal == NULL || n_chains == NULL || scores == NULL || heights == NULL || dead == NULL) {
+        Py_XDECREF(legal);
+        Py_XDECREF(n_chains);
+        Py_XDECREF(scores);
+        Py_XDECREF(heights);
+        Py_XDECREF(dead);
+        return NULL;
+    }
+    npy_bool *legal_data = (npy_bool *)PyArray_DATA(legal);
+    int *n_chains_data = (int *)PyArray_DATA(n_chains);
+    int *scores_data = (int *)PyArray_DATA(scores);
+    int *heights_data = (int *)PyArray_DATA(heights);
+    npy_bool *dead_data = (npy_bool *)PyArray_DATA(dead);
+    for(npy_intp k = 0; k < n * ACTIONS_NUM; k++){
+        legal_data[k] = (npy_bool)evals[k].legal;
+        n_chains_data[k] = evals[k].n_chains;
+        scores_data[k] = evals[k].score;
+        dead_data[k] = (npy_bool)evals[k].dead;
+        memcpy(heights_data + k * (COLS_NUM-2), evals[k].heights, sizeof(evals[k].heights));
+    }
+    return Py_BuildValue("(NNNNN)", legal, n_chains, scores, heights, dead);
+}
+
+//全ての行動について，置いて連鎖を最後まで行った結果を求める関数．盤面は変更しない
+static PyObject* pyEvaluateActions(PyObject *self, PyObject *args){
+    PyObject *board_obj;
+    int parent_puyo, child_puyo;
+    if (!PyArg_ParseTuple(args, "Oii", &board_obj, &parent_puyo, &child_puyo)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse.");
+        return NULL;
+    }
+    int (*board)[ROWS_NUM][COLS_NUM];
+    if (toBoardOrObject_ro(board_obj, &board) != 0) return NULL;
+
+    ActionEval evals[ACTIONS_NUM];
+    Py_BEGIN_ALLOW_THREADS
+    evaluateActions(board, parent_puyo, child_puyo, evals);
+    Py_END_ALLOW_THREADS
+    return evalsToArrays(evals, -1);
+}
+
+//N個の盤面についてevaluateActionsを行う関数
+static PyObject* pyEvaluateActionsBatch(PyObject *self, PyObject *args){
+    PyObject *boards_obj, *parent_obj, *child_obj;
+    int n_threads = 1;
+    if (!PyArg_ParseTuple(args, "O!OO|i", &PyArray_Type, &boards_obj, &parent_obj, &child_obj, &n_threads)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse.");
+        return NULL;
+    }
+    int (*boards)[ARRS_NUM][ROWS_NUM][COLS_NUM];
+    int n;
+    if (toBoards_ro(boards_obj, &boards, &n) != 0) return NULL;
+
+    PyArrayObject *parents = toIntArray(parent_obj, n, "parent_puyos");
+    if (parents == NULL) return NULL;
+    PyArrayObject *children = toIntArray(child_obj, n, "child_puyos");
+    if (children == NULL) {
+        Py_DECREF(parents);
+        return NULL;
+    }
+    ActionEval (*evals)[ACTIONS_NUM] = (ActionEval (*)[ACTIONS_NUM])PyMem_RawMalloc(sizeof(ActionEval) * ACTIONS_NUM * (n > 0 ? n : 1));
+    if (evals == NULL) {
+        Py_DECREF(parents);
+        Py_DECREF(children);
+        return PyErr_NoMemory();
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    evaluateActionsBatch(boards, n, (int *)PyArray_DATA(parents), (int *)PyArray_DATA(children), evals, n_threads);
+    Py_END_ALLOW_THREADS
+
+    Py_DECREF(parents);
+    Py_DECREF(children);
+    PyObject *ret = evalsToArrays(&evals[0][0], n);
+    PyMem_RawFree(evals);
+    return ret;
+}
+
+//特徴量の書き込み先を用意する．outがNoneなら新しい配列を作る
+static PyObject* featureOutput(PyObject *out_obj, int ndim, npy_intp *dims){
+    if (out_obj == Py_None) return PyArray_SimpleNew(ndim, dims, NPY_FLOAT32);
+    if (toOutArray(out_obj, NPY_FLOAT32, ndim, dims, "out") == NULL) return NULL;
+    Py_INCREF(out_obj);
+    return out_obj;
+}
+
+//盤面の連鎖の種の特徴量を(FEATURES_NUM,)のfloat32配列で返す関数
+static PyObject* pyChainFeatures(PyObject *self, PyObject *args){
+    PyObject *board_obj, *out_obj = Py_None;
+    if (!PyArg_ParseTuple(args, "O|O", &board_obj, &out_obj)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse.");
+        return NULL;
+    }
+    int (*board)[ROWS_NUM][COLS_NUM];
+    if (toBoardOrObject_ro(board_obj, &board) != 0) return NULL;
+
+    npy_intp dims[1] = {FEATURES_NUM};
+    PyObject *features = featureOutput(out_obj, 1, dims);
+    if (features == NULL) return NULL;
+    float *features_data = (float *)PyArray_DATA((PyArrayObject *)features);
+    Py_BEGIN_ALLOW_THREADS
+    chainFeatures(board, features_data);
+    Py_END_ALLOW_THREADS
+    return features;
+}
+
+//N個の盤面の特徴量を(N, FEATURES_NUM)のfloat32配列で返す関数
+static PyObject* pyChainFeaturesBatch(PyObject *self, PyObject *args){
+    PyObject *boards_obj, *out_obj = Py_None;
+    int n_threads = 1;
+    if (!PyArg_ParseTuple(args, "O!|Oi", &PyArray_Type, &boards_obj, &out_obj, &n_threads)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse.");
+        return NULL;
+    }
+    int (*boards)[ARRS_NUM][ROWS_NUM][COLS_NUM];
+    int n;
+    if (toBoards_ro(boards_obj, &boards, &n) != 0) return NULL;
+
+    npy_intp dims[2] = {n, FEATURES_NUM};
+    PyObject *features = featureOutput(out_obj, 2, dims);
+    if (features == NULL) return NULL;
+    float (*features_data)[FEATURES_NUM] = (float (*)[FEATURES_NUM])PyArray_DATA((PyArrayObject *)features);
+    Py_BEGIN_ALLOW_THREADS
+    chainFeaturesBatch(boards, n, features_data, n_threads);
+    Py_END_ALLOW_THREADS
+    return features;
+}
+
+//最初の一手ごとに，この先のツモを置いたときの最大スコア・最大連鎖数・最善の次の手を求める関数
+static PyObject* pySearchActions(PyObject *self, PyObject *args) {
+    PyObject *input_array_obj, *pairs_obj;
+    int depth = -1;
+    int n_threads = 1;
+    if (!PyArg_ParseTuple(args, "O!O|ii", &PyArray_Type, &input_array_obj, &pairs_obj, &depth, &n_threads)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse.");
+        return NULL;
+    }
+
+    //配列を取得
+    int (*board)[ROWS_NUM][COLS_NUM];
+    if(toBoard_ro(input_array_obj, &board) != 0){
+        return NULL;
+    }
+
+    PyArrayObject *pairs = (PyArrayObject *)PyArray_FROMANY(pairs_obj, NPY_INT32, 2, 2, NPY_ARRAY_IN_ARRAY | NPY_ARRAY_FORCECAST);
+    if (pairs == NULL) return NULL;
+    int pairs_num = (int)PyArray_DIM(pairs, 0);
+    if (PyArray_DIM(pairs, 1) != 2 || pairs_num < 1) {
+        PyErr_SetString(PyExc_ValueError, "pairs must have shape (D,2) with D >= 1");
+        Py_DECREF(pairs);
+        return NULL;
+    }
+    if (depth < 0) depth = pairs_num;
+    if (depth < 1 || depth > pairs_num || depth > SEARCH_MAX_DEPTH) {
+        PyErr_Format(PyExc_ValueError, "depth must be in 1..%d", pairs_num < SEARCH_MAX_DEPTH ? pairs_num : SEARCH_MAX_DEPTH);
+        Py_DECREF(pairs);
+        return NULL;
+    }
+    const int (*pairs_data)[2] = (const int (*)[2])PyArray_DATA(pairs);
+    for (int k = 0; k < pairs_num; k++) {
+        if (pairs_data[k][0] < 1 || pairs_data[k][0] > COLOR_NUM || pairs_data[k][1] < 1 || pairs_data[k][1] > COLOR_NUM) {
+            PyErr_Format(PyExc_ValueError, "pair colors must be in 1..%d", COLOR_NUM);
+            Py_DECREF(pairs);
+            return NULL;
+        }
+    }
+
+    SearchResult results[ACTIONS_NUM];
+    Py_BEGIN_ALLOW_THREADS
+    searchActions(board, pairs_data, depth, results, n_threads);
+    Py_END_ALLOW_THREADS
+    Py_DECREF(pairs);
+
+    //結果をNumPy配列に詰める
+    npy_intp dims[1] = {ACTIONS_NUM};
+    PyArrayObject *scores = (PyArrayObject*)PyArray_SimpleNew(1, dims, NPY_INT32);
+    PyArrayObject *chains = (PyArrayObject*)PyArray_SimpleNew(1, dims, NPY_INT32);
+    PyArrayObject *next_actions = (PyArrayObject*)PyArray_SimpleNew(1, dims, NPY_INT32);
+    if (scores == NULL || chains == NULL || next_actions == NULL) {
+        Py_XDECREF(scores);
+        Py_XDECREF(chains);
+        Py_XDECREF(next_actions);
+        return NULL;
+    }
+    int *scores_data = (int *)PyArray_DATA(scores);
+    int *chains_data = (int *)PyArray_DATA(chains);
+    int *next_data = (int *)PyArray_DATA(next_actions);
+    for(int action = 0; action < ACTIONS_NUM; action++){
+        scores_data[action] = results[action].best_score;
+        chains_data[action] = results[action].max_chain;
+        next_data[action] = results[action].best_next;
+    }
+
+    return Py_BuildValue("(NNN)", scores, chains, next_actions);
+}
+
+//ビームサーチで最初の手を選ぶ関数
+static PyObject* pyBeamSearch(PyObject *self, PyObject *args) {
+    PyObject *board_obj, *pairs_obj;
+    int depth = -1;
+    int width = 64;
+    BeamWeights weights = {1.0, 0.0, 0.0, 0.0, 0.0};
+    unsigned long long seed = 0;
+    int n_threads = 1;
+    if (!PyArg_ParseTuple(args, "OO|ii(ddddd)Ki", &board_obj, &pairs_obj, &depth, &width,
+                          &weights.score, &weights.chain, &weights.connect, &weights.bumpiness, &weights.death,
+                          &seed, &n_threads)) {
+        return NULL;
+    }
+
+    //配列を取得
+    int (*board)[ROWS_NUM][COLS_NUM];
+    if (toBoardOrObject_ro(board_obj, &board) != 0) return NULL;
+
+    PyArrayObject *pairs = (PyArrayObject *)PyArray_FROMANY(pairs_obj, NPY_INT32, 2, 2, NPY_ARRAY_IN_ARRAY | NPY_ARRAY_FORCECAST);
+    if (pairs == NULL) return NULL;
+    int pairs_num = (int)PyArray_DIM(pairs, 0);
+    if (PyArray_DIM(pairs, 1) != 2) {
+        PyErr_SetString(PyExc_ValueError, "pairs must have shape (K,2)");
+        Py_DECREF(pairs);
+        return NULL;
+    }
+    if (depth < 0) depth = pairs_num;
+    if (depth < 1 || depth > BEAM_MAX_DEPTH) {
+        PyErr_Format(PyExc_ValueError, "depth must be in 1..%d", BEAM_MAX_DEPTH);
+        Py_DECREF(pairs);
+        return NULL;
+    }
+    if (width < 1 || width > BEAM_MAX_WIDTH) {
+        PyErr_Format(PyExc_ValueError, "width must be in 1..%d", BEAM_MAX_WIDTH);
+        Py_DECREF(pairs);
+        return NULL;
+    }
+    const int (*pairs_data)[2] = (const int (*)[2])PyArray_DATA(pairs);
+    for (int k = 0; k < pairs_num; k++) {
+        if (pairs_data[k][0] < 1 || pairs_data[k][0] > COLOR_NUM || pairs_data[k][1] < 1 || pairs_data[k][1] > COLOR_NUM) {
+            PyErr_Format(PyExc_ValueError, "pair colors must be in 1..%d", COLOR_NUM);
+            Py_DECREF(pairs);
+            return NULL;
+        }
+    }
+
+    BeamResult result;
+    int err;
+    Py_BEGIN_ALLOW_THREADS
+    err = beamSearch(board, pairs_data, pairs_num, depth, width, &weights, (uint64_t)seed, &result, n_threads);
+    Py_END_ALLOW_THREADS
+    Py_DECREF(pairs);
+    if (err != 0) return PyErr_NoMemory();
+
+    npy_intp dims[1] = {result.pv_len};
+    PyArrayObject *pv = (PyArrayObject*)PyArray_SimpleNew(1, dims, NPY_INT32);
+    if (pv == NULL) return NULL;
+    memcpy(PyArray_DATA(pv), result.pv, sizeof(int) * result.pv_len);
+
+    return Py_BuildValue("(iNLdii)", result.action, pv, result.nodes, result.value, result.score, result.max_chain);
+}
+
+//puyo面のZobristハッシュを返す関数
+static PyObject* hashBoard(PyObject *self, PyObject *args) {
+    PyObject *input_array_obj;
+    if (!PyArg_ParseTuple(args, "O!", &PyArray_Type, &input_array_obj)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse.");
+        return NULL;
+    }
+
+    //配列を取得
+    int (*board)[ROWS_NUM][COLS_NUM];
+    if(toBoard_ro(input_array_obj, &board) != 0){
+        return NULL;
+    }
+
+    return PyLong_FromUnsignedLongLong((unsigned long long)zobristHash(board));
+}
+
+//置換表を使って連鎖を行い、連鎖数とスコアを返す関数
+static PyObject* chainAutoCached(PyObject *self, PyObject *args) {
+    PyObject *input_array_obj;
+    if (!PyArg_ParseTuple(args, "O!", &PyArray_Type, &input_array_obj)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse.");
+        return NULL;
+    }
+
+    //配列を取得
+    int (*board)[ROWS_NUM][COLS_NUM];
+    if(toBoard_rw(input_array_obj, &board) != 0){
+        return NULL;
+    }
+
+    int n_chains, score;
+    Py_BEGIN_ALLOW_THREADS
+    uint64_t hash = zobristHash(board);
+    allChainCached(board, &hash, &n_chains, &score);
+    Py_END_ALLOW_THREADS
+
+    return Py_BuildValue("(ii)", n_chains, score);
+}
+
+//置換表に盤面の連鎖結果があれば返す関数．なければNone
+static PyObject* pyProbeCache(PyObject *self, PyObject *args) {
+    PyObject *input_array_obj;
+    if (!PyArg_ParseTuple(args, "O!", &PyArray_Type, &input_array_obj)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse.");
+        return NULL;
+    }
+
+    //配列を取得
+    int (*board)[ROWS_NUM][COLS_NUM];
+    if(toBoard_ro(input_array_obj, &board) != 0){
+        return NULL;
+    }
+
+    int n_chains, score, found;
+    Py_BEGIN_ALLOW_THREADS
+    found = probeCache(board, zobristHash(board), &n_chains, &score);
+    Py_END_ALLOW_THREADS
+    if(!found)
+        Py_RETURN_NONE;
+
+    return Py_BuildValue("(ii)", n_chains, score);
+}
+
+static PyObject* pySetCacheSize(PyObject *self, PyObject *args) {
+    Py_ssize_t n_entries;
+    if (!PyArg_ParseTuple(args, "n", &n_entries)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse.");
+        return NULL;
+    }
+    if (n_entries < 0) {
+        PyErr_SetString(PyExc_ValueError, "n_entries must be >= 0");
+        return NULL;
+    }
+    int err;
+    Py_BEGIN_ALLOW_THREADS
+    err = setCacheSize((size_t)n_entries);
+    Py_END_ALLOW_THREADS
+    if (err != 0)
+        return PyErr_NoMemory();
+
+    Py_RETURN_NONE;
+}
+
+static PyObject* pyClearCache(PyObject *self, PyObject *args) {
+    Py_BEGIN_ALLOW_THREADS
+    clearCache();
+    Py_END_ALLOW_THREADS
+    Py_RETURN_NONE;
+}
+
+static PyObject* pyGetCacheStats(PyObject *self, PyObject *args) {
+    CacheStats stats;
+    Py_BEGIN_ALLOW_THREADS
+    getCacheStats(&stats);
+    Py_END_ALLOW_THREADS
+    return Py_BuildValue("{s:n,s:K,s:K,s:K}",
+                         "size", (Py_ssize_t)stats.size,
+                         "hits", (unsigned long long)stats.hits,
+                         "misses", (unsigned long long)stats.misses,
+                         "stores", (unsigned long long)stats.stores);
+}
+
+static PyObject* histArray(const uint64_t *hist, int n){
+    npy_intp dims[1] = {n};
+    PyArrayObject *arr = (PyArrayObject *)PyArray_SimpleNew(1, dims, NPY_UINT64);
+    if (arr == NULL) return NULL;
+    memcpy(PyArray_DATA(arr), hist, sizeof(uint64_t) * n);
+    return (PyObject *)arr;
+}
+
+static PyObject* pyGetStats(PyObject *self, PyObject *args) {
+    int reset = 0;
+    if (!PyArg_ParseTuple(args, "|p", &reset)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse.");
+        return NULL;
+    }
+
+    PuyoStats stats;
+    getStats(&stats);
+    if (reset) resetStats();
+
+    PyObject *chain_hist = histArray(stats.chain_hist, STAT_CHAIN_BINS);
+    if (chain_hist == NULL) return NULL;
+    PyObject *fall_hist = histArray(stats.fall_hist, STAT_FALL_BINS);
+    if (fall_hist == NULL) {
+        Py_DECREF(chain_hist);
+        return NULL;
+    }
+
+    const char *clock = statsClockName();
+    const uint64_t *c = stats.counters;
+    const uint64_t *t = stats.cycles;
+    return Py_BuildValue("{s:O,s:O,s:z,s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:N,s:N,s:{s:K,s:K,s:K,s:K}}",
+                         "enabled", statsEnabled() ? Py_True : Py_False,
+                         "timers", statsTimersEnabled() ? Py_True : Py_False,
+                         "clock", clock,
+                         "canput_calls", (unsigned long long)c[STAT_CANPUT_CALLS],
+                         "canput_rejects", (unsigned long long)c[STAT_CANPUT_REJECTS],
+                         "seed_calls", (unsigned long long)c[STAT_SEED_CALLS],
+                         "seed_fails", (unsigned long long)c[STAT_SEED_FAILS],
+                         "erase_visited", (unsigned long long)c[STAT_ERASE_VISITED],
+                         "fall_calls", (unsigned long long)c[STAT_FALL_CALLS],
+                         "fall_moved", (unsigned long long)c[STAT_FALL_MOVED],
+                         "one_chain_calls", (unsigned long long)c[STAT_ONECHAIN_CALLS],
+                         "all_chain_calls", (unsigned long long)c[STAT_ALLCHAIN_CALLS],
+                         "chain_hist", chain_hist,
+                         "fall_hist", fall_hist,
+                         "cycles",
+                         "canPut", (unsigned long long)t[STAT_TIMER_CANPUT],
+                         "fallPuyos", (unsigned long long)t[STAT_TIMER_FALL],
+                         "oneChain", (unsigned long long)t[STAT_TIMER_ONECHAIN],
+                         "allChain", (unsigned long long)t[STAT_TIMER_ALLCHAIN]);
+}
+
+//使っているSIMDの命令セットと，このCPUで使える命令セットを返す関数
+static PyObject* pyGetSimdInfo(PyObject *self, PyObject *args) {
+    PyObject *supported = PyList_New(0);
+    if (supported == NULL) return NULL;
+    for (int level = 0; level < SIMD_LEVELS; level++) {
+        if (!simdSupported(level)) continue;
+        PyObject *name = PyUnicode_FromString(simdLevelName(level));
+        if (name == NULL || PyList_Append(supported, name) != 0) {
+            Py_XDECREF(name);
+            Py_DECREF(supported);
+            return NULL;
+        }
+        Py_DECREF(name);
+    }
+    return Py_BuildValue("{s:s,s:N}", "level", simdLevelName(simdLevel()), "supported", supported);
+}
+
+//指定した命令セット以下で使える最も新しいものに切り替える関数
+static PyObject* pySetSimdLevel(PyObject *self, PyObject *args) {
+    const char *name;
+    if (!PyArg_ParseTuple(args, "s", &name)) {
+        return NULL;
+    }
+    int level = simdLevelFromName(name);
+    if (level < 0) {
+        PyErr_Format(PyExc_ValueError, "unknown SIMD level: %s", name);
+        return NULL;
+    }
+    return PyUnicode_FromString(simdLevelName(setSimdLevel(level)));
+}
+
+static int compareInt(const void *a, const void *b){
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+// ソート済みの配列のq%点を線形補間で求める関数（numpy.percentileの既定と同じ）
+static double percentile(const int *sorted, int n, double q){
+    double pos = (n - 1) * q / 100.0;
+    int lo = (int)pos;
+    if(lo >= n - 1) return sorted[n - 1];
+    return sorted[lo] + (sorted[lo + 1] - sorted[lo]) * (pos - lo);
+}
+
+//盤面からランダムなツモでロールアウトを行い、スコアと最大連鎖数の統計を返す関数
+static PyObject* pyRollout(PyObject *self, PyObject *args) {
+    PyObject *input_array_obj;
+    unsigned long long seed;
+    int n_rollouts, horizon;
+    int policy = POLICY_RANDOM;
+    int n_threads = 1;
+    if (!PyArg_ParseTuple(args, "O!Kii|ii", &PyArray_Type, &input_array_obj, &seed, &n_rollouts, &horizon, &policy, &n_threads)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse.");
+        return NULL;
+    }
+    if (n_rollouts < 1 || horizon < 0) {
+        PyErr_SetString(PyExc_ValueError, "n_rollouts must be >= 1 and horizon must be >= 0");
+        return NULL;
+    }
+    if (policy != POLICY_RANDOM && policy != POLICY_GREEDY) {
+        PyErr_SetString(PyExc_ValueError, "unknown policy");
+        return NULL;
+    }
+
+    //配列を取得
+    int (*board)[ROWS_NUM][COLS_NUM];
+    if(toBoard_ro(input_array_obj, &board) != 0){
+        return NULL;
+    }
+
+    RolloutResult *results = (RolloutResult *)PyMem_RawMalloc(sizeof(RolloutResult) * n_rollouts);
+    int *scores = (int *)PyMem_RawMalloc(sizeof(int) * n_rollouts);
+    int *chains = (int *)PyMem_RawMalloc(sizeof(int) * n_rollouts);
+    if (results == NULL || scores == NULL || chains == NULL) {
+        PyMem_RawFree(results);
+        PyMem_RawFree(scores);
+        PyMem_RawFree(chains);
+        return PyErr_NoMemory();
+    }
+
+    //統計を求める
+    double score_sum = 0, score_sq_sum = 0, chain_sum = 0, turns_sum = 0;
+    int dead_num = 0;
+    Py_BEGIN_ALLOW_THREADS
+    rolloutBoards(board, (uint64_t)seed, n_rollouts, horizon, policy, results, n_threads);
+    for(int i = 0; i < n_rollouts; i++){
+        scores[i] = results[i].score;
+        chains[i] = results[i].max_chain;
+        score_sum += results[i].score;
+        score_sq_sum += (double)results[i].score * results[i].score;
+        chain_sum += results[i].max_chain;
+        turns_sum += results[i].turns;
+        dead_num += results[i].dead;
+    }
+    qsort(scores, n_rollouts, sizeof(int), compareInt);
+    qsort(chains, n_rollouts, sizeof(int), compareInt);
+    Py_END_ALLOW_THREADS
+
+    double score_mean = score_sum / n_rollouts;
+    double score_var = score_sq_sum / n_rollouts - score_mean * score_mean;
+    PyObject *stats = Py_BuildValue(
+        "{s:i,s:d,s:d,s:i,s:d,s:d,s:d,s:d,s:d,s:d,s:i,s:d,s:d,s:d,s:d,s:d,s:d,s:d}",
+        "n_rollouts", n_rollouts,
+        "score_mean", score_mean,
+        "score_std", score_var > 0 ? sqrt(score_var) : 0.0,
+        "score_max", scores[n_rollouts - 1],
+        "score_p10", percentile(scores, n_rollouts, 10),
+        "score_p25", percentile(scores, n_rollouts, 25),
+        "score_p50", percentile(scores, n_rollouts, 50),
+        "score_p75", percentile(scores, n_rollouts, 75),
+        "score_p90", percentile(scores, n_rollouts, 90),
+        "chain_mean", chain_sum / n_rollouts,
+        "chain_max", chains[n_rollouts - 1],
+        "chain_p10", percentile(chains, n_rollouts, 10),
+        "chain_p25", percentile(chains, n_rollouts, 25),
+        "chain_p50", percentile(chains, n_rollouts, 50),
+        "chain_p75", percentile(chains, n_rollouts, 75),
+        "chain_p90", percentile(chains, n_rollouts, 90),
+        "dead_rate", (double)dead_num / n_rollouts,
+        "turns_mean", turns_sum / n_rollouts);
+
+    PyMem_RawFree(results);
+    PyMem_RawFree(scores);
+    PyMem_RawFree(chains);
+    return stats;
+}
+
+//2人対戦を1手進める関数
+static PyObject* pyVersusStep(PyObject *self, PyObject *args) {
+    PyObject *boards_obj, *pending_obj, *carry_obj, *parent_obj, *child_obj, *action_obj;
+    unsigned long long seed;
+    int max_drop = OJAMA_MAX_DROP;
+    if (!PyArg_ParseTuple(args, "O!OOOOOK|i", &PyArray_Type, &boards_obj, &pending_obj, &carry_obj, &parent_obj, &child_obj, &action_obj, &seed, &max_drop)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse.");
+        return NULL;
+    }
+    if (max_drop < 0) {
+        PyErr_SetString(PyExc_ValueError, "max_drop must be >= 0");
+        return NULL;
+    }
+
+    //配列を取得
+    int (*boards)[ARRS_NUM][ROWS_NUM][COLS_NUM];
+    int n;
+    if(toBoards_rw(boards_obj, &boards, &n) != 0){
+        return NULL;
+    }
+    if (n != 2) {
+        PyErr_SetString(PyExc_ValueError, "boards must have shape (2,2,15,8)");
+        return NULL;
+    }
+
+    npy_intp player_dims[1] = {2};
+    int *pending = (int *)toOutArray(pending_obj, NPY_INT32, 1, player_dims, "pending");
+    if (pending == NULL) return NULL;
+    int *carry = (int *)toOutArray(carry_obj, NPY_INT32, 1, player_dims, "carry");
+    if (carry == NULL) return NULL;
+
+    PyArrayObject *inputs[3] = {NULL, NULL, NULL};
+    PyObject *input_objs[3] = {parent_obj, child_obj, action_obj};
+    const char *input_names[3] = {"parent_puyos", "child_puyos", "actions"};
+    for(int k = 0; k < 3; k++){
+        inputs[k] = toIntArray(input_objs[k], 2, input_names[k]);
+        if(inputs[k] == NULL){
+            for(int l = 0; l < k; l++) Py_DECREF(inputs[l]);
+            return NULL;
+        }
+    }
+    for(int k = 0; k < 2; k++){
+        const int *colors = (const int *)PyArray_DATA(inputs[k]);
+        for(int p = 0; p < 2; p++){
+            if (colors[p] < 1 || colors[p] > COLOR_NUM) {
+                PyErr_Format(PyExc_ValueError, "%s must be in 1..%d", input_names[k], COLOR_NUM);
+                for(int l = 0; l < 3; l++) Py_DECREF(inputs[l]);
+                return NULL;
+            }
+        }
+    }
+
+    int (*board_ptrs[2])[ROWS_NUM][COLS_NUM] = {boards[0], boards[1]};
+    VersusPlayer players[2] = {{pending[0], carry[0]}, {pending[1], carry[1]}};
+    VersusResult results[2];
+    PuyoRandom rng;
+    Py_BEGIN_ALLOW_THREADS
+    randomInit(&rng, (uint64_t)seed, 0);
+    versusStep(board_ptrs, players, (int *)PyArray_DATA(inputs[0]), (int *)PyArray_DATA(inputs[1]), (int *)PyArray_DATA(inputs[2]), max_drop, &rng, results);
+    Py_END_ALLOW_THREADS
+    for(int k = 0; k < 3; k++) Py_DECREF(inputs[k]);
+
+    for(int p = 0; p < 2; p++){
+        pending[p] = players[p].pending;
+        carry[p] = players[p].carry;
+    }
+
+    return Py_BuildValue("((OO)(ii)(ii)(ii)(ii)(OO))",
+                         results[0].legal ? Py_True : Py_False, results[1].legal ? Py_True : Py_False,
+                         results[0].n_chains, results[1].n_chains,
+                         results[0].score, results[1].score,
+                         results[0].sent, results[1].sent,
+                         results[0].dropped, results[1].dropped,
+                         results[0].dead ? Py_True : Py_False, results[1].dead ? Py_True : Py_False);
+}
+
+//組み込みの方策どうしで対戦をまとめて行う関数
+static PyObject* pyPlayVersus(PyObject *self, PyObject *args) {
+    unsigned long long seed;
+    int n_games, max_turns;
+    int policies[2] = {POLICY_GREEDY, POLICY_GREEDY};
+    int n_threads = 1;
+    if (!PyArg_ParseTuple(args, "Kii|iii", &seed, &n_games, &max_turns, &policies[0], &policies[1], &n_threads)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse.");
+        return NULL;
+    }
+    if (n_games < 0 || max_turns < 0) {
+        PyErr_SetString(PyExc_ValueError, "n_games and max_turns must be >= 0");
+        return NULL;
+    }
+    for(int p = 0; p < 2; p++){
+        if (policies[p] != POLICY_RANDOM && policies[p] != POLICY_GREEDY) {
+            PyErr_SetString(PyExc_ValueError, "unknown policy");
+            return NULL;
+        }
+    }
+
+    npy_intp dims[1] = {n_games};
+    npy_intp player_dims[2] = {n_games, 2};
+    PyArrayObject *winners = (PyArrayObject*)PyArray_SimpleNew(1, dims, NPY_INT32);
+    PyArrayObject *turns = (PyArrayObject*)PyArray_SimpleNew(1, dims, NPY_INT32);
+    PyArrayObject *scores = (PyArrayObject*)PyArray_SimpleNew(2, player_dims, NPY_INT32);
+    PyArrayObject *max_chains = (PyArrayObject*)PyArray_SimpleNew(2, player_dims, NPY_INT32);
+    VersusGameResult *results = (VersusGameResult *)PyMem_RawMalloc(sizeof(VersusGameResult) * (n_games > 0 ? n_games : 1));
+    if (winners == NULL || turns == NULL || scores == NULL || max_chains == NULL || results == NULL) {
+        Py_XDECREF(winners);
+        Py_XDECREF(turns);
+        Py_XDECREF(scores);
+        Py_XDECREF(max_chains);
+        PyMem_RawFree(results);
+        if (!PyErr_Occurred()) PyErr_NoMemory();
+        return NULL;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    playVersusGames((uint64_t)seed, n_games, max_turns, policies, results, n_threads);
+    Py_END_ALLOW_THREADS
+
+    int *winners_data = (int *)PyArray_DATA(winners);
+    int *turns_data = (int *)PyArray_DATA(turns);
+    int (*scores_data)[2] = (int (*)[2])PyArray_DATA(scores);
+    int (*chains_data)[2] = (int (*)[2])PyArray_DATA(max_chains);
+    for(int i = 0; i < n_games; i++){
+        winners_data[i] = results[i].winner;
+        turns_data[i] = results[i].turns;
+        for(int p = 0; p < 2; p++){
+            scores_data[i][p] = results[i].score[p];
+            chains_data[i][p] = results[i].max_chain[p];
+        }
+    }
+    PyMem_RawFree(results);
+
+    return Py_BuildValue("(NNNN)", winners, turns, scores, max_chains);
+}
+
+//盤面の束かモデル入力の束を，色を並べ替えた全ての組み合わせに増やす関数
+//行動番号は色によらないのでそのまま写し，ツモなどの色は同じ並べ替えで書き換える
+static PyObject* pyAugmentColors(PyObject *self, PyObject *args){
+    PyObject *x_obj, *perms_obj = Py_None, *actions_obj = Py_None, *pairs_obj = Py_None, *out_obj = Py_None;
+    int layout = LAYOUT_NHWC;
+    int n_threads = 1;
+    if (!PyArg_ParseTuple(args, "O|OOOOii", &x_obj, &perms_obj, &actions_obj, &pairs_obj, &out_obj, &layout, &n_threads)) {
+        return NULL;
+    }
+    if (!PyArray_Check(x_obj)) {
+        PyErr_SetString(PyExc_TypeError, "x must be ndarray");
+        return NULL;
+    }
+    if (layout != LAYOUT_NHWC && layout != LAYOUT_NCHW) {
+        PyErr_Format(PyExc_ValueError, "invalid layout: %d", layout);
+        return NULL;
+    }
+    PyArrayObject *x = (PyArrayObject *)x_obj;
+    PyArrayObject *perms_arr = NULL, *actions = NULL, *actions_out = NULL, *pairs = NULL, *pairs_out = NULL;
+    PyObject *out = NULL;
+
+    //盤面 (N, 2, 15, 8) かモデル入力 (encodeBoardの出力をN個並べたもの) かを型と形で判定する
+    int is_boards = PyArray_TYPE(x) == NPY_INT32;
+    int dtype = DTYPE_FLOAT32;
+    int n;
+    int (*boards)[ARRS_NUM][ROWS_NUM][COLS_NUM] = NULL;
+    npy_intp sample_dims[4];
+    int sample_ndim;
+    if (is_boards) {
+        if (toBoards_ro(x_obj, &boards, &n) != 0) return NULL;
+        sample_dims[0] = ARRS_NUM; sample_dims[1] = ROWS_NUM; sample_dims[2] = COLS_NUM;
+        sample_ndim = 3;
+    } else {
+        switch (PyArray_TYPE(x)) {
+            case NPY_FLOAT32: dtype = DTYPE_FLOAT32; break;
+            case NPY_FLOAT16: dtype = DTYPE_FLOAT16; break;
+            case NPY_UINT8:   dtype = PyArray_NDIM(x) == 2 ? DTYPE_BITS : DTYPE_UINT8; break;
+            default:
+                PyErr_SetString(PyExc_TypeError, "x must be int32 boards or float32/float16/uint8 model inputs");
+                return NULL;
+        }
+        npy_intp dims[4];
+        int ndim = encodedShape(layout, dtype, PyArray_DIM(x, 0), dims);
+        if (PyArray_NDIM(x) != ndim || PyArray_DIM(x, 0) > INT_MAX) {
+            PyErr_SetString(PyExc_ValueError, "x has an unexpected shape for the given layout");
+            return NULL;
+        }
+        for (int k = 1; k < ndim; k++) {
+            if (PyArray_DIM(x, k) != dims[k]) {
+                PyErr_SetString(PyExc_ValueError, "x has an unexpected shape for the given layout");
+                return NULL;
+            }
+            sample_dims[k-1] = dims[k];
+        }
+        sample_ndim = ndim - 1;
+        if (!PyArray_IS_C_CONTIGUOUS(x) || !PyArray_ISALIGNED(x)) {
+            PyErr_SetString(PyExc_ValueError, "x must be C-contiguous and aligned");
+            return NULL;
+        }
+        n = (int)PyArray_DIM(x, 0);
+    }
+
+    //色の並べ替え．指定がなければ全て
+    int (*perms)[COLOR_NUM];
+    int n_perms;
+    int all_perms[AUGMENT_MAX_PERMS][COLOR_NUM];
+    if (perms_obj == Py_None) {
+        n_perms = colorPermutations(all_perms);
+        perms = all_perms;
+    } else {
+        perms_arr = (PyArrayObject *)PyArray_FROMANY(perms_obj, NPY_INT32, 2, 2, NPY_ARRAY_IN_ARRAY | NPY_ARRAY_FORCECAST);
+        if (perms_arr == NULL) return NULL;
+        n_perms = (int)PyArray_DIM(perms_arr, 0);
+        perms = (int (*)[COLOR_NUM])PyArray_DATA(perms_arr);
+        if (PyArray_DIM(perms_arr, 1) != COLOR_NUM || n_perms < 1) {
+            PyErr_Format(PyExc_ValueError, "perms must have shape (P,%d) with P >= 1", COLOR_NUM);
+            Py_DECREF(perms_arr);
+            return NULL;
+        }
+        for (int p = 0; p < n_perms; p++) {
+            if (!isColorPermutation(perms[p])) {
+                PyErr_Format(PyExc_ValueError, "perms[%d] is not a permutation of 0..%d", p, COLOR_NUM - 1);
+                Py_DECREF(perms_arr);
+                return NULL;
+            }
+        }
+    }
+
+    //出力先 (N, P, ...)
+    npy_intp out_dims[5] = {n, n_perms};
+    for (int k = 0; k < sample_ndim; k++) out_dims[k+2] = sample_dims[k];
+    int out_type = PyArray_TYPE(x);
+    if (out_obj == Py_None) {
+        out = PyArray_SimpleNew(sample_ndim + 2, out_dims, out_type);
+        if (out == NULL) {
+            Py_XDECREF(perms_arr);
+            return NULL;
+        }
+    } else {
+        if (toOutArray(out_obj, out_type, sample_ndim + 2, out_dims, "out") == NULL) {
+            Py_XDECREF(perms_arr);
+            return NULL;
+        }
+        Py_INCREF(out_obj);
+        out = out_obj;
+    }
+
+    //行動番号 (N,) -> (N, P)
+    if (actions_obj != Py_None) {
+        actions = toIntArray(actions_obj, n, "actions");
+        npy_intp dims[2] = {n, n_perms};
+        if (actions != NULL) actions_out = (PyArrayObject *)PyArray_SimpleNew(2, dims, NPY_INT32);
+        if (actions_out == NULL) goto fail;
+    }
+
+    //ツモなどの色 (N, ...) -> (N, P, ...)
+    int pair_len = 0;
+    if (pairs_obj != Py_None) {
+        pairs = (PyArrayObject *)PyArray_FROMANY(pairs_obj, NPY_INT32, 1, 0, NPY_ARRAY_IN_ARRAY | NPY_ARRAY_FORCECAST);
+        if (pairs == NULL) goto fail;
+        if (PyArray_DIM(pairs, 0) != n || PyArray_NDIM(pairs) > 6) {
+            PyErr_Format(PyExc_ValueError, "pairs must have shape (%d, ...)", n);
+            goto fail;
+        }
+        npy_intp dims[8] = {n, n_perms};
+        pair_len = 1;
+        for (int k = 1; k < PyArray_NDIM(pairs); k++) {
+            dims[k+1] = PyArray_DIM(pairs, k);
+            pair_len *= (int)PyArray_DIM(pairs, k);
+        }
+        pairs_out = (PyArrayObject *)PyArray_SimpleNew(PyArray_NDIM(pairs) + 1, dims, NPY_INT32);
+        if (pairs_out == NULL) goto fail;
+    }
+
+    int err = 0;
+    Py_BEGIN_ALLOW_THREADS
+    if (is_boards)
+        augmentBoards(boards, n, (const int (*)[COLOR_NUM])perms, n_perms,
+                      (int (*)[ARRS_NUM][ROWS_NUM][COLS_NUM])PyArray_DATA((PyArrayObject *)out), n_threads);
+    else
+        err = augmentEncoded(PyArray_DATA(x), n, layout, dtype, (const int (*)[COLOR_NUM])perms, n_perms,
+                             PyArray_DATA((PyArrayObject *)out), n_threads);
+    if (actions_out != NULL) {
+        const int *src = (const int *)PyArray_DATA(actions);
+        int *dst = (int *)PyArray_DATA(actions_out);
+        for (int k = 0; k < n; k++)
+            for (int p = 0; p < n_perms; p++)
+                dst[(size_t)k * n_perms + p] = src[k];
+    }
+    if (pairs_out != NULL)
+        augmentColorValues((const int *)PyArray_DATA(pairs), n, pair_len, (const int (*)[COLOR_NUM])perms, n_perms,
+                           (int *)PyArray_DATA(pairs_out));
+    Py_END_ALLOW_THREADS
+
+    Py_XDECREF(perms_arr);
+    Py_XDECREF(actions);
+    Py_XDECREF(pairs);
+    if (err != 0) {
+        Py_DECREF(out);
+        Py_XDECREF(actions_out);
+        Py_XDECREF(pairs_out);
+        return PyErr_NoMemory();
+    }
+    PyObject *ret = Py_BuildValue("(OOO)", out,
+                                  actions_out ? (PyObject *)actions_out : Py_None,
+                                  pairs_out ? (PyObject *)pairs_out : Py_None);
+    Py_DECREF(out);
+    Py_XDECREF(actions_out);
+    Py_XDECREF(pairs_out);
+    return ret;
+
+fail:
+    Py_XDECREF(perms_arr);
+    Py_XDECREF(out);
+    Py_XDECREF(actions);
+    Py_XDECREF(actions_out);
+    Py_XDECREF(pairs);
+    Py_XDECREF(pairs_out);
+    return NULL;
+}
+
+//n個の系列のツモをstart組目からlength組ずつ(n, length, 2)のint32配列で返す関数
+static PyObject* pyGenerateTsumo(PyObject *self, PyObject *args){
+    unsigned long long seed, stream = 0;
+    int n, length;
+    long long start = 0;
+    PyObject *out_obj = Py_None;
+    int n_threads = 1;
+    if (!PyArg_ParseTuple(args, "Kii|LKOi", &seed, &n, &length, &start, &stream, &out_obj, &n_threads)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse.");
+        return NULL;
+    }
+    if (n < 0 || length < 0 || start < 0) {
+        PyErr_SetString(PyExc_ValueError, "n, length and start must be >= 0");
+        return NULL;
+    }
+
+    npy_intp dims[3] = {n, length, 2};
+    PyObject *pairs;
+    if (out_obj != Py_None) {
+        if (toOutArray(out_obj, NPY_INT32, 3, dims, "out") == NULL) return NULL;
+        pairs = out_obj;
+        Py_INCREF(pairs);
+    } else {
+        pairs = PyArray_SimpleNew(3, dims, NPY_INT32);
+        if (pairs == NULL) return NULL;
+    }
+
+    int (*pairs_data)[2] = (int (*)[2])PyArray_DATA((PyArrayObject *)pairs);
+    Py_BEGIN_ALLOW_THREADS
+    generateTsumo((uint64_t)seed, (uint64_t)stream, n, (int64_t)start, length, pairs_data, n_threads);
+    Py_END_ALLOW_THREADS
+    return pairs;
+}
+
+//N個の盤面のpuyo面を(N, PACK_BYTES)のuint8配列に詰める関数
+static PyObject* pyPackBoards(PyObject *self, PyObject *args){
+    PyObject *boards_obj;
+    if (!PyArg_ParseTuple(args, "O!", &PyArray_Type, &boards_obj)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse.");
+        return NULL;
+    }
+
+    int (*boards)[ARRS_NUM][ROWS_NUM][COLS_NUM];
+    int n;
+    if (toBoards_ro(boards_obj, &boards, &n) != 0) return NULL;
+
+    npy_intp dims[2] = {n, PACK_BYTES};
+    PyArrayObject *packed = (PyArrayObject *)PyArray_SimpleNew(2, dims, NPY_UINT8);
+    if (packed == NULL) return PyErr_NoMemory();
+
+    int done;
+    Py_BEGIN_ALLOW_THREADS
+    done = packBoards(boards, n, (unsigned char (*)[PACK_BYTES])PyArray_DATA(packed));
+    Py_END_ALLOW_THREADS
+
+    if (done != n) {
+        PyErr_Format(PyExc_ValueError, "board %d has a value that cannot be packed", done);
+        Py_DECREF(packed);
+        return NULL;
+    }
+    return (PyObject *)packed;
+}
+
+//(N, PACK_BYTES)のuint8配列を(N, 2, 15, 8)の盤面に戻す関数
+static PyObject* pyUnpackBoards(PyObject *self, PyObject *args){
+    PyObject *packed_obj;
+    if (!PyArg_ParseTuple(args, "O", &packed_obj)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse.");
+        return NULL;
+    }
+
+    PyArrayObject *packed = (PyArrayObject *)PyArray_FROMANY(packed_obj, NPY_UINT8, 2, 2, NPY_ARRAY_IN_ARRAY);
+    if (packed == NULL) return NULL;
+    if (PyArray_DIM(packed, 1) != PACK_BYTES) {
+        PyErr_Format(PyExc_ValueError, "packed must have shape (N, %d)", PACK_BYTES);
+        Py_DECREF(packed);
+        return NULL;
+    }
+    int n = (int)PyArray_DIM(packed, 0);
+
+    npy_intp dims[4] = {n, ARRS_NUM, ROWS_NUM, COLS_NUM};
+    PyArrayObject *boards = (PyArrayObject *)PyArray_SimpleNew(4, dims, NPY_INT32);
+    if (boards == NULL) {
+        Py_DECREF(packed);
+        return PyErr_NoMemory();
+    }
+
+    int done;
+    Py_BEGIN_ALLOW_THREADS
+    done = unpackBoards((const unsigned char (*)[PACK_BYTES])PyArray_DATA(packed), n,
+                        (int (*)[ARRS_NUM][ROWS_NUM][COLS_NUM])PyArray_DATA(boards));
+    Py_END_ALLOW_THREADS
+
+    Py_DECREF(packed);
+    if (done != n) {
+        PyErr_Format(PyExc_ValueError, "packed board %d has an invalid cell code", done);
+        Py_DECREF(boards);
+        return NULL;
+    }
+    return (PyObject *)boards;
+}
+
+//対局ログにN個の(盤面, ツモ, 行動, 連鎖数, スコア)を追記し，追記後のレコード数を返す関数
+static PyObject* pyAppendGameLog(PyObject *self, PyObject *args){
+    PyObject *path_obj = NULL;
+    PyObject *boards_obj, *parent_obj, *child_obj, *actions_obj, *scores_obj;
+    PyObject *chains_obj = Py_None;
+    if (!PyArg_ParseTuple(args, "O&O!OOOO|O", PyUnicode_FSConverter, &path_obj, &PyArray_Type, &boards_obj,
+                          &parent_obj, &child_obj, &actions_obj, &scores_obj, &chains_obj)) {
+        return NULL;
+    }
+
+    int (*boards)[ARRS_NUM][ROWS_NUM][COLS_NUM];
+    int n;
+    PyArrayObject *parents = NULL, *children = NULL, *actions = NULL, *scores = NULL, *chains = NULL;
+    LogRecord *records = NULL;
+    PyObject *ret = NULL;
+    if (toBoards_ro(boards_obj, &boards, &n) != 0) goto done;
+    parents = toIntArray(parent_obj, n, "parent_puyos");
+    if (parents == NULL) goto done;
+    children = toIntArray(child_obj, n, "child_puyos");
+    if (children == NULL) goto done;
+    actions = toIntArray(actions_obj, n, "actions");
+    if (actions == NULL) goto done;
+    scores = toIntArray(scores_obj, n, "scores");
+    if (scores == NULL) goto done;
+    if (chains_obj != Py_None) {
+        chains = toIntArray(chains_obj, n, "chains");
+        if (chains == NULL) goto done;
+    }
+
+    records = (LogRecord *)PyMem_RawMalloc(sizeof(LogRecord) * (n > 0 ? n : 1));
+    if (records == NULL) {
+        PyErr_NoMemory();
+        goto done;
+    }
+    for (int i = 0; i < n; i++) {
+        LogRecord *r = &records[i];
+        if (!packBoard(boards[i], &r->board)) {
+            PyErr_Format(PyExc_ValueError, "board %d has a value that cannot be packed", i);
+            goto done;
+        }
+        r->parent_puyo = ((int *)PyArray_DATA(parents))[i];
+        r->child_puyo = ((int *)PyArray_DATA(children))[i];
+        r->action = ((int *)PyArray_DATA(actions))[i];
+        r->score = ((int *)PyArray_DATA(scores))[i];
+        r->n_chains = chains ? ((int *)PyArray_DATA(chains))[i] : 0;
+        //レコードには1バイトずつ書くので，範囲外の値は書かずにエラーにする
+        if (r->parent_puyo < 1 || r->parent_puyo > COLOR_NUM || r->child_puyo < 1 || r->child_puyo > COLOR_NUM) {
+            PyErr_Format(PyExc_ValueError, "record %d: puyo colors must be in 1..%d", i, COLOR_NUM);
+            goto done;
+        }
+        if (r->action < 0 || r->action >= ACTIONS_NUM) {
+            PyErr_Format(PyExc_ValueError, "record %d: action must be in 0..%d", i, ACTIONS_NUM - 1);
+            goto done;
+        }
+        if (r->n_chains < 0 || r->n_chains > UINT8_MAX) {
+            PyErr_Format(PyExc_ValueError, "record %d: chains must be in 0..%d", i, UINT8_MAX);
+            goto done;
+        }
+    }
+
+    long long count;
+    const char *path = PyBytes_AS_STRING(path_obj);
+    Py_BEGIN_ALLOW_THREADS
+    count = appendGameLog(path, records, n);
+    Py_END_ALLOW_THREADS
+
+    if (count == -1) {
+        PyErr_SetFromErrnoWithFilename(PyExc_OSError, path);
+    } else if (count == -2) {
+        PyErr_Format(PyExc_ValueError, "%s is not a compatible game log", path);
+    } else {
+        ret = PyLong_FromLongLong(count);
+    }
+
+done:
+    PyMem_RawFree(records);
+    Py_XDECREF(parents);
+    Py_XDECREF(children);
+    Py_XDECREF(actions);
+    Py_XDECREF(scores);
+    Py_XDECREF(chains);
+    Py_XDECREF(path_obj);
+    return ret;
+}
+
+//優先度付き経験再生バッファ-------------------------------------------------------------------------------------
+
+//memoryはlockを取って操作する．lockはGILを解放してから取る
+typedef struct {
+    PyObject_HEAD
+    ReplayMemory memory;
+    PuyoMutex lock;
+} ReplayBufferObject;
+
+static PyObject* ReplayBuffer_new(PyTypeObject *type, PyObject *args, PyObject *kwds){
+    ReplayBufferObject *self = (ReplayBufferObject *)type->tp_alloc(type, 0);
+    if (self == NULL) return NULL;
+    mutexInit(&self->lock);
+    return (PyObject *)self;
+}
+
+static int ReplayBuffer_init(ReplayBufferObject *self, PyObject *args, PyObject *kwds){
+    static char *kwlist[] = {"capacity", "alpha", "seed", NULL};
+    int capacity;
+    double alpha = 0.6;
+    unsigned long long seed = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "i|dK", kwlist, &capacity, &alpha, &seed)) {
+        return -1;
+    }
+    if (capacity <= 0) {
+        PyErr_SetString(PyExc_ValueError, "capacity must be positive");
+        return -1;
+    }
+    int ok;
+    Py_BEGIN_ALLOW_THREADS
+    mutexLock(&self->lock);
+    replayFree(&self->memory);
+    ok = replayInit(&self->memory, capacity, alpha, (uint64_t)seed);
+    mutexUnlock(&self->lock);
+    Py_END_ALLOW_THREADS
+    if (!ok) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    return 0;
+}
+
+static void ReplayBuffer_dealloc(ReplayBufferObject *self){
+    PyTypeObject *type = Py_TYPE(self);
+    replayFree(&self->memory);
+    mutexDestroy(&self->lock);
+    type->tp_free((PyObject *)self);
+    Py_DECREF(type);
+}
+
+static int checkReplayReady(ReplayBufferObject *self){
+    if (self->memory.capacity == 0) {
+        PyErr_SetString(PyExc_RuntimeError, "ReplayBuffer is not initialized");
+        return -1;
+    }
+    return 0;
+}
+
+//遷移を1つ追加し，書き込んだ位置を返す
+static PyObject* ReplayBuffer_add(ReplayBufferObject *self, PyObject *args){
+    PyObject *board_obj, *next_obj;
+    int action, done;
+    float reward;
+    double priority = -1.0;
+    if (!PyArg_ParseTuple(args, "O!ifO!p|d", &PyArray_Type, &board_obj, &action, &reward, &PyArray_Type, &next_obj, &done, &priority)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse.");
+        return NULL;
+    }
+    if (checkReplayReady(self) != 0) return NULL;
+
+    int (*board)[ROWS_NUM][COLS_NUM];
+    int (*next_board)[ROWS_NUM][COLS_NUM];
+    if (toBoard_ro(board_obj, &board) != 0) return NULL;
+    if (toBoard_ro(next_obj, &next_board) != 0) return NULL;
+
+    PackedBoard packed, next_packed;
+    if (!packBoard(board, &packed) || !packBoard(next_board, &next_packed)) {
+        PyErr_SetString(PyExc_ValueError, "board has a value that cannot be packed");
+        return NULL;
+    }
+    int index = -1;
+    Py_BEGIN_ALLOW_THREADS
+    mutexLock(&self->lock);
+    if (self->memory.capacity > 0)
+        index = replayAdd(&self->memory, &packed, action, reward, &next_packed, done, priority);
+    mutexUnlock(&self->lock);
+    Py_END_ALLOW_THREADS
+    if (index < 0) {
+        PyErr_SetString(PyExc_RuntimeError, "ReplayBuffer is not initialized");
+        return NULL;
+    }
+    return PyLong_FromLong(index);
+}
+
+//N個の遷移をまとめて追加する
+static PyObject* ReplayBuffer_addBatch(ReplayBufferObject *self, PyObject *args){
+    PyObject *boards_obj, *actions_obj, *rewards_obj, *next_obj, *dones_obj;
+    PyObject *priorities_obj = Py_None;
+    if (!PyArg_ParseTuple(args, "O!OOO!O|O", &PyArray_Type, &boards_obj, &actions_obj, &rewards_obj, &PyArray_Type, &next_obj, &dones_obj, &priorities_obj)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse.");
+        return NULL;
+    }
+    if (checkReplayReady(self) != 0) return NULL;
+
+    int (*boards)[ARRS_NUM][ROWS_NUM][COLS_NUM];
+    int (*next_boards)[ARRS_NUM][ROWS_NUM][COLS_NUM];
+    int n, next_n;
+    if (toBoards_ro(boards_obj, &boards, &n) != 0) return NULL;
+    if (toBoards_ro(next_obj, &next_boards, &next_n) != 0) return NULL;
+    if (next_n != n) {
+        PyErr_Format(PyExc_ValueError, "next_boards must have length %d", n);
+        return NULL;
+    }
+
+    PyArrayObject *actions = NULL, *dones = NULL, *rewards = NULL, *priorities = NULL;
+    PackedBoard *packed = NULL;
+    PyObject *ret = NULL;
+    actions = toIntArray(actions_obj, n, "actions");
+    if (actions == NULL) goto done;
+    dones = toIntArray(dones_obj, n, "dones");
+    if (dones == NULL) goto done;
+    rewards = toDoubleArray(rewards_obj, n, "rewards");
+    if (rewards == NULL) goto done;
+    if (priorities_obj != Py_None) {
+        priorities = toDoubleArray(priorities_obj, n, "priorities");
+        if (priorities == NULL) goto done;
+    }
+
+    //全て詰められることを確認してから追加する
+    packed = (PackedBoard *)PyMem_RawMalloc(sizeof(PackedBoard) * 2 * (n > 0 ? n : 1));
+    if (packed == NULL) {
+        PyErr_NoMemory();
+        goto done;
+    }
+    for (int i = 0; i < n; i++) {
+        if (!packBoard(boards[i], &packed[2*i]) || !packBoard(next_boards[i], &packed[2*i+1])) {
+            PyErr_Format(PyExc_ValueError, "board %d has a value that cannot be packed", i);
+            goto done;
+        }
+    }
+    const int *actions_data = (const int *)PyArray_DATA(actions);
+    const int *dones_data = (const int *)PyArray_DATA(dones);
+    const double *rewards_data = (const double *)PyArray_DATA(rewards);
+    const double *priorities_data = priorities ? (const double *)PyArray_DATA(priorities) : NULL;
+    Py_BEGIN_ALLOW_THREADS
+    mutexLock(&self->lock);
+    for (int i = 0; i < n && self->memory.capacity > 0; i++) {
+        replayAdd(&self->memory, &packed[2*i], actions_data[i], (float)rewards_data[i], &packed[2*i+1], dones_data[i],
+                  priorities_data ? priorities_data[i] : -1.0);
+    }
+    mutexUnlock(&self->lock);
+    Py_END_ALLOW_THREADS
+    ret = Py_None;
+    Py_INCREF(ret);
+
+done:
+    PyMem_RawFree(packed);
+    Py_XDECREF(actions);
+    Py_XDECREF(dones);
+    Py_XDECREF(rewards);
+    Py_XDECREF(priorities);
+    return ret;
+}
+
+//優先度に比例してバッチを取り出し，盤面をモデル入力に変換して返す
+static PyObject* ReplayBuffer_sample(ReplayBufferObject *self, PyObject *args){
+    int batch_size;
+    double beta = 0.4;
+    int layout = LAYOUT_NHWC, dtype = DTYPE_FLOAT32;
+    if (!PyArg_ParseTuple(args, "i|dii", &batch_size, &beta, &layout, &dtype)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse.");
+        return NULL;
+    }
+    if (checkReplayReady(self) != 0) return NULL;
+    if (checkEncoding(layout, dtype) != 0) return NULL;
+    if (batch_size <= 0) {
+        PyErr_SetString(PyExc_ValueError, "batch_size must be positive");
+        return NULL;
+    }
+    ReplayMemory *rm = &self->memory;
+
+    npy_intp x_dims[4];
+    int x_ndim = encodedShape(layout, dtype, batch_size, x_dims);
+    npy_intp dims[1] = {batch_size};
+    PyArrayObject *x = (PyArrayObject *)PyArray_SimpleNew(x_ndim, x_dims, encodedTypenum(dtype));
+    PyArrayObject *next_x = (PyArrayObject *)PyArray_SimpleNew(x_ndim, x_dims, encodedTypenum(dtype));
+    PyArrayObject *actions = (PyArrayObject *)PyArray_SimpleNew(1, dims, NPY_INT32);
+    PyArrayObject *rewards = (PyArrayObject *)PyArray_SimpleNew(1, dims, NPY_FLOAT32);
+    PyArrayObject *dones = (PyArrayObject *)PyArray_SimpleNew(1, dims, NPY_BOOL);
+    PyArrayObject *indices = (PyArrayObject *)PyArray_SimpleNew(1, dims, NPY_INT32);
+    PyArrayObject *weights = (PyArrayObject *)PyArray_SimpleNew(1, dims, NPY_FLOAT32);
+    if (!x || !next_x || !actions || !rewards || !dones || !indices || !weights) {
+        Py_XDECREF(x); Py_XDECREF(next_x); Py_XDECREF(actions); Py_XDECREF(rewards);
+        Py_XDECREF(dones); Py_XDECREF(indices); Py_XDECREF(weights);
+        return PyErr_NoMemory();
+    }
+
+    int *indices_data = (int *)PyArray_DATA(indices);
+    float *weights_data = (float *)PyArray_DATA(weights);
+    char *x_data = (char *)PyArray_DATA(x);
+    char *next_x_data = (char *)PyArray_DATA(next_x);
+    int *actions_data = (int *)PyArray_DATA(actions);
+    float *rewards_data = (float *)PyArray_DATA(rewards);
+    unsigned char *dones_data = (unsigned char *)PyArray_DATA(dones);
+    size_t stride = (size_t)encodedBytes(dtype);
+    int empty;
+    Py_BEGIN_ALLOW_THREADS
+    mutexLock(&self->lock);
+    empty = rm->size == 0 || !(replayTotal(rm) > 0.0);
+    if (!empty) {
+        replaySample(rm, batch_size, beta, indices_data, weights_data);
+        int tmp_board[ARRS_NUM][ROWS_NUM][COLS_NUM];
+        for (int k = 0; k < batch_size; k++) {
+            int index = indices_data[k];
+            unpackBoard(&rm->boards[index], tmp_board);
+            encodeBoard(tmp_board, layout, dtype, x_data + k * stride);
+            unpackBoard(&rm->next_boards[index], tmp_board);
+            encodeBoard(tmp_board, layout, dtype, next_x_data + k * stride);
+            actions_data[k] = rm->actions[index];
+            rewards_data[k] = rm->rewards[index];
+            dones_data[k] = rm->dones[index];
+        }
+    }
+    mutexUnlock(&self->lock);
+    Py_END_ALLOW_THREADS
+    if (empty) {
+        Py_DECREF(x); Py_DECREF(next_x); Py_DECREF(actions); Py_DECREF(rewards);
+        Py_DECREF(dones); Py_DECREF(indices); Py_DECREF(weights);
+        PyErr_SetString(PyExc_ValueError, "ReplayBuffer has no transition to sample");
+        return NULL;
+    }
+
+    return Py_BuildValue("(NNNNNNN)", x, actions, rewards, next_x, dones, indices, weights);
+}
+
+//indicesの遷移の優先度をprioritiesに更新する
+static PyObject* ReplayBuffer_updatePriorities(ReplayBufferObject *self, PyObject *args){
+    PyObject *indices_obj, *priorities_obj;
+    if (!PyArg_ParseTuple(args, "OO", &indices_obj, &priorities_obj)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse.");
+        return NULL;
+    }
+    if (checkReplayReady(self) != 0) return NULL;
+
+    PyArrayObject *indices = (PyArrayObject *)PyArray_FROMANY(indices_obj, NPY_INT32, 1, 1, NPY_ARRAY_IN_ARRAY | NPY_ARRAY_FORCECAST);
+    if (indices == NULL) return NULL;
+    int n = (int)PyArray_DIM(indices, 0);
+    PyArrayObject *priorities = toDoubleArray(priorities_obj, n, "priorities");
+    if (priorities == NULL) {
+        Py_DECREF(indices);
+        return NULL;
+    }
+
+    const int *indices_data = (const int *)PyArray_DATA(indices);
+    const double *priorities_data = (const double *)PyArray_DATA(priorities);
+    //すべて正しいことを確認してから更新する．bad は最初に不正だった位置
+    int bad = -1;
+    Py_BEGIN_ALLOW_THREADS
+    mutexLock(&self->lock);
+    for (int i = 0; i < n; i++) {
+        if (indices_data[i] < 0 || indices_data[i] >= self->memory.size || !(priorities_data[i] >= 0.0)) {
+            bad = i;
+            break;
+        }
+    }
+    if (bad < 0) {
+        for (int i = 0; i < n; i++)
+            replayUpdate(&self->memory, indices_data[i], priorities_data[i]);
+    }
+    mutexUnlock(&self->lock);
+    Py_END_ALLOW_THREADS
+    if (bad >= 0) {
+        PyErr_Format(PyExc_ValueError, "invalid index %d or priority at position %d", indices_data[bad], bad);
+        Py_DECREF(indices);
+        Py_DECREF(priorities);
+        return NULL;
+    }
+
+    Py_DECREF(indices);
+    Py_DECREF(priorities);
+    Py_RETURN_NONE;
+}
+
+//indicesの遷移の盤面を(N, 2, 15, 8)の配列に戻して返す
+static PyObject* ReplayBuffer_getBoards(ReplayBufferObject *self, PyObject *args){
+    PyObject *indices_obj;
+    if (!PyArg_ParseTuple(args, "O", &indices_obj)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse.");
+        return NULL;
+    }
+    if (checkReplayReady(self) != 0) return NULL;
+
+    PyArrayObject *indices = (PyArrayObject *)PyArray_FROMANY(indices_obj, NPY_INT32, 1, 1, NPY_ARRAY_IN_ARRAY | NPY_ARRAY_FORCECAST);
+    if (indices == NULL) return NULL;
+    int n = (int)PyArray_DIM(indices, 0);
+    const int *indices_data = (const int *)PyArray_DATA(indices);
+
+    npy_intp dims[4] = {n, ARRS_NUM, ROWS_NUM, COLS_NUM};
+    PyArrayObject *boards = (PyArrayObject *)PyArray_SimpleNew(4, dims, NPY_INT32);
+    PyArrayObject *next_boards = (PyArrayObject *)PyArray_SimpleNew(4, dims, NPY_INT32);
+    if (!boards || !next_boards) {
+        Py_XDECREF(boards);
+        Py_XDECREF(next_boards);
+        Py_DECREF(indices);
+        return PyErr_NoMemory();
+    }
+    int (*boards_data)[ARRS_NUM][ROWS_NUM][COLS_NUM] = (int (*)[ARRS_NUM][ROWS_NUM][COLS_NUM])PyArray_DATA(boards);
+    int (*next_data)[ARRS_NUM][ROWS_NUM][COLS_NUM] = (int (*)[ARRS_NUM][ROWS_NUM][COLS_NUM])PyArray_DATA(next_boards);
+    int bad = -1;
+    Py_BEGIN_ALLOW_THREADS
+    mutexLock(&self->lock);
+    for (int i = 0; i < n; i++) {
+        if (indices_data[i] < 0 || indices_data[i] >= self->memory.size) {
+            bad = i;
+            break;
+        }
+        unpackBoard(&self->memory.boards[indices_data[i]], boards_data[i]);
+        unpackBoard(&self->memory.next_boards[indices_data[i]], next_data[i]);
+    }
+    mutexUnlock(&self->lock);
+    Py_END_ALLOW_THREADS
+    if (bad >= 0) {
+        PyErr_Format(PyExc_IndexError, "index %d out of range", indices_data[bad]);
+        Py_DECREF(boards);
+        Py_DECREF(next_boards);
+        Py_DECREF(indices);
+        return NULL;
+    }
+    Py_DECREF(indices);
+    return Py_BuildValue("(NN)", boards, next_boards);
+}
+
+static Py_ssize_t ReplayBuffer_len(ReplayBufferObject *self){
+    return self->memory.size;
+}
+
+static PyObject* ReplayBuffer_getCapacity(ReplayBufferObject *self, void *closure){
+    return PyLong_FromLong(self->memory.capacity);
+}
+
+static PyObject* ReplayBuffer_getTotalPriority(ReplayBufferObject *self, void *closure){
+    return PyFloat_FromDouble(self->memory.capacity ? replayTotal(&self->memory) : 0.0);
+}
+
+static PyObject* ReplayBuffer_getMaxPriority(ReplayBufferObject *self, void *closure){
+    return PyFloat_FromDouble(self->memory.max_priority);
+}
+
+static PyMethodDef ReplayBuffer_methods[] = {
+    {"add", (PyCFunction)ReplayBuffer_add, METH_VARARGS,
+        "Add a transition (board, action, reward, next_board, done[, priority]) and return its index."},
+    {"addBatch", (PyCFunction)ReplayBuffer_addBatch, METH_VARARGS,
+        "Add N transitions at once."},
+    {"sample", (PyCFunction)ReplayBuffer_sample, METH_VARARGS,
+        "Sample a batch proportionally to priority and return encoded boards, metadata, indices and weights."},
+    {"updatePriorities", (PyCFunction)ReplayBuffer_updatePriorities, METH_VARARGS,
+        "Set priorities of the given transitions."},
+    {"getBoards", (PyCFunction)ReplayBuffer_getBoards, METH_VARARGS,
+        "Unpack boards and next boards of the given transitions."},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyGetSetDef ReplayBuffer_getset[] = {
+    {"capacity", (getter)ReplayBuffer_getCapacity, NULL, "Maximum number of transitions.", NULL},
+    {"total_priority", (getter)ReplayBuffer_getTotalPriority, NULL, "Sum of priority^alpha over stored transitions.", NULL},
+    {"max_priority", (getter)ReplayBuffer_getMaxPriority, NULL, "Priority given to new transitions by default.", NULL},
+    {NULL, NULL, NULL, NULL, NULL}
+};
+
+static PyType_Slot ReplayBuffer_slots[] = {
+    {Py_tp_dealloc, (void *)ReplayBuffer_dealloc},
+    {Py_sq_length, (void *)ReplayBuffer_len},
+    {Py_tp_doc, (void *)"Prioritized experience replay buffer with packed board storage."},
+    {Py_tp_methods, ReplayBuffer_methods},
+    {Py_tp_getset, ReplayBuffer_getset},
+    {Py_tp_init, (void *)ReplayBuffer_init},
+    {Py_tp_new, (void *)ReplayBuffer_new},
+    {0, NULL}
+};
+
+static PyType_Spec ReplayBuffer_spec = {
+    .name = "puyothon.puyothon.ReplayBuffer",
+    .basicsize = sizeof(ReplayBufferObject),
+    .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | PUYO_TPFLAGS_IMMUTABLE,
+    .slots = ReplayBuffer_slots,
+};
+
+//共有メモリのリングバッファ-------------------------------------------------------------------------------------
+
+//ringの読み書きとacquiredはlockを取って行う．lockはGILを解放してから取る
+//別のプロセスとはlockなしで共有できるが，同じオブジェクトを複数のスレッドから使うとtailやacquiredが壊れるため
+typedef struct {
+    PyObject_HEAD
+    ShmRing ring;
+    int acquired; //acquireで得てまだreleaseしていない件数
+    PuyoMutex lock;
+} SharedRingObject;
+
+static PyObject* SharedRing_new(PyTypeObject *type, PyObject *args, PyObject *kwds){
+    SharedRingObject *self = (SharedRingObject *)type->tp_alloc(type, 0);
+    if (self == NULL) return NULL;
+    mutexInit(&self->lock);
+    return (PyObject *)self;
+}
+
+static int SharedRing_init(SharedRingObject *self, PyObject *args, PyObject *kwds){
+    static char *kwlist[] = {"name", "capacity", NULL};
+    const char *name;
+    int capacity = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "s|i", kwlist, &name, &capacity)) {
+        return -1;
+    }
+    //ringViewで作った配列が共有メモリを指したままになるので，つなぎ直しはしない
+    int attached, ret = 0, err = 0;
+    Py_BEGIN_ALLOW_THREADS
+    mutexLock(&self->lock);
+    attached = self->ring.header != NULL;
+    if (!attached) {
+        self->acquired = 0;
+        ret = capacity > 0 ? ringCreate(&self->ring, name, capacity) : ringAttach(&self->ring, name);
+        err = errno;
+    }
+    mutexUnlock(&self->lock);
+    Py_END_ALLOW_THREADS
+    if (attached) {
+        PyErr_SetString(PyExc_RuntimeError, "SharedRing is already attached");
+        return -1;
+    }
+    if (ret != 0) {
+        errno = err;
+        PyErr_SetFromErrnoWithFilename(PyExc_OSError, name);
+        return -1;
+    }
+    return 0;
+}
+
+static void SharedRing_dealloc(SharedRingObject *self){
+    PyTypeObject *type = Py_TYPE(self);
+    ringClose(&self->ring);
+    mutexDestroy(&self->lock);
+    type->tp_free((PyObject *)self);
+    Py_DECREF(type);
+}
+
+static int checkRingReady(SharedRingObject *self){
+    if (self->ring.header == NULL) {
+        PyErr_SetString(PyExc_RuntimeError, "SharedRing is not attached");
+        return -1;
+    }
+    return 0;
+}
+
+//読み出し側は1つに限る．tailは読み出し側だけが書き換えるので，作成したオブジェクト以外からは読ませない
+static int checkRingReader(SharedRingObject *self){
+    if (checkRingReady(self) != 0) return -1;
+    if (!self->ring.owner) {
+        PyErr_SetString(PyExc_RuntimeError, "only the SharedRing that created the ring can read from it");
+        return -1;
+    }
+    return 0;
+}
+
+//1件書き込む．満杯ならFalseを返す
+static PyObject* SharedRing_push(SharedRingObject *self, PyObject *args){
+    PyObject *board_obj;
+    int action, n_chains = 0, score = 0, done = 0;
+    float reward;
+    if (!PyArg_ParseTuple(args, "O!if|iip", &PyArray_Type, &board_obj, &action, &reward, &n_chains, &score, &done)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse.");
+        return NULL;
+    }
+    if (checkRingReady(self) != 0) return NULL;
+
+    int (*board)[ROWS_NUM][COLS_NUM];
+    if (toBoard_ro(board_obj, &board) != 0) return NULL;
+    int pushed;
+    Py_BEGIN_ALLOW_THREADS
+    mutexLock(&self->lock);
+    pushed = ringPush(&self->ring, board, action, reward, n_chains, score, done);
+    mutexUnlock(&self->lock);
+    Py_END_ALLOW_THREADS
+    return PyBool_FromLong(pushed);
+}
+
+//N件を先頭から順に書き込み，書き込めた件数を返す
+static PyObject* SharedRing_pushBatch(SharedRingObject *self, PyObject *args){
+    PyObject *boards_obj, *actions_obj, *rewards_obj, *chains_obj, *scores_obj, *dones_obj;
+    if (!PyArg_ParseTuple(args, "O!OOOOO", &PyArray_Type, &boards_obj, &actions_obj, &rewards_obj, &chains_obj, &scores_obj, &dones_obj)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse.");
+        return NULL;
+    }
+    if (checkRingReady(self) != 0) return NULL;
+
+    int (*boards)[ARRS_NUM][ROWS_NUM][COLS_NUM];
+    int n;
+    if (toBoards_ro(boards_obj, &boards, &n) != 0) return NULL;
+
+    PyArrayObject *actions = NULL, *rewards = NULL, *chains = NULL, *scores = NULL, *dones = NULL;
+    PyObject *ret = NULL;
+    actions = toIntArray(actions_obj, n, "actions");
+    if (actions == NULL) goto done;
+    rewards = toDoubleArray(rewards_obj, n, "rewards");
+    if (rewards == NULL) goto done;
+    chains = toIntArray(chains_obj, n, "chains");
+    if (chains == NULL) goto done;
+    scores = toIntArray(scores_obj, n, "scores");
+    if (scores == NULL) goto done;
+    dones = toIntArray(dones_obj, n, "dones");
+    if (dones == NULL) goto done;
+
+    const int *actions_data = (const int *)PyArray_DATA(actions);
+    const double *rewards_data = (const double *)PyArray_DATA(rewards);
+    const int *chains_data = (const int *)PyArray_DATA(chains);
+    const int *scores_data = (const int *)PyArray_DATA(scores);
+    const int *dones_data = (const int *)PyArray_DATA(dones);
+    int pushed = 0;
+    Py_BEGIN_ALLOW_THREADS
+    mutexLock(&self->lock);
+    while (pushed < n && ringPush(&self->ring, boards[pushed], actions_data[pushed], (float)rewards_data[pushed],
+                                  chains_data[pushed], scores_data[pushed], dones_data[pushed] != 0)) {
+        pushed++;
+    }
+    mutexUnlock(&self->lock);
+    Py_END_ALLOW_THREADS
+    ret = PyLong_FromLong(pushed);
+
+done:
+    Py_XDECREF(actions);
+    Py_XDECREF(rewards);
+    Py_XDECREF(chains);
+    Py_XDECREF(scores);
+    Py_XDECREF(dones);
+    return ret;
+}
+
+//読める連続したスロットを最大max_n件確保し，(先頭のスロット番号, 件数)を返す
+static PyObject* SharedRing_acquire(SharedRingObject *self, PyObject *args){
+    int max_n;
+    if (!PyArg_ParseTuple(args, "i", &max_n)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse.");
+        return NULL;
+    }
+    if (checkRingReader(self) != 0) return NULL;
+
+    int first, n;
+    Py_BEGIN_ALLOW_THREADS
+    mutexLock(&self->lock);
+    n = ringAcquire(&self->ring, max_n, &first);
+    self->acquired = n;
+    mutexUnlock(&self->lock);
+    Py_END_ALLOW_THREADS
+    return Py_BuildValue("(ii)", first, n);
+}
+
+//acquireで確保したスロットの先頭n件を返却する
+static PyObject* SharedRing_release(SharedRingObject *self, PyObject *args){
+    int n;
+    if (!PyArg_ParseTuple(args, "i", &n)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse.");
+        return NULL;
+    }
+    if (checkRingReader(self) != 0) return NULL;
+    int acquired;
+    Py_BEGIN_ALLOW_THREADS
+    mutexLock(&self->lock);
+    acquired = self->acquired;
+    if (0 <= n && n <= acquired) {
+        ringRelease(&self->ring, n);
+        self->acquired = 0;
+    }
+    mutexUnlock(&self->lock);
+    Py_END_ALLOW_THREADS
+    if (n < 0 || n > acquired) {
+        PyErr_Format(PyExc_ValueError, "n must be between 0 and %d", acquired);
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+//最大max_n件を読み出してコピーを返し，スロットを返却する
+static PyObject* SharedRing_pop(SharedRingObject *self, PyObject *args){
+    int max_n;
+    if (!PyArg_ParseTuple(args, "i", &max_n)) {
+        PyErr_SetString(PyExc_TypeError, "Failed to parse.");
+        return NULL;
+    }
+    if (checkRingReader(self) != 0) return NULL;
+    if (max_n < 0) max_n = 0;
+
+    ShmRing *ring = &self->ring;
+    int n;
+    Py_BEGIN_ALLOW_THREADS
+    mutexLock(&self->lock);
+    n = ringReadable(ring, max_n);
+    mutexUnlock(&self->lock);
+    Py_END_ALLOW_THREADS
+
+    npy_intp board_dims[4] = {n, ARRS_NUM, ROWS_NUM, COLS_NUM};
+    npy_intp dims[1] = {n};
+    enum { BOARDS, ACTIONS, REWARDS, CHAINS, SCORES, DONES, OUTS_NUM };
+    PyObject *outs[OUTS_NUM] = {
+        PyArray_SimpleNew(4, board_dims, NPY_INT32),
+        PyArray_SimpleNew(1, dims, NPY_INT32),
+        PyArray_SimpleNew(1, dims, NPY_FLOAT32),
+        PyArray_SimpleNew(1, dims, NPY_INT32),
+        PyArray_SimpleNew(1, dims, NPY_INT32),
+        PyArray_SimpleNew(1, dims, NPY_BOOL),
+    };
+    for (int a = 0; a < OUTS_NUM; a++) {
+        if (outs[a] == NULL) {
+            for (int b = 0; b < OUTS_NUM; b++) Py_XDECREF(outs[b]);
+            return PyErr_NoMemory();
+        }
+    }
+    PyArrayObject *boards = (PyArrayObject *)outs[BOARDS];
+    int *actions = (int *)PyArray_DATA((PyArrayObject *)outs[ACTIONS]);
+    float *rewards = (float *)PyArray_DATA((PyArrayObject *)outs[REWARDS]);
+    int *chains = (int *)PyArray_DATA((PyArrayObject *)outs[CHAINS]);
+    int *scores = (int *)PyArray_DATA((PyArrayObject *)outs[SCORES]);
+    unsigned char *dones = (unsigned char *)PyArray_DATA((PyArrayObject *)outs[DONES]);
+
+    //末尾で折り返す場合は2回に分けて読み出す
+    int k = 0;
+    Py_BEGIN_ALLOW_THREADS
+    mutexLock(&self->lock);
+    while (k < n) {
+        int first;
+        int count = ringAcquire(ring, n - k, &first);
+        if (count == 0) break; //配列を確保している間に同じオブジェクトの別のスレッドが先に読んだ
+        for (int i = 0; i < count; i++, k++) {
+            int slot = first + i;
+            memcpy(PyArray_GETPTR1(boards, k), ring->boards[slot], sizeof(ring->boards[slot]));
+            actions[k] = ring->actions[slot];
+            rewards[k] = ring->rewards[slot];
+            chains[k] = ring->chains[slot];
+            scores[k] = ring->scores[slot];
+            dones[k] = ring->dones[slot] != 0;
+        }
+        ringRelease(ring, count);
+    }
+    self->acquired = 0;
+    mutexUnlock(&self->lock);
+    Py_END_ALLOW_THREADS
+
+    //読めた件数に切り詰める
+    if (k < n) {
+        for (int a = 0; a < OUTS_NUM; a++) {
+            PyObject *part = outs[a] ? PySequence_GetSlice(outs[a], 0, k) : NULL;
+            Py_DECREF(outs[a]);
+            outs[a] = part;
+        }
+        for (int a = 0; a < OUTS_NUM; a++) {
+            if (outs[a] == NULL) {
+                for (int b = 0; b < OUTS_NUM; b++) Py_XDECREF(outs[b]);
+                return NULL;
+            }
+        }
+    }
+    return Py_BuildValue("(NNNNNN)", outs[BOARDS], outs[ACTIONS], outs[REWARDS], outs[CHAINS], outs[SCORES], outs[DONES]);
+}
+
+//共有メモリの名前を削除する．つないでいるプロセスは引き続き使える
+static PyObject* SharedRing_unlink(SharedRingObject *self, PyObject *Py_UNUSED(ignored)){
+    if (checkRingReady(self) != 0) return NULL;
+    if (ringUnlink(self->ring.name) != 0) {
+        return PyErr_SetFromErrnoWithFilename(PyExc_OSError, self->ring.name);
+    }
+    Py_RETURN_NONE;
+}
+
+//共有メモリ上の配列をそのまま指すndarrayを作る．配列が生きている間はselfを解放しない
+static PyObject* ringView(SharedRingObject *self, void *data, int ndim, npy_intp *dims, int typenum){
+    if (checkRingReady(self) != 0) return NULL;
+    PyObject *view = PyArray_SimpleNewFromData(ndim, dims, typenum, data);
+    if (view == NULL) return NULL;
+    Py_INCREF(self);
+    if (PyArray_SetBaseObject((PyArrayObject *)view, (PyObject *)self) < 0) {
+        Py_DECREF(view);
+        return NULL;
+    }
+    return view;
+}
+
+static PyObject* SharedRing_getBoards(SharedRingObject *self, void *closure){
+    npy_intp dims[4] = {self->ring.header ? self->ring.header->capacity : 0, ARRS_NUM, ROWS_NUM, COLS_NUM};
+    return ringView(self, self->ring.boards, 4, dims, NPY_INT32);
+}
+
+static PyObject* SharedRing_getActions(SharedRingObject *self, void *closure){
+    npy_intp dims[1] = {self->ring.header ? self->ring.header->capacity : 0};
+    return ringView(self, self->ring.actions, 1, dims, NPY_INT32);
+}
+
+static PyObject* SharedRing_getRewards(SharedRingObject *self, void *closure){
+    npy_intp dims[1] = {self->ring.header ? self->ring.header->capacity : 0};
+    return ringView(self, self->ring.rewards, 1, dims, NPY_FLOAT32);
+}
+
+static PyObject* SharedRing_getChains(SharedRingObject *self, void *closure){
+    npy_intp dims[1] = {self->ring.header ? self->ring.header->capacity : 0};
+    return ringView(self, self->ring.chains, 1, dims, NPY_INT32);
+}
+
+static PyObject* SharedRing_getScores(SharedRingObject *self, void *closure){
+    npy_intp dims[1] = {self->ring.header ? self->ring.header->capacity : 0};
+    return ringView(self, self->ring.scores, 1, dims, NPY_INT32);
+}
+
+static PyObject* SharedRing_getDones(SharedRingObject *self, void *closure){
+    npy_intp dims[1] = {self->ring.header ? self->ring.header->capacity : 0};
+    return ringView(self, self->ring.dones, 1, dims, NPY_INT32);
+}
+
+static PyObject* SharedRing_getName(SharedRingObject *self, void *closure){
+    return PyUnicode_FromString(self->ring.name);
+}
+
+static PyObject* SharedRing_getCapacity(SharedRingObject *self, void *closure){
+    return PyLong_FromLong(self->ring.header ? (long)self->ring.header->capacity : 0);
+}
+
+static Py_ssize_t SharedRing_len(SharedRingObject *self){
+    return self->ring.header ? ringCount(&self->ring) : 0;
+}
+
+static PyMethodDef SharedRing_methods[] = {
+    {"push", (PyCFunction)SharedRing_push, METH_VARARGS,
+        "Publish one record (board, action, reward[, n_chains, score, done]). Return False if full."},
+    {"pushBatch", (PyCFunction)SharedRing_pushBatch, METH_VARARGS,
+        "Publish N records in order and return how many were written."},
+    {"acquire", (PyCFunction)SharedRing_acquire, METH_VARARGS,
+        "Reserve up to max_n contiguous published slots for reading and return (first, n)."},
+    {"release", (PyCFunction)SharedRing_release, METH_VARARGS,
+        "Return the first n acquired slots to producers."},
+    {"pop", (PyCFunction)SharedRing_pop, METH_VARARGS,
+        "Copy out and release up to max_n records."},
+    {"unlink", (PyCFunction)SharedRing_unlink, METH_NOARGS,
+        "Remove the shared memory name."},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyGetSetDef SharedRing_getset[] = {
+    {"boards", (getter)SharedRing_getBoards, NULL, "View of the board slots.", NULL},
+    {"actions", (getter)SharedRing_getActions, NULL, "View of the action slots.", NULL},
+    {"rewards", (getter)SharedRing_getRewards, NULL, "View of the reward slots.", NULL},
+    {"chains", (getter)SharedRing_getChains, NULL, "View of the chain count slots.", NULL},
+    {"scores", (getter)SharedRing_getScores, NULL, "View of the score slots.", NULL},
+    {"dones", (getter)SharedRing_getDones, NULL, "View of the done flag slots.", NULL},
+    {"name", (getter)SharedRing_getName, NULL, "Shared memory name.", NULL},
+    {"capacity", (getter)SharedRing_getCapacity, NULL, "Number of slots.", NULL},
+    {NULL, NULL, NULL, NULL, NULL}
+};
+
+static PyType_Slot SharedRing_slots[] = {
+    {Py_tp_dealloc, (void *)SharedRing_dealloc},
+    {Py_sq_length, (void *)SharedRing_len},
+    {Py_tp_doc, (void *)"Board ring buffer in POSIX shared memory."},
+    {Py_tp_methods, SharedRing_methods},
+    {Py_tp_getset, SharedRing_getset},
+    {Py_tp_init, (void *)SharedRing_init},
+    {Py_tp_new, (void *)SharedRing_new},
+    {0, NULL}
+};
+
+static PyType_Spec SharedRing_spec = {
+    .name = "puyothon.puyothon.SharedRing",
+    .basicsize = sizeof(SharedRingObject),
+    .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | PUYO_TPFLAGS_IMMUTABLE,
+    .slots = SharedRing_slots,
+};
+
+//盤面オブジェクト-------------------------------------------------------------------------------------------------
+
+//Boardのメソッドは1回の処理が短く，GILの受け渡しのほうが重いのでGILを持ったまま実行する
+static Py_ssize_t board_shape[3] = {ARRS_NUM, ROWS_NUM, COLS_NUM};
+static Py_ssize_t board_strides[3] = {ROWS_NUM * COLS_NUM * sizeof(int), COLS_NUM * sizeof(int), sizeof(int)};
+
+static PyObject* Board_new(PyTypeObject *type, PyObject *args, PyObject *kwds){
+    BoardObject *self = (BoardObject *)type->tp_alloc(type, 0);
+    if (self == NULL) return NULL;
+    initBoard(self->board);
+    return (PyObject *)self;
+}
+
+static void Board_dealloc(BoardObject *self){
+    PyTypeObject *type = Py_TYPE(self);
+    type->tp_free((PyObject *)self);
+    Py_DECREF(type);
+}
+
+//Board(board=None)．ndarrayかBoardを渡すとその盤面をコピーする
+static int Board_init(BoardObject *self, PyObject *args, PyObject *kwds){
+    static char *kwlist[] = {"board", NULL};
+    PyObject *board_obj = Py_None;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|O", kwlist, &board_obj)) {
+        return -1;
+    }
+    if (board_obj == Py_None) {
+        initBoard(self->board);
+        return 0;
+    }
+    if (isBoardObject(board_obj)) {
+        memcpy(self->board, ((BoardObject *)board_obj)->board, sizeof(self->board));
+        return 0;
+    }
+    int (*board)[ROWS_NUM][COLS_NUM];
+    if (toBoard_ro(board_obj, &board) != 0) return -1;
+    memcpy(self->board, board, sizeof(self->board));
+    return 0;
+}
+
+//位置引数のi番目を整数として取り出す．なければdefaultの値にする
+static int fastArgInt(PyObject *const *args, Py_ssize_t nargs, Py_ssize_t i, int def, int *out){
+    if (i >= nargs) {
+        *out = def;
+        return 0;
+    }
+    long v = PyLong_AsLong(args[i]);
+    if (v == -1 && PyErr_Occurred()) return -1;
+    if (v < INT_MIN || v > INT_MAX) {
+        PyErr_SetString(PyExc_OverflowError, "argument out of int range");
+        return -1;
+    }
+    *out = (int)v;
+    return 0;
+}
+
+static int checkNargs(const char *name, Py_ssize_t nargs, Py_ssize_t min, Py_ssize_t max){
+    if (nargs < min || nargs > max) {
+        if (min == max)
+            PyErr_Format(PyExc_TypeError, "%s() takes %zd arguments (%zd given)", name, min, nargs);
+        else
+            PyErr_Format(PyExc_TypeError, "%s() takes %zd to %zd arguments (%zd given)", name, min, max, nargs);
+        return -1;
+    }
+    return 0;
+}
+
+//put(parent, child, col, rot)．置けなければFalseを返す
+static PyObject* Board_put(BoardObject *self, PyObject *const *args, Py_ssize_t nargs){
+    int parent_puyo, child_puyo, col, rot;
+    if (checkNargs("put", nargs, 4, 4) != 0) return NULL;
+    if (fastArgInt(args, nargs, 0, 0, &parent_puyo) != 0) return NULL;
+    if (fastArgInt(args, nargs, 1, 0, &child_puyo) != 0) return NULL;
+    if (fastArgInt(args, nargs, 2, 0, &col) != 0) return NULL;
+    if (fastArgInt(args, nargs, 3, 0, &rot) != 0) return NULL;
+
+    if (!canPut(self->board, col, rot))
+        Py_RETURN_FALSE;
+    putPuyo(self->board, col, rot, parent_puyo, child_puyo);
+    Py_RETURN_TRUE;
+}
+
+//fall(engine=ENGINE_ARRAY)．落下した最大段数を返す
+static PyObject* Board_fall(BoardObject *self, PyObject *const *args, Py_ssize_t nargs){
+    int engine;
+    if (checkNargs("fall", nargs, 0, 1) != 0) return NULL;
+    if (fastArgInt(args, nargs, 0, ENGINE_ARRAY, &engine) != 0) return NULL;
+    if (checkEngine(engine) != 0) return NULL;
+
+    int fall_max = engine == ENGINE_BITBOARD ? fallPuyosBB(self->board) : fallPuyos(self->board);
+    return PyLong_FromLong(fall_max);
+}
+
+//erase(chain_count, engine=ENGINE_ARRAY)．1連鎖分を消してスコアを返す
+static PyObject* Board_erase(BoardObject *self, PyObject *const *args, Py_ssize_t nargs){
+    int chain_count, engine;
+    if (checkNargs("erase", nargs, 1, 2) != 0) return NULL;
+    if (fastArgInt(args, nargs, 0, 0, &chain_count) != 0) return NULL;
+    if (fastArgInt(args, nargs, 1, ENGINE_ARRAY, &engine) != 0) return NULL;
+    if (checkEngine(engine) != 0) return NULL;
+
+    int score = engine == ENGINE_BITBOARD ? oneChainBB(self->board, chain_count) : oneChain(self->board, chain_count);
+    return PyLong_FromLong(score);
+}
+
+//chain(engine=ENGINE_ARRAY)．最後まで連鎖して(連鎖数, スコア)を返す
+static PyObject* Board_chain(BoardObject *self, PyObject *const *args, Py_ssize_t nargs){
+    int engine;
+    if (checkNargs("chain", nargs, 0, 1) != 0) return NULL;
+    if (fastArgInt(args, nargs, 0, ENGINE_ARRAY, &engine) != 0) return NULL;
+    if (checkEngine(engine) != 0) return NULL;
+
+    int n_chains, score;
+    if (engine == ENGINE_BITBOARD)
+        allChainBB(self->board, &n_chains, &score);
+    else
+        allChain(self->board, &n_chains, &score);
+    return Py_BuildValue("(ii)", n_chains, score);
+}
+
+//make(parent, child, col, rot)．(置けたか, 連鎖数, スコア, 変更記録) を返す
+static PyObject* Board_make(BoardObject *self, PyObject *const *args, Py_ssize_t nargs){
+    int parent_puyo, child_puyo, col, rot;
+    if (checkNargs("make", nargs, 4, 4) != 0) return NULL;
+    if (fastArgInt(args, nargs, 0, 0, &parent_puyo) != 0) return NULL;
+    if (fastArgInt(args, nargs, 1, 0, &child_puyo) != 0) return NULL;
+    if (fastArgInt(args, nargs, 2, 0, &col) != 0) return NULL;
+    if (fastArgInt(args, nargs, 3, 0, &rot) != 0) return NULL;
+
+    UndoRecord undo;
+    int legal = makeMove(self->board, col, rot, parent_puyo, child_puyo, &undo);
+    return makeMoveResult(legal, &undo);
+}
+
+static PyObject* Board_unmake(BoardObject *self, PyObject *undo){
+    if (applyUndoBytes(self->board, undo) != 0) return NULL;
+    Py_RETURN_NONE;
+}
+
+static PyObject* Board_isDead(BoardObject *self, PyObject *unused){
+    return PyBool_FromLong(isDeadBoard(self->board));
+}
+
+static PyObject* Board_copy(BoardObject *self, PyObject *unused){
+    PyTypeObject *type = Py_TYPE(self);
+    BoardObject *copy = (BoardObject *)type->tp_alloc(type, 0);
+    if (copy == NULL) return NULL;
+    memcpy(copy->board, self->board, sizeof(self->board));
+    return (PyObject *)copy;
+}
+
+//encode(layout=LAYOUT_NHWC, dtype=DTYPE_FLOAT32, out=None)．cvtBoardForModelと同じ
+static PyObject* Board_encode(BoardObject *self, PyObject *const *args, Py_ssize_t nargs){
+    int layout, dtype;
+    if (checkNargs("encode", nargs, 0, 3) != 0) return NULL;
+    if (fastArgInt(args, nargs, 0, LAYOUT_NHWC, &layout) != 0) return NULL;
+    if (fastArgInt(args, nargs, 1, DTYPE_FLOAT32, &dtype) != 0) return NULL;
+    if (checkEncoding(layout, dtype) != 0) return NULL;
+
+    if (nargs > 2 && args[2] != Py_None) {
+        Py_buffer view;
+        if (getEncodedBuffer(args[2], dtype, 1, &view, "out") != 0) return NULL;
+        Py_BEGIN_ALLOW_THREADS
+        encodeBoard(self->board, layout, dtype, view.buf);
+        Py_END_ALLOW_THREADS
+        PyBuffer_Release(&view);
+        Py_INCREF(args[2]);
+        return args[2];
+    }
+
+    npy_intp dims[4];
+    int ndim = encodedShape(layout, dtype, 1, dims);
+    PyArrayObject *x = (PyArrayObject *)PyArray_SimpleNew(ndim, dims, encodedTypenum(dtype));
+    if (x == NULL) return NULL;
+    Py_BEGIN_ALLOW_THREADS
+    encodeBoard(self->board, layout, dtype, PyArray_DATA(x));
+    Py_END_ALLOW_THREADS
+    return (PyObject *)x;
+}
+
+//盤面をそのまま指すndarrayを返す．配列が生きている間はselfを解放しない
+static PyObject* Board_getArray(BoardObject *self, void *closure){
+    npy_intp dims[3] = {ARRS_NUM, ROWS_NUM, COLS_NUM};
+    PyObject *view = PyArray_SimpleNewFromData(3, dims, NPY_INT32, self->board);
+    if (view == NULL) return NULL;
+    Py_INCREF(self);
+    if (PyArray_SetBaseObject((PyArrayObject *)view, (PyObject *)self) < 0) {
+        Py_DECREF(view);
+        return NULL;
+    }
+    return view;
+}
+
+//bufferプロトコル．np.asarray(board)で(ARRS_NUM, ROWS_NUM, COLS_NUM)のint32配列として見える
+static int Board_getbuffer(BoardObject *self, Py_buffer *view, int flags){
+    view->obj = (PyObject *)self;
+    Py_INCREF(self);
+    view->buf = self->board;
+    view->len = sizeof(self->board);
+    view->readonly = 0;
+    view->itemsize = sizeof(int);
+    view->format = (flags & PyBUF_FORMAT) ? "i" : NULL;
+    view->ndim = 3;
+    view->shape = (flags & PyBUF_ND) == PyBUF_ND ? board_shape : NULL;
+    view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? board_strides : NULL;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+    return 0;
+}
+
+static PyMethodDef Board_methods[] = {
+    {"put", (PyCFunction)(void(*)(void))Board_put, METH_FASTCALL,
+        "Put puyos (parent, child, col, rot). Return False if the location is not allowed."},
+    {"fall", (PyCFunction)(void(*)(void))Board_fall, METH_FASTCALL, "Fall puyos and return the max fall distance."},
+    {"erase", (PyCFunction)(void(*)(void))Board_erase, METH_FASTCALL,
+        "Erase 4 or more connected puyos as the given chain and return the score."},
+    {"chain", (PyCFunction)(void(*)(void))Board_chain, METH_FASTCALL,
+        "Execute chains and return the number of chains and the score."},
+    {"make", (PyCFunction)(void(*)(void))Board_make, METH_FASTCALL,
+        "Put puyos and execute chains, returning (legal, n_chains, score, undo)."},
+    {"unmake", (PyCFunction)Board_unmake, METH_O, "Restore the board from an undo record of make."},
+    {"is_dead", (PyCFunction)Board_isDead, METH_NOARGS, "Return True if the board is dead."},
+    {"copy", (PyCFunction)Board_copy, METH_NOARGS, "Return a copy of the board."},
+    {"encode", (PyCFunction)(void(*)(void))Board_encode, METH_FASTCALL,
+        "Encode the board for the model, like cvtBoardForModel."},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyGetSetDef Board_getset[] = {
+    {"array", (getter)Board_getArray, NULL, "Writable ndarray view of the board.", NULL},
+    {NULL, NULL, NULL, NULL, NULL}
+};
+
+static PyType_Slot Board_slots[] = {
+    {Py_tp_dealloc, (void *)Board_dealloc},
+    {Py_bf_getbuffer, (void *)Board_getbuffer},
+    {Py_tp_doc, (void *)"Game board stored inline with fast methods."},
+    {Py_tp_methods, Board_methods},
+    {Py_tp_getset, Board_getset},
+    {Py_tp_init, (void *)Board_init},
+    {Py_tp_new, (void *)Board_new},
+    {0, NULL}
+};
+
+static PyType_Spec Board_spec = {
+    .name = "puyothon.puyothon.Board",
+    .basicsize = sizeof(BoardObject),
+    .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | PUYO_TPFLAGS_IMMUTABLE,
+    .slots = Board_slots,
+};
+
+//モジュールの作成-------------------------------------------------------------------------------------------------
+
+static int addIntConstants(PyObject *module){
+    if (PyModule_AddIntMacro(module, ARRS_NUM) < 0) return -1;
+    if (PyModule_AddIntMacro(module, ROWS_NUM) < 0) return -1;
+    if (PyModule_AddIntMacro(module, COLS_NUM) < 0) return -1;
+
+    if (PyModule_AddIntMacro(module, PUYO) < 0) return -1;
+    if (PyModule_AddIntMacro(module, STATE) < 0) return -1;
+
+    if (PyModule_AddIntMacro(module, OJAMA) < 0) return -1;
+    if (PyModule_AddIntMacro(module, BLOCK) < 0) return -1;
     if (PyModule_AddIntMacro(module, EMPTY) < 0) return -1;
 
     if (PyModule_AddIntMacro(module, COLOR_NUM) < 0) return -1;
@@ -337,12 +3034,60 @@ static int addIntConstants(PyObject *module){
     if (PyModule_AddIntMacro(module, IDLE) < 0) return -1;
     if (PyModule_AddIntMacro(module, NEW) < 0) return -1;
 
+    if (PyModule_AddIntMacro(module, ENGINE_ARRAY) < 0) return -1;
+    if (PyModule_AddIntMacro(module, ENGINE_BITBOARD) < 0) return -1;
+
+    if (PyModule_AddIntMacro(module, LAYOUT_NHWC) < 0) return -1;
+    if (PyModule_AddIntMacro(module, LAYOUT_NCHW) < 0) return -1;
+    if (PyModule_AddIntMacro(module, DTYPE_FLOAT32) < 0) return -1;
+    if (PyModule_AddIntMacro(module, DTYPE_FLOAT16) < 0) return -1;
+    if (PyModule_AddIntMacro(module, DTYPE_UINT8) < 0) return -1;
+    if (PyModule_AddIntMacro(module, DTYPE_BITS) < 0) return -1;
+
+    if (PyModule_AddIntMacro(module, PACK_BYTES) < 0) return -1;
+    if (PyModule_AddIntMacro(module, LOG_HEADER_BYTES) < 0) return -1;
+    if (PyModule_AddIntMacro(module, LOG_RECORD_BYTES) < 0) return -1;
+    if (PyModule_AddIntMacro(module, LOG_VERSION) < 0) return -1;
+
+    if (PyModule_AddIntMacro(module, POLICY_RANDOM) < 0) return -1;
+    if (PyModule_AddIntMacro(module, POLICY_GREEDY) < 0) return -1;
+
+    if (PyModule_AddIntMacro(module, OJAMA_RATE) < 0) return -1;
+    if (PyModule_AddIntMacro(module, OJAMA_MAX_DROP) < 0) return -1;
+
+    if (PyModule_AddIntMacro(module, TSUMO_CYCLE) < 0) return -1;
+
+    if (PyModule_AddIntMacro(module, FEATURES_NUM) < 0) return -1;
+    if (PyModule_AddIntMacro(module, FEATURE_DROPS) < 0) return -1;
+    if (PyModule_AddIntMacro(module, FEATURE_HEIGHT_OFFSET) < 0) return -1;
+    if (PyModule_AddIntMacro(module, FEATURE_CONNECT_OFFSET) < 0) return -1;
+    if (PyModule_AddIntMacro(module, FEATURE_GROUP_OFFSET) < 0) return -1;
+
+    if (PyModule_AddIntMacro(module, VARIANT_STANDARD) < 0) return -1;
+    if (PyModule_AddIntMacro(module, VARIANT_COLOR3) < 0) return -1;
+    if (PyModule_AddIntMacro(module, VARIANT_COLOR5) < 0) return -1;
+    if (PyModule_AddIntMacro(module, VARIANT_WIDE) < 0) return -1;
+    if (PyModule_AddIntMacro(module, VARIANTS_NUM) < 0) return -1;
+
     return 0;
 }
 
 static PyMethodDef puyo_methods[] = {
     {"cvtBoardForModel",  cvtBoardForModel,  METH_VARARGS, ""},
     {"getAbleBoardsForModel", getAbleBoardsForModel, METH_VARARGS, ""},
+    {"getAbleBoardsForModelInto", getAbleBoardsForModelInto, METH_VARARGS,
+        "Write encoded boards after every able action into given buffers and return the number of able actions."},
+    {"getAbleBoardsForModelBatch", getAbleBoardsForModelBatch, METH_VARARGS,
+        "Write boards after every action of N boards into given buffers with a validity mask."},
+    {"step",              (PyCFunction)(void(*)(void))pyStep, METH_VARARGS | METH_KEYWORDS,
+        "Take an action index, execute chains and write the next legal mask and candidate boards. Return (legal, n_chains, score, done)."},
+    {"legalActionMask",   pyLegalActionMask, METH_O,
+        "Return the legal actions of the board as a 22-bit mask."},
+    {"legalActionMasks",  pyLegalActionMasks, METH_VARARGS,
+        "Return the 22-bit legal action masks of N boards as a uint32 array."},
+    {"makeMove",          pyMakeMove,        METH_VARARGS,
+        "Put puyos and execute chains, returning (legal, n_chains, score, undo)."},
+    {"unmakeMove",        pyUnmakeMove,      METH_VARARGS, "Restore the board from an undo record of makeMove."},
     {"putPuyo",           pyPutPuyo,         METH_VARARGS,
         "Put puyos at the specified location and number of rotations."},
     {"fallPuyo",          fall,              METH_VARARGS, "Fall puyos in board."},
@@ -350,34 +3095,146 @@ static PyMethodDef puyo_methods[] = {
         "Erase 4 or more connected Puyos and return the score."},
     {"chainAuto",         chainAuto,         METH_VARARGS,
         "Executes chains and returns the number of chains and the score."},
-    {"makeBoard",         makeBoard,         METH_NOARGS,  "Make new game board."},
+    {"makeBoard",         makeBoard,         METH_VARARGS, "Make new game board."},
+    {"getRuleVariants",   pyGetRuleVariants, METH_NOARGS,
+        "Return (name, colors, rows, cols, actions) of every rule variant."},
     {"isDead",            isDead,            METH_VARARGS,
         "Return True if player of given board is dead."},
+    {"stepBatch",         stepBatch,         METH_VARARGS,
+        "Put puyos, execute chains and check death for N boards at once."},
+    {"evaluateActions",   pyEvaluateActions, METH_VARARGS,
+        "Try every action on a copy of the board and return (legal, n_chains, scores, heights, dead)."},
+    {"evaluateActionsBatch", pyEvaluateActionsBatch, METH_VARARGS,
+        "Run evaluateActions for N boards in parallel."},
+    {"chainFeatures",     pyChainFeatures,   METH_VARARGS,
+        "Return the latent chain features of the board as a float32 array of FEATURES_NUM values."},
+    {"chainFeaturesBatch", pyChainFeaturesBatch, METH_VARARGS,
+        "Return the latent chain features of N boards as an (N, FEATURES_NUM) float32 array."},
+    {"searchActions",     pySearchActions,   METH_VARARGS,
+        "Search upcoming pairs and return the best score, max chain and best next action for every first action."},
+    {"beamSearch",        pyBeamSearch,      METH_VARARGS,
+        "Beam search over known and sampled pairs and return (action, pv, nodes, value, score, max_chain)."},
+    {"rollout",           pyRollout,         METH_VARARGS,
+        "Run random rollouts from the board and return score and chain statistics."},
+    {"versusStep",        pyVersusStep,      METH_VARARGS,
+        "Advance a two-player game by one move with ojama offsetting and dropping."},
+    {"playVersus",        pyPlayVersus,      METH_VARARGS,
+        "Play versus games between built-in policies and return winners, turns, scores and max chains."},
+    {"hashBoard",         hashBoard,         METH_VARARGS, "Return the Zobrist hash of the puyo plane."},
+    {"chainAutoCached",   chainAutoCached,   METH_VARARGS,
+        "Executes chains using the transposition table and returns the number of chains and the score."},
+    {"probeCache",        pyProbeCache,      METH_VARARGS,
+        "Return the cached number of chains and score of the board, or None."},
+    {"setCacheSize",      pySetCacheSize,    METH_VARARGS, "Resize the transposition table. 0 disables it."},
+    {"clearCache",        pyClearCache,      METH_NOARGS,  "Clear the transposition table and its counters."},
+    {"getCacheStats",     pyGetCacheStats,   METH_NOARGS,  "Return the size and hit/miss/store counters of the transposition table."},
+    {"getStats",          pyGetStats,        METH_VARARGS,
+        "Return the hot-path counters of a PUYO_STATS build, optionally resetting them."},
+    {"getSimdInfo",       pyGetSimdInfo,     METH_NOARGS,  "Return the SIMD level in use and the levels supported by this CPU."},
+    {"setSimdLevel",      pySetSimdLevel,    METH_VARARGS, "Use the newest supported SIMD level not above the given one."},
+    {"augmentColors",     pyAugmentColors,   METH_VARARGS,
+        "Expand boards or model inputs to every color permutation, remapping actions and pair colors."},
+    {"generateTsumo",     pyGenerateTsumo,   METH_VARARGS,
+        "Generate N seeded 128-pair cyclic tsumo sequences as an (N, length, 2) int32 array."},
+    {"packBoards",        pyPackBoards,      METH_VARARGS, "Pack the puyo planes of N boards into (N, 32) bytes."},
+    {"unpackBoards",      pyUnpackBoards,    METH_VARARGS, "Unpack (N, 32) bytes into N boards."},
+    {"appendGameLog",     pyAppendGameLog,   METH_VARARGS,
+        "Append (board, pair, action, chains, score) records to a game log file and return the record count."},
     {NULL, NULL, 0, NULL}
 };
 
-static struct PyModuleDef puyo_module = {
-    PyModuleDef_HEAD_INIT,
-    "puyothon",
-    NULL,
-    -1,
-    puyo_methods
-};
+//モジュールごとの状態．サブインタプリタごとに別の型オブジェクトを持つ
+typedef struct {
+    PyObject *board_type;
+    PyObject *replay_buffer_type;
+    PyObject *shared_ring_type;
+} PuyoModuleState;
 
-PyMODINIT_FUNC PyInit_puyothon(void) {
-    PyObject *module = PyModule_Create(&puyo_module);
-    if (module == NULL) return NULL;
+static int puyo_traverse(PyObject *module, visitproc visit, void *arg){
+    PuyoModuleState *state = (PuyoModuleState *)PyModule_GetState(module);
+    Py_VISIT(state->board_type);
+    Py_VISIT(state->replay_buffer_type);
+    Py_VISIT(state->shared_ring_type);
+    return 0;
+}
 
-    import_array();
-    if (PyErr_Occurred()) {
-        Py_DECREF(module);
-        return NULL;
-    }
+static int puyo_clear(PyObject *module){
+    PuyoModuleState *state = (PuyoModuleState *)PyModule_GetState(module);
+    Py_CLEAR(state->board_type);
+    Py_CLEAR(state->replay_buffer_type);
+    Py_CLEAR(state->shared_ring_type);
+    return 0;
+}
 
-    if (addIntConstants(module) < 0) {
-        Py_DECREF(module);
-        return NULL;
+static void puyo_free(void *module){
+    puyo_clear((PyObject *)module);
+}
+
+//Cの表（Zobrist，置換表，合法手表，SIMD）はプロセスで共有するので，インタプリタがいくつあっても1回だけ作る
+static PuyoOnce tables_once = PUYO_ONCE_INIT;
+
+static void initTables(void){
+    initSimd();
+    initZobrist();
+    initCache();
+    initLegalTable();
+}
+
+//specから型を作り，状態に保持してモジュールに登録する
+static int addType(PyObject *module, PyType_Spec *spec, const char *name, PyObject **slot){
+    *slot = PyType_FromModuleAndSpec(module, spec, NULL);
+    if (*slot == NULL) return -1;
+    Py_INCREF(*slot);
+    if (PyModule_AddObject(module, name, *slot) < 0) {
+        Py_DECREF(*slot);
+        return -1;
     }
+    return 0;
+}
+
+static int puyo_exec(PyObject *module){
+    if (_import_array() < 0) return -1;
+
+    //表を作る間はGILを解放する．別のスレッドが作っている途中なら終わるまで待つ
+    Py_BEGIN_ALLOW_THREADS
+    callOnce(&tables_once, initTables);
+    Py_END_ALLOW_THREADS
+
+    if (addIntConstants(module) < 0) return -1;
+
+    PuyoModuleState *state = (PuyoModuleState *)PyModule_GetState(module);
+    if (addType(module, &ReplayBuffer_spec, "ReplayBuffer", &state->replay_buffer_type) < 0) return -1;
+    if (addType(module, &Board_spec, "Board", &state->board_type) < 0) return -1;
+    if (addType(module, &SharedRing_spec, "SharedRing", &state->shared_ring_type) < 0) return -1;
+    return 0;
+}
+
+//GILのないビルド（3.13t以降）に対応する
+//サブインタプリタには対応しない．numpyのC APIの表，SIMDの選択，置換表，計測カウンタがプロセスで1つしかないため
+//同じBoardやSharedRingの読み出し側を複数のスレッドから同時に操作するのは呼び出し側で避ける
+static PyModuleDef_Slot puyo_slots[] = {
+    {Py_mod_exec, (void *)puyo_exec},
+#ifdef Py_mod_multiple_interpreters
+    {Py_mod_multiple_interpreters, Py_MOD_MULTIPLE_INTERPRETERS_NOT_SUPPORTED},
+#endif
+#ifdef Py_mod_gil
+    {Py_mod_gil, Py_MOD_GIL_NOT_USED},
+#endif
+    {0, NULL}
+};
+
+static struct PyModuleDef puyo_module = {
+    PyModuleDef_HEAD_INIT,
+    .m_name = "puyothon",
+    .m_doc = NULL,
+    .m_size = sizeof(PuyoModuleState),
+    .m_methods = puyo_methods,
+    .m_slots = puyo_slots,
+    .m_traverse = puyo_traverse,
+    .m_clear = puyo_clear,
+    .m_free = puyo_free,
+};
 
-    return module;
+PyMODINIT_FUNC PyInit_puyothon(void) {
+    return PyModuleDef_Init(&puyo_module);
 }
\ No newline at end of file
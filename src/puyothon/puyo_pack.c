@@ -0,0 +1,77 @@
+#include <string.h>
+#include "puyo_pack.h"
+
+#define PACK_CODE_OJAMA 5
+#define PACK_CODE_BLOCK 6
+
+// 盤面をPackedBoardに詰める関数．STATE面は保存しない
+// 表せない値が盤面内にあれば0を返す
+int packBoard(int (*board)[ROWS_NUM][COLS_NUM], PackedBoard *pb){
+    memset(pb, 0, sizeof(PackedBoard));
+    int k = 0;
+    for(int i = 1; i < ROWS_NUM; i++){
+        for(int j = 1; j < COLS_NUM-1; j++, k++){
+            int p = board[PUYO][i][j];
+            uint64_t code;
+            if(EMPTY <= p && p <= COLOR_NUM) code = (uint64_t)p;
+            else if(p == OJAMA) code = PACK_CODE_OJAMA;
+            else if(p == BLOCK) code = PACK_CODE_BLOCK;
+            else return 0;
+            pb->w[k / PACK_CELLS_PER_WORD] |= code << ((k % PACK_CELLS_PER_WORD) * PACK_CELL_BITS);
+        }
+    }
+    return 1;
+}
+
+// PackedBoardを盤面に戻す関数．壁はBLOCK，STATE面はIDLEにする
+// 使われていない符号があれば0を返す
+int unpackBoard(const PackedBoard *pb, int (*board)[ROWS_NUM][COLS_NUM]){
+    initBoard(board);
+    int k = 0;
+    for(int i = 1; i < ROWS_NUM; i++){
+        for(int j = 1; j < COLS_NUM-1; j++, k++){
+            int code = (int)((pb->w[k / PACK_CELLS_PER_WORD] >> ((k % PACK_CELLS_PER_WORD) * PACK_CELL_BITS)) & 7);
+            if(code == PACK_CODE_OJAMA) board[PUYO][i][j] = OJAMA;
+            else if(code == PACK_CODE_BLOCK) board[PUYO][i][j] = BLOCK;
+            else if(code <= COLOR_NUM) board[PUYO][i][j] = code;
+            else return 0;
+        }
+    }
+    return 1;
+}
+
+void packedToBytes(const PackedBoard *pb, unsigned char *bytes){
+    for(int w = 0; w < PACK_WORDS; w++){
+        for(int b = 0; b < 8; b++)
+            bytes[w*8 + b] = (unsigned char)(pb->w[w] >> (8*b));
+    }
+}
+
+void packedFromBytes(const unsigned char *bytes, PackedBoard *pb){
+    for(int w = 0; w < PACK_WORDS; w++){
+        uint64_t x = 0;
+        for(int b = 0; b < 8; b++)
+            x |= (uint64_t)bytes[w*8 + b] << (8*b);
+        pb->w[w] = x;
+    }
+}
+
+// n個の盤面をバイト列に詰める関数．詰められない盤面があればその番号を，全て詰められたらnを返す
+int packBoards(int (*boards)[ARRS_NUM][ROWS_NUM][COLS_NUM], int n, unsigned char (*bytes)[PACK_BYTES]){
+    for(int i = 0; i < n; i++){
+        PackedBoard pb;
+        if(!packBoard(boards[i], &pb)) return i;
+        packedToBytes(&pb, bytes[i]);
+    }
+    return n;
+}
+
+// n個のバイト列を盤面に戻す関数．戻せないバイト列があればその番号を，全て戻せたらnを返す
+int unpackBoards(const unsigned char (*bytes)[PACK_BYTES], int n, int (*boards)[ARRS_NUM][ROWS_NUM][COLS_NUM]){
+    for(int i = 0; i < n; i++){
+        PackedBoard pb;
+        packedFromBytes(bytes[i], &pb);
+        if(!unpackBoard(&pb, boards[i])) return i;
+    }
+    return n;
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef _PUYO_PACK_H_
+#define _PUYO_PACK_H_
+
+#include <stdint.h>
+#include "puyo_func.h"
+
+//盤面内の1マスを3bitで表し，1語に21マスずつ詰める
+//符号: EMPTY=0, 色1~4=1~4, OJAMA=5, BLOCK=6
+#define PACK_CELL_BITS 3
+#define PACK_CELLS_PER_WORD 21
+#define PACK_CELLS ((ROWS_NUM-1)*(COLS_NUM-2))
+#define PACK_WORDS ((PACK_CELLS + PACK_CELLS_PER_WORD - 1) / PACK_CELLS_PER_WORD)
+
+//ファイルなどに保存するときのバイト列．各語をリトルエンディアンで並べる
+#define PACK_BYTES (PACK_WORDS * 8)
+
+typedef struct {
+    uint64_t w[PACK_WORDS];
+} PackedBoard;
+
+int packBoard(int (*board)[ROWS_NUM][COLS_NUM], PackedBoard *pb);
+int unpackBoard(const PackedBoard *pb, int (*board)[ROWS_NUM][COLS_NUM]);
+void packedToBytes(const PackedBoard *pb, unsigned char *bytes);
+void packedFromBytes(const unsigned char *bytes, PackedBoard *pb);
+int packBoards(int (*boards)[ARRS_NUM][ROWS_NUM][COLS_NUM], int n, unsigned char (*bytes)[PACK_BYTES]);
+int unpackBoards(const unsigned char (*bytes)[PACK_BYTES], int n, int (*boards)[ARRS_NUM][ROWS_NUM][COLS_NUM]);
+
+#endif //_PUYO_PACK_H_
\ No newline at end of file
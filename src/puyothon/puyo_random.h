@@ -0,0 +1,43 @@
+#ifndef _PUYO_RANDOM_H_
+#define _PUYO_RANDOM_H_
+
+#include <stdint.h>
+
+//xoshiro256**による乱数生成器
+typedef struct {
+    uint64_t s[4];
+} PuyoRandom;
+
+static inline uint64_t splitmix64Next(uint64_t *x){
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// seedとstreamから乱数生成器を初期化する．streamが異なれば独立した系列になる
+static inline void randomInit(PuyoRandom *rng, uint64_t seed, uint64_t stream){
+    uint64_t x = seed ^ splitmix64Next(&stream);
+    for(int k = 0; k < 4; k++) rng->s[k] = splitmix64Next(&x);
+}
+
+static inline uint64_t randomNext(PuyoRandom *rng){
+    uint64_t *s = rng->s;
+    uint64_t x = s[1] * 5;
+    uint64_t result = ((x << 7) | (x >> 57)) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = (s[3] << 45) | (s[3] >> 19);
+    return result;
+}
+
+// 0以上n未満の整数を返す
+static inline int randomBelow(PuyoRandom *rng, int n){
+    return (int)(((randomNext(rng) >> 32) * (uint64_t)n) >> 32);
+}
+
+#endif //_PUYO_RANDOM_H_
\ No newline at end of file
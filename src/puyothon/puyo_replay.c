@@ -0,0 +1,113 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "puyo_replay.h"
+
+// capacity個の遷移を保存できるバッファを確保する関数．失敗したら0を返す
+int replayInit(ReplayMemory *rm, int capacity, double alpha, uint64_t seed){
+    memset(rm, 0, sizeof(ReplayMemory));
+    if(capacity <= 0) return 0;
+    int leaves = 1;
+    while(leaves < capacity) leaves <<= 1;
+
+    rm->capacity = capacity;
+    rm->leaves = leaves;
+    rm->alpha = alpha;
+    rm->max_priority = 1.0;
+    rm->tree = (double *)calloc((size_t)leaves * 2, sizeof(double));
+    rm->boards = (PackedBoard *)malloc((size_t)capacity * sizeof(PackedBoard));
+    rm->next_boards = (PackedBoard *)malloc((size_t)capacity * sizeof(PackedBoard));
+    rm->actions = (int *)malloc((size_t)capacity * sizeof(int));
+    rm->rewards = (float *)malloc((size_t)capacity * sizeof(float));
+    rm->dones = (unsigned char *)malloc((size_t)capacity);
+    randomInit(&rm->rng, seed, 0);
+    if(!rm->tree || !rm->boards || !rm->next_boards || !rm->actions || !rm->rewards || !rm->dones){
+        replayFree(rm);
+        return 0;
+    }
+    return 1;
+}
+
+void replayFree(ReplayMemory *rm){
+    free(rm->tree);
+    free(rm->boards);
+    free(rm->next_boards);
+    free(rm->actions);
+    free(rm->rewards);
+    free(rm->dones);
+    memset(rm, 0, sizeof(ReplayMemory));
+}
+
+// 葉の値を書き換え，根までの和を更新する
+static void setLeaf(ReplayMemory *rm, int index, double value){
+    int node = rm->leaves + index;
+    rm->tree[node] = value;
+    for(node >>= 1; node >= 1; node >>= 1)
+        rm->tree[node] = rm->tree[2*node] + rm->tree[2*node+1];
+}
+
+// 遷移の優先度を更新する関数．priorityはalpha乗する前の値
+void replayUpdate(ReplayMemory *rm, int index, double priority){
+    if(priority > rm->max_priority) rm->max_priority = priority;
+    setLeaf(rm, index, pow(priority, rm->alpha));
+}
+
+// 遷移を追加し，書き込んだ位置を返す関数．満杯なら最も古い遷移を上書きする
+// priorityが負なら今までの最大の優先度を使う
+int replayAdd(ReplayMemory *rm, const PackedBoard *board, int action, float reward, const PackedBoard *next_board, int done, double priority){
+    int index = rm->next;
+    rm->boards[index] = *board;
+    rm->next_boards[index] = *next_board;
+    rm->actions[index] = action;
+    rm->rewards[index] = reward;
+    rm->dones[index] = (unsigned char)(done != 0);
+    replayUpdate(rm, index, priority < 0 ? rm->max_priority : priority);
+
+    rm->next = (index + 1) % rm->capacity;
+    if(rm->size < rm->capacity) rm->size++;
+    return index;
+}
+
+double replayTotal(const ReplayMemory *rm){
+    return rm->tree[1];
+}
+
+// 累積和がuになる葉を根から辿って探す
+static int findLeaf(const ReplayMemory *rm, double u){
+    int node = 1;
+    while(node < rm->leaves){
+        double left = rm->tree[2*node];
+        if(u < left || rm->tree[2*node+1] <= 0.0){
+            node = 2*node;
+        }else{
+            u -= left;
+            node = 2*node+1;
+        }
+    }
+    int index = node - rm->leaves;
+    return index < rm->size ? index : rm->size - 1;
+}
+
+// 優先度に比例してn個の遷移を選ぶ関数（層化サンプリング）
+// weightsには重要度重み(size * P(i))^-betaをバッチ内の最大値で割ったものを書き込む
+// size > 0 かつ優先度の和が正であること
+void replaySample(ReplayMemory *rm, int n, double beta, int *indices, float *weights){
+    double total = rm->tree[1];
+    double segment = total / n;
+    double max_weight = 0.0;
+    for(int k = 0; k < n; k++){
+        double r = (double)(randomNext(&rm->rng) >> 11) * (1.0 / 9007199254740992.0);
+        double u = (k + r) * segment;
+        if(u >= total) u = nextafter(total, 0.0);
+        int index = findLeaf(rm, u);
+        double p = rm->tree[rm->leaves + index] / total;
+        double w = p > 0.0 ? pow(rm->size * p, -beta) : 0.0;
+        indices[k] = index;
+        weights[k] = (float)w;
+        if(w > max_weight) max_weight = w;
+    }
+    if(max_weight > 0.0){
+        for(int k = 0; k < n; k++)
+            weights[k] = (float)(weights[k] / max_weight);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,33 @@
+#ifndef _PUYO_REPLAY_H_
+#define _PUYO_REPLAY_H_
+
+#include "puyo_pack.h"
+#include "puyo_random.h"
+
+//優先度付き経験再生のバッファ
+//遷移(board, action, reward, next_board, done)を詰めた盤面で保存し，
+//優先度^alphaを葉に持つ和のセグメント木で比例サンプリングする
+typedef struct {
+    int capacity;
+    int size;
+    int next;
+    int leaves;          //capacity以上の2のべき
+    double alpha;
+    double max_priority; //新しい遷移に与える優先度（alpha乗する前）
+    double *tree;        //tree[1]が根，tree[leaves + i]が遷移iの葉
+    PackedBoard *boards;
+    PackedBoard *next_boards;
+    int *actions;
+    float *rewards;
+    unsigned char *dones;
+    PuyoRandom rng;
+} ReplayMemory;
+
+int replayInit(ReplayMemory *rm, int capacity, double alpha, uint64_t seed);
+void replayFree(ReplayMemory *rm);
+int replayAdd(ReplayMemory *rm, const PackedBoard *board, int action, float reward, const PackedBoard *next_board, int done, double priority);
+void replayUpdate(ReplayMemory *rm, int index, double priority);
+double replayTotal(const ReplayMemory *rm);
+void replaySample(ReplayMemory *rm, int n, double beta, int *indices, float *weights);
+
+#endif //_PUYO_REPLAY_H_
\ No newline at end of file
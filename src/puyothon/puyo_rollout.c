@@ -0,0 +1,112 @@
+#include <string.h>
+#include "puyo_rollout.h"
+#include "puyo_cache.h"
+#include "puyo_hash.h"
+#include "puyo_random.h"
+#include "puyo_thread.h"
+#include "puyo_tsumo.h"
+
+//並列処理で1スレッドが一度に受け持つロールアウト数
+#define ROLLOUT_GRAIN 4
+
+// 方策に従って行動を選ぶ関数．置ける手がなければ-1を返す
+// hashはboardのpuyo面のZobristハッシュ（POLICY_GREEDYで置換表を引くのに使う）
+int selectPolicyAction(int (*board)[ROWS_NUM][COLS_NUM], uint64_t hash, int parent_puyo, int child_puyo, int policy, PuyoRandom *rng){
+    int able_actions[ACTIONS_NUM];
+    int able_actions_num = 0;
+    for(int action = 0; action < ACTIONS_NUM; action++){
+        int col, rot;
+        actionToColRot(action, &col, &rot);
+        if(canPut(board, col, rot))
+            able_actions[able_actions_num++] = action;
+    }
+    if(able_actions_num == 0) return -1;
+
+    if(policy != POLICY_GREEDY)
+        return able_actions[randomBelow(rng, able_actions_num)];
+
+    //スコアが最大の手を集め，その中からランダムに選ぶ
+    int best_score = -1;
+    int best_num = 0;
+    for(int i = 0; i < able_actions_num; i++){
+        int col, rot;
+        actionToColRot(able_actions[i], &col, &rot);
+
+        int tmp_board[ARRS_NUM][ROWS_NUM][COLS_NUM];
+        memcpy(tmp_board, board, sizeof(tmp_board));
+        uint64_t tmp_hash = hash;
+        putPuyoHash(tmp_board, col, rot, parent_puyo, child_puyo, &tmp_hash);
+
+        int n_chains, score;
+        allChainCached(tmp_board, &tmp_hash, &n_chains, &score);
+
+        if(score > best_score){
+            best_score = score;
+            best_num = 0;
+        }
+        if(score == best_score)
+            able_actions[best_num++] = able_actions[i];
+    }
+    return able_actions[randomBelow(rng, best_num)];
+}
+
+// boardからhorizon手までランダムなツモでロールアウトする関数．boardは変更しない
+// ツモは128組周期のツモ列の先頭から使う．乱数はseedとstreamで決まるので，同じ引数なら常に同じ結果になる
+void rolloutBoard(int (*board)[ROWS_NUM][COLS_NUM], uint64_t seed, uint64_t stream, int horizon, int policy, RolloutResult *result){
+    PuyoRandom rng;
+    randomInit(&rng, seed, stream);
+    TsumoTable tsumo;
+    tsumoInit(&tsumo, &rng);
+
+    int tmp_board[ARRS_NUM][ROWS_NUM][COLS_NUM];
+    memcpy(tmp_board, board, sizeof(tmp_board));
+    uint64_t hash = zobristHash(tmp_board);
+
+    result->score = 0;
+    result->max_chain = 0;
+    result->turns = 0;
+    result->dead = 0;
+
+    for(int turn = 0; turn < horizon; turn++){
+        int parent_puyo, child_puyo;
+        tsumoPair(&tsumo, turn, &parent_puyo, &child_puyo);
+
+        int action = selectPolicyAction(tmp_board, hash, parent_puyo, child_puyo, policy, &rng);
+        if(action < 0) break;
+
+        int col, rot;
+        actionToColRot(action, &col, &rot);
+        putPuyoHash(tmp_board, col, rot, parent_puyo, child_puyo, &hash);
+
+        int n_chains, score;
+        allChainCached(tmp_board, &hash, &n_chains, &score);
+
+        result->score += score;
+        if(n_chains > result->max_chain) result->max_chain = n_chains;
+        result->turns++;
+
+        if(isDeadBoard(tmp_board)) break;
+    }
+    result->dead = isDeadBoard(tmp_board);
+}
+
+typedef struct {
+    int (*board)[ROWS_NUM][COLS_NUM];
+    uint64_t seed;
+    int horizon;
+    int policy;
+    RolloutResult *results;
+} RolloutJob;
+
+static void rolloutTask(void *ctx, int begin, int end){
+    RolloutJob *job = (RolloutJob *)ctx;
+    for(int i = begin; i < end; i++)
+        rolloutBoard(job->board, job->seed, (uint64_t)i, job->horizon, job->policy, &job->results[i]);
+}
+
+// n_rollouts回のロールアウトをスレッドに分担して行う関数
+// i回目のロールアウトは乱数系列iを使うので，結果はスレッド数によらない
+void rolloutBoards(int (*board)[ROWS_NUM][COLS_NUM], uint64_t seed, int n_rollouts, int horizon, int policy, RolloutResult *results, int n_threads){
+    RolloutJob job = {board, seed, horizon, policy, results};
+    parallelFor(n_rollouts, n_threads, ROLLOUT_GRAIN, rolloutTask, &job);
+}
\ No newline at end of file
@@ -0,0 +1,25 @@
+#ifndef _PUYO_ROLLOUT_H_
+#define _PUYO_ROLLOUT_H_
+
+#include <stdint.h>
+#include "puyo_func.h"
+
+//ロールアウトの方策
+#define POLICY_RANDOM 0 //置ける手から一様ランダム
+#define POLICY_GREEDY 1 //その手で得られるスコアが最大の手（同点はランダム）
+
+//1回のロールアウトの結果
+typedef struct {
+    int score;
+    int max_chain;
+    int turns;
+    int dead;
+} RolloutResult;
+
+#include "puyo_random.h"
+
+int selectPolicyAction(int (*board)[ROWS_NUM][COLS_NUM], uint64_t hash, int parent_puyo, int child_puyo, int policy, PuyoRandom *rng);
+void rolloutBoard(int (*board)[ROWS_NUM][COLS_NUM], uint64_t seed, uint64_t stream, int horizon, int policy, RolloutResult *result);
+void rolloutBoards(int (*board)[ROWS_NUM][COLS_NUM], uint64_t seed, int n_rollouts, int horizon, int policy, RolloutResult *results, int n_threads);
+
+#endif //_PUYO_ROLLOUT_H_
\ No newline at end of file
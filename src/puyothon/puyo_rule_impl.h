@@ -0,0 +1,357 @@
+//ぷよを置く・落とす・消す処理の本体．ルールの種類ごとに1回ずつincludeする
+//標準のルールはpuyo_func.cから，それ以外はpuyo_variant_impl.hからincludeする
+//V_SUFFIX（関数名の接尾辞．空でもよい），V_COLORS，V_ROWS，V_COLSを定義してからincludeすること
+//段と列の番号は盤面の大きさから求めるので，ルールの修正はここだけで済む
+//puyo_func.h，puyo_hash.h，puyo_stats.hを先にincludeしておくこと
+
+#define V_CAT_(a, b) a##b
+#define V_CAT(a, b) V_CAT_(a, b)
+#define V_FN(name) V_CAT(name, V_SUFFIX)
+#define V_BOARD(p) ((int (*)[V_ROWS][V_COLS])(p))
+
+#define V_TOP (V_ROWS-3)       //見える最上段（12段目）
+#define V_GHOST (V_ROWS-2)     //幽霊ぷよの段（13段目）
+#define V_SPAWN ((V_COLS-1)/2) //ぷよが降ってくる列（3列目）
+
+// 盤面を初期化する関数
+// puyo面の外側をBLOCK，内側をEMPTYにし，state面をIDLEにする
+static inline void V_FN(initBoardImpl)(int (*board)[V_ROWS][V_COLS]){
+    int *data = &board[0][0][0];
+    for(int i = 0; i < V_ROWS * V_COLS; i++){
+        if(i % V_COLS == 0 || i % V_COLS == V_COLS - 1 || i < V_COLS)
+            data[i] = BLOCK;
+        else
+            data[i] = EMPTY;
+
+        data[V_ROWS*V_COLS + i] = IDLE;
+    }
+}
+
+static inline int V_FN(isDeadImpl)(int (*board)[V_ROWS][V_COLS]){
+    return board[PUYO][V_TOP][V_SPAWN] != EMPTY;
+}
+
+static inline int V_FN(canPutImpl)(int (*board)[V_ROWS][V_COLS], int col, int rot){
+    //死亡時は操作を受け付つけない
+    if(board[PUYO][V_TOP][V_SPAWN] != EMPTY) return 0;
+
+    //指定範囲外の操作は受け付けない
+    if(col <= 0 || col >= V_COLS-1) return 0;
+    //回転数を0~3にする
+    rot = (rot + 40000) % 4;
+
+    //子ぷよが置かれる列を求める
+    int col_child = col;
+    if(rot == 1) col_child++;
+    else if(rot == 3) col_child--;
+
+    //置きたい列が13段目（幽霊ぷよ）まで埋まっていると置けない．壁の列も埋まっているので置けない
+    if(board[PUYO][V_GHOST][col] != EMPTY || board[PUYO][V_GHOST][col_child] != EMPTY) return 0;
+
+    //14段目に軸ぷよは設置できない
+    if(rot == 2 && board[PUYO][V_TOP][col] != EMPTY) return 0;
+
+    //置きたい列が12段目まで埋まっていて、14段目も埋まっているとき、縦置きは設置できない
+    if((rot == 0 || rot == 2) && board[PUYO][V_TOP][col] != EMPTY && board[PUYO][V_GHOST+1][col] != EMPTY) return 0;
+
+    //ぷよを移動させる向きを求める
+    //軸ぷよを降ってくる列より左に置くなら左、それ以外なら右に移動させる必要がある
+    int way = col < V_SPAWN ? -1 : 1;
+
+    //壁の高さを調べる
+    int col_wall12 = -1;//軸ぷよの経路上で12段まで埋まっている列のうち最も降ってくる列に近い列
+    for(int i = col*way; i >= V_SPAWN*way; i--){
+        if(board[PUYO][V_TOP][i*way] != EMPTY)
+            col_wall12 = i*way;
+        if(board[PUYO][V_GHOST][i*way] != EMPTY)
+            return 0; //13段の壁があるときは置けない
+    }
+
+    //軸ぷよの経路上で12段まで埋まっている列がなく、子ぷよを置きたい列も埋まっていないとき、置ける
+    if(col_wall12 < 0 && board[PUYO][V_TOP][col_child] == EMPTY)
+        return 1;
+
+    //11段まで埋まっている列を足場として使えれば回せる
+    int c;
+    if(col_wall12 < 0){
+        c = col;
+    }else{
+        c = col_wall12 - way;
+    }
+
+    while(board[PUYO][V_TOP][c] == EMPTY){
+        if(board[PUYO][V_TOP-1][c] != EMPTY)
+            return 1;
+        c -= way;
+    }
+
+    //谷間を利用できるときは回せる
+    if(board[PUYO][V_TOP][V_SPAWN-1] != EMPTY && board[PUYO][V_TOP][V_SPAWN+1] != EMPTY)
+        return 1;
+
+    return 0;
+}
+
+// undoがNULLでなければ，マスを書き換える前の値を記録する（1手の中で最初の1回だけ）
+// UndoRecordは標準の盤面の大きさなので，undoを渡すのは標準のルールだけ
+static inline void V_FN(recordCell)(int (*board)[V_ROWS][V_COLS], int plane, int i, int j, UndoRecord *undo){
+    if(!undo) return;
+    int index = (plane * V_ROWS + i) * V_COLS + j;
+    uint64_t bit = 1ull << (index & 63);
+    if(undo->seen[index >> 6] & bit) return;
+    undo->seen[index >> 6] |= bit;
+    undo->cells[undo->n_cells].index = (unsigned char)index;
+    undo->cells[undo->n_cells].value = (signed char)board[plane][i][j];
+    undo->n_cells++;
+}
+
+// マス(i, j)のぷよをpに書き換える．hashがNULLでなければZobristハッシュも更新する（標準のルールだけ）
+static inline void V_FN(setPuyo)(int (*board)[V_ROWS][V_COLS], int i, int j, int p, uint64_t *hash, UndoRecord *undo){
+    if(hash) *hash ^= zobristKey(i, j, board[PUYO][i][j]) ^ zobristKey(i, j, p);
+    V_FN(recordCell)(board, PUYO, i, j, undo);
+    board[PUYO][i][j] = p;
+}
+
+static inline void V_FN(setState)(int (*board)[V_ROWS][V_COLS], int i, int j, int state, UndoRecord *undo){
+    V_FN(recordCell)(board, STATE, i, j, undo);
+    board[STATE][i][j] = state;
+}
+
+// ぷよを落とす関数．hashがNULLでなければZobristハッシュも更新し，undoがNULLでなければ変更を記録する
+static int V_FN(fallPuyosImpl)(int (*board)[V_ROWS][V_COLS], uint64_t *hash, UndoRecord *undo){
+    STAT_TIMER_BEGIN(t);
+    STAT_INC(STAT_FALL_CALLS);
+    int fall_max = 0;
+    for(int col = 1; col < V_COLS-1; col++){
+        int bottom = -1;
+        for(int row = 1; row < V_ROWS-1; row++){//最上段のぷよは落とさない
+            switch (board[PUYO][row][col]){
+                case EMPTY:
+                    if(bottom < 0) bottom = row;
+                    break;
+                case BLOCK:
+                    bottom = -1;
+                    break;
+                default:
+                    if(bottom < 0) break;
+                    if(hash) *hash ^= zobristKey(row, col, board[PUYO][row][col]) ^ zobristKey(bottom, col, board[PUYO][row][col]);
+                    V_FN(setPuyo)(board, bottom, col, board[PUYO][row][col], NULL, undo);
+                    V_FN(setState)(board, bottom, col, NEW, undo);
+                    V_FN(setPuyo)(board, row, col, EMPTY, NULL, undo);
+                    V_FN(setState)(board, row, col, IDLE, undo);
+
+                    int fall = row - bottom;
+                    if(fall > fall_max) fall_max = fall;
+                    STAT_INC(STAT_FALL_MOVED);
+                    STAT_FALL(fall);
+
+                    bottom++;
+                    break;
+            }
+
+        }
+    }
+    STAT_TIMER_END(STAT_TIMER_FALL, t);
+    return fall_max;
+}
+
+static inline int V_FN(putPuyoImpl)(int (*board)[V_ROWS][V_COLS], int col, int rot, int parent_puyo, int child_puyo, uint64_t *hash, UndoRecord *undo){
+    //回転数を0~3にする
+    rot = ((rot % 4) + 4) % 4;
+
+    switch (rot){
+        case 0:
+            if(board[PUYO][V_TOP][col] == EMPTY){
+                V_FN(setPuyo)(board, V_TOP, col, parent_puyo, hash, undo);
+                V_FN(setPuyo)(board, V_GHOST, col, child_puyo, hash, undo);
+                if(board[PUYO][V_TOP-1][col] != EMPTY)
+                    V_FN(setState)(board, V_TOP, col, NEW, undo);
+            }else{
+                V_FN(setPuyo)(board, V_GHOST, col, parent_puyo, hash, undo);
+                V_FN(setPuyo)(board, V_GHOST+1, col, child_puyo, hash, undo);
+            }
+            break;
+        case 1:
+            V_FN(setPuyo)(board, V_GHOST, col, parent_puyo, hash, undo);
+            V_FN(setPuyo)(board, V_GHOST, col+1, child_puyo, hash, undo);
+            break;
+        case 2:
+            V_FN(setPuyo)(board, V_TOP, col, child_puyo, hash, undo);
+            V_FN(setPuyo)(board, V_GHOST, col, parent_puyo, hash, undo);
+            if(board[PUYO][V_TOP-1][col] != EMPTY)
+                V_FN(setState)(board, V_TOP, col, NEW, undo);
+            break;
+        case 3:
+            V_FN(setPuyo)(board, V_GHOST, col, parent_puyo, hash, undo);
+            V_FN(setPuyo)(board, V_GHOST, col-1, child_puyo, hash, undo);
+            break;
+        default:
+            return -1;
+    }
+    //ぷよを落とす
+    return V_FN(fallPuyosImpl)(board, hash, undo);
+}
+
+static inline int V_FN(countNeighbor)(int (*board)[V_ROWS][V_COLS], int i, int j){
+    int puyo = board[PUYO][i][j];
+    if(puyo <= 0) return 0;
+    if(i >= V_GHOST) return 0;
+
+    int count = 0;
+    if(i + 1 < V_GHOST && board[PUYO][i+1][j] == puyo) count ++;
+    if(board[PUYO][i-1][j] == puyo) count ++;
+    if(board[PUYO][i][j+1] == puyo) count ++;
+    if(board[PUYO][i][j-1] == puyo) count ++;
+
+    return count;
+}
+
+static inline int V_FN(isLinkingSeedImpl)(int (*board)[V_ROWS][V_COLS], int i, int j){
+    int puyo = board[PUYO][i][j];
+    if(puyo <= 0) return 0;
+
+    int count = V_FN(countNeighbor)(board, i, j);
+
+    if(count < 2) return 0; // 隣接する同色ぷよの数が1つ以下の場合は（消せる場合もあるが）ここでは消さない．このぷよが消せる場合は隣接する同色ぷよでisLinkingSeedがTrueになる．
+    if(count > 2) return 1; // 隣接する同色ぷよの数が3つ以上の場合は，自分含めて4つ以上つながっていることが確定する
+
+    // 「隣接する同色ぷよの数が2つ」を満たすぷよ同士が隣り合っている場合は消せることが確定する
+    if(board[PUYO][i+1][j] == puyo && V_FN(countNeighbor)(board, i+1, j) >=2) return 1;
+    if(board[PUYO][i-1][j] == puyo && V_FN(countNeighbor)(board, i-1, j) >=2) return 1;
+    if(board[PUYO][i][j+1] == puyo && V_FN(countNeighbor)(board, i, j+1) >=2) return 1;
+    if(board[PUYO][i][j-1] == puyo && V_FN(countNeighbor)(board, i, j-1) >=2) return 1;
+
+    return 0;
+}
+
+// そのぷよを消すか高速に判断する関数
+static inline int V_FN(isLinkingSeed)(int (*board)[V_ROWS][V_COLS], int i, int j){
+    int seed = V_FN(isLinkingSeedImpl)(board, i, j);
+    STAT_INC(STAT_SEED_CALLS);
+    if(!seed) STAT_INC(STAT_SEED_FAILS);
+    return seed;
+}
+
+// 消えたぷよ(i, j)に隣接するおじゃまぷよを消す関数
+// 13段目より上のおじゃまぷよは消えない
+static inline void V_FN(eraseNeighborOjama)(int (*board)[V_ROWS][V_COLS], int i, int j, UndoRecord *undo){
+    if(i+1 < V_GHOST && board[PUYO][i+1][j] == OJAMA) V_FN(setPuyo)(board, i+1, j, EMPTY, NULL, undo);
+    if(i-1 < V_GHOST && board[PUYO][i-1][j] == OJAMA) V_FN(setPuyo)(board, i-1, j, EMPTY, NULL, undo);
+    if(i < V_GHOST){
+        if(board[PUYO][i][j+1] == OJAMA) V_FN(setPuyo)(board, i, j+1, EMPTY, NULL, undo);
+        if(board[PUYO][i][j-1] == OJAMA) V_FN(setPuyo)(board, i, j-1, EMPTY, NULL, undo);
+    }
+}
+
+static int V_FN(eraseLinking)(int (*board)[V_ROWS][V_COLS], int i, int j){
+    int puyo = board[PUYO][i][j];
+    if(puyo <= 0) return 0;
+    STAT_INC(STAT_ERASE_VISITED);
+    board[PUYO][i][j] = EMPTY;
+    V_FN(eraseNeighborOjama)(board, i, j, NULL);
+
+    int count = 1;
+    if(board[PUYO][i+1][j] == puyo)
+        count += V_FN(eraseLinking)(board, i+1, j);
+    if(board[PUYO][i-1][j] == puyo)
+        count += V_FN(eraseLinking)(board, i-1, j);
+    if(board[PUYO][i][j+1] == puyo)
+        count += V_FN(eraseLinking)(board, i, j+1);
+    if(board[PUYO][i][j-1] == puyo)
+        count += V_FN(eraseLinking)(board, i, j-1);
+
+    return count;
+}
+
+// eraseLinkingと同じ処理を行い，変更をundoに記録する関数
+// 再帰の中で毎回記録の有無を調べないよう，記録しない版とは分けている
+static int V_FN(eraseLinkingUndo)(int (*board)[V_ROWS][V_COLS], int i, int j, UndoRecord *undo){
+    int puyo = board[PUYO][i][j];
+    if(puyo <= 0) return 0;
+    STAT_INC(STAT_ERASE_VISITED);
+    V_FN(setPuyo)(board, i, j, EMPTY, NULL, undo);
+    V_FN(eraseNeighborOjama)(board, i, j, undo);
+
+    int count = 1;
+    if(board[PUYO][i+1][j] == puyo)
+        count += V_FN(eraseLinkingUndo)(board, i+1, j, undo);
+    if(board[PUYO][i-1][j] == puyo)
+        count += V_FN(eraseLinkingUndo)(board, i-1, j, undo);
+    if(board[PUYO][i][j+1] == puyo)
+        count += V_FN(eraseLinkingUndo)(board, i, j+1, undo);
+    if(board[PUYO][i][j-1] == puyo)
+        count += V_FN(eraseLinkingUndo)(board, i, j-1, undo);
+
+    return count;
+}
+
+//連鎖を一つ進め、スコアを返す関数
+//chain_numは既に実行された連鎖数
+static int V_FN(oneChainImpl)(int (*board)[V_ROWS][V_COLS], int chain_num, UndoRecord *undo){
+    STAT_TIMER_BEGIN(t);
+    STAT_INC(STAT_ONECHAIN_CALLS);
+    int total_erased_count = 0;
+    int linking_bonus = 0;
+
+    int color_flg[V_COLORS];
+    for(int i = 0; i < V_COLORS; i++) color_flg[i] = 0;
+
+    for(int i = 1; i < V_GHOST; i++){
+        for(int j = 1; j < V_COLS-1; j++){
+            if(board[STATE][i][j] != NEW) continue;
+            if(!V_FN(isLinkingSeed)(board, i, j)) continue;
+
+            int puyo = board[PUYO][i][j];
+            int erased_count = undo ? V_FN(eraseLinkingUndo)(board, i, j, undo) : V_FN(eraseLinking)(board, i, j);
+            if(erased_count >= 4){
+                total_erased_count += erased_count;
+
+                //色フラグを立てる
+                if(puyo <= V_COLORS) color_flg[puyo-1] = 1;
+
+                //連結ボーナスに加算
+                if(erased_count >= 11) linking_bonus += 10;
+                else if(erased_count >= 5) linking_bonus += erased_count - 3;
+            }
+
+        }
+    }
+
+    //ひとつも消えてなければスコアは0
+    if(total_erased_count <= 0){
+        STAT_TIMER_END(STAT_TIMER_ONECHAIN, t);
+        return 0;
+    }
+
+    int color_num = 0;
+    for(int i = 0; i < V_COLORS; i++)
+        if(color_flg[i]) color_num++;
+
+    STAT_TIMER_END(STAT_TIMER_ONECHAIN, t);
+    return calcChainScore(total_erased_count, linking_bonus, color_num, chain_num);
+}
+
+//最後まで連鎖を実行する関数
+static void V_FN(allChainImpl)(int (*board)[V_ROWS][V_COLS], int *n_chains, int *score, UndoRecord *undo){
+    STAT_TIMER_BEGIN(t);
+    STAT_INC(STAT_ALLCHAIN_CALLS);
+    V_FN(fallPuyosImpl)(board, NULL, undo);
+
+    *n_chains = 0;
+    *score = 0;
+
+    while(1){
+        int s = V_FN(oneChainImpl)(board, *n_chains+1, undo);
+
+        //スコアが0以下なら連鎖終了
+        if(s <= 0){
+            STAT_CHAIN(*n_chains);
+            STAT_TIMER_END(STAT_TIMER_ALLCHAIN, t);
+            return;
+        }
+
+        V_FN(fallPuyosImpl)(board, NULL, undo);
+        (*n_chains)++;
+        *score += s;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,308 @@
+#include <stdlib.h>
+#include <string.h>
+#include "puyo_search.h"
+#include "puyo_bitboard.h"
+#include "puyo_cache.h"
+#include "puyo_env.h"
+#include "puyo_hash.h"
+#include "puyo_legal.h"
+#include "puyo_random.h"
+#include "puyo_thread.h"
+
+// boardにpairs[0]から順にdepth手置いたときの最大スコアと最大連鎖数を求める関数
+// スコアは経路上の合計，連鎖数は経路上の最大値．best_actionには最大スコアとなる最初の手を入れる
+// 置ける手がない（死亡している）ときはその時点で打ち切り，スコア0として扱う
+// hashはboardのpuyo面のZobristハッシュ．置換表が有効なら連鎖結果を再利用する
+static void searchNode(int (*board)[ROWS_NUM][COLS_NUM], uint64_t hash, const int (*pairs)[2], int depth, int *best_score, int *max_chain, int *best_action){
+    *best_score = 0;
+    *max_chain = 0;
+    *best_action = -1;
+    if(depth <= 0) return;
+
+    for(int action = 0; action < ACTIONS_NUM; action++){
+        int col, rot;
+        actionToColRot(action, &col, &rot);
+        if(!canPut(board, col, rot)) continue;
+
+        int tmp_board[ARRS_NUM][ROWS_NUM][COLS_NUM];
+        memcpy(tmp_board, board, sizeof(tmp_board));
+        uint64_t tmp_hash = hash;
+        putPuyoHash(tmp_board, col, rot, pairs[0][0], pairs[0][1], &tmp_hash);
+
+        int n_chains, score;
+        allChainCached(tmp_board, &tmp_hash, &n_chains, &score);
+
+        int sub_score, sub_chain, sub_action;
+        searchNode(tmp_board, tmp_hash, pairs + 1, depth - 1, &sub_score, &sub_chain, &sub_action);
+        score += sub_score;
+        if(sub_chain > n_chains) n_chains = sub_chain;
+
+        if(*best_action < 0 || score > *best_score){
+            *best_score = score;
+            *best_action = action;
+        }
+        if(n_chains > *max_chain) *max_chain = n_chains;
+    }
+}
+
+typedef struct {
+    int (*board)[ROWS_NUM][COLS_NUM];
+    uint64_t hash;
+    const int (*pairs)[2];
+    int depth;
+    SearchResult *results;
+} SearchJob;
+
+static void searchTask(void *ctx, int begin, int end){
+    SearchJob *job = (SearchJob *)ctx;
+    for(int action = begin; action < end; action++){
+        SearchResult *result = &job->results[action];
+        result->best_score = -1;
+        result->max_chain = -1;
+        result->best_next = -1;
+
+        int col, rot;
+        actionToColRot(action, &col, &rot);
+        if(!canPut(job->board, col, rot)) continue;
+
+        int tmp_board[ARRS_NUM][ROWS_NUM][COLS_NUM];
+        memcpy(tmp_board, job->board, sizeof(tmp_board));
+        uint64_t hash = job->hash;
+        putPuyoHash(tmp_board, col, rot, job->pairs[0][0], job->pairs[0][1], &hash);
+
+        int n_chains, score;
+        allChainCached(tmp_board, &hash, &n_chains, &score);
+
+        int sub_score, sub_chain, sub_action;
+        searchNode(tmp_board, hash, job->pairs + 1, job->depth - 1, &sub_score, &sub_chain, &sub_action);
+
+        result->best_score = score + sub_score;
+        result->max_chain = n_chains > sub_chain ? n_chains : sub_chain;
+        result->best_next = sub_action;
+    }
+}
+
+// 最初の一手 (0..ACTIONS_NUM-1) ごとに，pairsのツモをdepth手先まで置いたときの結果を求める関数
+// pairs[k] = {親ぷよ, 子ぷよ} はk手目のツモ．最初の一手ごとにスレッドへ分担する
+void searchActions(int (*board)[ROWS_NUM][COLS_NUM], const int (*pairs)[2], int depth, SearchResult *results, int n_threads){
+    if(depth > SEARCH_MAX_DEPTH) depth = SEARCH_MAX_DEPTH;
+    if(depth < 1) depth = 1;
+    SearchJob job = {board, zobristHash(board), pairs, depth, results};
+    parallelFor(ACTIONS_NUM, n_threads, 1, searchTask, &job);
+}
+
+//ビームサーチ-----------------------------------------------------------------------------------------------------
+
+typedef struct {
+    int board[ARRS_NUM][ROWS_NUM][COLS_NUM];
+    double value;
+    int score;
+    int max_chain;
+    int parent; //1つ前のビームでの番号
+    int action;
+    int status; //0: 未生成，1: 生存，2: 死亡
+} BeamNode;
+
+typedef struct {
+    const BeamNode *beam;
+    BeamNode *children; //ビームのノードbの行動aの子はchildren[b*ACTIONS_NUM + a]
+    int parent_puyo;
+    int child_puyo;
+    const BeamWeights *weights;
+} BeamExpand;
+
+// ぷよを1個置いたときに起こせる最大連鎖数を求める関数
+static int chainPotential(int (*board)[ROWS_NUM][COLS_NUM]){
+    int best = 0;
+    for(int j = 1; j < COLS_NUM-1; j++){
+        int i = 1;
+        while(i <= 12 && board[PUYO][i][j] != EMPTY) i++;
+        if(i > 12) continue;
+        for(int color = 1; color <= COLOR_NUM; color++){
+            int tmp_board[ARRS_NUM][ROWS_NUM][COLS_NUM];
+            memcpy(tmp_board[PUYO], board[PUYO], sizeof(tmp_board[PUYO]));
+            memset(tmp_board[STATE], 0, sizeof(tmp_board[STATE]));
+            tmp_board[PUYO][i][j] = color;
+            tmp_board[STATE][i][j] = NEW;
+
+            int n_chains, score;
+            allChainBB(tmp_board, &n_chains, &score);
+            if(n_chains > best) best = n_chains;
+        }
+    }
+    return best;
+}
+
+// 上下左右に隣り合う同色ぷよの組を数える関数（12段目まで）
+static int countConnections(int (*board)[ROWS_NUM][COLS_NUM]){
+    int count = 0;
+    for(int i = 1; i <= 12; i++){
+        for(int j = 1; j < COLS_NUM-1; j++){
+            int p = board[PUYO][i][j];
+            if(p <= 0) continue;
+            if(i < 12 && board[PUYO][i+1][j] == p) count++;
+            if(board[PUYO][i][j+1] == p) count++;
+        }
+    }
+    return count;
+}
+
+static int countBits(uint32_t x){
+    int n = 0;
+    for(; x; x &= x - 1) n++;
+    return n;
+}
+
+// ノードの評価値を求める関数
+static double evaluateNode(int (*board)[ROWS_NUM][COLS_NUM], int score, const BeamWeights *w){
+    double value = w->score * score;
+    if(w->chain != 0) value += w->chain * chainPotential(board);
+    if(w->connect != 0) value += w->connect * countConnections(board);
+    if(w->bumpiness != 0){
+        int heights[COLS_NUM-2];
+        columnHeights(board, heights);
+        int bump = 0;
+        for(int j = 0; j < COLS_NUM-3; j++) bump += abs(heights[j] - heights[j+1]);
+        value += w->bumpiness * bump;
+    }
+    if(w->death != 0) value += w->death * (ACTIONS_NUM - countBits(legalActionMask(board)));
+    return value;
+}
+
+// ビームのノード[begin, end)の子を全て生成する
+static void expandTask(void *ctx, int begin, int end){
+    BeamExpand *job = (BeamExpand *)ctx;
+    for(int b = begin; b < end; b++){
+        const BeamNode *node = &job->beam[b];
+        uint32_t legal = legalActionMask((int (*)[ROWS_NUM][COLS_NUM])node->board);
+        for(int action = 0; action < ACTIONS_NUM; action++){
+            BeamNode *child = &job->children[(size_t)b * ACTIONS_NUM + action];
+            child->status = 0;
+            if(!((legal >> action) & 1)) continue;
+
+            int col, rot, n_chains, score;
+            actionToColRot(action, &col, &rot);
+            memcpy(child->board, node->board, sizeof(child->board));
+            putPuyo(child->board, col, rot, job->parent_puyo, job->child_puyo);
+            allChainBB(child->board, &n_chains, &score);
+
+            child->parent = b;
+            child->action = action;
+            child->score = node->score + score;
+            child->max_chain = n_chains > node->max_chain ? n_chains : node->max_chain;
+            if(isDeadBoard(child->board)){
+                child->status = 2;
+                continue;
+            }
+            child->status = 1;
+            child->value = evaluateNode(child->board, child->score, job->weights);
+        }
+    }
+}
+
+typedef struct {
+    double value;
+    int index;
+} BeamOrder;
+
+//評価値の降順．同点なら番号の小さい方を先にして，スレッド数によらず同じ結果にする
+static int compareOrder(const void *a, const void *b){
+    const BeamOrder *x = (const BeamOrder *)a, *y = (const BeamOrder *)b;
+    if(x->value != y->value) return x->value > y->value ? -1 : 1;
+    return (x->index > y->index) - (x->index < y->index);
+}
+
+// ビームサーチで最初の手を選ぶ関数
+// pairs[k]はk手目のツモ．depthがn_pairsより深い分のツモはseedから一様ランダムに決める
+// 各深さで，ビームの全ノードの置ける手を全て試し，死亡していない子から評価値の高い順にwidth個を残す
+// ノードの展開はparallelForで1ノードずつ取り出して分担する．メモリが足りなければ-1を返す
+int beamSearch(int (*board)[ROWS_NUM][COLS_NUM], const int (*pairs)[2], int n_pairs, int depth, int width,
+               const BeamWeights *weights, uint64_t seed, BeamResult *result, int n_threads){
+    if(depth > BEAM_MAX_DEPTH) depth = BEAM_MAX_DEPTH;
+    if(depth < 1) depth = 1;
+    if(width > BEAM_MAX_WIDTH) width = BEAM_MAX_WIDTH;
+    if(width < 1) width = 1;
+
+    int all_pairs[BEAM_MAX_DEPTH][2];
+    PuyoRandom rng;
+    randomInit(&rng, seed, 0);
+    for(int d = 0; d < depth; d++){
+        if(d < n_pairs){
+            all_pairs[d][0] = pairs[d][0];
+            all_pairs[d][1] = pairs[d][1];
+        }else{
+            all_pairs[d][0] = randomBelow(&rng, COLOR_NUM) + 1;
+            all_pairs[d][1] = randomBelow(&rng, COLOR_NUM) + 1;
+        }
+    }
+
+    BeamNode *beam = (BeamNode *)malloc(sizeof(BeamNode) * width);
+    BeamNode *children = (BeamNode *)malloc(sizeof(BeamNode) * width * ACTIONS_NUM);
+    BeamOrder *order = (BeamOrder *)malloc(sizeof(BeamOrder) * width * ACTIONS_NUM);
+    int (*hist)[2] = (int (*)[2])malloc(sizeof(int) * 2 * depth * width); //深さdのk番目のノードの(親の番号, 手)
+    if(beam == NULL || children == NULL || order == NULL || hist == NULL){
+        free(beam);
+        free(children);
+        free(order);
+        free(hist);
+        return -1;
+    }
+
+    memcpy(beam[0].board, board, sizeof(beam[0].board));
+    beam[0].value = 0;
+    beam[0].score = 0;
+    beam[0].max_chain = 0;
+    int beam_size = 1;
+    int reached = 0;
+    result->nodes = 0;
+
+    for(int d = 0; d < depth; d++){
+        BeamExpand job = {beam, children, all_pairs[d][0], all_pairs[d][1], weights};
+        parallelFor(beam_size, n_threads, 1, expandTask, &job);
+
+        int alive = 0;
+        for(int k = 0; k < beam_size * ACTIONS_NUM; k++){
+            if(children[k].status != 0) result->nodes++;
+            if(children[k].status == 1){
+                order[alive].value = children[k].value;
+                order[alive].index = k;
+                alive++;
+            }
+        }
+        if(alive == 0) break;
+
+        qsort(order, alive, sizeof(BeamOrder), compareOrder);
+        beam_size = alive < width ? alive : width;
+        for(int k = 0; k < beam_size; k++){
+            beam[k] = children[order[k].index];
+            hist[d * width + k][0] = beam[k].parent;
+            hist[d * width + k][1] = beam[k].action;
+        }
+        reached = d + 1;
+    }
+
+    //最善ノード（ビームの先頭）から手順をたどる
+    result->pv_len = reached;
+    if(reached == 0){
+        result->action = -1;
+        result->value = 0;
+        result->score = 0;
+        result->max_chain = 0;
+    }else{
+        int k = 0;
+        for(int d = reached - 1; d >= 0; d--){
+            result->pv[d] = hist[d * width + k][1];
+            k = hist[d * width + k][0];
+        }
+        result->action = result->pv[0];
+        result->value = beam[0].value;
+        result->score = beam[0].score;
+        result->max_chain = beam[0].max_chain;
+    }
+
+    free(beam);
+    free(children);
+    free(order);
+    free(hist);
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#ifndef _PUYO_SEARCH_H_
+#define _PUYO_SEARCH_H_
+
+#include "puyo_func.h"
+
+//探索できる最大の深さ（ツモの数）
+//全ての手順（22^depth通り）を調べるので，1手深くするごとに約22倍の時間がかかる．深さ4で約0.2秒
+#define SEARCH_MAX_DEPTH 4
+
+//最初の一手ごとの探索結果．置けない手はすべて-1
+typedef struct {
+    int best_score;
+    int max_chain;
+    int best_next;
+} SearchResult;
+
+void searchActions(int (*board)[ROWS_NUM][COLS_NUM], const int (*pairs)[2], int depth, SearchResult *results, int n_threads);
+
+//ビームサーチの深さと幅の上限
+#define BEAM_MAX_DEPTH 32
+#define BEAM_MAX_WIDTH 1024
+
+//ビームサーチの評価の重み．評価値は各特徴量に重みを掛けた和
+typedef struct {
+    double score;     //経路上で得たスコアの合計
+    double chain;     //ぷよを1個置いたときに起こせる最大連鎖数（0なら計算しない）
+    double connect;   //上下左右に隣り合う同色ぷよの組の数
+    double bumpiness; //隣り合う列の高さの差の合計
+    double death;     //置けない手の数（窒息の危険）
+} BeamWeights;
+
+//ビームサーチの結果
+typedef struct {
+    int action;            //選んだ最初の手．置ける手がなければ-1
+    int pv[BEAM_MAX_DEPTH];//最善ノードまでの手順
+    int pv_len;
+    long long nodes;       //生成した子ノードの数
+    double value;          //最善ノードの評価値
+    int score;             //最善ノードまでのスコアの合計
+    int max_chain;         //最善ノードまでの最大連鎖数
+} BeamResult;
+
+int beamSearch(int (*board)[ROWS_NUM][COLS_NUM], const int (*pairs)[2], int n_pairs, int depth, int width,
+               const BeamWeights *weights, uint64_t seed, BeamResult *result, int n_threads);
+
+#endif //_PUYO_SEARCH_H_
\ No newline at end of file
@@ -0,0 +1,270 @@
+#include <errno.h>
+#include <string.h>
+#include "puyo_shm.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define RING_ALIGN 64
+
+#ifndef _WIN32
+
+static uint64_t alignUp(uint64_t x){
+    return (x + RING_ALIGN - 1) & ~(uint64_t)(RING_ALIGN - 1);
+}
+
+// capacityからヘッダの配置を決める
+static void layoutHeader(RingHeader *h, uint32_t capacity){
+    uint64_t offset = alignUp(sizeof(RingHeader));
+    h->magic = RING_MAGIC;
+    h->version = RING_VERSION;
+    h->capacity = capacity;
+    h->board_bytes = sizeof(int) * ARRS_NUM * ROWS_NUM * COLS_NUM;
+    h->boards_offset = offset;  offset = alignUp(offset + (uint64_t)capacity * h->board_bytes);
+    h->actions_offset = offset; offset = alignUp(offset + (uint64_t)capacity * sizeof(int));
+    h->rewards_offset = offset; offset = alignUp(offset + (uint64_t)capacity * sizeof(float));
+    h->chains_offset = offset;  offset = alignUp(offset + (uint64_t)capacity * sizeof(int));
+    h->scores_offset = offset;  offset = alignUp(offset + (uint64_t)capacity * sizeof(int));
+    h->dones_offset = offset;   offset = alignUp(offset + (uint64_t)capacity * sizeof(int));
+    h->seqs_offset = offset;    offset = alignUp(offset + (uint64_t)capacity * sizeof(uint64_t));
+    h->total_size = offset;
+}
+
+static void setPointers(ShmRing *ring){
+    char *base = (char *)ring->header;
+    RingHeader *h = ring->header;
+    ring->boards = (int (*)[ARRS_NUM][ROWS_NUM][COLS_NUM])(base + h->boards_offset);
+    ring->actions = (int *)(base + h->actions_offset);
+    ring->rewards = (float *)(base + h->rewards_offset);
+    ring->chains = (int *)(base + h->chains_offset);
+    ring->scores = (int *)(base + h->scores_offset);
+    ring->dones = (int *)(base + h->dones_offset);
+    ring->seqs = (uint64_t *)(base + h->seqs_offset);
+}
+
+// 名前nameの共有メモリにcapacity個（2のべきに切り上げ）のリングバッファを作る関数
+// 成功したら0，失敗したら-1を返しerrnoを設定する．同じ名前が既にあれば失敗する
+int ringCreate(ShmRing *ring, const char *name, int capacity){
+    memset(ring, 0, sizeof(ShmRing));
+    if(capacity <= 0 || capacity > (1 << 30) || strlen(name) >= RING_NAME_MAX){
+        errno = EINVAL;
+        return -1;
+    }
+    uint32_t cap = 2;
+    while(cap < (uint32_t)capacity) cap <<= 1;
+    RingHeader layout;
+    memset(&layout, 0, sizeof(layout));
+    layoutHeader(&layout, cap);
+
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if(fd < 0) return -1;
+    if(ftruncate(fd, (off_t)layout.total_size) != 0){
+        int err = errno;
+        close(fd);
+        shm_unlink(name);
+        errno = err;
+        return -1;
+    }
+    void *p = mmap(NULL, layout.total_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int err = errno;
+    close(fd);
+    if(p == MAP_FAILED){
+        shm_unlink(name);
+        errno = err;
+        return -1;
+    }
+
+    ring->header = (RingHeader *)p;
+    ring->size = layout.total_size;
+    ring->owner = 1;
+    strcpy(ring->name, name);
+    //ftruncate直後は0で埋まっている．magicは最後に書いて公開する
+    uint32_t magic = layout.magic;
+    layout.magic = 0;
+    *ring->header = layout;
+    setPointers(ring);
+    for(uint32_t i = 0; i < cap; i++)
+        ring->seqs[i] = i;
+    __atomic_store_n(&ring->header->magic, magic, __ATOMIC_RELEASE);
+    return 0;
+}
+
+// 既存のリングバッファにつなぐ関数．成功したら0，失敗したら-1を返しerrnoを設定する
+int ringAttach(ShmRing *ring, const char *name){
+    memset(ring, 0, sizeof(ShmRing));
+    if(strlen(name) >= RING_NAME_MAX){
+        errno = EINVAL;
+        return -1;
+    }
+    int fd = shm_open(name, O_RDWR, 0600);
+    if(fd < 0) return -1;
+    struct stat st;
+    if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(RingHeader)){
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+    void *p = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int err = errno;
+    close(fd);
+    if(p == MAP_FAILED){
+        errno = err;
+        return -1;
+    }
+
+    //作成側と同じ配置か確認する
+    RingHeader *h = (RingHeader *)p;
+    RingHeader expected;
+    memset(&expected, 0, sizeof(expected));
+    uint32_t cap = h->capacity;
+    layoutHeader(&expected, cap);
+    if(__atomic_load_n(&h->magic, __ATOMIC_ACQUIRE) != RING_MAGIC || h->version != RING_VERSION || cap < 2 || (cap & (cap - 1)) != 0 ||
+       memcmp(&h->board_bytes, &expected.board_bytes, offsetof(RingHeader, pad0) - offsetof(RingHeader, board_bytes)) != 0 ||
+       h->total_size > (uint64_t)st.st_size){
+        munmap(p, (size_t)st.st_size);
+        errno = EINVAL;
+        return -1;
+    }
+
+    ring->header = h;
+    ring->size = (size_t)st.st_size;
+    ring->owner = 0;
+    strcpy(ring->name, name);
+    setPointers(ring);
+    return 0;
+}
+
+void ringClose(ShmRing *ring){
+    if(ring->header != NULL)
+        munmap(ring->header, ring->size);
+    memset(ring, 0, sizeof(ShmRing));
+}
+
+int ringUnlink(const char *name){
+    return shm_unlink(name);
+}
+
+// 1件書き込む関数．満杯なら0を返す
+// スロットを通し番号の比較交換で確保し，書き終えてから通し番号を進めて公開する
+int ringPush(ShmRing *ring, int (*board)[ROWS_NUM][COLS_NUM], int action, float reward, int n_chains, int score, int done){
+    RingHeader *h = ring->header;
+    uint64_t mask = h->capacity - 1;
+    uint64_t pos = __atomic_load_n(&h->head, __ATOMIC_RELAXED);
+    uint64_t slot;
+    while(1){
+        slot = pos & mask;
+        uint64_t seq = __atomic_load_n(&ring->seqs[slot], __ATOMIC_ACQUIRE);
+        int64_t diff = (int64_t)(seq - pos);
+        if(diff == 0){
+            if(__atomic_compare_exchange_n(&h->head, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                break;
+        }else if(diff < 0){
+            return 0;
+        }else{
+            pos = __atomic_load_n(&h->head, __ATOMIC_RELAXED);
+        }
+    }
+
+    memcpy(ring->boards[slot], board, sizeof(ring->boards[slot]));
+    ring->actions[slot] = action;
+    ring->rewards[slot] = reward;
+    ring->chains[slot] = n_chains;
+    ring->scores[slot] = score;
+    ring->dones[slot] = done;
+    __atomic_store_n(&ring->seqs[slot], pos + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+// 公開済みで連続したスロットを最大max_n件探す関数（読み出し側専用）
+// 先頭のスロット番号をfirstに書き込み件数を返す．配列の末尾で折り返す前に止まる
+int ringAcquire(ShmRing *ring, int max_n, int *first){
+    RingHeader *h = ring->header;
+    uint64_t mask = h->capacity - 1;
+    uint64_t pos = __atomic_load_n(&h->tail, __ATOMIC_RELAXED);
+    int n = 0;
+    *first = (int)(pos & mask);
+    while(n < max_n){
+        uint64_t slot = (pos + n) & mask;
+        if(n > 0 && slot == 0) break;
+        if(__atomic_load_n(&ring->seqs[slot], __ATOMIC_ACQUIRE) != pos + n + 1) break;
+        n++;
+    }
+    return n;
+}
+
+// ringAcquireで得たスロットのうち先頭n件を書き込み側に返す関数
+void ringRelease(ShmRing *ring, int n){
+    RingHeader *h = ring->header;
+    uint64_t mask = h->capacity - 1;
+    uint64_t pos = __atomic_load_n(&h->tail, __ATOMIC_RELAXED);
+    for(int k = 0; k < n; k++)
+        __atomic_store_n(&ring->seqs[(pos + k) & mask], pos + k + h->capacity, __ATOMIC_RELEASE);
+    __atomic_store_n(&h->tail, pos + n, __ATOMIC_RELEASE);
+}
+
+// 公開済みで読める件数を最大max_n件まで数える関数（読み出し側専用）．末尾での折り返しも含める
+int ringReadable(const ShmRing *ring, int max_n){
+    RingHeader *h = ring->header;
+    uint64_t mask = h->capacity - 1;
+    uint64_t pos = __atomic_load_n(&h->tail, __ATOMIC_RELAXED);
+    int n = 0;
+    while(n < max_n && n < (int)h->capacity && __atomic_load_n(&ring->seqs[(pos + n) & mask], __ATOMIC_ACQUIRE) == pos + n + 1)
+        n++;
+    return n;
+}
+
+// 確保済みで未読の件数（書き込み中のものを含む）
+int ringCount(const ShmRing *ring){
+    uint64_t head = __atomic_load_n(&ring->header->head, __ATOMIC_ACQUIRE);
+    uint64_t tail = __atomic_load_n(&ring->header->tail, __ATOMIC_ACQUIRE);
+    return (int)(head - tail);
+}
+
+#else
+
+int ringCreate(ShmRing *ring, const char *name, int capacity){
+    memset(ring, 0, sizeof(ShmRing));
+    errno = ENOSYS;
+    return -1;
+}
+
+int ringAttach(ShmRing *ring, const char *name){
+    memset(ring, 0, sizeof(ShmRing));
+    errno = ENOSYS;
+    return -1;
+}
+
+void ringClose(ShmRing *ring){
+    memset(ring, 0, sizeof(ShmRing));
+}
+
+int ringUnlink(const char *name){
+    errno = ENOSYS;
+    return -1;
+}
+
+int ringPush(ShmRing *ring, int (*board)[ROWS_NUM][COLS_NUM], int action, float reward, int n_chains, int score, int done){
+    return 0;
+}
+
+int ringAcquire(ShmRing *ring, int max_n, int *first){
+    *first = 0;
+    return 0;
+}
+
+void ringRelease(ShmRing *ring, int n){
+}
+
+int ringReadable(const ShmRing *ring, int max_n){
+    return 0;
+}
+
+int ringCount(const ShmRing *ring){
+    return 0;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,59 @@
+#ifndef _PUYO_SHM_H_
+#define _PUYO_SHM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "puyo_func.h"
+
+//共有メモリ上のリングバッファ
+//盤面(ARRS_NUM, ROWS_NUM, COLS_NUM)のint32と行動・報酬・連鎖数・スコア・終了フラグを列ごとの配列で持つ．
+//スロットごとの通し番号で公開を管理し，複数の書き込み側と1つの読み出し側がロックなしで使える（MPSC）
+#define RING_MAGIC 0x52595550u //"PUYR"
+#define RING_VERSION 1
+#define RING_NAME_MAX 256
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity; //2のべき
+    uint32_t board_bytes;
+    uint64_t total_size;
+    uint64_t boards_offset;
+    uint64_t actions_offset;
+    uint64_t rewards_offset;
+    uint64_t chains_offset;
+    uint64_t scores_offset;
+    uint64_t dones_offset;
+    uint64_t seqs_offset;
+    char pad0[128 - 4*4 - 9*8];
+    uint64_t head; //書き込み側が次に確保する通し番号
+    char pad1[64 - 8];
+    uint64_t tail; //読み出し側が次に読む通し番号
+    char pad2[64 - 8];
+} RingHeader;
+
+typedef struct {
+    RingHeader *header;
+    size_t size;
+    int owner; //作成した側なら1．読み出し（acquire・release）は作成した側だけが行う
+    char name[RING_NAME_MAX];
+    int (*boards)[ARRS_NUM][ROWS_NUM][COLS_NUM];
+    int *actions;
+    float *rewards;
+    int *chains;
+    int *scores;
+    int *dones;
+    uint64_t *seqs;
+} ShmRing;
+
+int ringCreate(ShmRing *ring, const char *name, int capacity);
+int ringAttach(ShmRing *ring, const char *name);
+void ringClose(ShmRing *ring);
+int ringUnlink(const char *name);
+int ringPush(ShmRing *ring, int (*board)[ROWS_NUM][COLS_NUM], int action, float reward, int n_chains, int score, int done);
+int ringAcquire(ShmRing *ring, int max_n, int *first);
+void ringRelease(ShmRing *ring, int n);
+int ringReadable(const ShmRing *ring, int max_n);
+int ringCount(const ShmRing *ring);
+
+#endif //_PUYO_SHM_H_
\ No newline at end of file
@@ -0,0 +1,438 @@
+#include <stdlib.h>
+#include <string.h>
+#include "puyo_simd.h"
+
+//x86ではSSE2/AVX2/AVX-512のカーネルも作る
+//関数ごとにtarget属性を付けるので，拡張モジュール全体を特別なオプションでビルドする必要はない
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIMD_X86 1
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#include <cpuid.h>
+#define SIMD_TARGET(isa) __attribute__((target(isa)))
+#else
+#include <intrin.h>
+#define SIMD_TARGET(isa)
+#endif
+#endif
+
+//ビットボードの面の数（色，おじゃま，STATE面）
+#define SCAN_PLANES (COLOR_NUM+2)
+
+//スカラー-------------------------------------------------------------------------------------------------
+
+static void encodeNHWCFloat32Scalar(int (*board)[ROWS_NUM][COLS_NUM], float *x){
+    memset(x, 0, sizeof(float)*(ROWS_NUM-1)*(COLS_NUM-2)*(COLOR_NUM));
+    for(int i = 1; i < ROWS_NUM; i++){
+        for(int j = 1; j < COLS_NUM-1; j++){
+            int p = board[PUYO][i][j];
+            if(1 <= p && p <= COLOR_NUM)
+                x[((i-1)*(COLS_NUM-2) + (j-1))*COLOR_NUM + (p-1)] = 1.0f;
+        }
+    }
+}
+
+static void encodeNCHWFloat32Scalar(int (*board)[ROWS_NUM][COLS_NUM], float *x){
+    memset(x, 0, sizeof(float)*(ROWS_NUM-1)*(COLS_NUM-2)*(COLOR_NUM));
+    for(int i = 1; i < ROWS_NUM; i++){
+        for(int j = 1; j < COLS_NUM-1; j++){
+            int p = board[PUYO][i][j];
+            if(1 <= p && p <= COLOR_NUM)
+                x[((p-1)*(ROWS_NUM-1) + (i-1))*(COLS_NUM-2) + (j-1)] = 1.0f;
+        }
+    }
+}
+
+static inline void setCell(BitMask *a, int row, int col){
+    int lane = col - 1;
+    a->w[lane >> 2] |= (uint64_t)1 << ((lane & 3) * BB_LANE_BITS + row);
+}
+
+static int toBitBoardScalar(int (*board)[ROWS_NUM][COLS_NUM], BitBoard *bb){
+    memset(bb, 0, sizeof(BitBoard));
+
+    //壁がぷよと同じ値だと連結判定に影響するので，壁は0以下でなければならない
+    for(int j = 0; j < COLS_NUM; j++)
+        if(board[PUYO][0][j] > 0) return 0;
+    for(int i = 1; i < ROWS_NUM; i++)
+        if(board[PUYO][i][0] > 0 || board[PUYO][i][COLS_NUM-1] > 0) return 0;
+
+    for(int j = 1; j < COLS_NUM-1; j++){
+        for(int i = 1; i < ROWS_NUM; i++){
+            int p = board[PUYO][i][j];
+            if(1 <= p && p <= COLOR_NUM) setCell(&bb->color[p-1], i, j);
+            else if(p == OJAMA) setCell(&bb->ojama, i, j);
+            else if(p != EMPTY) return 0;
+
+            if(board[STATE][i][j] == NEW) setCell(&bb->state, i, j);
+        }
+    }
+    return 1;
+}
+
+#ifdef SIMD_X86
+
+//SSE2------------------------------------------------------------------------------------------------------
+
+//盤面の走査では1段8マスをint16に詰めて1本のレジスタに載せ，各面のi段目の結果を(1 << i)として列ごとに積み上げる
+//積み上げた16bitの要素はそのままビットボードのレーンになる
+
+SIMD_TARGET("sse2") static inline __m128i loadRow16SSE2(const int *row){
+    return _mm_packs_epi32(_mm_loadu_si128((const __m128i *)row), _mm_loadu_si128((const __m128i *)(row + 4)));
+}
+
+// 列ごとの16bit（j番目の要素がj列目）をビットマスクにする
+SIMD_TARGET("sse2") static inline BitMask lanesToMask(__m128i lanes){
+    BitMask r;
+    _mm_storel_epi64((__m128i *)&r.w[0], _mm_srli_si128(lanes, 2));         //1~4列目
+    r.w[1] = (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(lanes, 10));        //5~6列目
+    return r;
+}
+
+SIMD_TARGET("sse2") static inline void lanesToBitBoard(const __m128i *acc, BitBoard *bb){
+    memset(bb, 0, sizeof(BitBoard));
+    for(int c = 0; c < COLOR_NUM; c++)
+        bb->color[c] = lanesToMask(acc[c]);
+    bb->ojama = lanesToMask(acc[COLOR_NUM]);
+    bb->state = lanesToMask(acc[COLOR_NUM+1]);
+}
+
+SIMD_TARGET("sse2") static void encodeNHWCFloat32SSE2(int (*board)[ROWS_NUM][COLS_NUM], float *x){
+    const __m128i colors = _mm_setr_epi32(1, 2, 3, 4);
+    const __m128i one = _mm_castps_si128(_mm_set1_ps(1.0f));
+    for(int i = 1; i < ROWS_NUM; i++){
+        for(int j = 1; j < COLS_NUM-1; j++){
+            __m128i p = _mm_set1_epi32(board[PUYO][i][j]);
+            _mm_storeu_si128((__m128i *)x, _mm_and_si128(_mm_cmpeq_epi32(p, colors), one));
+            x += COLOR_NUM;
+        }
+    }
+}
+
+SIMD_TARGET("sse2") static void encodeNCHWFloat32SSE2(int (*board)[ROWS_NUM][COLS_NUM], float *x){
+    const __m128i one = _mm_castps_si128(_mm_set1_ps(1.0f));
+    for(int c = 1; c <= COLOR_NUM; c++){
+        __m128i v = _mm_set1_epi32(c);
+        for(int i = 1; i < ROWS_NUM; i++){
+            __m128i lo = _mm_loadu_si128((const __m128i *)&board[PUYO][i][1]);  //1~4列目
+            __m128i hi = _mm_loadl_epi64((const __m128i *)&board[PUYO][i][5]);  //5~6列目
+            _mm_storeu_si128((__m128i *)x, _mm_and_si128(_mm_cmpeq_epi32(lo, v), one));
+            _mm_storel_epi64((__m128i *)(x + 4), _mm_and_si128(_mm_cmpeq_epi32(hi, v), one));
+            x += COLS_NUM-2;
+        }
+    }
+}
+
+SIMD_TARGET("sse2") static int toBitBoardSSE2(int (*board)[ROWS_NUM][COLS_NUM], BitBoard *bb){
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ojama = _mm_set1_epi16(OJAMA);
+    const __m128i state_new = _mm_set1_epi16(NEW);
+    if(_mm_movemask_epi8(_mm_cmpgt_epi16(loadRow16SSE2(board[PUYO][0]), zero))) return 0;
+
+    __m128i acc[SCAN_PLANES];
+    for(int k = 0; k < SCAN_PLANES; k++) acc[k] = zero;
+    __m128i valid_all = _mm_set1_epi16(-1), positive = zero, bit = _mm_set1_epi16(1);
+    for(int i = 1; i < ROWS_NUM; i++){
+        bit = _mm_slli_epi16(bit, 1);
+        __m128i row = loadRow16SSE2(board[PUYO][i]);
+        __m128i valid = _mm_cmpeq_epi16(row, zero);
+        for(int c = 0; c < COLOR_NUM; c++){
+            __m128i eq = _mm_cmpeq_epi16(row, _mm_set1_epi16((short)(c + 1)));
+            valid = _mm_or_si128(valid, eq);
+            acc[c] = _mm_or_si128(acc[c], _mm_and_si128(eq, bit));
+        }
+        __m128i eq = _mm_cmpeq_epi16(row, ojama);
+        valid = _mm_or_si128(valid, eq);
+        acc[COLOR_NUM] = _mm_or_si128(acc[COLOR_NUM], _mm_and_si128(eq, bit));
+        eq = _mm_cmpeq_epi16(loadRow16SSE2(board[STATE][i]), state_new);
+        acc[COLOR_NUM+1] = _mm_or_si128(acc[COLOR_NUM+1], _mm_and_si128(eq, bit));
+        valid_all = _mm_and_si128(valid_all, valid);
+        positive = _mm_or_si128(positive, _mm_cmpgt_epi16(row, zero));
+    }
+    //0列目と7列目は壁（2バイトずつ），1~6列目は盤面内
+    if((_mm_movemask_epi8(positive) & 0xC003) || (~_mm_movemask_epi8(valid_all) & 0x3FFC)) return 0;
+
+    lanesToBitBoard(acc, bb);
+    return 1;
+}
+
+//AVX2------------------------------------------------------------------------------------------------------
+
+SIMD_TARGET("avx2") static void encodeNHWCFloat32AVX2(int (*board)[ROWS_NUM][COLS_NUM], float *x){
+    const __m256i colors = _mm256_setr_epi32(1, 2, 3, 4, 1, 2, 3, 4);
+    const __m256i one = _mm256_castps_si256(_mm256_set1_ps(1.0f));
+    //2列ずつ各マスの値を4要素に広げる
+    const __m256i spread[3] = {
+        _mm256_setr_epi32(1, 1, 1, 1, 2, 2, 2, 2),
+        _mm256_setr_epi32(3, 3, 3, 3, 4, 4, 4, 4),
+        _mm256_setr_epi32(5, 5, 5, 5, 6, 6, 6, 6),
+    };
+    for(int i = 1; i < ROWS_NUM; i++){
+        __m256i row = _mm256_loadu_si256((const __m256i *)board[PUYO][i]);
+        for(int k = 0; k < 3; k++){
+            __m256i p = _mm256_permutevar8x32_epi32(row, spread[k]);
+            _mm256_storeu_si256((__m256i *)x, _mm256_and_si256(_mm256_cmpeq_epi32(p, colors), one));
+            x += 2*COLOR_NUM;
+        }
+    }
+}
+
+SIMD_TARGET("avx2") static void encodeNCHWFloat32AVX2(int (*board)[ROWS_NUM][COLS_NUM], float *x){
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256i shift = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 0, 0); //1~6列目を先頭に寄せる
+    __m256i rows[ROWS_NUM-1];
+    for(int i = 1; i < ROWS_NUM; i++)
+        rows[i-1] = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i *)board[PUYO][i]), shift);
+    //8要素ずつ書き，はみ出した2要素は次の段で上書きする．各色の最後の段だけは6要素を書く
+    for(int c = 1; c <= COLOR_NUM; c++){
+        __m256i v = _mm256_set1_epi32(c);
+        for(int i = 0; i < ROWS_NUM-2; i++){
+            _mm256_storeu_ps(x, _mm256_and_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(rows[i], v)), one));
+            x += COLS_NUM-2;
+        }
+        __m256 last = _mm256_and_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(rows[ROWS_NUM-2], v)), one);
+        _mm_storeu_ps(x, _mm256_castps256_ps128(last));
+        _mm_storel_pi((__m64 *)(x + 4), _mm256_extractf128_ps(last, 1));
+        x += COLS_NUM-2;
+    }
+}
+
+//2段16マスをint16に詰める（下位128bitがi段目，上位128bitがi+1段目）
+SIMD_TARGET("avx2") static inline __m256i loadRows16AVX2(const int *rows){
+    __m256i packed = _mm256_packs_epi32(_mm256_loadu_si256((const __m256i *)rows), _mm256_loadu_si256((const __m256i *)(rows + 8)));
+    return _mm256_permute4x64_epi64(packed, 0xD8);
+}
+
+SIMD_TARGET("avx2") static int toBitBoardAVX2(int (*board)[ROWS_NUM][COLS_NUM], BitBoard *bb){
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ojama = _mm256_set1_epi16(OJAMA);
+    const __m256i state_new = _mm256_set1_epi16(NEW);
+    if(_mm256_movemask_epi8(_mm256_cmpgt_epi32(_mm256_loadu_si256((const __m256i *)board[PUYO][0]), zero))) return 0;
+
+    __m256i acc[SCAN_PLANES];
+    for(int k = 0; k < SCAN_PLANES; k++) acc[k] = zero;
+    __m256i valid_all = _mm256_set1_epi16(-1), positive = zero;
+    __m256i bit = _mm256_setr_epi16(2, 2, 2, 2, 2, 2, 2, 2, 4, 4, 4, 4, 4, 4, 4, 4);
+    for(int i = 1; i < ROWS_NUM; i += 2){
+        __m256i rows = loadRows16AVX2(board[PUYO][i]);
+        __m256i valid = _mm256_cmpeq_epi16(rows, zero);
+        for(int c = 0; c < COLOR_NUM; c++){
+            __m256i eq = _mm256_cmpeq_epi16(rows, _mm256_set1_epi16((short)(c + 1)));
+            valid = _mm256_or_si256(valid, eq);
+            acc[c] = _mm256_or_si256(acc[c], _mm256_and_si256(eq, bit));
+        }
+        __m256i eq = _mm256_cmpeq_epi16(rows, ojama);
+        valid = _mm256_or_si256(valid, eq);
+        acc[COLOR_NUM] = _mm256_or_si256(acc[COLOR_NUM], _mm256_and_si256(eq, bit));
+        eq = _mm256_cmpeq_epi16(loadRows16AVX2(board[STATE][i]), state_new);
+        acc[COLOR_NUM+1] = _mm256_or_si256(acc[COLOR_NUM+1], _mm256_and_si256(eq, bit));
+        valid_all = _mm256_and_si256(valid_all, valid);
+        positive = _mm256_or_si256(positive, _mm256_cmpgt_epi16(rows, zero));
+        bit = _mm256_slli_epi16(bit, 2);
+    }
+    if((_mm256_movemask_epi8(positive) & 0xC003C003u) || (~_mm256_movemask_epi8(valid_all) & 0x3FFC3FFCu)) return 0;
+
+    //2段分の結果を重ねる
+    __m128i lanes[SCAN_PLANES];
+    for(int k = 0; k < SCAN_PLANES; k++)
+        lanes[k] = _mm_or_si128(_mm256_castsi256_si128(acc[k]), _mm256_extracti128_si256(acc[k], 1));
+    lanesToBitBoard(lanes, bb);
+    return 1;
+}
+
+//AVX-512（AVX512Fの命令だけを使う）-------------------------------------------------------------------------
+
+SIMD_TARGET("avx512f") static void encodeNHWCFloat32AVX512(int (*board)[ROWS_NUM][COLS_NUM], float *x){
+    const __m512i colors = _mm512_setr_epi32(1, 2, 3, 4, 1, 2, 3, 4, 1, 2, 3, 4, 1, 2, 3, 4);
+    const __m512 one = _mm512_set1_ps(1.0f);
+    const __m512i spread_lo = _mm512_setr_epi32(1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4);
+    const __m512i spread_hi = _mm512_setr_epi32(5, 5, 5, 5, 6, 6, 6, 6, 0, 0, 0, 0, 0, 0, 0, 0);
+    for(int i = 1; i < ROWS_NUM; i++){
+        __m512i row = _mm512_maskz_loadu_epi32(0x00FF, board[PUYO][i]);
+        __mmask16 lo = _mm512_cmpeq_epi32_mask(_mm512_permutexvar_epi32(spread_lo, row), colors);
+        __mmask16 hi = _mm512_cmpeq_epi32_mask(_mm512_permutexvar_epi32(spread_hi, row), colors);
+        _mm512_storeu_ps(x, _mm512_maskz_mov_ps(lo, one));
+        _mm512_mask_storeu_ps(x + 16, 0x00FF, _mm512_maskz_mov_ps(hi, one));
+        x += (COLS_NUM-2)*COLOR_NUM;
+    }
+}
+
+SIMD_TARGET("avx512f") static void encodeNCHWFloat32AVX512(int (*board)[ROWS_NUM][COLS_NUM], float *x){
+    const __m512 one = _mm512_set1_ps(1.0f);
+    //2段分の1~6列目を先頭に寄せる
+    const __m512i shift = _mm512_setr_epi32(1, 2, 3, 4, 5, 6, 9, 10, 11, 12, 13, 14, 0, 0, 0, 0);
+    for(int i = 1; i < ROWS_NUM; i += 2){
+        __m512i rows = _mm512_permutexvar_epi32(shift, _mm512_loadu_si512((const void *)board[PUYO][i]));
+        for(int c = 1; c <= COLOR_NUM; c++){
+            __mmask16 eq = _mm512_cmpeq_epi32_mask(rows, _mm512_set1_epi32(c));
+            _mm512_mask_storeu_ps(x + ((c-1)*(ROWS_NUM-1) + (i-1))*(COLS_NUM-2), 0x0FFF, _mm512_maskz_mov_ps(eq, one));
+        }
+    }
+}
+
+SIMD_TARGET("avx512f") static int toBitBoardAVX512(int (*board)[ROWS_NUM][COLS_NUM], BitBoard *bb){
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i ojama = _mm512_set1_epi32(OJAMA);
+    const __m512i state_new = _mm512_set1_epi32(NEW);
+    if(_mm512_cmpgt_epi32_mask(_mm512_maskz_loadu_epi32(0x00FF, board[PUYO][0]), zero)) return 0;
+
+    //2段ずつ比較する（下位8要素がi段目，上位8要素がi+1段目）
+    __m512i acc[SCAN_PLANES];
+    for(int k = 0; k < SCAN_PLANES; k++) acc[k] = zero;
+    __m512i bit = _mm512_setr_epi32(2, 2, 2, 2, 2, 2, 2, 2, 4, 4, 4, 4, 4, 4, 4, 4);
+    __mmask16 valid_all = 0xFFFF, positive = 0;
+    for(int i = 1; i < ROWS_NUM; i += 2){
+        __m512i rows = _mm512_loadu_si512((const void *)board[PUYO][i]);
+        __mmask16 valid = _mm512_cmpeq_epi32_mask(rows, zero);
+        for(int c = 0; c < COLOR_NUM; c++){
+            __mmask16 eq = _mm512_cmpeq_epi32_mask(rows, _mm512_set1_epi32(c + 1));
+            valid |= eq;
+            acc[c] = _mm512_mask_or_epi32(acc[c], eq, acc[c], bit);
+        }
+        __mmask16 eq = _mm512_cmpeq_epi32_mask(rows, ojama);
+        valid |= eq;
+        acc[COLOR_NUM] = _mm512_mask_or_epi32(acc[COLOR_NUM], eq, acc[COLOR_NUM], bit);
+        eq = _mm512_cmpeq_epi32_mask(_mm512_loadu_si512((const void *)board[STATE][i]), state_new);
+        acc[COLOR_NUM+1] = _mm512_mask_or_epi32(acc[COLOR_NUM+1], eq, acc[COLOR_NUM+1], bit);
+        valid_all &= valid;
+        positive |= _mm512_cmpgt_epi32_mask(rows, zero);
+        bit = _mm512_slli_epi32(bit, 2);
+    }
+    if((positive & 0x8181) || (~valid_all & 0x7E7E)) return 0;
+
+    //int16に詰めてから2段分の結果を重ねる
+    __m128i lanes[SCAN_PLANES];
+    for(int k = 0; k < SCAN_PLANES; k++){
+        __m256i packed = _mm512_cvtepi32_epi16(acc[k]);
+        lanes[k] = _mm_or_si128(_mm256_castsi256_si128(packed), _mm256_extracti128_si256(packed, 1));
+    }
+    lanesToBitBoard(lanes, bb);
+    return 1;
+}
+
+//CPUの判定--------------------------------------------------------------------------------------------------
+
+static void cpuid(unsigned leaf, unsigned subleaf, unsigned r[4]){
+#if defined(__GNUC__) || defined(__clang__)
+    __cpuid_count(leaf, subleaf, r[0], r[1], r[2], r[3]);
+#else
+    int regs[4];
+    __cpuidex(regs, (int)leaf, (int)subleaf);
+    for(int k = 0; k < 4; k++) r[k] = (unsigned)regs[k];
+#endif
+}
+
+//OSが保存するレジスタの種類（XCR0）
+static uint64_t xgetbv0(void){
+#if defined(__GNUC__) || defined(__clang__)
+    unsigned lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((uint64_t)hi << 32) | lo;
+#else
+    return _xgetbv(0);
+#endif
+}
+
+// 実行中のCPUとOSが使える命令セットをbit（bit levelが1なら使える）で返す
+static unsigned detectSimd(void){
+    unsigned supported = 1u << SIMD_SCALAR;
+    unsigned r[4];
+    cpuid(0, 0, r);
+    unsigned max_leaf = r[0];
+    if(max_leaf < 1) return supported;
+
+    cpuid(1, 0, r);
+    if(r[3] & (1u << 26)) supported |= 1u << SIMD_SSE2;
+    int osxsave = (r[2] >> 27) & 1, avx = (r[2] >> 28) & 1;
+    if(!osxsave || !avx || max_leaf < 7) return supported;
+
+    uint64_t xcr0 = xgetbv0();
+    if((xcr0 & 0x06) != 0x06) return supported; //XMM, YMM
+    cpuid(7, 0, r);
+    if(r[1] & (1u << 5)) supported |= 1u << SIMD_AVX2;
+    if((r[1] & (1u << 16)) && (xcr0 & 0xE6) == 0xE6) supported |= 1u << SIMD_AVX512; //opmask, ZMM
+    return supported;
+}
+
+#else
+
+static unsigned detectSimd(void){
+    return 1u << SIMD_SCALAR;
+}
+
+#endif //SIMD_X86
+
+//選択------------------------------------------------------------------------------------------------------
+
+static const SimdKernels kernels[SIMD_LEVELS] = {
+    {encodeNHWCFloat32Scalar, encodeNCHWFloat32Scalar, toBitBoardScalar},
+#ifdef SIMD_X86
+    {encodeNHWCFloat32SSE2, encodeNCHWFloat32SSE2, toBitBoardSSE2},
+    {encodeNHWCFloat32AVX2, encodeNCHWFloat32AVX2, toBitBoardAVX2},
+    {encodeNHWCFloat32AVX512, encodeNCHWFloat32AVX512, toBitBoardAVX512},
+#else
+    {encodeNHWCFloat32Scalar, encodeNCHWFloat32Scalar, toBitBoardScalar},
+    {encodeNHWCFloat32Scalar, encodeNCHWFloat32Scalar, toBitBoardScalar},
+    {encodeNHWCFloat32Scalar, encodeNCHWFloat32Scalar, toBitBoardScalar},
+#endif
+};
+
+static const char *level_names[SIMD_LEVELS] = {"scalar", "sse2", "avx2", "avx512"};
+
+//initSimdを呼ぶまではスカラー版を使う
+const SimdKernels *simd_current = &kernels[SIMD_SCALAR];
+static int current_level = SIMD_SCALAR;
+static unsigned supported_levels = 1u << SIMD_SCALAR;
+
+// CPUを調べて使える中で最も新しい命令セットのカーネルを選ぶ関数
+// 環境変数PUYO_SIMD（scalar, sse2, avx2, avx512）があれば，それより新しいものは使わない
+void initSimd(void){
+    supported_levels = detectSimd();
+    int level = SIMD_LEVELS - 1;
+    const char *env = getenv("PUYO_SIMD");
+    if(env != NULL && env[0] != '\0'){
+        int cap = simdLevelFromName(env);
+        if(cap >= 0) level = cap;
+    }
+    setSimdLevel(level);
+}
+
+int simdLevel(void){
+#ifdef _MSC_VER
+    return *(volatile int *)&current_level;
+#else
+    return __atomic_load_n(&current_level, __ATOMIC_RELAXED);
+#endif
+}
+
+int simdSupported(int level){
+    return 0 <= level && level < SIMD_LEVELS && ((supported_levels >> level) & 1);
+}
+
+// level以下で使える最も新しい命令セットに切り替え，選んだ段階を返す関数
+// 他のスレッドが処理中のカーネルはそのまま最後まで動き，次の呼び出しから新しいものになる
+int setSimdLevel(int level){
+    if(level >= SIMD_LEVELS) level = SIMD_LEVELS - 1;
+    while(level > SIMD_SCALAR && !simdSupported(level)) level--;
+    if(level < SIMD_SCALAR) level = SIMD_SCALAR;
+#ifdef _MSC_VER
+    *(const SimdKernels *volatile *)&simd_current = &kernels[level];
+    *(volatile int *)&current_level = level;
+#else
+    __atomic_store_n(&simd_current, &kernels[level], __ATOMIC_RELEASE);
+    __atomic_store_n(&current_level, level, __ATOMIC_RELAXED);
+#endif
+    return level;
+}
+
+const char *simdLevelName(int level){
+    if(level < 0 || level >= SIMD_LEVELS) return "unknown";
+    return level_names[level];
+}
+
+// 名前から段階を返す関数．知らない名前なら-1
+int simdLevelFromName(const char *name){
+    for(int level = 0; level < SIMD_LEVELS; level++)
+        if(strcmp(name, level_names[level]) == 0) return level;
+    return -1;
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#ifndef _PUYO_SIMD_H_
+#define _PUYO_SIMD_H_
+
+#include "puyo_func.h"
+#include "puyo_bitboard.h"
+
+//SIMD命令セットの段階（大きいほど新しい）
+#define SIMD_SCALAR 0
+#define SIMD_SSE2 1
+#define SIMD_AVX2 2
+#define SIMD_AVX512 3
+#define SIMD_LEVELS 4
+
+//命令セットごとに用意したカーネル．initSimdで実行中のCPUに合うものが選ばれる
+//setSimdLevelは他のスレッドがカーネルを呼んでいる間でも，表を指すポインタ1つを書き換えるだけで切り替える
+typedef struct {
+    void (*encode_nhwc_f32)(int (*board)[ROWS_NUM][COLS_NUM], float *x); //toBoardForModel
+    void (*encode_nchw_f32)(int (*board)[ROWS_NUM][COLS_NUM], float *x); //encodeBoard(NCHW, float32)
+    int (*to_bitboard)(int (*board)[ROWS_NUM][COLS_NUM], BitBoard *bb);  //toBitBoard
+} SimdKernels;
+
+extern const SimdKernels *simd_current;
+
+//今使っているカーネルの表を返す関数
+static inline const SimdKernels *simdKernels(void){
+#ifdef _MSC_VER
+    return *(const SimdKernels *const volatile *)&simd_current;
+#else
+    return __atomic_load_n(&simd_current, __ATOMIC_ACQUIRE);
+#endif
+}
+
+void initSimd(void);
+int simdLevel(void);
+int simdSupported(int level);
+int setSimdLevel(int level);
+const char *simdLevelName(int level);
+int simdLevelFromName(const char *name);
+
+#endif //_PUYO_SIMD_H_
\ No newline at end of file
@@ -0,0 +1,188 @@
+#include <string.h>
+#include "puyo_stats.h"
+#include "puyo_thread.h"
+
+#if defined(PUYO_STATS) && defined(PUYO_STATS_TIMERS)
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define STATS_RDTSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define STATS_RDTSC
+#elif !defined(_WIN32)
+#include <time.h>
+#endif
+#endif
+
+#ifdef PUYO_STATS
+
+//集計領域の数．同時に生きているスレッドがこれを超えると，超えた分は最後の領域を共有する
+//最後の領域を使うスレッドは原子的に足すので，共有しても値はずれない
+#define STATS_SLOTS 256
+#define SHARED_SLOT (STATS_SLOTS - 1)
+
+//スレッドが終了しても集計値は残し，領域だけを次のスレッドに使い回す
+static PuyoStats slots[STATS_SLOTS];
+static int free_slots[STATS_SLOTS];
+static int n_free = 0;
+static int n_used = 0;
+#ifdef _WIN32
+static PuyoMutex stats_mutex = SRWLOCK_INIT;
+#else
+static PuyoMutex stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+PUYO_TLS PuyoStats *puyo_stats_local = NULL;
+PUYO_TLS int puyo_stats_shared = 0;
+
+void statsAddShared(uint64_t *p, uint64_t v){
+#ifdef _WIN32
+    InterlockedExchangeAdd64((volatile LONG64 *)p, (LONG64)v);
+#else
+    __atomic_fetch_add(p, v, __ATOMIC_RELAXED);
+#endif
+}
+
+static void releaseSlot(PuyoStats *s){
+    int k = (int)(s - slots);
+    mutexLock(&stats_mutex);
+    //共有している領域は返さない
+    if(k != SHARED_SLOT) free_slots[n_free++] = k;
+    mutexUnlock(&stats_mutex);
+}
+
+//スレッドの終了時に，statsDetachを呼ばずに終わったスレッド（Pythonのスレッドなど）の領域を返す
+#ifdef _WIN32
+static DWORD exit_key = FLS_OUT_OF_INDEXES;
+
+static void WINAPI onThreadExit(PVOID value){
+    if(value) releaseSlot((PuyoStats *)value);
+}
+
+static void createExitKey(void){
+    exit_key = FlsAlloc(onThreadExit);
+}
+
+static void setExitValue(PuyoStats *s){
+    if(exit_key != FLS_OUT_OF_INDEXES) FlsSetValue(exit_key, s);
+}
+#else
+static pthread_key_t exit_key;
+static int exit_key_ok = 0;
+
+static void onThreadExit(void *value){
+    releaseSlot((PuyoStats *)value);
+}
+
+static void createExitKey(void){
+    exit_key_ok = pthread_key_create(&exit_key, onThreadExit) == 0;
+}
+
+static void setExitValue(PuyoStats *s){
+    if(exit_key_ok) pthread_setspecific(exit_key, s);
+}
+#endif
+
+static PuyoOnce exit_key_once = PUYO_ONCE_INIT;
+
+// 呼び出したスレッドに集計領域を割り当てる関数
+PuyoStats *statsAttach(void){
+    callOnce(&exit_key_once, createExitKey);
+    mutexLock(&stats_mutex);
+    int k;
+    if(n_free > 0) k = free_slots[--n_free];
+    else if(n_used < STATS_SLOTS) k = n_used++;
+    else k = SHARED_SLOT;
+    mutexUnlock(&stats_mutex);
+
+    puyo_stats_local = &slots[k];
+    puyo_stats_shared = k == SHARED_SLOT;
+    setExitValue(puyo_stats_local);
+    return puyo_stats_local;
+}
+
+// スレッドの集計領域を手放す関数．使い捨てのワーカーが終了時に呼ぶ
+// 呼ばずに終わったスレッドの領域はスレッドの終了時に返す
+void statsDetach(void){
+    PuyoStats *s = puyo_stats_local;
+    if(s == NULL) return;
+    puyo_stats_local = NULL;
+    puyo_stats_shared = 0;
+    setExitValue(NULL);
+    releaseSlot(s);
+}
+
+#endif //PUYO_STATS
+
+int statsEnabled(void){
+#ifdef PUYO_STATS
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+int statsTimersEnabled(void){
+#if defined(PUYO_STATS) && defined(PUYO_STATS_TIMERS)
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+#if defined(PUYO_STATS) && defined(PUYO_STATS_TIMERS)
+// 計測用の時刻を返す関数．x86ではTSCのサイクル数，それ以外ではナノ秒
+uint64_t statsClock(void){
+#if defined(STATS_RDTSC)
+    return __rdtsc();
+#elif defined(_WIN32)
+    LARGE_INTEGER t;
+    QueryPerformanceCounter(&t);
+    return (uint64_t)t.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+#endif
+
+// statsClockの単位を返す関数．タイマーが無効ならNULL
+const char *statsClockName(void){
+#if defined(PUYO_STATS) && defined(PUYO_STATS_TIMERS)
+#if defined(STATS_RDTSC)
+    return "rdtsc";
+#elif defined(_WIN32)
+    return "qpc";
+#else
+    return "ns";
+#endif
+#else
+    return NULL;
+#endif
+}
+
+// 全スレッドの集計値を合計する関数．無効なビルドでは全て0になる
+// 計測中の他スレッドの値は読み取り時点のものになる
+void getStats(PuyoStats *stats){
+    memset(stats, 0, sizeof(*stats));
+#ifdef PUYO_STATS
+    mutexLock(&stats_mutex);
+    for(int k = 0; k < n_used; k++){
+        for(int i = 0; i < STAT_COUNTERS_NUM; i++) stats->counters[i] += slots[k].counters[i];
+        for(int i = 0; i < STAT_CHAIN_BINS; i++) stats->chain_hist[i] += slots[k].chain_hist[i];
+        for(int i = 0; i < STAT_FALL_BINS; i++) stats->fall_hist[i] += slots[k].fall_hist[i];
+        for(int i = 0; i < STAT_TIMERS_NUM; i++) stats->cycles[i] += slots[k].cycles[i];
+    }
+    mutexUnlock(&stats_mutex);
+#endif
+}
+
+// 集計値を0に戻す関数．計測中のスレッドがないときに呼ぶ
+void resetStats(void){
+#ifdef PUYO_STATS
+    mutexLock(&stats_mutex);
+    memset(slots, 0, sizeof(slots[0]) * n_used);
+    mutexUnlock(&stats_mutex);
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,107 @@
+#ifndef _PUYO_STATS_H_
+#define _PUYO_STATS_H_
+
+#include <stdint.h>
+
+//ホットパスの計測カウンタ
+//PUYO_STATSを定義してビルドしたときだけ有効になる．未定義のときはマクロが空になり，計測のコードは一切残らない
+//PUYO_STATS_TIMERSも定義すると関数ごとのサイクル数も計測する
+
+//カウンタの種類
+enum {
+    STAT_CANPUT_CALLS,
+    STAT_CANPUT_REJECTS,
+    STAT_SEED_CALLS,
+    STAT_SEED_FAILS,
+    STAT_ERASE_VISITED,
+    STAT_FALL_CALLS,
+    STAT_FALL_MOVED,
+    STAT_ONECHAIN_CALLS,
+    STAT_ALLCHAIN_CALLS,
+    STAT_COUNTERS_NUM
+};
+
+//サイクル数を計測する関数の種類．入れ子になった呼び出しの分も含む
+enum {
+    STAT_TIMER_CANPUT,
+    STAT_TIMER_FALL,
+    STAT_TIMER_ONECHAIN,
+    STAT_TIMER_ALLCHAIN,
+    STAT_TIMERS_NUM
+};
+
+//連鎖数の分布．最後のビンはそれ以上の連鎖数をまとめる
+#define STAT_CHAIN_BINS 20
+//1個のぷよが落下した段数の分布
+#define STAT_FALL_BINS 14
+
+typedef struct {
+    uint64_t counters[STAT_COUNTERS_NUM];
+    uint64_t chain_hist[STAT_CHAIN_BINS];
+    uint64_t fall_hist[STAT_FALL_BINS];
+    uint64_t cycles[STAT_TIMERS_NUM];
+} PuyoStats;
+
+int statsEnabled(void);
+int statsTimersEnabled(void);
+const char *statsClockName(void);
+void getStats(PuyoStats *stats);
+void resetStats(void);
+
+#ifdef PUYO_STATS
+
+#ifdef _MSC_VER
+#define PUYO_TLS __declspec(thread)
+#else
+#define PUYO_TLS __thread
+#endif
+
+extern PUYO_TLS PuyoStats *puyo_stats_local;
+extern PUYO_TLS int puyo_stats_shared;
+PuyoStats *statsAttach(void);
+void statsDetach(void);
+void statsAddShared(uint64_t *p, uint64_t v);
+
+//スレッドごとの集計領域．初回だけ登録する
+static inline PuyoStats *statsLocal(void){
+    PuyoStats *s = puyo_stats_local;
+    return s ? s : statsAttach();
+}
+
+//他のスレッドと共有している領域なら原子的に足す
+static inline void statsAdd(uint64_t *p, uint64_t v){
+    if(puyo_stats_shared) statsAddShared(p, v);
+    else *p += v;
+}
+
+#define STAT_ADD(id, v) statsAdd(&statsLocal()->counters[id], (uint64_t)(v))
+#define STAT_INC(id) STAT_ADD(id, 1)
+#define STAT_CHAIN(n) statsAdd(&statsLocal()->chain_hist[(n) < STAT_CHAIN_BINS ? (n) : STAT_CHAIN_BINS-1], 1)
+#define STAT_FALL(d) statsAdd(&statsLocal()->fall_hist[(d) < STAT_FALL_BINS ? (d) : STAT_FALL_BINS-1], 1)
+#define STAT_DETACH() statsDetach()
+
+#else
+
+#define STAT_ADD(id, v) ((void)0)
+#define STAT_INC(id) ((void)0)
+#define STAT_CHAIN(n) ((void)0)
+#define STAT_FALL(d) ((void)0)
+#define STAT_DETACH() ((void)0)
+
+#endif //PUYO_STATS
+
+#if defined(PUYO_STATS) && defined(PUYO_STATS_TIMERS)
+
+uint64_t statsClock(void);
+
+#define STAT_TIMER_BEGIN(t) uint64_t t = statsClock()
+#define STAT_TIMER_END(id, t) statsAdd(&statsLocal()->cycles[id], statsClock() - (t))
+
+#else
+
+#define STAT_TIMER_BEGIN(t) ((void)0)
+#define STAT_TIMER_END(id, t) ((void)0)
+
+#endif //PUYO_STATS_TIMERS
+
+#endif //_PUYO_STATS_H_
\ No newline at end of file
@@ -0,0 +1,300 @@
+#include <stdlib.h>
+#include "puyo_thread.h"
+#include "puyo_stats.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+//スレッド数の上限
+#define MAX_THREADS 256
+
+#ifdef _WIN32
+typedef CONDITION_VARIABLE PuyoCond;
+#define PUYO_MUTEX_INIT SRWLOCK_INIT
+#define PUYO_COND_INIT CONDITION_VARIABLE_INIT
+#else
+typedef pthread_cond_t PuyoCond;
+#define PUYO_MUTEX_INIT PTHREAD_MUTEX_INITIALIZER
+#define PUYO_COND_INIT PTHREAD_COND_INITIALIZER
+#endif
+
+typedef struct {
+    volatile long next;
+    int n;
+    int grain;
+    ParallelTask task;
+    void *ctx;
+} ParallelJob;
+
+static long fetchAdd(volatile long *p, long v){
+#ifdef _WIN32
+    return InterlockedExchangeAdd(p, v);
+#else
+    return __atomic_fetch_add(p, v, __ATOMIC_RELAXED);
+#endif
+}
+
+//未処理の範囲をgrain個ずつ取り出して処理する
+static void runJob(ParallelJob *job){
+    while(1){
+        long begin = fetchAdd(&job->next, job->grain);
+        if(begin >= job->n) return;
+        long end = begin + job->grain;
+        if(end > job->n) end = job->n;
+        job->task(job->ctx, (int)begin, (int)end);
+    }
+}
+
+//使い捨てのスレッド．プールを別の呼び出しが使っているときに使う
+#ifdef _WIN32
+static DWORD WINAPI worker(LPVOID arg){
+    runJob((ParallelJob *)arg);
+    STAT_DETACH();
+    return 0;
+}
+#else
+static void *worker(void *arg){
+    runJob((ParallelJob *)arg);
+    STAT_DETACH();
+    return NULL;
+}
+#endif
+
+void mutexInit(PuyoMutex *mutex){
+#ifdef _WIN32
+    InitializeSRWLock(mutex);
+#else
+    pthread_mutex_init(mutex, NULL);
+#endif
+}
+
+//SRWLOCKは破棄しなくてよい
+void mutexDestroy(PuyoMutex *mutex){
+#ifdef _WIN32
+    (void)mutex;
+#else
+    pthread_mutex_destroy(mutex);
+#endif
+}
+
+void mutexLock(PuyoMutex *mutex){
+#ifdef _WIN32
+    AcquireSRWLockExclusive(mutex);
+#else
+    pthread_mutex_lock(mutex);
+#endif
+}
+
+void mutexUnlock(PuyoMutex *mutex){
+#ifdef _WIN32
+    ReleaseSRWLockExclusive(mutex);
+#else
+    pthread_mutex_unlock(mutex);
+#endif
+}
+
+static void condWait(PuyoCond *cond, PuyoMutex *mutex){
+#ifdef _WIN32
+    SleepConditionVariableSRW(cond, mutex, INFINITE, 0);
+#else
+    pthread_cond_wait(cond, mutex);
+#endif
+}
+
+static void condBroadcast(PuyoCond *cond){
+#ifdef _WIN32
+    WakeAllConditionVariable(cond);
+#else
+    pthread_cond_broadcast(cond);
+#endif
+}
+
+//parallelForで使い回すワーカースレッドのプール．プロセスで1つだけ持つ
+//ワーカーは一度作ったら終了せず，次の処理が来るまでwakeで待つ
+typedef struct {
+    PuyoMutex mutex;
+    PuyoCond wake; //処理が来たことをワーカーに知らせる
+    PuyoCond done; //参加したワーカーがすべて抜けたことを呼び出し元に知らせる
+    int busy;      //いずれかのparallelForがプールを使っている
+    int size;      //作ったワーカーの数
+    int wanted;    //今の処理に参加させるワーカーの数．締め切ったら0にする
+    int joined;    //今の処理に参加したワーカーの数
+    int running;   //今の処理を実行中のワーカーの数
+    ParallelJob *job;
+} WorkerPool;
+
+static WorkerPool pool = {PUYO_MUTEX_INIT, PUYO_COND_INIT, PUYO_COND_INIT, 0, 0, 0, 0, 0, NULL};
+
+static void poolLoop(void){
+    mutexLock(&pool.mutex);
+    while(1){
+        while(pool.joined >= pool.wanted) condWait(&pool.wake, &pool.mutex);
+        ParallelJob *job = pool.job;
+        pool.joined++;
+        pool.running++;
+        mutexUnlock(&pool.mutex);
+        runJob(job);
+        mutexLock(&pool.mutex);
+        if(--pool.running == 0) condBroadcast(&pool.done);
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI poolWorker(LPVOID arg){
+    poolLoop();
+    return 0;
+}
+#else
+static void *poolWorker(void *arg){
+    poolLoop();
+    return NULL;
+}
+
+//fork後の子プロセスにはワーカーがいないので，プールを空に戻す
+static void poolAfterFork(void){
+    WorkerPool empty = {PUYO_MUTEX_INIT, PUYO_COND_INIT, PUYO_COND_INIT, 0, 0, 0, 0, 0, NULL};
+    pool = empty;
+}
+
+static PuyoOnce fork_once = PUYO_ONCE_INIT;
+
+static void registerFork(void){
+    pthread_atfork(NULL, NULL, poolAfterFork);
+}
+#endif
+
+//ワーカーをn個まで増やす．作れなかった場合はそこで止める．pool.mutexを持って呼ぶ
+static void poolGrow(int n){
+    while(pool.size < n){
+#ifdef _WIN32
+        HANDLE thread = CreateThread(NULL, 0, poolWorker, NULL, 0, NULL);
+        if(thread == NULL) return;
+        CloseHandle(thread);
+#else
+        pthread_t thread;
+        if(pthread_create(&thread, NULL, poolWorker, NULL) != 0) return;
+        pthread_detach(thread);
+#endif
+        pool.size++;
+    }
+}
+
+//プールのワーカーn_workers個と呼び出し元でjobを処理する
+//プールを別の呼び出しが使っている（別のスレッドからの同時呼び出しや入れ子）場合は何もせず-1を返す
+static int poolRun(ParallelJob *job, int n_workers){
+#ifndef _WIN32
+    callOnce(&fork_once, registerFork);
+#endif
+    mutexLock(&pool.mutex);
+    if(pool.busy){
+        mutexUnlock(&pool.mutex);
+        return -1;
+    }
+    pool.busy = 1;
+    poolGrow(n_workers);
+    pool.job = job;
+    pool.joined = 0;
+    pool.running = 0;
+    pool.wanted = n_workers < pool.size ? n_workers : pool.size;
+    condBroadcast(&pool.wake);
+    mutexUnlock(&pool.mutex);
+
+    runJob(job);
+
+    //まだ参加していないワーカーは締め切り，参加したワーカーが抜けるのを待つ
+    mutexLock(&pool.mutex);
+    pool.wanted = 0;
+    while(pool.running > 0) condWait(&pool.done, &pool.mutex);
+    pool.job = NULL;
+    pool.busy = 0;
+    mutexUnlock(&pool.mutex);
+    return 0;
+}
+
+#ifdef _WIN32
+static BOOL CALLBACK onceCallback(PINIT_ONCE once, PVOID param, PVOID *context){
+    (*(void (**)(void))param)();
+    return TRUE;
+}
+#endif
+
+// funcをプロセス全体で1回だけ実行する関数．同時に呼ばれた場合は実行が終わるまで待つ
+void callOnce(PuyoOnce *once, void (*func)(void)){
+#ifdef _WIN32
+    InitOnceExecuteOnce(once, onceCallback, (PVOID)&func, NULL);
+#else
+    pthread_once(once, func);
+#endif
+}
+
+// 使用できる論理CPU数を返す関数
+int cpuCount(void){
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+// 実際に使うスレッド数を決める関数
+// n_threadsが0以下ならCPU数を使う．処理数nより多くはしない
+int resolveThreads(int n_threads, int n){
+    if(n_threads <= 0) n_threads = cpuCount();
+    if(n_threads > MAX_THREADS) n_threads = MAX_THREADS;
+    if(n_threads > n) n_threads = n;
+    if(n_threads < 1) n_threads = 1;
+    return n_threads;
+}
+
+// [0, n) をn_threads個のスレッドで分担して処理する関数
+// 各スレッドはgrain個ずつ処理範囲を取り出すので，処理時間にばらつきがあっても偏りにくい
+// 呼び出し元のスレッドも処理に参加する．スレッドを作れなかった場合は残りを呼び出し元で処理する
+// ワーカーはプールのものを使い回す．プールが使用中なら使い捨てのスレッドを作る
+void parallelFor(int n, int n_threads, int grain, ParallelTask task, void *ctx){
+    if(n <= 0) return;
+    if(grain < 1) grain = 1;
+    n_threads = resolveThreads(n_threads, (n + grain - 1) / grain);
+
+    if(n_threads == 1){
+        task(ctx, 0, n);
+        return;
+    }
+
+    ParallelJob job;
+    job.next = 0;
+    job.n = n;
+    job.grain = grain;
+    job.task = task;
+    job.ctx = ctx;
+
+    if(poolRun(&job, n_threads - 1) == 0) return;
+
+#ifdef _WIN32
+    HANDLE threads[MAX_THREADS];
+    int started = 0;
+    for(int t = 0; t < n_threads - 1; t++){
+        threads[started] = CreateThread(NULL, 0, worker, &job, 0, NULL);
+        if(threads[started] == NULL) break;
+        started++;
+    }
+    runJob(&job);
+    for(int t = 0; t < started; t++){
+        WaitForSingleObject(threads[t], INFINITE);
+        CloseHandle(threads[t]);
+    }
+#else
+    pthread_t threads[MAX_THREADS];
+    int started = 0;
+    for(int t = 0; t < n_threads - 1; t++){
+        if(pthread_create(&threads[started], NULL, worker, &job) != 0) break;
+        started++;
+    }
+    runJob(&job);
+    for(int t = 0; t < started; t++)
+        pthread_join(threads[t], NULL);
+#endif
+}
\ No newline at end of file
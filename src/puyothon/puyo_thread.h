@@ -0,0 +1,28 @@
+#ifndef _PUYO_THREAD_H_
+#define _PUYO_THREAD_H_
+
+#ifdef _WIN32
+#include <windows.h>
+typedef SRWLOCK PuyoMutex;
+typedef INIT_ONCE PuyoOnce;
+#define PUYO_ONCE_INIT INIT_ONCE_STATIC_INIT
+#else
+#include <pthread.h>
+typedef pthread_mutex_t PuyoMutex;
+typedef pthread_once_t PuyoOnce;
+#define PUYO_ONCE_INIT PTHREAD_ONCE_INIT
+#endif
+
+//並列処理の対象となる関数．[begin, end) の範囲を処理する
+typedef void (*ParallelTask)(void *ctx, int begin, int end);
+
+int cpuCount(void);
+int resolveThreads(int n_threads, int n);
+void mutexInit(PuyoMutex *mutex);
+void mutexDestroy(PuyoMutex *mutex);
+void mutexLock(PuyoMutex *mutex);
+void mutexUnlock(PuyoMutex *mutex);
+void callOnce(PuyoOnce *once, void (*func)(void));
+void parallelFor(int n, int n_threads, int grain, ParallelTask task, void *ctx);
+
+#endif //_PUYO_THREAD_H_
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include "puyo_tsumo.h"
+#include "puyo_thread.h"
+
+//1つのスレッドが続けて処理する系列の数
+#define TSUMO_GRAIN 64
+
+// 1周期分のツモをrngで作る関数
+// 各色TSUMO_CYCLE*2/COLOR_NUM個ずつ並べてFisher-Yatesでシャッフルする
+void tsumoInit(TsumoTable *table, PuyoRandom *rng){
+    const int n = TSUMO_CYCLE * 2;
+    for(int k = 0; k < n; k++) table->puyos[k] = (unsigned char)(k % COLOR_NUM + 1);
+    for(int k = n - 1; k > 0; k--){
+        int l = randomBelow(rng, k + 1);
+        unsigned char t = table->puyos[k];
+        table->puyos[k] = table->puyos[l];
+        table->puyos[l] = t;
+    }
+
+    //最初の2組に全色が出ないように，4個目を前の3個のどれかと同じ色の後ろのぷよと入れ替える
+    if(COLOR_NUM < 4) return;
+    unsigned char *p = table->puyos;
+    if(p[3] == p[0] || p[3] == p[1] || p[3] == p[2]) return;
+    if(p[0] == p[1] || p[0] == p[2] || p[1] == p[2]) return;
+    for(int k = 4; k < n; k++){
+        if(p[k] == p[0] || p[k] == p[1] || p[k] == p[2]){
+            unsigned char t = p[3];
+            p[3] = p[k];
+            p[k] = t;
+            return;
+        }
+    }
+}
+
+// seedとstreamからツモを作る関数．streamが異なれば独立したツモになる
+void tsumoInitSeed(TsumoTable *table, uint64_t seed, uint64_t stream){
+    PuyoRandom rng;
+    randomInit(&rng, seed, stream);
+    tsumoInit(table, &rng);
+}
+
+typedef struct {
+    uint64_t seed;
+    uint64_t stream;
+    int64_t start;
+    int length;
+    int (*pairs)[2];
+} TsumoJob;
+
+static void tsumoTask(void *ctx, int begin, int end){
+    TsumoJob *job = (TsumoJob *)ctx;
+    TsumoTable table;
+    for(int i = begin; i < end; i++){
+        tsumoInitSeed(&table, job->seed, job->stream + (uint64_t)i);
+        int (*pairs)[2] = job->pairs + (size_t)i * job->length;
+        for(int t = 0; t < job->length; t++)
+            tsumoPair(&table, job->start + t, &pairs[t][0], &pairs[t][1]);
+    }
+}
+
+// n個の系列のツモをstart組目からlength組ずつpairs (n, length, 2) に書き込む関数
+// i番目の系列は乱数系列stream+iを使うので，系列を別のプロセスに分けても同じツモになる
+void generateTsumo(uint64_t seed, uint64_t stream, int n, int64_t start, int length, int (*pairs)[2], int n_threads){
+    TsumoJob job = {seed, stream, start, length, pairs};
+    parallelFor(n, n_threads, TSUMO_GRAIN, tsumoTask, &job);
+}
\ No newline at end of file
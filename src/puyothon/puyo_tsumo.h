@@ -0,0 +1,29 @@
+#ifndef _PUYO_TSUMO_H_
+#define _PUYO_TSUMO_H_
+
+#include <stdint.h>
+#include "puyo_func.h"
+#include "puyo_random.h"
+
+//ツモの周期（ペア数）．ツモ列はTSUMO_CYCLE組ごとに同じ並びを繰り返す
+#define TSUMO_CYCLE 128
+
+//1周期分のツモ．各色をほぼ同じ数ずつ（COLOR_NUMが4なら64個ずつ）並べてシャッフルしたもの
+//最初の2組は高々3色になる（COLOR_NUMが4以上のとき）
+typedef struct {
+    unsigned char puyos[TSUMO_CYCLE * 2];
+} TsumoTable;
+
+void tsumoInit(TsumoTable *table, PuyoRandom *rng);
+void tsumoInitSeed(TsumoTable *table, uint64_t seed, uint64_t stream);
+
+// index組目（0始まり）のツモを返す．周期を超えたら先頭に戻る
+static inline void tsumoPair(const TsumoTable *table, int64_t index, int *parent_puyo, int *child_puyo){
+    int k = (int)(index & (TSUMO_CYCLE - 1));
+    *parent_puyo = table->puyos[2*k];
+    *child_puyo = table->puyos[2*k+1];
+}
+
+void generateTsumo(uint64_t seed, uint64_t stream, int n, int64_t start, int length, int (*pairs)[2], int n_threads);
+
+#endif //_PUYO_TSUMO_H_
\ No newline at end of file
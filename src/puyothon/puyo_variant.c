@@ -0,0 +1,84 @@
+#include <stdint.h>
+#include <string.h>
+#include "puyo_variant.h"
+#include "puyo_encode.h"
+#include "puyo_hash.h"
+#include "puyo_stats.h"
+
+//半精度浮動小数点数の1.0
+#define FLOAT16_ONE 0x3C00
+
+//elems要素のモデル入力のバイト数
+static int encodedSize(int elems, int dtype){
+    switch(dtype){
+        case DTYPE_FLOAT32: return elems * 4;
+        case DTYPE_FLOAT16: return elems * 2;
+        case DTYPE_UINT8:   return elems;
+        case DTYPE_BITS:    return (elems + 7) / 8;
+    }
+    return 0;
+}
+
+//標準のルールはpuyo_func.cの関数（SIMDのカーネルを含む）をそのまま使う
+#define STD_BOARD(p) ((int (*)[ROWS_NUM][COLS_NUM])(p))
+
+static void initBoardStd(int *board){ initBoard(STD_BOARD(board)); }
+static int canPutStd(int *board, int col, int rot){ return canPut(STD_BOARD(board), col, rot); }
+static int putPuyoStd(int *board, int col, int rot, int parent_puyo, int child_puyo){
+    return putPuyo(STD_BOARD(board), col, rot, parent_puyo, child_puyo);
+}
+static int fallPuyosStd(int *board){ return fallPuyos(STD_BOARD(board)); }
+static int oneChainStd(int *board, int chain_num){ return oneChain(STD_BOARD(board), chain_num); }
+static void allChainStd(int *board, int *n_chains, int *score){ allChain(STD_BOARD(board), n_chains, score); }
+static int isDeadStd(int *board){ return isDeadBoard(STD_BOARD(board)); }
+static void encodeBoardStd(int *board, int layout, int dtype, void *x){ encodeBoard(STD_BOARD(board), layout, dtype, x); }
+
+//色数と盤面の大きさを定数にした関数を種類ごとに作る
+#define V_SUFFIX Color3
+#define V_COLORS 3
+#define V_ROWS ROWS_NUM
+#define V_COLS COLS_NUM
+#include "puyo_variant_impl.h"
+
+#define V_SUFFIX Color5
+#define V_COLORS 5
+#define V_ROWS ROWS_NUM
+#define V_COLS COLS_NUM
+#include "puyo_variant_impl.h"
+
+#define V_SUFFIX Wide
+#define V_COLORS COLOR_NUM
+#define V_ROWS ROWS_NUM
+#define V_COLS (COLS_NUM+2)
+#include "puyo_variant_impl.h"
+
+//行動の数．左端の列の左向きと右端の列の右向きは置けない
+#define VARIANT_ACTIONS(cols) (((cols)-2)*4 - 2)
+
+#define VARIANT_ENTRY(name, suffix, colors, rows, cols) \
+    {name, colors, rows, cols, VARIANT_ACTIONS(cols),   \
+     initBoard##suffix, canPut##suffix, putPuyo##suffix, fallPuyos##suffix, \
+     oneChain##suffix, allChain##suffix, isDead##suffix, encodeBoard##suffix}
+
+const RuleVariant rule_variants[VARIANTS_NUM] = {
+    VARIANT_ENTRY("standard", Std, COLOR_NUM, ROWS_NUM, COLS_NUM),
+    VARIANT_ENTRY("color3", Color3, 3, ROWS_NUM, COLS_NUM),
+    VARIANT_ENTRY("color5", Color5, 5, ROWS_NUM, COLS_NUM),
+    VARIANT_ENTRY("wide", Wide, COLOR_NUM, ROWS_NUM, COLS_NUM+2),
+};
+
+//番号からルールを返す関数．範囲外ならNULL
+const RuleVariant *getRuleVariant(int variant){
+    if(variant < 0 || variant >= VARIANTS_NUM) return NULL;
+    return &rule_variants[variant];
+}
+
+// 1盤面を変換したときの要素数を返す関数
+int variantEncodedElems(const RuleVariant *v){
+    return (v->rows-1)*(v->cols-2)*v->colors;
+}
+
+// 1盤面を変換したときのバイト数を返す関数
+int variantEncodedBytes(const RuleVariant *v, int dtype){
+    return encodedSize(variantEncodedElems(v), dtype);
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#ifndef _PUYO_VARIANT_H_
+#define _PUYO_VARIANT_H_
+
+#include "puyo_func.h"
+
+//ルールの種類（色数と盤面の大きさの組み合わせ）
+//種類ごとに色数・行数・列数を定数にした関数をコンパイル時に作り，実行時に番号で選ぶ
+#define VARIANT_STANDARD 0 //4色，6列（ROWS_NUM x COLS_NUM）．既存の関数をそのまま使う
+#define VARIANT_COLOR3 1   //3色，6列
+#define VARIANT_COLOR5 2   //5色，6列
+#define VARIANT_WIDE 3     //4色，8列
+#define VARIANTS_NUM 4
+
+//盤面はARRS_NUM x rows x colsのint配列（外周の壁を含む）として渡す
+//見える最上段はrows-3段目，その上に幽霊ぷよの段と14段目にあたる段がある
+//ぷよは(cols-1)/2列目から降ってくる
+typedef struct {
+    const char *name;
+    int colors;  //色数
+    int rows;    //行数（壁を含む）
+    int cols;    //列数（壁を含む）
+    int actions; //行動の数
+    void (*initBoard)(int *board);
+    int (*canPut)(int *board, int col, int rot);
+    int (*putPuyo)(int *board, int col, int rot, int parent_puyo, int child_puyo);
+    int (*fallPuyos)(int *board);
+    int (*oneChain)(int *board, int chain_num);
+    void (*allChain)(int *board, int *n_chains, int *score);
+    int (*isDead)(int *board);
+    void (*encodeBoard)(int *board, int layout, int dtype, void *x); //モデル入力の形はpuyo_encode.hと同じ
+} RuleVariant;
+
+extern const RuleVariant rule_variants[VARIANTS_NUM];
+
+const RuleVariant *getRuleVariant(int variant);
+int variantEncodedElems(const RuleVariant *v);
+int variantEncodedBytes(const RuleVariant *v, int dtype);
+
+#endif //_PUYO_VARIANT_H_
\ No newline at end of file
@@ -0,0 +1,65 @@
+//ルールの種類ごとの関数．puyo_variant.cから種類ごとに1回ずつincludeする
+//V_SUFFIX（関数名の接尾辞），V_COLORS，V_ROWS，V_COLSを定義してからincludeすること
+//処理の本体はpuyo_func.cと同じpuyo_rule_impl.hで作り，ここではRuleVariantの形に合わせるだけにする
+
+#include "puyo_rule_impl.h"
+
+static void V_FN(initBoard)(int *board){
+    V_FN(initBoardImpl)(V_BOARD(board));
+}
+
+static int V_FN(isDead)(int *board){
+    return V_FN(isDeadImpl)(V_BOARD(board));
+}
+
+static int V_FN(canPut)(int *board, int col, int rot){
+    return V_FN(canPutImpl)(V_BOARD(board), col, rot);
+}
+
+static int V_FN(fallPuyos)(int *board){
+    return V_FN(fallPuyosImpl)(V_BOARD(board), NULL, NULL);
+}
+
+static int V_FN(putPuyo)(int *board, int col, int rot, int parent_puyo, int child_puyo){
+    return V_FN(putPuyoImpl)(V_BOARD(board), col, rot, parent_puyo, child_puyo, NULL, NULL);
+}
+
+static int V_FN(oneChain)(int *board, int chain_num){
+    return V_FN(oneChainImpl)(V_BOARD(board), chain_num, NULL);
+}
+
+static void V_FN(allChain)(int *board, int *n_chains, int *score){
+    V_FN(allChainImpl)(V_BOARD(board), n_chains, score, NULL);
+}
+
+static void V_FN(encodeBoard)(int *board_data, int layout, int dtype, void *x){
+    int (*board)[V_ROWS][V_COLS] = V_BOARD(board_data);
+    const int elems = (V_ROWS-1)*(V_COLS-2)*V_COLORS;
+    memset(x, 0, encodedSize(elems, dtype));
+    for(int i = 1; i < V_ROWS; i++){
+        for(int j = 1; j < V_COLS-1; j++){
+            int p = board[PUYO][i][j];
+            if(p < 1 || p > V_COLORS) continue;
+            int k = layout == LAYOUT_NHWC ? (((i-1)*(V_COLS-2) + (j-1))*V_COLORS + (p-1))
+                                          : (((p-1)*(V_ROWS-1) + (i-1))*(V_COLS-2) + (j-1));
+            switch(dtype){
+                case DTYPE_FLOAT32: ((float *)x)[k] = 1.0f; break;
+                case DTYPE_FLOAT16: ((uint16_t *)x)[k] = FLOAT16_ONE; break;
+                case DTYPE_UINT8:   ((uint8_t *)x)[k] = 1; break;
+                case DTYPE_BITS:    ((uint8_t *)x)[k >> 3] |= (uint8_t)(0x80 >> (k & 7)); break;
+            }
+        }
+    }
+}
+
+#undef V_CAT_
+#undef V_CAT
+#undef V_FN
+#undef V_BOARD
+#undef V_TOP
+#undef V_GHOST
+#undef V_SPAWN
+#undef V_SUFFIX
+#undef V_COLORS
+#undef V_ROWS
+#undef V_COLS
\ No newline at end of file
@@ -0,0 +1,168 @@
+#include <string.h>
+#include "puyo_versus.h"
+#include "puyo_bitboard.h"
+#include "puyo_hash.h"
+#include "puyo_rollout.h"
+#include "puyo_thread.h"
+#include "puyo_tsumo.h"
+
+// スコアをおじゃまぷよの数に変換する関数
+// 割り切れなかったスコアは*carryに繰り越し，次の変換で加算する
+int scoreToOjama(int score, int *carry){
+    int total = score + *carry;
+    *carry = total % OJAMA_RATE;
+    return total / OJAMA_RATE;
+}
+
+// 発生したおじゃまぷよで自分に降る予定のおじゃまぷよを相殺する関数
+// 相殺しきれなかった分（相手に送る数）を返す
+int offsetOjama(int ojama, int *pending){
+    if(ojama <= *pending){
+        *pending -= ojama;
+        return 0;
+    }
+    ojama -= *pending;
+    *pending = 0;
+    return ojama;
+}
+
+// おじゃまぷよをn個降らせる関数
+// 6個ごとに1段ずつ全列に降らせ，余りはランダムに選んだ別々の列に1個ずつ降らせる
+// 13段目より上にはみ出したおじゃまぷよは消える．実際に置いた数を返す
+int dropOjama(int (*board)[ROWS_NUM][COLS_NUM], int n, PuyoRandom *rng){
+    if(n <= 0) return 0;
+
+    int count[COLS_NUM] = {0};
+    for(int j = 1; j < COLS_NUM-1; j++) count[j] = n / (COLS_NUM-2);
+
+    //余りを降らせる列を選ぶ
+    int cols[COLS_NUM-2];
+    for(int k = 0; k < COLS_NUM-2; k++) cols[k] = k + 1;
+    for(int k = 0; k < n % (COLS_NUM-2); k++){
+        int r = k + randomBelow(rng, COLS_NUM-2 - k);
+        int tmp = cols[k]; cols[k] = cols[r]; cols[r] = tmp;
+        count[cols[k]]++;
+    }
+
+    int placed = 0;
+    for(int j = 1; j < COLS_NUM-1; j++){
+        int row = 1;
+        while(row < ROWS_NUM-1 && board[PUYO][row][j] != EMPTY) row++;
+        for(int k = 0; k < count[j] && row < ROWS_NUM-1; k++, row++){
+            board[PUYO][row][j] = OJAMA;
+            board[STATE][row][j] = NEW;
+            placed++;
+        }
+    }
+    return placed;
+}
+
+// 2人同時に1手進める関数
+// 各プレイヤーがぷよを置いて連鎖し，スコアをおじゃまぷよに変換して相殺したあと相手に送る．
+// 連鎖しなかったプレイヤーには，降る予定のおじゃまぷよが最大max_drop個降る．
+// 置けない行動を指定したプレイヤーはぷよを置かない
+void versusStep(int (*boards[2])[ROWS_NUM][COLS_NUM], VersusPlayer *players, const int *parent_puyos, const int *child_puyos,
+                const int *actions, int max_drop, PuyoRandom *rng, VersusResult *results){
+    int sent[2];
+    for(int p = 0; p < 2; p++){
+        VersusResult *result = &results[p];
+        result->n_chains = 0;
+        result->score = 0;
+        result->dropped = 0;
+
+        int col, rot;
+        actionToColRot(actions[p], &col, &rot);
+        result->legal = 0 <= actions[p] && actions[p] < ACTIONS_NUM && canPut(boards[p], col, rot);
+        if(result->legal){
+            putPuyo(boards[p], col, rot, parent_puyos[p], child_puyos[p]);
+            allChainBB(boards[p], &result->n_chains, &result->score);
+        }
+
+        int ojama = scoreToOjama(result->score, &players[p].carry);
+        sent[p] = offsetOjama(ojama, &players[p].pending);
+        result->sent = sent[p];
+    }
+
+    for(int p = 0; p < 2; p++){
+        players[1-p].pending += sent[p];
+    }
+
+    for(int p = 0; p < 2; p++){
+        if(results[p].score == 0 && players[p].pending > 0){
+            int n = players[p].pending < max_drop ? players[p].pending : max_drop;
+            players[p].pending -= n;
+            results[p].dropped = n;
+            dropOjama(boards[p], n, rng);
+        }
+        results[p].dead = isDeadBoard(boards[p]);
+    }
+}
+
+typedef struct {
+    uint64_t seed;
+    int max_turns;
+    const int *policies;
+    VersusGameResult *results;
+} VersusJob;
+
+// 1回の対戦を最後まで行う関数
+// 両プレイヤーには同じ128組周期のツモ列が配られる．乱数はseedとgameで決まる
+static void playVersusGame(uint64_t seed, int game, int max_turns, const int *policies, VersusGameResult *result){
+    TsumoTable tsumo;
+    PuyoRandom drop_rng, policy_rng[2];
+    tsumoInitSeed(&tsumo, seed, (uint64_t)game * 4);
+    randomInit(&drop_rng, seed, (uint64_t)game * 4 + 1);
+    randomInit(&policy_rng[0], seed, (uint64_t)game * 4 + 2);
+    randomInit(&policy_rng[1], seed, (uint64_t)game * 4 + 3);
+
+    int board_data[2][ARRS_NUM][ROWS_NUM][COLS_NUM];
+    int (*boards[2])[ROWS_NUM][COLS_NUM] = {board_data[0], board_data[1]};
+    VersusPlayer players[2] = {{0, 0}, {0, 0}};
+    for(int p = 0; p < 2; p++){
+        initBoard(boards[p]);
+        result->score[p] = 0;
+        result->max_chain[p] = 0;
+    }
+    result->winner = -1;
+    result->turns = 0;
+
+    for(int turn = 0; turn < max_turns; turn++){
+        int parent_puyo, child_puyo;
+        tsumoPair(&tsumo, turn, &parent_puyo, &child_puyo);
+        int parents[2] = {parent_puyo, parent_puyo};
+        int children[2] = {child_puyo, child_puyo};
+
+        int actions[2];
+        for(int p = 0; p < 2; p++)
+            actions[p] = selectPolicyAction(boards[p], zobristHash(boards[p]), parent_puyo, child_puyo, policies[p], &policy_rng[p]);
+
+        VersusResult step[2];
+        versusStep(boards, players, parents, children, actions, OJAMA_MAX_DROP, &drop_rng, step);
+        result->turns++;
+
+        int dead[2];
+        for(int p = 0; p < 2; p++){
+            result->score[p] += step[p].score;
+            if(step[p].n_chains > result->max_chain[p]) result->max_chain[p] = step[p].n_chains;
+            dead[p] = step[p].dead || actions[p] < 0;
+        }
+        if(dead[0] || dead[1]){
+            if(!dead[0]) result->winner = 0;
+            else if(!dead[1]) result->winner = 1;
+            return;
+        }
+    }
+}
+
+static void versusTask(void *ctx, int begin, int end){
+    VersusJob *job = (VersusJob *)ctx;
+    for(int i = begin; i < end; i++)
+        playVersusGame(job->seed, i, job->max_turns, job->policies, &job->results[i]);
+}
+
+// n_games回の対戦をスレッドに分担して行う関数
+// policies[p]はプレイヤーpの方策（POLICY_RANDOM, POLICY_GREEDY）
+void playVersusGames(uint64_t seed, int n_games, int max_turns, const int *policies, VersusGameResult *results, int n_threads){
+    VersusJob job = {seed, max_turns, policies, results};
+    parallelFor(n_games, n_threads, 1, versusTask, &job);
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#ifndef _PUYO_VERSUS_H_
+#define _PUYO_VERSUS_H_
+
+#include <stdint.h>
+#include "puyo_func.h"
+#include "puyo_random.h"
+
+//おじゃまぷよ1個あたりのスコア（ぷよ通のレート）
+#define OJAMA_RATE 70
+//1手で降るおじゃまぷよの最大数（5段分）
+#define OJAMA_MAX_DROP 30
+
+//対戦中の各プレイヤーの状態
+typedef struct {
+    int pending; //自分に降る予定のおじゃまぷよの数
+    int carry;   //おじゃまぷよに変換されずに繰り越されたスコア
+} VersusPlayer;
+
+//1手分の結果
+typedef struct {
+    int legal;
+    int n_chains;
+    int score;
+    int sent;    //相殺後に相手へ送ったおじゃまぷよの数
+    int dropped; //自分に降ったおじゃまぷよの数
+    int dead;
+} VersusResult;
+
+//対戦1回分の結果．winnerは勝ったプレイヤー（0か1），引き分けは-1
+typedef struct {
+    int winner;
+    int turns;
+    int score[2];
+    int max_chain[2];
+} VersusGameResult;
+
+int scoreToOjama(int score, int *carry);
+int offsetOjama(int ojama, int *pending);
+int dropOjama(int (*board)[ROWS_NUM][COLS_NUM], int n, PuyoRandom *rng);
+void versusStep(int (*boards[2])[ROWS_NUM][COLS_NUM], VersusPlayer *players, const int *parent_puyos, const int *child_puyos,
+                const int *actions, int max_drop, PuyoRandom *rng, VersusResult *results);
+void playVersusGames(uint64_t seed, int n_games, int max_turns, const int *policies, VersusGameResult *results, int n_threads);
+
+#endif //_PUYO_VERSUS_H_
\ No newline at end of file
@@ -0,0 +1,34 @@
+// 合法手の表（puyo_legal.c）がcanPutと一致するかを全ての盤面で調べるプログラム
+// canPutの結果は各列の12段目から14段目と11段目が埋まっているかだけで決まるので，
+// 6列x4段の埋まり方2^24通りを全て試す．一致しない盤面があれば終了コード1を返す
+#include <stdio.h>
+#include "puyo_func.h"
+#include "puyo_legal.h"
+
+int main(void){
+    initLegalTable();
+
+    int board[ARRS_NUM][ROWS_NUM][COLS_NUM];
+    initBoard(board);
+    long mismatches = 0;
+    for(long s = 0; s < (1L << 24); s++){
+        for(int j = 1; j < COLS_NUM-1; j++){
+            for(int r = 0; r < 4; r++)
+                board[PUYO][11+r][j] = (s >> ((j-1)*4 + r)) & 1 ? 1 + (r+j) % COLOR_NUM : EMPTY;
+        }
+
+        uint32_t expected = 0;
+        for(int a = 0; a < ACTIONS_NUM; a++){
+            int col, rot;
+            actionToColRot(a, &col, &rot);
+            if(canPut(board, col, rot)) expected |= 1u << a;
+        }
+        uint32_t mask = legalActionMask(board);
+        if(mask != expected){
+            if(mismatches < 5) printf("mismatch: state %06lx table %06x canPut %06x\n", s, mask, expected);
+            mismatches++;
+        }
+    }
+    printf("mismatches: %ld\n", mismatches);
+    return mismatches != 0;
+}
\ No newline at end of file
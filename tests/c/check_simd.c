@@ -0,0 +1,77 @@
+// SIMDのカーネル（puyo_simd.c）が命令セットごとにスカラー版と同じ結果になるかを調べるプログラム
+// 乱数の盤面（範囲外の値や壁の欠けた盤面を含む）でencode_nhwc_f32，encode_nchw_f32，to_bitboardを比べる
+// 実行中のCPUが対応していない命令セットは飛ばす．一致しない盤面があれば終了コード1を返す
+//
+// 使い方: check_simd [盤面の数]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "puyo_simd.h"
+
+#define ENCODED_ELEMS ((ROWS_NUM-1)*(COLS_NUM-2)*COLOR_NUM)
+#define GUARD -7.0f //書き込み範囲を超えていないかを見るための値
+
+static unsigned long long rng_state = 88172645463325252ull;
+
+static unsigned int rnd(void){
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (unsigned int)rng_state;
+}
+
+//乱数の盤面を作る関数．modeによってはBLOCKや範囲外の色，壊れた壁を混ぜる
+static void randomBoard(int (*board)[ROWS_NUM][COLS_NUM]){
+    initBoard(board);
+    int mode = rnd() % 8;
+    for(int i = 1; i < ROWS_NUM; i++){
+        for(int j = 1; j < COLS_NUM-1; j++){
+            int r = rnd() % 10;
+            if(r < 5) board[PUYO][i][j] = EMPTY;
+            else if(r < 9) board[PUYO][i][j] = rnd() % COLOR_NUM + 1;
+            else board[PUYO][i][j] = mode == 0 ? BLOCK : mode == 1 ? COLOR_NUM + 3 : OJAMA;
+            board[STATE][i][j] = rnd() % 2;
+        }
+    }
+    if(mode == 2) board[PUYO][rnd() % ROWS_NUM][rnd() % 2 ? 0 : COLS_NUM-1] = rnd() % 5;
+    if(mode == 3) board[PUYO][0][rnd() % COLS_NUM] = rnd() % 3;
+}
+
+int main(int argc, char **argv){
+    long n = argc > 1 ? atol(argv[1]) : 200000;
+    initSimd();
+    for(int level = 0; level < SIMD_LEVELS; level++)
+        printf("%s: %s\n", simdLevelName(level), simdSupported(level) ? "checked" : "skipped");
+
+    long mismatches = 0;
+    for(long t = 0; t < n; t++){
+        int board[ARRS_NUM][ROWS_NUM][COLS_NUM];
+        randomBoard(board);
+
+        float nhwc[ENCODED_ELEMS], nchw[ENCODED_ELEMS];
+        BitBoard bb;
+        setSimdLevel(SIMD_SCALAR);
+        simdKernels()->encode_nhwc_f32(board, nhwc);
+        simdKernels()->encode_nchw_f32(board, nchw);
+        int ok = simdKernels()->to_bitboard(board, &bb);
+
+        for(int level = SIMD_SCALAR+1; level < SIMD_LEVELS; level++){
+            if(setSimdLevel(level) != level) continue;
+            float nhwc_l[ENCODED_ELEMS+1], nchw_l[ENCODED_ELEMS+1];
+            BitBoard bb_l;
+            nhwc_l[ENCODED_ELEMS] = nchw_l[ENCODED_ELEMS] = GUARD;
+            simdKernels()->encode_nhwc_f32(board, nhwc_l);
+            simdKernels()->encode_nchw_f32(board, nchw_l);
+            int ok_l = simdKernels()->to_bitboard(board, &bb_l);
+
+            if(memcmp(nhwc_l, nhwc, sizeof(nhwc)) != 0 || memcmp(nchw_l, nchw, sizeof(nchw)) != 0
+               || nhwc_l[ENCODED_ELEMS] != GUARD || nchw_l[ENCODED_ELEMS] != GUARD
+               || ok_l != ok || (ok && memcmp(&bb_l, &bb, sizeof(bb)) != 0)){
+                if(mismatches < 5) printf("mismatch: board %ld level %s\n", t, simdLevelName(level));
+                mismatches++;
+            }
+        }
+    }
+    printf("mismatches: %ld\n", mismatches);
+    return mismatches != 0;
+}
\ No newline at end of file
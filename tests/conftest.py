@@ -0,0 +1,57 @@
+"""
+C 本体を直接呼ぶ検査プログラム (tests/c/*.c) をコンパイルして実行するための fixture.
+"""
+import os
+import subprocess
+
+import pytest
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SRC_DIR = os.path.join(ROOT, "src", "puyothon")
+
+# 検査プログラムに使う C 本体のソース (setup.py の bench_sources と同じく Python に依存しないもの)
+CORE_SOURCES = [
+    "puyo_func.c",
+    "puyo_bitboard.c",
+    "puyo_env.c",
+    "puyo_legal.c",
+    "puyo_encode.c",
+    "puyo_hash.c",
+    "puyo_thread.c",
+    "puyo_stats.c",
+    "puyo_simd.c",
+]
+
+
+@pytest.fixture(scope="session")
+def run_c_check(tmp_path_factory):
+    """
+    tests/c/<name>.c を C 本体と一緒にコンパイルして実行し, 終了コードと標準出力を返す関数を渡す.
+    C コンパイラが使えない環境ではテストを飛ばす.
+    """
+    import setuptools  # noqa: F401 (distutils を setuptools のものにする)
+    from distutils.ccompiler import new_compiler
+    from distutils.errors import CCompilerError, DistutilsError
+    from distutils.sysconfig import customize_compiler
+
+    build_dir = str(tmp_path_factory.mktemp("c_check"))
+    thread_args = [] if os.name == "nt" else ["-pthread"]
+    compiler = new_compiler()
+    customize_compiler(compiler)
+    objects = []
+
+    def run(name:str, *args:str) -> tuple[int, str]:
+        try:
+            if not objects:
+                objects.extend(compiler.compile([os.path.join(SRC_DIR, s) for s in CORE_SOURCES], output_dir=build_dir,
+                                                include_dirs=[SRC_DIR], extra_postargs=thread_args))
+            main = compiler.compile([os.path.join(ROOT, "tests", "c", name + ".c")], output_dir=build_dir,
+                                    include_dirs=[SRC_DIR], extra_postargs=thread_args)
+            compiler.link_executable(main + objects, name, output_dir=build_dir, extra_postargs=thread_args)
+        except (CCompilerError, DistutilsError) as e:
+            pytest.skip(f"C compiler is not available: {e}")
+        exe = os.path.join(build_dir, compiler.executable_filename(name))
+        result = subprocess.run([exe, *args], capture_output=True, text=True)
+        return result.returncode, result.stdout
+
+    return run
@@ -0,0 +1,70 @@
+"""
+ビットボードのエンジン (ENGINE_BITBOARD) が配列のエンジン (ENGINE_ARRAY) と同じ結果になるかを調べるテスト.
+連鎖数・スコア・処理後の盤面 (puyo面と state面) がすべて一致することを確認する.
+"""
+import numpy as np
+import pytest
+
+import puyothon as puyo
+
+A = puyo.ENGINE_ARRAY
+B = puyo.ENGINE_BITBOARD
+
+
+def randomBoard(rng:np.random.Generator) -> np.ndarray:
+    """
+    おじゃまぷよと宙に浮いたぷよを含む乱数の盤面を作る関数. state面も乱数にする.
+    """
+    board = puyo.makeBoard()
+    fill = rng.integers(-2, puyo.COLOR_NUM + 1, (puyo.ROWS_NUM - 1, puyo.COLS_NUM - 2))
+    fill[fill == puyo.BLOCK] = puyo.EMPTY
+    fill[rng.random(fill.shape) < 0.3] = puyo.EMPTY
+    board[puyo.PUYO, 1:, 1:-1] = fill
+    board[puyo.STATE, 1:, 1:-1] = rng.integers(0, 2, fill.shape)
+    return board
+
+
+def test_play_games():
+    """ランダムに置いて進めた対局の各局面で chainAuto の結果が一致する."""
+    rng = np.random.default_rng(0)
+    actions = [(col, rot) for col in range(1, puyo.COLS_NUM - 1) for rot in range(4)]
+    for _ in range(300):
+        board = puyo.makeBoard()
+        for _ in range(200):
+            parent, child = (int(c) for c in rng.integers(1, puyo.COLOR_NUM + 1, 2))
+            order = rng.permutation(len(actions))
+            if not any(puyo.putPuyo(board, parent, child, *actions[k]) for k in order):
+                break
+            other = board.copy()
+            assert puyo.chainAuto(board, A) == puyo.chainAuto(other, B)
+            assert (board == other).all()
+            if puyo.isDead(board):
+                break
+
+
+@pytest.mark.parametrize("func", ["fallPuyo", "erasePuyo", "chainAuto"])
+def test_random_boards(func:str):
+    """乱数の盤面で fallPuyo, erasePuyo, chainAuto の結果が一致する."""
+    rng = np.random.default_rng(1)
+    for _ in range(5000):
+        board = randomBoard(rng)
+        other = board.copy()
+        if func == "fallPuyo":
+            results = puyo.fallPuyo(board, A), puyo.fallPuyo(other, B)
+        elif func == "erasePuyo":
+            results = puyo.erasePuyo(board, 3, A), puyo.erasePuyo(other, 3, B)
+        else:
+            results = puyo.chainAuto(board, A), puyo.chainAuto(other, B)
+        assert results[0] == results[1]
+        assert (board == other).all()
+
+
+def test_invalid_engine():
+    """ENGINE_ARRAY, ENGINE_BITBOARD 以外のエンジンは ValueError になる."""
+    board = puyo.makeBoard()
+    with pytest.raises(ValueError):
+        puyo.chainAuto(board, 7)
+    with pytest.raises(ValueError):
+        puyo.fallPuyo(board, -3)
+    with pytest.raises(ValueError):
+        puyo.Board().chain(9)
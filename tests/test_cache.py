@@ -0,0 +1,119 @@
+"""
+置換表を使う chainAutoCached が chainAuto と同じ結果になるか, hashBoard が安定しているかを調べるテスト.
+"""
+import os
+import subprocess
+import sys
+import threading
+
+import numpy as np
+import pytest
+
+import puyothon as puyo
+
+
+@pytest.fixture
+def cache():
+    """置換表を有効にし, テストの後で無効 (初期状態) に戻す."""
+    puyo.setCacheSize(1 << 12)
+    yield
+    puyo.setCacheSize(0)
+
+
+def playedBoards(n_games:int, seed:int) -> list[np.ndarray]:
+    """
+    ランダムに置いて進めた対局の, 連鎖を実行する前の各局面を返す関数.
+    """
+    rng = np.random.default_rng(seed)
+    actions = [(col, rot) for col in range(1, puyo.COLS_NUM - 1) for rot in range(4)]
+    boards = []
+    for _ in range(n_games):
+        board = puyo.makeBoard()
+        for _ in range(200):
+            parent, child = (int(c) for c in rng.integers(1, puyo.COLOR_NUM + 1, 2))
+            order = rng.permutation(len(actions))
+            if not any(puyo.putPuyo(board, parent, child, *actions[k]) for k in order):
+                break
+            boards.append(board.copy())
+            puyo.chainAuto(board)
+            if puyo.isDead(board):
+                break
+    return boards
+
+
+def test_hits_and_misses(cache):
+    """1 回目 (ミス) も 2 回目 (ヒット) も chainAuto と同じ結果と盤面になる."""
+    boards = playedBoards(30, 0)
+    for board in boards:
+        expected = board.copy()
+        result = puyo.chainAuto(expected)
+        for _ in range(2):
+            other = board.copy()
+            assert puyo.chainAutoCached(other) == result
+            assert np.array_equal(other, expected)
+        assert puyo.probeCache(board) == result
+    stats = puyo.getCacheStats()
+    assert stats["hits"] > 0 and stats["misses"] > 0
+    assert stats["hits"] + stats["misses"] == 2 * len(boards)
+
+
+def test_disabled():
+    """置換表が無効なときも chainAuto と同じで, probeCache は None を返す."""
+    puyo.setCacheSize(0)
+    for board in playedBoards(5, 1):
+        expected = board.copy()
+        result = puyo.chainAuto(expected)
+        assert puyo.chainAutoCached(board) == result
+        assert np.array_equal(board, expected)
+    assert puyo.probeCache(puyo.makeBoard()) is None
+    assert puyo.getCacheStats()["size"] == 0
+
+
+def test_resize_while_running(cache):
+    """他のスレッドが置換表の大きさを変えている間も chainAutoCached の結果が変わらない."""
+    boards = playedBoards(10, 2)
+    expected = []
+    for board in boards:
+        other = board.copy()
+        expected.append((puyo.chainAuto(other), other))
+    stop = threading.Event()
+
+    def resize():
+        sizes = [0, 1 << 8, 0, 1 << 12]
+        k = 0
+        while not stop.is_set():
+            puyo.setCacheSize(sizes[k % len(sizes)])
+            k += 1
+
+    thread = threading.Thread(target=resize)
+    thread.start()
+    try:
+        for _ in range(5):
+            for board, (result, after) in zip(boards, expected):
+                other = board.copy()
+                assert puyo.chainAutoCached(other) == result
+                assert np.array_equal(other, after)
+    finally:
+        stop.set()
+        thread.join()
+
+
+def test_hash_stable():
+    """hashBoard は puyo面だけで決まり, 呼ぶたびにもプロセスが変わっても同じ値になる. 空の盤面は 0."""
+    boards = playedBoards(3, 3)[::10]
+    hashes = [puyo.hashBoard(board) for board in boards]
+    assert puyo.hashBoard(puyo.makeBoard()) == 0
+    assert len(set(hashes)) == len(hashes)
+    for board, value in zip(boards, hashes):
+        other = board.copy()
+        other[puyo.STATE] = 1 - other[puyo.STATE]
+        assert puyo.hashBoard(other) == value
+        assert puyo.hashBoard(board) == value
+
+    code = ("import numpy as np, puyothon as puyo, sys\n"
+            "boards = np.frombuffer(sys.stdin.buffer.read(), np.int32).reshape(-1, 2, 15, 8)\n"
+            "print(' '.join(str(puyo.hashBoard(board)) for board in boards))\n")
+    env = dict(os.environ, PYTHONPATH=os.pathsep.join(sys.path))
+    out = subprocess.run([sys.executable, "-c", code], input=np.stack(boards).astype(np.int32).tobytes(),
+                         capture_output=True, env=env, check=True).stdout
+    assert [int(value) for value in out.split()] == hashes
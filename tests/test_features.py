@@ -0,0 +1,107 @@
+"""
+連鎖の種の特徴量 (chainFeatures) が, Python で盤面をコピーして数え直した結果と一致するかを調べるテスト.
+"""
+import numpy as np
+
+import puyothon as puyo
+
+TOP_ROW = 12 #つながりを数える最上段
+WIDTH = puyo.COLS_NUM - 2
+
+
+def floodFill(puyos:np.ndarray, i:int, j:int) -> set[tuple[int, int]]:
+    """
+    (i, j) と同じ色で上下左右につながったぷよの位置を 12 段目まで集める関数.
+    """
+    color = puyos[i, j]
+    group = {(i, j)}
+    stack = [(i, j)]
+    while stack:
+        y, x = stack.pop()
+        for ny, nx in ((y + 1, x), (y - 1, x), (y, x + 1), (y, x - 1)):
+            if 1 <= ny <= TOP_ROW and (ny, nx) not in group and puyos[ny, nx] == color:
+                group.add((ny, nx))
+                stack.append((ny, nx))
+    return group
+
+
+def bruteForceFeatures(board:np.ndarray) -> np.ndarray:
+    """
+    chainFeatures と同じ並びの特徴量を, 落とすたびに盤面をコピーして chainAuto を呼んで求める関数.
+    """
+    features = np.zeros(puyo.FEATURES_NUM, np.float32)
+    puyos = board[puyo.PUYO]
+    for j in range(1, puyo.COLS_NUM - 1):
+        empty = np.flatnonzero(puyos[1:TOP_ROW + 1, j] == puyo.EMPTY)
+        i = 1 + empty[0] if len(empty) else TOP_ROW + 1
+        for color in range(1, puyo.COLOR_NUM + 1):
+            for k in range(puyo.FEATURE_DROPS):
+                row = i + k
+                if row > TOP_ROW:
+                    break
+                other = board.copy()
+                other[puyo.STATE] = puyo.IDLE
+                other[puyo.PUYO, i:row + 1, j] = color
+                other[puyo.STATE, i:row + 1, j] = puyo.NEW
+                if len(floodFill(other[puyo.PUYO], row, j)) < 4:
+                    continue
+                index = (((j - 1) * puyo.COLOR_NUM + color - 1) * puyo.FEATURE_DROPS + k) * 2
+                features[index:index + 2] = puyo.chainAuto(other)
+
+    for j in range(1, puyo.COLS_NUM - 1):
+        filled = np.flatnonzero(puyos[1:, j] != puyo.EMPTY)
+        features[puyo.FEATURE_HEIGHT_OFFSET + j - 1] = 1 + filled[-1] if len(filled) else 0
+
+    seen = set()
+    for i in range(1, TOP_ROW + 1):
+        for j in range(1, puyo.COLS_NUM - 1):
+            color = puyos[i, j]
+            if not 1 <= color <= puyo.COLOR_NUM:
+                continue
+            for ny, nx in ((i + 1, j), (i, j + 1)):
+                if ny <= TOP_ROW and puyos[ny, nx] == color:
+                    features[puyo.FEATURE_CONNECT_OFFSET + color - 1] += 1
+            if (i, j) in seen:
+                continue
+            group = floodFill(puyos, i, j)
+            seen |= group
+            if len(group) in (2, 3):
+                features[puyo.FEATURE_GROUP_OFFSET + (color - 1) * 2 + len(group) - 2] += 1
+    return features
+
+
+def playedBoards(n_games:int, seed:int) -> list[np.ndarray]:
+    """
+    ランダムに置いて進めた対局の, 窒息する直前までの各局面を返す関数.
+    """
+    rng = np.random.default_rng(seed)
+    actions = [(col, rot) for col in range(1, puyo.COLS_NUM - 1) for rot in range(4)]
+    boards = []
+    for _ in range(n_games):
+        board = puyo.makeBoard()
+        for _ in range(200):
+            parent, child = (int(c) for c in rng.integers(1, puyo.COLOR_NUM + 1, 2))
+            order = rng.permutation(len(actions))
+            if not any(puyo.putPuyo(board, parent, child, *actions[k]) for k in order):
+                break
+            puyo.chainAuto(board)
+            if puyo.isDead(board):
+                break
+            boards.append(board.copy())
+    return boards
+
+
+def test_brute_force():
+    """200 局の対局の全ての局面で, 特徴量が数え直した結果と一致する."""
+    for board in playedBoards(200, 0):
+        before = board.copy()
+        assert np.array_equal(puyo.chainFeatures(board), bruteForceFeatures(board))
+        assert np.array_equal(board, before)
+
+
+def test_batch():
+    """chainFeaturesBatch がスレッド数によらず盤面ごとの chainFeatures と一致する."""
+    boards = np.stack(playedBoards(20, 1))
+    expected = np.stack([puyo.chainFeatures(board) for board in boards])
+    for n_threads in (1, 3):
+        assert np.array_equal(puyo.chainFeaturesBatch(boards, n_threads=n_threads), expected)
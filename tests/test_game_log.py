@@ -0,0 +1,72 @@
+"""
+対局ログ (appendGameLog, openGameLog) の読み書きを調べるテスト.
+"""
+import threading
+
+import numpy as np
+import pytest
+
+import puyothon as puyo
+
+ACTIONS_NUM = 22
+
+
+def records(n:int, action:int, start:int = 0) -> tuple:
+    """空の盤面と固定のツモ・行動で, スコアが start から連番の n 個のレコードを作る."""
+    boards = np.stack([puyo.makeBoard() for _ in range(n)])
+    return boards, np.full(n, 1), np.full(n, 2), np.full(n, action), np.arange(start, start + n)
+
+
+def test_round_trip(tmp_path):
+    """書いたレコードが openGameLog で同じ値として読める."""
+    path = str(tmp_path / "games.log")
+    rng = np.random.default_rng(7)
+    boards = np.stack([puyo.makeBoard() for _ in range(50)])
+    fill = rng.integers(-2, puyo.COLOR_NUM + 1, (50, puyo.ROWS_NUM - 1, puyo.COLS_NUM - 2))
+    fill[fill == puyo.BLOCK] = puyo.EMPTY
+    boards[:, puyo.PUYO, 1:, 1:-1] = fill
+    parents = rng.integers(1, puyo.COLOR_NUM + 1, 50)
+    children = rng.integers(1, puyo.COLOR_NUM + 1, 50)
+    actions = rng.integers(0, ACTIONS_NUM, 50)
+    scores = rng.integers(0, 1 << 20, 50)
+    chains = rng.integers(0, 20, 50)
+    assert puyo.appendGameLog(path, boards, parents, children, actions, scores, chains) == 50
+
+    log = puyo.openGameLog(path)
+    assert (puyo.unpackBoards(np.asarray(log["board"]))[:, puyo.PUYO] == boards[:, puyo.PUYO]).all()
+    for name, values in (("parent", parents), ("child", children), ("action", actions), ("score", scores), ("n_chains", chains)):
+        assert (log[name] == values).all(), name
+
+
+@pytest.mark.parametrize("field, value", [("parent", 0), ("child", puyo.COLOR_NUM + 1), ("action", -1),
+                                          ("action", ACTIONS_NUM), ("chains", 256)])
+def test_out_of_range(tmp_path, field:str, value:int):
+    """1 バイトに収まらない値や範囲外の色・行動は ValueError になり, 何も書き込まない."""
+    path = str(tmp_path / "games.log")
+    boards, parents, children, actions, scores = records(3, 0)
+    chains = np.zeros(3, np.int64)
+    arrays = {"parent": parents, "child": children, "action": actions, "chains": chains}
+    arrays[field][1] = value
+    with pytest.raises(ValueError):
+        puyo.appendGameLog(path, boards, parents, children, actions, scores, chains)
+    assert puyo.appendGameLog(path, *records(1, 0)) == 1
+
+
+def test_concurrent_append(tmp_path):
+    """複数のスレッドが同じファイルに同時に追記しても, 全てのレコードが残る."""
+    path = str(tmp_path / "games.log")
+
+    def writer(k:int):
+        for i in range(100):
+            puyo.appendGameLog(path, *records(10, k, i * 10))
+
+    threads = [threading.Thread(target=writer, args=(k,)) for k in range(4)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+
+    log = puyo.openGameLog(path)
+    assert len(log) == 4000
+    for k in range(4):
+        assert (np.sort(log["score"][log["action"] == k]) == np.arange(1000)).all()
@@ -0,0 +1,34 @@
+"""
+合法手の表 (legalActionMask, legalActionMasks) が canPut と一致するかを調べるテスト.
+"""
+import numpy as np
+
+import puyothon as puyo
+
+
+def test_exhaustive(run_c_check):
+    """12段目から14段目と11段目の埋まり方 2^24 通りの全てで表と canPut が一致する."""
+    code, out = run_c_check("check_legal")
+    assert code == 0, out
+
+
+def test_batch():
+    """legalActionMasks が盤面ごとの legalActionMask と一致する."""
+    rng = np.random.default_rng(2)
+    boards = np.stack([puyo.makeBoard() for _ in range(1000)])
+    boards[:, puyo.PUYO, 10:, 1:-1] = rng.integers(0, 2, (1000, puyo.ROWS_NUM - 10, puyo.COLS_NUM - 2))
+    masks = puyo.legalActionMasks(boards)
+    assert masks.dtype == np.uint32
+    assert list(masks) == [puyo.legalActionMask(board) for board in boards]
+
+
+def test_import_not_counted():
+    """import 時に表を作るための canPut は計測カウンタ (PUYO_STATS=1 でビルドした場合) に入らない."""
+    import os
+    import subprocess
+    import sys
+
+    code = "import puyothon as puyo; print(puyo.getStats()['canput_calls'])"
+    env = dict(os.environ, PYTHONPATH=os.pathsep.join(sys.path))
+    out = subprocess.run([sys.executable, "-c", code], capture_output=True, text=True, check=True, env=env)
+    assert out.stdout.strip() == "0"
@@ -0,0 +1,83 @@
+"""
+makeMove / unmakeMove (と Board.make / Board.unmake) が, 盤面をコピーして putPuyo と chainAuto を行った結果と一致し,
+変更記録で元の盤面に戻せるかを調べるテスト.
+"""
+import numpy as np
+import pytest
+
+import puyothon as puyo
+
+ACTIONS = [(col, rot) for col in range(1, puyo.COLS_NUM - 1) for rot in range(4)]
+
+
+def _moveFuncs(kind:str):
+    """
+    (盤面を作る関数, 盤面を ndarray として見る関数, make, unmake) を返す関数.
+    """
+    if kind == "module":
+        return puyo.makeBoard, lambda board: board, puyo.makeMove, puyo.unmakeMove
+    return (puyo.Board, np.asarray,
+            lambda board, parent, child, col, rot: board.make(parent, child, col, rot),
+            lambda board, undo: board.unmake(undo))
+
+
+@pytest.mark.parametrize("kind", ["module", "board"])
+def test_play_games(kind:str):
+    """
+    ランダムに進めた対局の各局面で, 全ての置き方について make の結果が putPuyo と chainAuto に一致し,
+    unmake で元に戻る. 対局の最後には進めた手を逆順に全て戻して空の盤面に戻る.
+    """
+    new_board, view, make, unmake = _moveFuncs(kind)
+    rng = np.random.default_rng(0)
+    for _ in range(100):
+        board = new_board()
+        history = []
+        for _ in range(200):
+            parent, child = (int(c) for c in rng.integers(1, puyo.COLOR_NUM + 1, 2))
+            before = view(board).copy()
+            for col, rot in ACTIONS:
+                expected = before.copy()
+                legal = puyo.putPuyo(expected, parent, child, col, rot)
+                n_chains, score = puyo.chainAuto(expected) if legal else (0, 0)
+                result = make(board, parent, child, col, rot)
+                assert result[:3] == (legal, n_chains, score)
+                assert np.array_equal(view(board), expected)
+                unmake(board, result[3])
+                assert np.array_equal(view(board), before)
+
+            order = rng.permutation(len(ACTIONS))
+            for k in order:
+                legal, _, _, undo = make(board, parent, child, *ACTIONS[k])
+                if legal:
+                    history.append((before, undo))
+                    break
+            if not legal or puyo.isDead(view(board)):
+                break
+
+        for before, undo in reversed(history):
+            unmake(board, undo)
+            assert np.array_equal(view(board), before)
+        assert np.array_equal(view(board), puyo.makeBoard())
+
+
+@pytest.mark.parametrize("kind", ["module", "board"])
+def test_illegal(kind:str):
+    """置けない手では盤面を変えず, 空の変更記録を返す."""
+    new_board, view, make, unmake = _moveFuncs(kind)
+    board = new_board()
+    view(board)[puyo.PUYO, 1:13, 3] = puyo.OJAMA
+    before = view(board).copy()
+    legal, n_chains, score, undo = make(board, 1, 2, 1, 0)
+    assert (legal, n_chains, score, undo) == (False, 0, 0, b"")
+    assert np.array_equal(view(board), before)
+    unmake(board, undo)
+    assert np.array_equal(view(board), before)
+
+
+@pytest.mark.parametrize("undo", [b"\x00", b"\xff\x01"])
+def test_invalid_undo(undo:bytes):
+    """長さが奇数か, マスの番号が範囲外の変更記録は ValueError になる."""
+    with pytest.raises(ValueError):
+        puyo.unmakeMove(puyo.makeBoard(), undo)
+    with pytest.raises(ValueError):
+        puyo.Board().unmake(undo)
@@ -0,0 +1,65 @@
+"""
+n_threads で並列化する関数 (ワーカースレッドのプールを使い回す) が, スレッド数や呼び出し方によらず同じ結果になるかを調べるテスト.
+"""
+import os
+import sys
+import threading
+
+import numpy as np
+import pytest
+
+import puyothon as puyo
+
+
+def _board():
+    board = puyo.makeBoard()
+    board[puyo.PUYO, 1:4, 1:7] = [[1, 2, 3, 4, 1, 2], [1, 2, 3, 4, 1, 2], [2, 3, 4, 1, 2, 3]]
+    return board
+
+
+def test_thread_counts():
+    """n_threads = 1, 2, 4 で rollout と beamSearch の結果が一致する. プールを何度も使い回す."""
+    board = _board()
+    pairs = puyo.generateTsumo(5, 1, 8)[0]
+    ref_rollout = puyo.rollout(board, 7, 64, 10, n_threads=1)
+    ref_beam = puyo.beamSearch(board, pairs, depth=6, width=8, n_threads=1)
+    for n_threads in (2, 4, 1, 4):
+        for _ in range(5):
+            assert puyo.rollout(board, 7, 64, 10, n_threads=n_threads) == ref_rollout
+            beam = puyo.beamSearch(board, pairs, depth=6, width=8, n_threads=n_threads)
+            assert beam[0] == ref_beam[0]
+            assert np.array_equal(beam[1], ref_beam[1])
+            assert beam[2:] == ref_beam[2:]
+
+
+def test_concurrent_callers():
+    """複数のスレッドから同時に呼んでも (プールを使えない呼び出しは一時的なスレッドで処理する) 結果が一致する."""
+    board = _board()
+    ref = puyo.rollout(board, 3, 128, 10, n_threads=1)
+    results = []
+
+    def run():
+        for _ in range(20):
+            results.append(puyo.rollout(board, 3, 128, 10, n_threads=4))
+
+    threads = [threading.Thread(target=run) for _ in range(4)]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    assert len(results) == 80
+    assert all(result == ref for result in results)
+
+
+@pytest.mark.skipif(not hasattr(os, "fork"), reason="fork がない")
+def test_fork():
+    """プールを使った後に fork した子プロセスでも並列化した関数が終わり, 結果が一致する."""
+    board = _board()
+    ref = puyo.rollout(board, 3, 128, 10, n_threads=4)
+    pid = os.fork()
+    if pid == 0:
+        ok = puyo.rollout(board, 3, 128, 10, n_threads=4) == ref
+        sys.stdout.flush()
+        os._exit(0 if ok else 1)
+    _, status = os.waitpid(pid, 0)
+    assert os.WIFEXITED(status) and os.WEXITSTATUS(status) == 0
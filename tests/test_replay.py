@@ -0,0 +1,133 @@
+"""
+優先度付き経験再生 (ReplayBuffer) のサンプリングの割合・重要度重み・満杯時の上書き・優先度の更新・盤面の詰め直しを調べるテスト.
+"""
+import numpy as np
+import pytest
+
+import puyothon as puyo
+
+
+def randomBoard(rng:np.random.Generator) -> np.ndarray:
+    """
+    おじゃまぷよと宙に浮いたぷよを含む乱数の盤面を作る関数. state面も乱数にする.
+    """
+    board = puyo.makeBoard()
+    fill = rng.integers(-2, puyo.COLOR_NUM + 1, (puyo.ROWS_NUM - 1, puyo.COLS_NUM - 2))
+    fill[fill == puyo.BLOCK] = puyo.EMPTY
+    board[puyo.PUYO, 1:, 1:-1] = fill
+    board[puyo.STATE, 1:, 1:-1] = rng.integers(0, 2, fill.shape)
+    return board
+
+
+def filledBuffer(priorities:list[float], alpha:float, seed:int = 0, capacity:int | None = None) -> puyo.ReplayBuffer:
+    """
+    priorities の数だけ遷移を入れたバッファを作る関数. i 番目の遷移の action は i.
+    """
+    buffer = puyo.ReplayBuffer(capacity or len(priorities), alpha, seed)
+    board = puyo.makeBoard()
+    for i, priority in enumerate(priorities):
+        buffer.add(board, i, float(i), board, i % 2 == 1, priority)
+    return buffer
+
+
+@pytest.mark.parametrize("alpha", [1.0, 0.5, 0.0])
+def test_sampling_proportions(alpha:float):
+    """各遷移が選ばれる割合が 優先度^alpha に比例する (alpha = 0 なら一様)."""
+    priorities = np.array([1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0, 0.0])
+    buffer = filledBuffer(list(priorities), alpha)
+    counts = np.zeros(len(priorities))
+    for _ in range(500):
+        indices = buffer.sample(64)[5]
+        counts += np.bincount(indices, minlength=len(priorities))
+    leaves = priorities ** alpha #0 ** 0 = 1 なので alpha = 0 では優先度 0 の遷移も選ばれる
+    assert buffer.total_priority == pytest.approx(leaves.sum())
+    assert np.abs(counts / counts.sum() - leaves / leaves.sum()).max() < 0.01
+
+
+def test_importance_weights():
+    """重要度重みが (size * P(i))^-beta をバッチ内の最大値で割ったものになる."""
+    priorities = np.array([0.5, 1.0, 2.0, 4.0, 8.0])
+    alpha, beta = 0.6, 0.4
+    buffer = filledBuffer(list(priorities), alpha)
+    probs = priorities ** alpha / np.sum(priorities ** alpha)
+    for _ in range(20):
+        *_, indices, weights = buffer.sample(16, beta)
+        expected = (len(priorities) * probs[indices]) ** -beta
+        np.testing.assert_allclose(weights, expected / expected.max(), rtol=1e-5)
+    weights = buffer.sample(16, 0.0)[6]
+    assert (weights == 1.0).all()
+
+
+def test_sample_fields():
+    """sample の行動・報酬・終了フラグが選ばれた位置の遷移のものになる."""
+    buffer = filledBuffer([1.0] * 10, 0.6)
+    _, actions, rewards, _, dones, indices, _ = buffer.sample(32)
+    assert (actions == indices).all()
+    assert (rewards == indices.astype(np.float32)).all()
+    assert (dones == (indices % 2 == 1)).all()
+
+
+def test_overwrite_when_full():
+    """満杯になると最も古い遷移から上書きし, 上書きした遷移の優先度も置き換わる."""
+    rng = np.random.default_rng(0)
+    buffer = puyo.ReplayBuffer(4, 1.0, 0)
+    boards = [randomBoard(rng) for _ in range(7)]
+    positions = [buffer.add(boards[i], i, 0.0, boards[i], False, float(i + 1)) for i in range(7)]
+    assert positions == [0, 1, 2, 3, 0, 1, 2]
+    assert len(buffer) == buffer.capacity == 4
+    #位置 0, 1, 2 は 5, 6, 7 番目の遷移, 位置 3 は 4 番目の遷移
+    assert buffer.total_priority == pytest.approx(5 + 6 + 7 + 4)
+    assert buffer.max_priority == 7.0
+    stored, _ = buffer.getBoards(np.arange(4))
+    for position, i in enumerate([4, 5, 6, 3]):
+        assert np.array_equal(stored[position, puyo.PUYO], boards[i][puyo.PUYO])
+    actions = set()
+    for _ in range(50):
+        actions |= set(buffer.sample(8)[1].tolist())
+    assert actions == {3, 4, 5, 6}
+
+
+def test_update_priorities():
+    """updatePriorities で割合が変わり, max_priority も更新される. 0 にした遷移は選ばれない."""
+    buffer = filledBuffer([1.0] * 4, 1.0)
+    buffer.updatePriorities(np.array([0, 1, 2, 3]), np.array([0.0, 0.0, 3.0, 9.0]))
+    assert buffer.total_priority == pytest.approx(12.0)
+    assert buffer.max_priority == 9.0
+    counts = np.zeros(4)
+    for _ in range(200):
+        counts += np.bincount(buffer.sample(64)[5], minlength=4)
+    assert counts[0] == counts[1] == 0
+    assert abs(counts[3] / counts.sum() - 0.75) < 0.01
+
+
+@pytest.mark.parametrize("indices, priorities", [
+    ([0, 3], [1.0, 1.0]),          #まだ入っていない位置 (size = 3)
+    ([0, -1], [1.0, 1.0]),         #負の位置
+    ([0, 1], [1.0, -0.5]),         #負の優先度
+    ([0, 1], [1.0, float("nan")]), #NaN
+])
+def test_update_priorities_invalid(indices:list[int], priorities:list[float]):
+    """不正な位置や優先度は ValueError になり, 途中まで更新することもない."""
+    buffer = filledBuffer([1.0, 2.0, 3.0], 1.0, capacity=8)
+    total, max_priority = buffer.total_priority, buffer.max_priority
+    with pytest.raises(ValueError):
+        buffer.updatePriorities(np.array(indices), np.array(priorities))
+    assert buffer.total_priority == total
+    assert buffer.max_priority == max_priority
+
+
+def test_get_boards_round_trip():
+    """詰めて保存した盤面を getBoards で戻すと puyo面が一致し, STATE面は IDLE になる."""
+    rng = np.random.default_rng(1)
+    boards = np.stack([randomBoard(rng) for _ in range(100)])
+    next_boards = np.stack([randomBoard(rng) for _ in range(100)])
+    buffer = puyo.ReplayBuffer(100, 0.6, 0)
+    buffer.addBatch(boards, np.zeros(100, np.int32), np.zeros(100, np.float32), next_boards, np.zeros(100, bool))
+    order = rng.permutation(100)
+    stored, stored_next = buffer.getBoards(order)
+    assert np.array_equal(stored[:, puyo.PUYO], boards[order, puyo.PUYO])
+    assert np.array_equal(stored_next[:, puyo.PUYO], next_boards[order, puyo.PUYO])
+    assert (stored[:, puyo.STATE] == puyo.IDLE).all()
+    assert (stored_next[:, puyo.STATE] == puyo.IDLE).all()
+    with pytest.raises(IndexError):
+        buffer.getBoards(np.array([100]))
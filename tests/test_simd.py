@@ -0,0 +1,73 @@
+"""
+SIMD の命令セットごとのカーネルがスカラー版と同じ結果になるかを調べるテスト.
+"""
+import numpy as np
+
+import puyothon as puyo
+
+
+def test_kernels(run_c_check):
+    """乱数の盤面で toBoardForModel, encodeBoard (NCHW, float32), toBitBoard が全ての命令セットで一致する."""
+    code, out = run_c_check("check_simd", "200000")
+    assert code == 0, out
+
+
+def test_set_level():
+    """setSimdLevel で切り替えた全ての命令セットで cvtBoardForModel と chainAuto (ENGINE_BITBOARD) が一致する."""
+    rng = np.random.default_rng(3)
+    boards = []
+    for _ in range(2000):
+        board = puyo.makeBoard()
+        board[puyo.PUYO, 1:, 1:-1] = rng.integers(-2, puyo.COLOR_NUM + 1, (puyo.ROWS_NUM - 1, puyo.COLS_NUM - 2))
+        boards.append(board)
+
+    def results() -> list:
+        out = []
+        for board in boards:
+            other = board.copy()
+            out.append((puyo.cvtBoardForModel(board, puyo.LAYOUT_NHWC).tobytes(),
+                        puyo.cvtBoardForModel(board, puyo.LAYOUT_NCHW).tobytes(),
+                        puyo.chainAuto(other, puyo.ENGINE_BITBOARD), other.tobytes()))
+        return out
+
+    default = puyo.getSimdInfo()["level"]
+    try:
+        puyo.setSimdLevel("scalar")
+        expected = results()
+        for level in puyo.getSimdInfo()["supported"]:
+            assert puyo.setSimdLevel(level) == level
+            assert results() == expected, level
+    finally:
+        puyo.setSimdLevel(default)
+
+
+def test_switch_while_running():
+    """他のスレッドが変換している間に setSimdLevel で切り替えても結果は変わらない."""
+    import threading
+
+    rng = np.random.default_rng(4)
+    boards = np.stack([puyo.makeBoard() for _ in range(256)])
+    boards[:, puyo.PUYO, 1:, 1:-1] = rng.integers(0, puyo.COLOR_NUM + 1, (256, puyo.ROWS_NUM - 1, puyo.COLS_NUM - 2))
+    expected = [puyo.cvtBoardForModel(board, puyo.LAYOUT_NCHW).tobytes() for board in boards]
+    levels = puyo.getSimdInfo()["supported"]
+    default = puyo.getSimdInfo()["level"]
+    stop = threading.Event()
+    errors = []
+
+    def worker():
+        while not stop.is_set():
+            if [puyo.cvtBoardForModel(board, puyo.LAYOUT_NCHW).tobytes() for board in boards] != expected:
+                errors.append(1)
+
+    threads = [threading.Thread(target=worker) for _ in range(2)]
+    for t in threads:
+        t.start()
+    try:
+        for k in range(2000):
+            puyo.setSimdLevel(levels[k % len(levels)])
+    finally:
+        stop.set()
+        for t in threads:
+            t.join()
+        puyo.setSimdLevel(default)
+    assert not errors
@@ -0,0 +1,61 @@
+"""
+ツモ列の生成 (generateTsumo) が周期・色の数・最初の 2 組の色数・系列番号の約束を守り,
+同じシードから常に同じツモ列になる (rollout や playVersus の結果を再現できる) かを調べるテスト.
+"""
+import numpy as np
+import pytest
+
+import puyothon as puyo
+
+CYCLE = puyo.TSUMO_CYCLE
+
+
+def test_period():
+    """TSUMO_CYCLE (128) 組ごとに同じ並びを繰り返し, start を周期の倍数ずらしても同じになる."""
+    pairs = puyo.generateTsumo(1, 50, 3 * CYCLE)
+    assert CYCLE == 128
+    assert np.array_equal(pairs[:, :CYCLE], pairs[:, CYCLE:2 * CYCLE])
+    assert np.array_equal(pairs[:, :CYCLE], pairs[:, 2 * CYCLE:])
+    assert np.array_equal(puyo.generateTsumo(1, 50, CYCLE, start=5 * CYCLE + 7),
+                          np.roll(pairs[:, :CYCLE], -7, axis=1))
+    assert np.array_equal(puyo.generateTsumo(1, 50, 10, start=(1 << 40) + 3), pairs[:, 3:13])
+
+
+def test_color_counts():
+    """1 周期の中に各色がちょうど 64 個ずつ入る."""
+    pairs = puyo.generateTsumo(2, 500, CYCLE)
+    assert pairs.min() == 1 and pairs.max() == puyo.COLOR_NUM
+    for color in range(1, puyo.COLOR_NUM + 1):
+        assert ((pairs == color).sum(axis=(1, 2)) == 2 * CYCLE // puyo.COLOR_NUM).all()
+    assert 2 * CYCLE // puyo.COLOR_NUM == 64
+
+
+def test_first_two_pairs():
+    """最初の 2 組 (4 個) は高々 3 色になる."""
+    pairs = puyo.generateTsumo(3, 5000, 2)
+    colors = [len(set(first.ravel().tolist())) for first in pairs]
+    assert max(colors) <= 3
+    assert 3 in colors
+
+
+@pytest.mark.parametrize("n_threads", [1, 4])
+def test_streams(n_threads:int):
+    """i 番目のツモ列は stream + i 番目の系列と同じで, スレッド数や out の有無によらない."""
+    seed, stream = 4, 1000
+    pairs = puyo.generateTsumo(seed, 300, 20, stream=stream, n_threads=n_threads)
+    for i in (0, 1, 63, 64, 299):
+        assert np.array_equal(pairs[i], puyo.generateTsumo(seed, 1, 20, stream=stream + i)[0])
+    out = np.zeros((300, 20, 2), np.int32)
+    assert puyo.generateTsumo(seed, 300, 20, stream=stream, out=out, n_threads=n_threads) is out
+    assert np.array_equal(out, pairs)
+    assert not np.array_equal(pairs[0], pairs[1])
+    assert not np.array_equal(pairs[0], puyo.generateTsumo(seed + 1, 1, 20, stream=stream)[0])
+
+
+def test_fixed_values():
+    """同じシードからは常に同じツモ列になる. 乱数やシャッフルを変えると rollout や playVersus の結果も変わるので値を固定する."""
+    assert puyo.generateTsumo(0, 2, 6).tolist() == [
+        [[4, 2], [2, 3], [2, 4], [1, 2], [2, 4], [4, 3]],
+        [[2, 1], [3, 3], [4, 3], [4, 2], [4, 2], [3, 4]],
+    ]
+    assert puyo.generateTsumo(2**64 - 1, 1, 4, stream=7).tolist() == [[[1, 3], [1, 2], [1, 2], [2, 1]]]
@@ -0,0 +1,107 @@
+"""
+ルールの種類 (variant) ごとの関数が標準のルール (VARIANT_STANDARD) と同じ処理になるかを調べるテスト.
+色数だけが違うルールは同じ盤面で, 盤面が広いルールは標準の盤面を埋め込んで比べる.
+"""
+import numpy as np
+import pytest
+
+import puyothon as puyo
+
+
+def randomBoard(rng:np.random.Generator, variant:int, colors:int) -> np.ndarray:
+    """
+    列ごとに高さを決めて 1..colors の色とおじゃまぷよを積んだ盤面を作る関数. state面は全て NEW にする.
+    """
+    board = puyo.makeBoard(variant)
+    rows, cols = board.shape[1:]
+    for j in range(1, cols - 1):
+        height = rng.integers(0, rows - 1)
+        fill = rng.integers(1, colors + 1, height)
+        fill[rng.random(height) < 0.05] = puyo.OJAMA
+        board[puyo.PUYO, 1:height + 1, j] = fill
+    board[puyo.STATE, 1:, 1:-1] = 1
+    return board
+
+
+def results(board:np.ndarray, variant:int) -> list:
+    """putPuyo (全ての列と回転), fallPuyo, erasePuyo, chainAuto, isDead の結果と処理後の盤面を並べる."""
+    out = [puyo.isDead(board, variant)]
+    for col in range(1, board.shape[2] - 1):
+        for rot in range(4):
+            other = board.copy()
+            out.append((puyo.putPuyo(other, 1, 2, col, rot, variant), other.tobytes()))
+    other = board.copy()
+    out.append((puyo.fallPuyo(other, puyo.ENGINE_ARRAY, variant), puyo.erasePuyo(other, 1, puyo.ENGINE_ARRAY, variant),
+                other.tobytes()))
+    other = board.copy()
+    out.append((puyo.chainAuto(other, puyo.ENGINE_ARRAY, variant), other.tobytes()))
+    return out
+
+
+@pytest.mark.parametrize("variant", [puyo.VARIANT_COLOR3, puyo.VARIANT_COLOR5])
+def test_colors(variant:int):
+    """色数だけが違うルールは, どちらのルールにもある色の盤面で標準のルールと一致する."""
+    rng = np.random.default_rng(4)
+    colors = min(puyo.getRuleVariants()[variant]["colors"], puyo.COLOR_NUM)
+    for _ in range(1000):
+        board = randomBoard(rng, puyo.VARIANT_STANDARD, colors)
+        assert results(board, variant) == results(board, puyo.VARIANT_STANDARD)
+
+
+def test_wide():
+    """広い盤面の左側に標準の盤面を埋め込み, 残りの列を BLOCK で塞ぐと落下・消去・連鎖が一致する."""
+    rng = np.random.default_rng(5)
+    for _ in range(2000):
+        board = randomBoard(rng, puyo.VARIANT_STANDARD, puyo.COLOR_NUM)
+        wide = puyo.makeBoard(puyo.VARIANT_WIDE)
+        wide[:, :, :puyo.COLS_NUM] = board
+        wide[puyo.PUYO, :, puyo.COLS_NUM - 1:] = puyo.BLOCK
+
+        std, other = board.copy(), wide.copy()
+        assert puyo.fallPuyo(std) == puyo.fallPuyo(other, variant=puyo.VARIANT_WIDE)
+        assert puyo.erasePuyo(std, 1) == puyo.erasePuyo(other, 1, variant=puyo.VARIANT_WIDE)
+        assert (std == other[:, :, :puyo.COLS_NUM]).all()
+
+        std, other = board.copy(), wide.copy()
+        assert puyo.chainAuto(std) == puyo.chainAuto(other, variant=puyo.VARIANT_WIDE)
+        assert (std == other[:, :, :puyo.COLS_NUM]).all()
+
+
+@pytest.mark.parametrize("variant", range(puyo.VARIANTS_NUM))
+def test_actions(variant:int):
+    """空の盤面で置ける列と回転の組み合わせの数が actions と一致する."""
+    info = puyo.getRuleVariants()[variant]
+    board = puyo.makeBoard(variant)
+    assert board.shape == (puyo.ARRS_NUM, info["rows"], info["cols"])
+    placeable = sum(puyo.putPuyo(board.copy(), 1, 2, col, rot, variant)
+                    for col in range(1, info["cols"] - 1) for rot in range(4))
+    assert placeable == info["actions"]
+
+
+@pytest.mark.parametrize("variant", range(puyo.VARIANTS_NUM))
+def test_encode(variant:int):
+    """cvtBoardForModel の形がルールの大きさと色数に合い, 色ごとの one-hot になっている."""
+    info = puyo.getRuleVariants()[variant]
+    h, w, c = info["rows"] - 1, info["cols"] - 2, info["colors"]
+    board = randomBoard(np.random.default_rng(6), variant, c)
+    x = puyo.cvtBoardForModel(board, puyo.LAYOUT_NHWC, puyo.DTYPE_FLOAT32, variant=variant)
+    assert x.shape == (1, h, w, c)
+    cells = board[puyo.PUYO, 1:, 1:-1]
+    for p in range(1, c + 1):
+        assert (x[0, :, :, p - 1] == (cells == p)).all()
+    y = puyo.cvtBoardForModel(board, puyo.LAYOUT_NCHW, puyo.DTYPE_FLOAT32, variant=variant)
+    assert (y[0] == x[0].transpose(2, 0, 1)).all()
+    bits = puyo.cvtBoardForModel(board, puyo.LAYOUT_NHWC, puyo.DTYPE_BITS, variant=variant)
+    assert bits.shape == (1, (h * w * c + 7) // 8)
+    assert (np.unpackbits(bits[0])[:h * w * c] == x.reshape(-1)).all()
+
+
+def test_invalid():
+    """範囲外の variant, 標準以外でのビットボード, 形の合わない盤面は ValueError になる."""
+    with pytest.raises(ValueError):
+        puyo.makeBoard(puyo.VARIANTS_NUM)
+    wide = puyo.makeBoard(puyo.VARIANT_WIDE)
+    with pytest.raises(ValueError):
+        puyo.chainAuto(wide, puyo.ENGINE_BITBOARD, puyo.VARIANT_WIDE)
+    with pytest.raises(ValueError):
+        puyo.chainAuto(wide)